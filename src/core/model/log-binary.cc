@@ -0,0 +1,903 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "log-binary.h"
+
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <list>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <utility>
+#include <vector>
+#include "ns3/core-config.h"
+#include "fatal-error.h"
+
+#ifdef HAVE_PTHREAD_H
+#include "system-thread.h"
+#include "system-mutex.h"
+#include "system-condition.h"
+#endif
+
+#ifdef HAVE_STDLIB_H
+#include <cstdlib>
+#endif
+
+/**
+ * \file
+ * \ingroup logbinary
+ * Asynchronous binary backend of the NS_LOG macros, implementation.
+ */
+
+// Note:  there is no logging in this file: the functions below are
+// called from within the NS_LOG macros, and the threading primitives
+// they use log through the regular synchronous backend.
+
+namespace ns3 {
+
+namespace {
+
+/**
+ * \ingroup logbinary
+ * Binary log file format.
+ *
+ * The file starts with the 8 bytes of \c g_magic and continues with a
+ * sequence of records in host byte order.  A record starts with its
+ * RecordType.
+ *
+ * A SITE_RECORD defines the log site id used by the following
+ * LOG_RECORDs: uint32_t id, then the component name and the function
+ * name, each as a uint16_t length followed by the characters.  A site
+ * is defined once per writing thread, before its first use by that
+ * thread.
+ *
+ * A LOG_RECORD holds: uint8_t LogBinaryKind, uint8_t flags
+ * (\c FLAG_*), uint32_t LogLevel, uint32_t site id, int64_t time in
+ * nanoseconds, uint32_t node id, uint32_t length of the context text,
+ * uint32_t length of the message text, then the context and message
+ * characters.
+ */
+const char g_magic[8] = { 'N', 'S', '3', 'L', 'O', 'G', 'B', '1' };
+
+/** The type of a record in a binary log file. */
+enum RecordType {
+  SITE_RECORD = 1,  //!< Definition of a log site.
+  LOG_RECORD = 2    //!< A log message.
+};
+
+/** Flags of a LOG_RECORD. */
+enum RecordFlag {
+  FLAG_PREFIX_FUNC = 0x01,   //!< The component had LOG_PREFIX_FUNC.
+  FLAG_PREFIX_TIME = 0x02,   //!< The component had LOG_PREFIX_TIME.
+  FLAG_PREFIX_NODE = 0x04,   //!< The component had LOG_PREFIX_NODE.
+  FLAG_PREFIX_LEVEL = 0x08,  //!< The component had LOG_PREFIX_LEVEL.
+  FLAG_HAS_TIME = 0x10,      //!< The time field is valid.
+  FLAG_HAS_NODE = 0x20       //!< The node id field is valid.
+};
+
+/** The size of the buffers handed to the writer. */
+const std::size_t CHUNK_SIZE = 64 * 1024;
+/** The maximum number of buffers waiting for the writer. */
+const std::size_t MAX_QUEUED_CHUNKS = 64;
+
+/** The LogBinaryTimeSource. */
+LogBinaryTimeSource g_timeSource = 0;
+/** The LogBinaryNodeSource. */
+LogBinaryNodeSource g_nodeSource = 0;
+
+/**
+ * Append a value to a record buffer.
+ * \param [in,out] buffer The buffer.
+ * \param [in] value The value to append.
+ */
+template <typename T>
+void
+Append (std::vector<char> *buffer, T value)
+{
+  const char *p = reinterpret_cast<const char *> (&value);
+  buffer->insert (buffer->end (), p, p + sizeof (T));
+}
+
+/**
+ * Append a short string to a record buffer.
+ * \param [in,out] buffer The buffer.
+ * \param [in] s The string to append.
+ */
+void
+AppendString (std::vector<char> *buffer, const std::string &s)
+{
+  uint16_t length = s.size () < 0xffff ? s.size () : 0xffff;
+  Append (buffer, length);
+  buffer->insert (buffer->end (), s.begin (), s.begin () + length);
+}
+
+/**
+ * Read a value from a binary log.
+ * \param [in] is The binary log.
+ * \param [out] value The value read.
+ * \returns \c true if the value could be read.
+ */
+template <typename T>
+bool
+Read (std::istream &is, T *value)
+{
+  is.read (reinterpret_cast<char *> (value), sizeof (T));
+  return is.good ();
+}
+
+/**
+ * Read a string from a binary log.
+ * \param [in] is The binary log.
+ * \param [in] length The length of the string.
+ * \param [out] s The string read.
+ * \returns \c true if the string could be read.
+ */
+bool
+ReadString (std::istream &is, uint32_t length, std::string *s)
+{
+  s->resize (length);
+  if (length > 0)
+    {
+      is.read (&(*s)[0], length);
+    }
+  return is.good ();
+}
+
+} // anonymous namespace
+
+/**
+ * \ingroup logbinary
+ * The writer of the binary log file.
+ *
+ * The logging threads queue full buffers of records, which a
+ * background thread writes to the file.
+ */
+class LogBinaryWriter
+{
+public:
+  LogBinaryWriter ();
+  ~LogBinaryWriter ();
+
+  /**
+   * Open a new log file and start the writer thread.
+   * \param [in] filename The name of the file.
+   */
+  void Open (const std::string &filename);
+  /** Write all the queued buffers, stop the writer thread and close the file. */
+  void Close (void);
+  /**
+   * Queue a buffer of records for writing.
+   *
+   * This waits for the writer if too many buffers are already queued.
+   * \param [in] chunk The buffer, which the writer now owns.
+   */
+  void Submit (std::vector<char> *chunk);
+  /** Wait until all the buffers queued so far have been written. */
+  void Wait (void);
+  /**
+   * Get an empty buffer.
+   * \returns The buffer.
+   */
+  std::vector<char> *Allocate (void);
+  /**
+   * Get the id of a log site, allocating a new one on first use.
+   * \param [in] component The LogComponent of the site.
+   * \param [in] function The function of the site.
+   * \returns The id of the site.
+   */
+  uint32_t GetSiteId (const LogComponent *component, char const *function);
+  /**
+   * Get the generation of the log file.
+   *
+   * The generation changes whenever a new file is opened so that
+   * the logging threads can discard their buffers and site
+   * definitions, which belong to a previous file.
+   * \returns The generation of the current file.
+   */
+  uint32_t GetGeneration (void) const;
+
+private:
+  /** Body of the writer thread. */
+  void Run (void);
+  /**
+   * Write buffers to the file and recycle them.
+   * \param [in] chunks The buffers to write.
+   */
+  void Write (std::list<std::vector<char> *> *chunks);
+
+  std::ofstream m_file;                        //!< The log file.
+  std::list<std::vector<char> *> m_queue;      //!< The buffers to write.
+  std::list<std::vector<char> *> m_free;       //!< Recycled buffers.
+  uint64_t m_submitted;                        //!< The number of buffers queued.
+  uint64_t m_written;                          //!< The number of buffers written.
+  bool m_stop;                                 //!< Stop the writer thread.
+  uint32_t m_generation;                       //!< The generation of the file.
+  /** The site ids, by component and function. */
+  std::map<std::pair<const LogComponent *, char const *>, uint32_t> m_sites;
+#ifdef HAVE_PTHREAD_H
+  SystemMutex m_mutex;                         //!< Protects the queues and counters.
+  SystemCondition m_wakeup;                    //!< Wakes up the writer thread.
+  SystemCondition m_progress;                  //!< Signals written buffers.
+  Ptr<SystemThread> m_thread;                  //!< The writer thread.
+#endif
+};
+
+/**
+ * \ingroup logbinary
+ * The text of a binary log record being built.
+ */
+struct LogBinaryText
+{
+  std::ostringstream text;          //!< The text of the record.
+  std::size_t contextEnd;           //!< The length of the context text.
+  std::streambuf *clogBuffer;       //!< The buffer of \c std::clog during the context.
+};
+
+/**
+ * \ingroup logbinary
+ * The state of the binary backend in a logging thread.
+ */
+struct LogBinaryThreadState
+{
+  LogBinaryThreadState ();
+  ~LogBinaryThreadState ();
+
+  /**
+   * Submit \c chunk to the writer if it belongs to the current file.
+   * The caller holds \c lock.
+   */
+  void Submit (void);
+
+  /**
+   * The records being built, outermost first.  Only the first
+   * \c depth are in use: the others are kept for reuse.
+   */
+  std::vector<LogBinaryText *> texts;
+  std::size_t depth;                //!< The number of records being built.
+  std::vector<char> *chunk;         //!< The records not yet submitted.
+  uint32_t generation;              //!< The file generation of \c chunk and \c sites.
+  bool busy;                        //!< Set while completing a record.
+  bool registered;                  //!< Set when in the list of the thread states.
+  /**
+   * Protects \c chunk against LogBinaryDisable called by another
+   * thread.  SystemMutex is not used since it logs.
+   */
+  std::mutex lock;
+  /** The site ids defined by this thread, by component and function. */
+  std::map<std::pair<const LogComponent *, char const *>, uint32_t> sites;
+};
+
+/**
+ * \ingroup logbinary
+ * The states of the threads which buffered records, so that
+ * LogBinaryDisable can submit their buffers.
+ */
+struct LogBinaryThreadList
+{
+  std::mutex lock;                            //!< Protects \c states.
+  std::set<LogBinaryThreadState *> states;    //!< The thread states.
+};
+
+namespace {
+
+/**
+ * Set while a binary log file is open.  Read by all the logging
+ * threads.
+ */
+std::atomic<bool> g_enabled (false);
+
+/**
+ * Get the list of the thread states.
+ * \returns The list.
+ */
+LogBinaryThreadList *
+GetThreadList (void)
+{
+  static LogBinaryThreadList list;
+  return &list;
+}
+
+/**
+ * Get the writer.
+ * \returns The writer.
+ */
+LogBinaryWriter *
+GetWriter (void)
+{
+  static LogBinaryWriter writer;
+  return &writer;
+}
+
+/**
+ * Get the state of the calling thread.
+ * \returns The state.
+ */
+LogBinaryThreadState *
+GetThreadState (void)
+{
+  static thread_local LogBinaryThreadState state;
+  return &state;
+}
+
+/**
+ * Handler for the \c NS_LOG_BINARY environment variable.
+ */
+class LogBinaryEnvVar
+{
+public:
+  LogBinaryEnvVar ();  //!< Constructor, enables the backend if requested.
+};
+
+LogBinaryEnvVar::LogBinaryEnvVar ()
+{
+#ifdef HAVE_GETENV
+  char *envVar = getenv ("NS_LOG_BINARY");
+  if (envVar != 0 && std::strlen (envVar) > 0)
+    {
+      LogBinaryEnable (envVar);
+    }
+#endif
+}
+
+/** Invoke the handler for the \c NS_LOG_BINARY environment variable. */
+LogBinaryEnvVar g_logBinaryEnvVar;
+
+} // anonymous namespace
+
+
+LogBinaryWriter::LogBinaryWriter ()
+  : m_submitted (0),
+    m_written (0),
+    m_stop (false),
+    m_generation (0)
+{
+}
+
+LogBinaryWriter::~LogBinaryWriter ()
+{
+  // Messages logged later during the program termination go to std::clog.
+  g_enabled = false;
+  Close ();
+  while (!m_free.empty ())
+    {
+      delete m_free.front ();
+      m_free.pop_front ();
+    }
+}
+
+void
+LogBinaryWriter::Open (const std::string &filename)
+{
+  Close ();
+  m_file.open (filename.c_str (), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!m_file.is_open ())
+    {
+      NS_FATAL_ERROR ("Unable to open binary log file " << filename);
+    }
+  m_file.write (g_magic, sizeof (g_magic));
+  m_sites.clear ();
+  m_generation++;
+  m_stop = false;
+#ifdef HAVE_PTHREAD_H
+  m_thread = Create<SystemThread> (MakeCallback (&LogBinaryWriter::Run, this));
+  m_thread->Start ();
+#endif
+}
+
+void
+LogBinaryWriter::Close (void)
+{
+  if (!m_file.is_open ())
+    {
+      return;
+    }
+#ifdef HAVE_PTHREAD_H
+  m_mutex.Lock ();
+  m_stop = true;
+  m_mutex.Unlock ();
+  m_wakeup.SetCondition (true);
+  m_wakeup.Signal ();
+  m_thread->Join ();
+  m_thread = 0;
+#endif
+  Write (&m_queue);
+  m_file.close ();
+}
+
+void
+LogBinaryWriter::Submit (std::vector<char> *chunk)
+{
+#ifdef HAVE_PTHREAD_H
+  m_mutex.Lock ();
+  while (m_queue.size () >= MAX_QUEUED_CHUNKS)
+    {
+      m_progress.SetCondition (false);
+      m_mutex.Unlock ();
+      m_wakeup.SetCondition (true);
+      m_wakeup.Signal ();
+      m_progress.TimedWait (1000000);
+      m_mutex.Lock ();
+    }
+  m_queue.push_back (chunk);
+  m_submitted++;
+  bool wakeup = m_queue.size () == 1;
+  m_mutex.Unlock ();
+  if (wakeup)
+    {
+      m_wakeup.SetCondition (true);
+      m_wakeup.Signal ();
+    }
+#else
+  std::list<std::vector<char> *> chunks;
+  chunks.push_back (chunk);
+  m_submitted++;
+  Write (&chunks);
+#endif
+}
+
+void
+LogBinaryWriter::Wait (void)
+{
+#ifdef HAVE_PTHREAD_H
+  m_mutex.Lock ();
+  uint64_t target = m_submitted;
+  while (m_written < target && !m_stop)
+    {
+      m_progress.SetCondition (false);
+      m_mutex.Unlock ();
+      m_wakeup.SetCondition (true);
+      m_wakeup.Signal ();
+      m_progress.TimedWait (1000000);
+      m_mutex.Lock ();
+    }
+  m_mutex.Unlock ();
+#endif
+  m_file.flush ();
+}
+
+std::vector<char> *
+LogBinaryWriter::Allocate (void)
+{
+  std::vector<char> *chunk = 0;
+#ifdef HAVE_PTHREAD_H
+  CriticalSection cs (m_mutex);
+#endif
+  if (!m_free.empty ())
+    {
+      chunk = m_free.front ();
+      m_free.pop_front ();
+    }
+  else
+    {
+      chunk = new std::vector<char> ();
+      chunk->reserve (CHUNK_SIZE);
+    }
+  return chunk;
+}
+
+uint32_t
+LogBinaryWriter::GetSiteId (const LogComponent *component, char const *function)
+{
+#ifdef HAVE_PTHREAD_H
+  CriticalSection cs (m_mutex);
+#endif
+  std::pair<const LogComponent *, char const *> key (component, function);
+  std::map<std::pair<const LogComponent *, char const *>, uint32_t>::const_iterator i = m_sites.find (key);
+  if (i != m_sites.end ())
+    {
+      return i->second;
+    }
+  uint32_t id = m_sites.size ();
+  m_sites[key] = id;
+  return id;
+}
+
+uint32_t
+LogBinaryWriter::GetGeneration (void) const
+{
+  return m_generation;
+}
+
+void
+LogBinaryWriter::Run (void)
+{
+#ifdef HAVE_PTHREAD_H
+  // The log messages of this thread, if any, go to std::clog.
+  GetThreadState ()->busy = true;
+  while (true)
+    {
+      m_wakeup.SetCondition (false);
+      m_mutex.Lock ();
+      std::list<std::vector<char> *> chunks;
+      chunks.swap (m_queue);
+      bool stop = m_stop;
+      m_mutex.Unlock ();
+
+      Write (&chunks);
+      if (stop)
+        {
+          break;
+        }
+      m_wakeup.TimedWait (10000000);
+    }
+#endif
+}
+
+void
+LogBinaryWriter::Write (std::list<std::vector<char> *> *chunks)
+{
+  uint64_t written = 0;
+  for (std::list<std::vector<char> *>::iterator i = chunks->begin (); i != chunks->end (); ++i)
+    {
+      if (!(*i)->empty ())
+        {
+          m_file.write (&(**i)[0], (*i)->size ());
+        }
+      (*i)->clear ();
+      written++;
+    }
+#ifdef HAVE_PTHREAD_H
+  m_mutex.Lock ();
+#endif
+  m_free.splice (m_free.end (), *chunks);
+  m_written += written;
+#ifdef HAVE_PTHREAD_H
+  m_mutex.Unlock ();
+  m_progress.SetCondition (true);
+  m_progress.Broadcast ();
+#endif
+}
+
+
+LogBinaryThreadState::LogBinaryThreadState ()
+  : depth (0),
+    chunk (0),
+    generation (0),
+    busy (false),
+    registered (false)
+{
+}
+
+LogBinaryThreadState::~LogBinaryThreadState ()
+{
+  busy = true;
+  if (registered)
+    {
+      LogBinaryThreadList *list = GetThreadList ();
+      std::lock_guard<std::mutex> guard (list->lock);
+      list->states.erase (this);
+    }
+  if (g_enabled)
+    {
+      Submit ();
+    }
+  delete chunk;
+  for (std::vector<LogBinaryText *>::iterator i = texts.begin (); i != texts.end (); ++i)
+    {
+      delete *i;
+    }
+}
+
+
+void
+LogBinaryThreadState::Submit (void)
+{
+  if (chunk != 0 && generation == GetWriter ()->GetGeneration ())
+    {
+      GetWriter ()->Submit (chunk);
+      chunk = 0;
+    }
+}
+
+
+void
+LogBinarySetTimeSource (LogBinaryTimeSource ts)
+{
+  g_timeSource = ts;
+}
+
+void
+LogBinarySetNodeSource (LogBinaryNodeSource ns)
+{
+  g_nodeSource = ns;
+}
+
+void
+LogBinaryEnable (const std::string &filename)
+{
+  LogBinaryDisable ();
+  GetWriter ()->Open (filename);
+  g_enabled = true;
+}
+
+void
+LogBinaryDisable (void)
+{
+  if (!g_enabled)
+    {
+      return;
+    }
+  // The records buffered by all the threads are submitted before the
+  // file is closed.  A record completed by another thread from now on
+  // is dropped.
+  g_enabled = false;
+  LogBinaryThreadState *self = GetThreadState ();
+  self->busy = true;
+  {
+    LogBinaryThreadList *list = GetThreadList ();
+    std::lock_guard<std::mutex> guard (list->lock);
+    for (std::set<LogBinaryThreadState *>::iterator i = list->states.begin ();
+         i != list->states.end (); ++i)
+      {
+        std::lock_guard<std::mutex> stateGuard ((*i)->lock);
+        (*i)->Submit ();
+      }
+  }
+  GetWriter ()->Close ();
+  self->busy = false;
+}
+
+bool
+LogBinaryIsEnabled (void)
+{
+  return g_enabled && !GetThreadState ()->busy;
+}
+
+std::ostream &
+LogBinaryBegin (void)
+{
+  LogBinaryThreadState *state = GetThreadState ();
+  if (state->depth == state->texts.size ())
+    {
+      state->texts.push_back (new LogBinaryText);
+    }
+  LogBinaryText *record = state->texts[state->depth++];
+  record->text.str (std::string ());
+  record->text.clear ();
+  record->contextEnd = 0;
+  // The NS_LOG_APPEND_CONTEXT definitions which write to std::clog are
+  // recorded too: std::clog writes to the record until the end of the
+  // context.
+  record->clogBuffer = std::clog.rdbuf (record->text.rdbuf ());
+  return record->text;
+}
+
+void
+LogBinaryContextEnd (void)
+{
+  LogBinaryThreadState *state = GetThreadState ();
+  LogBinaryText *record = state->texts[state->depth - 1];
+  std::clog.rdbuf (record->clogBuffer);
+  std::streampos end = record->text.tellp ();
+  record->contextEnd = end > 0 ? static_cast<std::size_t> (end) : 0;
+}
+
+std::ostream &
+LogContextStream (void)
+{
+  LogBinaryThreadState *state = GetThreadState ();
+  if (state->depth == 0 || state->busy)
+    {
+      return std::clog;
+    }
+  return state->texts[state->depth - 1]->text;
+}
+
+void
+LogBinaryEnd (const LogComponent &component, enum LogLevel level,
+              char const *function, enum LogBinaryKind kind)
+{
+  LogBinaryThreadState *state = GetThreadState ();
+  LogBinaryText *record = state->texts[--state->depth];
+  std::string text = record->text.str ();
+  std::size_t contextEnd = record->contextEnd;
+  state->busy = true;
+
+  if (!state->registered)
+    {
+      LogBinaryThreadList *list = GetThreadList ();
+      std::lock_guard<std::mutex> guard (list->lock);
+      list->states.insert (state);
+      state->registered = true;
+    }
+  std::lock_guard<std::mutex> guard (state->lock);
+  if (!g_enabled)
+    {
+      // LogBinaryDisable was called by another thread.
+      state->busy = false;
+      return;
+    }
+
+  LogBinaryWriter *writer = GetWriter ();
+  if (state->generation != writer->GetGeneration ())
+    {
+      // The buffer and the site definitions belong to a previous file.
+      delete state->chunk;
+      state->chunk = 0;
+      state->sites.clear ();
+      state->generation = writer->GetGeneration ();
+    }
+  if (state->chunk == 0)
+    {
+      state->chunk = writer->Allocate ();
+    }
+
+  std::vector<char> *chunk = state->chunk;
+  std::pair<const LogComponent *, char const *> key (&component, function);
+  std::map<std::pair<const LogComponent *, char const *>, uint32_t>::const_iterator i = state->sites.find (key);
+  uint32_t site;
+  if (i == state->sites.end ())
+    {
+      site = writer->GetSiteId (&component, function);
+      state->sites[key] = site;
+      Append<uint8_t> (chunk, SITE_RECORD);
+      Append<uint32_t> (chunk, site);
+      AppendString (chunk, component.Name ());
+      AppendString (chunk, function);
+    }
+  else
+    {
+      site = i->second;
+    }
+
+  uint8_t flags = 0;
+  flags |= component.IsEnabled (LOG_PREFIX_FUNC) ? FLAG_PREFIX_FUNC : 0;
+  flags |= component.IsEnabled (LOG_PREFIX_TIME) ? FLAG_PREFIX_TIME : 0;
+  flags |= component.IsEnabled (LOG_PREFIX_NODE) ? FLAG_PREFIX_NODE : 0;
+  flags |= component.IsEnabled (LOG_PREFIX_LEVEL) ? FLAG_PREFIX_LEVEL : 0;
+  int64_t time = 0;
+  if ((flags & FLAG_PREFIX_TIME) && g_timeSource != 0)
+    {
+      time = (*g_timeSource)();
+      flags |= FLAG_HAS_TIME;
+    }
+  uint32_t node = 0;
+  if ((flags & FLAG_PREFIX_NODE) && g_nodeSource != 0)
+    {
+      node = (*g_nodeSource)();
+      flags |= FLAG_HAS_NODE;
+    }
+
+  Append<uint8_t> (chunk, LOG_RECORD);
+  Append<uint8_t> (chunk, kind);
+  Append<uint8_t> (chunk, flags);
+  Append<uint32_t> (chunk, level);
+  Append<uint32_t> (chunk, site);
+  Append<int64_t> (chunk, time);
+  Append<uint32_t> (chunk, node);
+  Append<uint32_t> (chunk, contextEnd);
+  Append<uint32_t> (chunk, text.size () - contextEnd);
+  chunk->insert (chunk->end (), text.begin (), text.end ());
+
+  if (chunk->size () >= CHUNK_SIZE)
+    {
+      state->chunk = 0;
+      writer->Submit (chunk);
+    }
+  state->busy = false;
+}
+
+void
+LogBinaryFlush (void)
+{
+  if (!g_enabled)
+    {
+      return;
+    }
+  LogBinaryThreadState *state = GetThreadState ();
+  state->busy = true;
+  {
+    std::lock_guard<std::mutex> guard (state->lock);
+    state->Submit ();
+  }
+  GetWriter ()->Wait ();
+  state->busy = false;
+}
+
+bool
+LogBinaryDecode (std::istream &is, std::ostream &os)
+{
+  char magic[sizeof (g_magic)];
+  is.read (magic, sizeof (magic));
+  if (!is.good () || std::memcmp (magic, g_magic, sizeof (g_magic)) != 0)
+    {
+      return false;
+    }
+  std::map<uint32_t, std::pair<std::string, std::string> > sites;
+  while (true)
+    {
+      uint8_t type;
+      if (!Read (is, &type))
+        {
+          // end of file.
+          return true;
+        }
+      if (type == SITE_RECORD)
+        {
+          uint32_t id;
+          uint16_t length;
+          std::string component, function;
+          if (!Read (is, &id)
+              || !Read (is, &length) || !ReadString (is, length, &component)
+              || !Read (is, &length) || !ReadString (is, length, &function))
+            {
+              return false;
+            }
+          sites[id] = std::make_pair (component, function);
+          continue;
+        }
+      if (type != LOG_RECORD)
+        {
+          return false;
+        }
+      uint8_t kind, flags;
+      uint32_t level, site, node, contextLength, messageLength;
+      int64_t time;
+      std::string context, message;
+      if (!Read (is, &kind) || !Read (is, &flags) || !Read (is, &level)
+          || !Read (is, &site) || !Read (is, &time) || !Read (is, &node)
+          || !Read (is, &contextLength) || !Read (is, &messageLength)
+          || !ReadString (is, contextLength, &context)
+          || !ReadString (is, messageLength, &message))
+        {
+          return false;
+        }
+      std::map<uint32_t, std::pair<std::string, std::string> >::const_iterator i = sites.find (site);
+      if (i == sites.end ())
+        {
+          return false;
+        }
+
+      // Same layout as the NS_LOG macros of log-macros-enabled.h,
+      // with the default LogTimePrinter and LogNodePrinter.
+      if (flags & FLAG_HAS_TIME)
+        {
+          os << time / 1e9 << "s ";
+        }
+      if (flags & FLAG_HAS_NODE)
+        {
+          if (node == 0xffffffff)
+            {
+              os << "-1 ";
+            }
+          else
+            {
+              os << node << " ";
+            }
+        }
+      os << context;
+      if (kind == LOG_BINARY_FUNCTION)
+        {
+          os << i->second.first << ":" << i->second.second
+             << "(" << message << ")" << std::endl;
+          continue;
+        }
+      if (flags & FLAG_PREFIX_FUNC)
+        {
+          os << i->second.first << ":" << i->second.second << "(): ";
+        }
+      if (flags & FLAG_PREFIX_LEVEL)
+        {
+          os << "[" << LogComponent::GetLevelLabel ((enum LogLevel)level) << "] ";
+        }
+      os << message << std::endl;
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,202 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NS3_LOG_BINARY_H
+#define NS3_LOG_BINARY_H
+
+#include <string>
+#include <iostream>
+#include <stdint.h>
+
+#include "log.h"
+
+/**
+ * \file
+ * \ingroup logging
+ * Asynchronous binary backend of the NS_LOG macros.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup logging
+ * \defgroup logbinary Binary logging
+ *
+ * When the binary backend is enabled, the NS_LOG_ERROR, NS_LOG_WARN,
+ * NS_LOG_DEBUG, NS_LOG_INFO, NS_LOG_LOGIC and NS_LOG_FUNCTION macros
+ * no longer write to \c std::clog.  Each message is instead stored as a
+ * compact record holding the log site (component and function), the
+ * level, the enabled prefixes, the raw simulation time and node id,
+ * and the text of the message and of NS_LOG_APPEND_CONTEXT.  The
+ * prefixes are not formatted at all while the simulation runs.
+ *
+ * The text is streamed to a stream of the logging thread.
+ * NS_LOG_APPEND_CONTEXT may write to LogContextStream() or to
+ * \c std::clog: \c std::clog is redirected to the record while the
+ * context is appended, and only then.
+ *
+ * Records are appended to a buffer owned by the logging thread.  Full
+ * buffers are handed to a background thread which writes them to the
+ * log file, so the simulation thread never waits on the file system
+ * unless the writer falls behind by more than a bounded number of
+ * buffers.  Without thread support the buffers are written
+ * synchronously when they fill up.
+ *
+ * The backend is enabled with LogBinaryEnable() or by setting the
+ * \c NS_LOG_BINARY environment variable to the name of the log file,
+ * along with the usual \c NS_LOG variable to select the components:
+ * \code
+ *   $ NS_LOG="TcpSocketBase=level_all|prefix_all" NS_LOG_BINARY=tcp.nslog ./waf --run tcp-bulk-send
+ *   $ ./waf --run "decode-binary-log --file=tcp.nslog"
+ * \endcode
+ * LogBinaryDecode(), used by the \c decode-binary-log utility,
+ * renders the records in the text format of the synchronous backend,
+ * except that the simulation time is always printed in seconds and
+ * the node id is the simulation context, as with the default
+ * LogTimePrinter and LogNodePrinter.
+ *
+ * NS_LOG_UNCOND is not affected by the binary backend.
+ */
+
+/**
+ * \ingroup logbinary
+ * The kind of a binary log record, which selects its text rendering.
+ */
+enum LogBinaryKind {
+  LOG_BINARY_MESSAGE  = 0,  //!< NS_LOG_ERROR, NS_LOG_WARN, etc.
+  LOG_BINARY_FUNCTION = 1   //!< NS_LOG_FUNCTION and NS_LOG_FUNCTION_NOARGS.
+};
+
+/**
+ * \ingroup logbinary
+ * Function signature for the raw simulation time of a log record.
+ *
+ * \returns The current simulation time, in nanoseconds.
+ */
+typedef int64_t (*LogBinaryTimeSource)(void);
+/**
+ * \ingroup logbinary
+ * Function signature for the raw node id of a log record.
+ *
+ * \returns The current simulation context.
+ */
+typedef uint32_t (*LogBinaryNodeSource)(void);
+
+/**
+ * \ingroup logbinary
+ * Set the function providing the time of binary log records.
+ *
+ * \param [in] ts The LogBinaryTimeSource function, or 0 if there is
+ *            no simulation time.
+ */
+void LogBinarySetTimeSource (LogBinaryTimeSource ts);
+/**
+ * \ingroup logbinary
+ * Set the function providing the node id of binary log records.
+ *
+ * \param [in] ns The LogBinaryNodeSource function, or 0 if there is
+ *            no simulation context.
+ */
+void LogBinarySetNodeSource (LogBinaryNodeSource ns);
+
+/**
+ * \ingroup logbinary
+ * Send the output of the NS_LOG macros to a binary log file.
+ *
+ * If the binary backend was already enabled, the previous log file
+ * is flushed and closed first.
+ *
+ * \param [in] filename The name of the binary log file.
+ */
+void LogBinaryEnable (const std::string &filename);
+/**
+ * \ingroup logbinary
+ * Flush and close the binary log file, and send the output of the
+ * NS_LOG macros back to \c std::clog.  The records buffered by every
+ * thread are written before the file is closed.
+ */
+void LogBinaryDisable (void);
+/**
+ * \ingroup logbinary
+ * Check if the NS_LOG macros of the calling thread use the binary
+ * backend.
+ *
+ * \returns \c true if log messages are recorded in binary form.
+ */
+bool LogBinaryIsEnabled (void);
+
+/**
+ * \ingroup logbinary
+ * Start a binary log record.
+ *
+ * The NS_LOG macros stream the text of NS_LOG_APPEND_CONTEXT and of
+ * the message to the returned stream, which belongs to the calling
+ * thread.  Must be followed by LogBinaryContextEnd() and
+ * LogBinaryEnd().
+ *
+ * The message may call code which logs in turn: each nested record
+ * gets a stream of its own, and is completed before the enclosing one.
+ *
+ * \returns The stream of the record.
+ */
+std::ostream & LogBinaryBegin (void);
+/**
+ * \ingroup logbinary
+ * Mark the end of the NS_LOG_APPEND_CONTEXT text of the current
+ * binary log record.
+ */
+void LogBinaryContextEnd (void);
+/**
+ * \ingroup logbinary
+ * Complete the current binary log record.
+ *
+ * \param [in] component The LogComponent of the log site.
+ * \param [in] level The level of the message.
+ * \param [in] function The name of the function of the log site.
+ *            It must be a string with static storage duration,
+ *            such as \c __FUNCTION__.
+ * \param [in] kind The kind of record.
+ */
+void LogBinaryEnd (const LogComponent &component, enum LogLevel level,
+                   char const *function, enum LogBinaryKind kind);
+/**
+ * \ingroup logbinary
+ * Get the stream NS_LOG_APPEND_CONTEXT writes to.
+ *
+ * \returns The stream of the binary log record being built by the
+ *          calling thread, if any, and \c std::clog otherwise.
+ */
+std::ostream & LogContextStream (void);
+/**
+ * \ingroup logbinary
+ * Write the records buffered by the calling thread to the log file
+ * and wait until all the records queued so far have been written.
+ */
+void LogBinaryFlush (void);
+
+/**
+ * \ingroup logbinary
+ * Render a binary log file as text.
+ *
+ * \param [in] is The binary log.
+ * \param [in,out] os The output stream to print the text on.
+ * \returns \c false if the input is not a valid binary log.
+ */
+bool LogBinaryDecode (std::istream &is, std::ostream &os);
+
+} // namespace ns3
+
+#endif /* NS3_LOG_BINARY_H */
@@ -97,14 +97,17 @@
  * MPI rank) to a log message.
  *
  * This is implemented locally in `.cc` files because
- * the relevant variable is only known there.
+ * the relevant variable is only known there.  It writes to
+ * ns3::LogContextStream(), which is \c std::clog or, with the binary
+ * backend, the record of the message.  Definitions which write to
+ * \c std::clog are recorded by the binary backend as well.
  *
  * Preferred format is something like (assuming the node id is
  * accessible from `var`:
  * \code
  *   if (var)
  *     {
- *       std::clog << "[node " << var->GetObject<Node> ()->GetId () << "] ";
+ *       ns3::LogContextStream () << "[node " << var->GetObject<Node> ()->GetId () << "] ";
  *     }
  * \endcode
  */
@@ -155,6 +158,16 @@
     {                                                           \
       if (g_log.IsEnabled (level))                              \
         {                                                       \
+          if (ns3::LogBinaryIsEnabled ())                       \
+            {                                                   \
+              std::ostream &ns3LogOs = ns3::LogBinaryBegin ();  \
+              NS_LOG_APPEND_CONTEXT;                            \
+              ns3::LogBinaryContextEnd ();                      \
+              ns3LogOs << msg;                                  \
+              ns3::LogBinaryEnd (g_log, level, __FUNCTION__,    \
+                                 ns3::LOG_BINARY_MESSAGE);      \
+              break;                                            \
+            }                                                   \
           NS_LOG_APPEND_TIME_PREFIX;                            \
           NS_LOG_APPEND_NODE_PREFIX;                            \
           NS_LOG_APPEND_CONTEXT;                                \
@@ -179,6 +192,16 @@
     {                                                           \
       if (g_log.IsEnabled (ns3::LOG_FUNCTION))                  \
         {                                                       \
+          if (ns3::LogBinaryIsEnabled ())                       \
+            {                                                   \
+              ns3::LogBinaryBegin ();                           \
+              NS_LOG_APPEND_CONTEXT;                            \
+              ns3::LogBinaryContextEnd ();                      \
+              ns3::LogBinaryEnd (g_log, ns3::LOG_FUNCTION,      \
+                                 __FUNCTION__,                  \
+                                 ns3::LOG_BINARY_FUNCTION);     \
+              break;                                            \
+            }                                                   \
           NS_LOG_APPEND_TIME_PREFIX;                            \
           NS_LOG_APPEND_NODE_PREFIX;                            \
           NS_LOG_APPEND_CONTEXT;                                \
@@ -216,6 +239,17 @@
     {                                                           \
       if (g_log.IsEnabled (ns3::LOG_FUNCTION))                  \
         {                                                       \
+          if (ns3::LogBinaryIsEnabled ())                       \
+            {                                                   \
+              std::ostream &ns3LogOs = ns3::LogBinaryBegin ();  \
+              NS_LOG_APPEND_CONTEXT;                            \
+              ns3::LogBinaryContextEnd ();                      \
+              ns3::ParameterLogger (ns3LogOs) << parameters;    \
+              ns3::LogBinaryEnd (g_log, ns3::LOG_FUNCTION,      \
+                                 __FUNCTION__,                  \
+                                 ns3::LOG_BINARY_FUNCTION);     \
+              break;                                            \
+            }                                                   \
           NS_LOG_APPEND_TIME_PREFIX;                            \
           NS_LOG_APPEND_NODE_PREFIX;                            \
           NS_LOG_APPEND_CONTEXT;                                \
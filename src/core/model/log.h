@@ -475,4 +475,7 @@ ParameterLogger::operator<< <const char *>(const char * param);
 
 /**@}*/  // \ingroup logging
 
+// The binary backend, used by the NS_LOG macros.
+#include "log-binary.h"
+
 #endif /* NS3_LOG_H */
@@ -46,6 +46,54 @@ NS_LOG_COMPONENT_DEFINE ("Object");
 
 NS_OBJECT_ENSURE_REGISTERED (Object);
 
+/**
+ * The cache is a small open-addressing hash table indexed by the
+ * TypeId uid of the lookup.  A slot stores the result of a previous
+ * lookup, including unsuccessful ones (a null Object) and matches
+ * on a parent TypeId of the aggregated Object.  The uid 0 is never
+ * allocated to a TypeId so it marks the empty slots.
+ */
+struct Object::LookupCache
+{
+  /** The number of slots: must be a power of two. */
+  static const uint32_t SIZE = 32;
+  /** The TypeId uid of the lookup stored in each slot. */
+  uint16_t uid[SIZE];
+  /** The result of the lookup stored in each slot. */
+  Object *object[SIZE];
+
+  /**
+   * Find the slot of a TypeId uid.
+   *
+   * Slots are never removed individually, so the probe sequence
+   * of a uid ends at its slot or at the first empty slot.
+   *
+   * \param [in] id The TypeId uid to look for.
+   * \param [out] found Set to \c true if the slot holds \p id.
+   * \return The slot holding \p id or the empty slot where it
+   *          should be stored, or SIZE if the cache is full.
+   */
+  uint32_t Find (uint16_t id, bool *found) const
+  {
+    for (uint32_t probe = 0; probe < SIZE; probe++)
+      {
+        uint32_t slot = (id + probe) & (SIZE - 1);
+        if (uid[slot] == id)
+          {
+            *found = true;
+            return slot;
+          }
+        if (uid[slot] == 0)
+          {
+            *found = false;
+            return slot;
+          }
+      }
+    *found = false;
+    return SIZE;
+  }
+};
+
 Object::AggregateIterator::AggregateIterator ()
   : m_object (0),
     m_current (0)
@@ -102,6 +150,7 @@ Object::Object ()
 {
   NS_LOG_FUNCTION (this);
   m_aggregates->n = 1;
+  m_aggregates->cache = 0;
   m_aggregates->buffer[0] = this;
 }
 Object::~Object () 
@@ -120,6 +169,9 @@ Object::~Object ()
           m_aggregates->n--;
         }
     }
+  // the cache might point to this object so it must be discarded
+  std::free (m_aggregates->cache);
+  m_aggregates->cache = 0;
   // finally, if all objects have been removed from the list,
   // delete the aggregate list
   if (m_aggregates->n == 0)
@@ -136,6 +188,7 @@ Object::Object (const Object &o)
     m_getObjectCount (0)
 {
   m_aggregates->n = 1;
+  m_aggregates->cache = 0;
   m_aggregates->buffer[0] = this;
 }
 void
@@ -151,6 +204,45 @@ Object::DoGetObject (TypeId tid) const
   NS_LOG_FUNCTION (this << tid);
   NS_ASSERT (CheckLoose ());
 
+  if (m_aggregates->cache == 0)
+    {
+      m_aggregates->cache = (struct LookupCache *) std::calloc (1, sizeof (struct LookupCache));
+    }
+  struct LookupCache *cache = m_aggregates->cache;
+  bool found;
+  uint32_t slot = cache->Find (tid.GetUid (), &found);
+  if (found)
+    {
+      return const_cast<Object *> (cache->object[slot]);
+    }
+
+  uint32_t i = DoFindObject (tid);
+  Object *current = (i < m_aggregates->n) ? m_aggregates->buffer[i] : 0;
+  if (slot < LookupCache::SIZE)
+    {
+      cache->uid[slot] = tid.GetUid ();
+      cache->object[slot] = current;
+    }
+  if (current != 0)
+    {
+      // The aggregate array is sorted by the number of cache misses
+      // of each object so that the dynamic_cast fast path of
+      // GetObject<T> is likely to hit the object that was requested
+      // through the largest number of TypeIds.  The cache stores
+      // objects, not indexes, so it is not affected by the sort.
+
+      // first, increment the access count
+      current->m_getObjectCount++;
+      // then, update the sort
+      UpdateSortedArray (m_aggregates, i);
+    }
+  // finally, return the match
+  return const_cast<Object *> (current);
+}
+uint32_t
+Object::DoFindObject (TypeId tid) const
+{
+  NS_LOG_FUNCTION (this << tid);
   uint32_t n = m_aggregates->n;
   TypeId objectTid = Object::GetTypeId ();
   for (uint32_t i = 0; i < n; i++)
@@ -163,21 +255,10 @@ Object::DoGetObject (TypeId tid) const
         }
       if (cur == tid)
         {
-          // This is an attempt to 'cache' the result of this lookup.
-          // the idea is that if we perform a lookup for a TypeId on this object,
-          // we are likely to perform the same lookup later so, we make sure
-          // that the aggregate array is sorted by the number of accesses
-          // to each object.
-
-          // first, increment the access count
-          current->m_getObjectCount++;
-          // then, update the sort
-          UpdateSortedArray (m_aggregates, i);
-          // finally, return the match
-          return const_cast<Object *> (current);
+          return i;
         }
     }
-  return 0;
+  return n;
 }
 void
 Object::Initialize (void)
@@ -263,6 +344,7 @@ Object::AggregateObject (Ptr<Object> o)
   struct Aggregates *aggregates = 
     (struct Aggregates *)std::malloc (sizeof(struct Aggregates)+(total-1)*sizeof(Object*));
   aggregates->n = total;
+  aggregates->cache = 0;
 
   // copy our buffer to the new buffer
   std::memcpy (&aggregates->buffer[0], 
@@ -314,7 +396,9 @@ Object::AggregateObject (Ptr<Object> o)
     }
 
   // Now that we are done with them, we can free our old aggregate buffers
+  std::free (a->cache);
   std::free (a);
+  std::free (b->cache);
   std::free (b);
 }
 /**
@@ -323,6 +323,9 @@ private:
   friend class AggregateIterator;
   friend struct ObjectDeleter;
 
+  /** Open-addressing table of TypeId uid to aggregated Object. */
+  struct LookupCache;
+
   /**
    * The list of Objects aggregated to this one.
    *
@@ -338,6 +341,12 @@ private:
   struct Aggregates {
     /** The number of entries in \c buffer. */
     uint32_t n;
+    /**
+     * The lookup cache of DoGetObject(), allocated lazily on the
+     * first lookup, and discarded whenever the set of aggregated
+     * Objects changes.
+     */
+    struct LookupCache *cache;
     /** The array of Objects. */
     Object *buffer[1];
   };
@@ -345,10 +354,24 @@ private:
   /**
    * Find an Object of TypeId tid in the aggregates of this Object.
    *
+   * Lookups are memoized per TypeId in the shared LookupCache of the
+   * aggregate, so that repeated requests for the same TypeId, whether
+   * an exact match or a parent of the aggregated Object, cost a single
+   * hash probe instead of a scan of the aggregates and of their
+   * TypeId hierarchy.
+   *
    * \param [in] tid The TypeId we're looking for
    * \return The matching Object, if it is found
    */
   Ptr<Object> DoGetObject (TypeId tid) const;
+  /**
+   * Scan the aggregates for an Object of TypeId tid, bypassing the cache.
+   *
+   * \param [in] tid The TypeId we're looking for
+   * \return The index of the matching Object in the aggregate buffer,
+   *          or the number of aggregates if it was not found.
+   */
+  uint32_t DoFindObject (TypeId tid) const;
   /**
    * Verify that this Object is still live, by checking it's reference count.
    * \return \c true if the reference count is non zero.
@@ -429,7 +452,7 @@ private:
   struct Aggregates * m_aggregates;
   /**
    * The number of times the Object was accessed with a
-   * call to GetObject().
+   * call to GetObject() which missed the lookup cache.
    *
    * This integer is used to implement a heuristic to sort
    * the array of aggregates in most-frequently accessed order.
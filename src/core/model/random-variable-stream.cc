@@ -137,6 +137,16 @@ RandomVariableStream::Peek(void) const
   return m_rng;
 }
 
+void
+RandomVariableStream::GetValues (double *values, uint32_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      values[i] = GetValue ();
+    }
+}
+
 NS_OBJECT_ENSURE_REGISTERED(UniformRandomVariable);
 
 TypeId 
@@ -207,6 +217,29 @@ UniformRandomVariable::GetInteger (void)
   NS_LOG_FUNCTION (this);
   return (uint32_t)GetValue (m_min, m_max + 1);
 }
+void
+UniformRandomVariable::GetValues (double *values, uint32_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  Peek ()->RandU01 (values, n);
+  double min = m_min;
+  double max = m_max;
+  if (IsAntithetic ())
+    {
+      for (uint32_t i = 0; i < n; i++)
+        {
+          double v = min + values[i] * (max - min);
+          values[i] = min + (max - v);
+        }
+    }
+  else
+    {
+      for (uint32_t i = 0; i < n; i++)
+        {
+          values[i] = min + values[i] * (max - min);
+        }
+    }
+}
 
 NS_OBJECT_ENSURE_REGISTERED(ConstantRandomVariable);
 
@@ -438,6 +471,25 @@ ExponentialRandomVariable::GetValue (void)
   NS_LOG_FUNCTION (this);
   return GetValue (m_mean, m_bound);
 }
+void
+ExponentialRandomVariable::GetValues (double *values, uint32_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  if (m_bound != 0)
+    {
+      // The rejection of values above the bound consumes a variable
+      // number of uniform values, so they cannot be drawn in advance.
+      RandomVariableStream::GetValues (values, n);
+      return;
+    }
+  Peek ()->RandU01 (values, n);
+  bool antithetic = IsAntithetic ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      double v = antithetic ? (1 - values[i]) : values[i];
+      values[i] = -m_mean * std::log (v);
+    }
+}
 uint32_t 
 ExponentialRandomVariable::GetInteger (void)
 {
@@ -149,6 +149,20 @@ public:
    */
   virtual uint32_t GetInteger (void) = 0;
 
+  /**
+   * \brief Get the next \p n random values drawn from the distribution.
+   *
+   * The values are the same, and drawn in the same order, as the
+   * ones which \p n successive calls to GetValue(void) would return,
+   * so mixing the two methods does not change the stream.
+   * Subclasses override this method to generate and transform
+   * the values in blocks.
+   *
+   * \param [out] values The array to fill.
+   * \param [in] n The number of values to draw.
+   */
+  virtual void GetValues (double *values, uint32_t n);
+
 protected:
   /**
    * \brief Get the pointer to the underlying RNG stream.
@@ -293,6 +307,11 @@ public:
    * \note The upper limit is included in the output range.
    */
   virtual uint32_t GetInteger (void);
+  /**
+   * \copydoc RandomVariableStream::GetValues
+   * \note The upper limit is excluded from the output range.
+   */
+  virtual void GetValues (double *values, uint32_t n);
   
 private:
   /** The lower bound on values that can be returned by this RNG stream. */
@@ -585,6 +604,7 @@ public:
   // Inherited from RandomVariableStream
   virtual double GetValue (void);
   virtual uint32_t GetInteger (void);
+  virtual void GetValues (double *values, uint32_t n);
 
 private:
   /** The mean value of the unbounded exponential distribution. */
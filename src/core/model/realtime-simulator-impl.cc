@@ -31,9 +31,11 @@
 #include "system-mutex.h"
 #include "boolean.h"
 #include "enum.h"
+#include "trace-source-accessor.h"
 
 
 #include <cmath>
+#include <algorithm>
 
 
 /**
@@ -69,6 +71,17 @@ RealtimeSimulatorImpl::GetTypeId (void)
                    TimeValue (Seconds (0.1)),
                    MakeTimeAccessor (&RealtimeSimulatorImpl::m_hardLimit),
                    MakeTimeChecker ())
+    .AddAttribute ("LockFreeInjection",
+                   "Let threads other than the main thread schedule events "
+                   "without locking the event list.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RealtimeSimulatorImpl::m_lockFreeInjection),
+                   MakeBooleanChecker ())
+    .AddTraceSource ("EventLateness",
+                     "The real time elapsed between the timestamp of an event "
+                     "and the start of its execution.",
+                     MakeTraceSourceAccessor (&RealtimeSimulatorImpl::m_latenessTrace),
+                     "ns3::RealtimeSimulatorImpl::LatenessTracedCallback")
   ;
   return tid;
 }
@@ -89,10 +102,15 @@ RealtimeSimulatorImpl::RealtimeSimulatorImpl ()
   m_currentUid = 0;
   m_currentTs = 0;
   m_currentContext = Simulator::NO_CONTEXT;
+  m_eventCount = 0;
   m_unscheduledEvents = 0;
 
   m_main = SystemThread::Self();
 
+  m_lockFreeInjection = false;
+  m_injected = 0;
+  ResetLatenessStatistics ();
+
   // Be very careful not to do anything that would cause a change or assignment
   // of the underlying reference counts of m_synchronizer or you will be sorry.
   m_synchronizer = CreateObject<WallClockSynchronizer> ();
@@ -112,6 +130,14 @@ RealtimeSimulatorImpl::DoDispose (void)
       Scheduler::Event next = m_events->RemoveNext ();
       next.impl->Unref ();
     }
+  InjectedEvent *injected = m_injected.exchange (0);
+  while (injected != 0)
+    {
+      InjectedEvent *next = injected->next;
+      injected->impl->Unref ();
+      delete injected;
+      injected = next;
+    }
   m_events = 0;
   m_synchronizer = 0;
   SimulatorImpl::DoDispose ();
@@ -208,6 +234,16 @@ RealtimeSimulatorImpl::ProcessOneEvent (void)
 
       { 
         CriticalSection cs (m_mutex);
+
+        //
+        // This resets the synchronizer so that any future event will cause it
+        // to interrupt the wait below.  It must be done before the injected
+        // events are merged, since an injecting thread only signals the
+        // synchronizer when it finds the injection list empty.
+        //
+        m_synchronizer->SetCondition (false);
+        MergeInjected ();
+
         //
         // Since we are in realtime mode, the time to delay has got to be the 
         // difference between the current realtime and the timestamp of the next 
@@ -253,10 +289,9 @@ RealtimeSimulatorImpl::ProcessOneEvent (void)
         // We've figured out how long we need to delay in order to pace the 
         // simulation time with the real time.  We're going to sleep, but need
         // to work with the synchronizer to make sure we're awakened if something 
-        // external happens (like a packet is received).  This next line resets
-        // the synchronizer so that any future event will cause it to interrupt.
+        // external happens (like a packet is received).  The synchronizer was
+        // reset at the start of this critical section for that purpose.
         //
-        m_synchronizer->SetCondition (false);
       }
 
       //
@@ -272,7 +307,7 @@ RealtimeSimulatorImpl::ProcessOneEvent (void)
       // requires a SpinWait down in the synchronizer.  What will happen is that 
       // whan Synchronize calls SpinWait, SpinWait will look directly at its 
       // condition variable.  Note that we set this condition variable to false 
-      // inside the critical section above. 
+      // inside the critical section above.
       //
       // SpinWait will go into a forever loop until either the time has expired or
       // until the condition variable becomes true.  A true condition indicates that
@@ -316,6 +351,7 @@ RealtimeSimulatorImpl::ProcessOneEvent (void)
   // whatever event is at the head of this list if the list is in time order.
   //
   Scheduler::Event next;
+  uint64_t tsLate;
 
   { 
     CriticalSection cs (m_mutex);
@@ -326,6 +362,7 @@ RealtimeSimulatorImpl::ProcessOneEvent (void)
     // event we're working on won't be on the list and so subsequent operations won't
     // mess with us.
     //
+    MergeInjected ();
     NS_ASSERT_MSG (m_events->IsEmpty () == false, 
                    "RealtimeSimulatorImpl::ProcessOneEvent(): event queue is empty");
     next = m_events->RemoveNext ();
@@ -349,6 +386,7 @@ RealtimeSimulatorImpl::ProcessOneEvent (void)
     m_currentTs = next.key.m_ts;
     m_currentContext = next.key.m_context;
     m_currentUid = next.key.m_uid;
+    m_eventCount++;
 
     // 
     // We're about to run the event and we've done our best to synchronize this
@@ -357,11 +395,14 @@ RealtimeSimulatorImpl::ProcessOneEvent (void)
     // been asked to commit ritual suicide.
     //
     // We check the simulation time against the current real time to make this
-    // judgement.
+    // judgement.  The same comparison gives the lateness statistics.
     //
+    uint64_t tsFinal = m_synchronizer->GetCurrentRealtime ();
+    tsLate = tsFinal > m_currentTs ? tsFinal - m_currentTs : 0;
+    RecordLateness (tsLate);
+
     if (m_synchronizationMode == SYNC_HARD_LIMIT)
       {
-        uint64_t tsFinal = m_synchronizer->GetCurrentRealtime ();
         uint64_t tsJitter;
 
         if (tsFinal >= m_currentTs)
@@ -386,6 +427,7 @@ RealtimeSimulatorImpl::ProcessOneEvent (void)
   // event list so we can execute it outside a critical section without fear of someone
   // changing things out from under us.
 
+  m_latenessTrace (TimeStep (tsLate));
   EventImpl *event = next.impl;
   m_synchronizer->EventStart ();
   event->Invoke ();
@@ -442,6 +484,8 @@ RealtimeSimulatorImpl::Run (void)
       {
         CriticalSection cs (m_mutex);
 
+        m_synchronizer->SetCondition (false);
+        MergeInjected ();
         if (!m_events->IsEmpty ())
           {
             process = true;
@@ -543,6 +587,12 @@ RealtimeSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay,
 {
   NS_LOG_FUNCTION (this << context << delay << impl);
 
+  if (UseInjection ())
+    {
+      Inject (m_synchronizer->GetCurrentRealtime () + delay.GetTimeStep (), context, impl);
+      return;
+    }
+
   {
     CriticalSection cs (m_mutex);
     uint64_t ts;
@@ -609,6 +659,12 @@ RealtimeSimulatorImpl::ScheduleRealtimeWithContext (uint32_t context, Time const
 {
   NS_LOG_FUNCTION (this << context << time << impl);
 
+  if (UseInjection ())
+    {
+      Inject (m_synchronizer->GetCurrentRealtime () + time.GetTimeStep (), context, impl);
+      return;
+    }
+
   {
     CriticalSection cs (m_mutex);
 
@@ -636,6 +692,13 @@ void
 RealtimeSimulatorImpl::ScheduleRealtimeNowWithContext (uint32_t context, EventImpl *impl)
 {
   NS_LOG_FUNCTION (this << context << impl);
+
+  if (UseInjection ())
+    {
+      Inject (m_synchronizer->GetCurrentRealtime (), context, impl);
+      return;
+    }
+
   {
     CriticalSection cs (m_mutex);
 
@@ -665,6 +728,113 @@ RealtimeSimulatorImpl::ScheduleRealtimeNow (EventImpl *impl)
   ScheduleRealtimeNowWithContext (GetContext (), impl);
 }
 
+bool
+RealtimeSimulatorImpl::UseInjection (void) const
+{
+  //
+  // The injected events are stamped with the real time of the synchronizer,
+  // which is only meaningful while the simulator runs.  m_currentTs is not
+  // read outside the main thread without the lock.
+  //
+  return m_lockFreeInjection && m_running && !SystemThread::Equals (m_main);
+}
+
+void
+RealtimeSimulatorImpl::Inject (uint64_t ts, uint32_t context, EventImpl *impl)
+{
+  InjectedEvent *injected = new InjectedEvent;
+  injected->impl = impl;
+  injected->ts = ts;
+  injected->context = context;
+  InjectedEvent *head = m_injected.load (std::memory_order_relaxed);
+  do
+    {
+      injected->next = head;
+    }
+  while (!m_injected.compare_exchange_weak (head, injected,
+                                            std::memory_order_release,
+                                            std::memory_order_relaxed));
+  //
+  // Only the first event injected since the last merge needs to wake up
+  // the main thread: the following ones will be merged at the same time.
+  //
+  if (head == 0)
+    {
+      m_synchronizer->Signal ();
+    }
+}
+
+void
+RealtimeSimulatorImpl::MergeInjected (void)
+{
+  InjectedEvent *injected = m_injected.exchange (0, std::memory_order_acquire);
+  if (injected == 0)
+    {
+      return;
+    }
+  // Reverse the list so that uids follow the order of injection.
+  InjectedEvent *fifo = 0;
+  while (injected != 0)
+    {
+      InjectedEvent *next = injected->next;
+      injected->next = fifo;
+      fifo = injected;
+      injected = next;
+    }
+  while (fifo != 0)
+    {
+      Scheduler::Event ev;
+      ev.impl = fifo->impl;
+      // The real time read by the injecting thread may be earlier
+      // than the time of the last event run.  The event is due anyway.
+      ev.key.m_ts = std::max (fifo->ts, m_currentTs);
+      ev.key.m_context = fifo->context;
+      ev.key.m_uid = m_uid;
+      m_uid++;
+      m_unscheduledEvents++;
+      m_events->Insert (ev);
+      InjectedEvent *next = fifo->next;
+      delete fifo;
+      fifo = next;
+    }
+}
+
+void
+RealtimeSimulatorImpl::RecordLateness (uint64_t tsLate)
+{
+  uint64_t us = tsLate / 1000;
+  uint32_t bucket = 0;
+  while (us != 0 && bucket < LATENESS_BUCKETS - 1)
+    {
+      us >>= 1;
+      bucket++;
+    }
+  m_lateness[bucket]++;
+  m_maxLateness = std::max (m_maxLateness, tsLate);
+}
+
+std::vector<uint64_t>
+RealtimeSimulatorImpl::GetLatenessHistogram (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return std::vector<uint64_t> (m_lateness, m_lateness + LATENESS_BUCKETS);
+}
+
+Time
+RealtimeSimulatorImpl::GetMaximumLateness (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return TimeStep (m_maxLateness);
+}
+
+void
+RealtimeSimulatorImpl::ResetLatenessStatistics (void)
+{
+  NS_LOG_FUNCTION (this);
+  std::fill (m_lateness, m_lateness + LATENESS_BUCKETS, 0);
+  m_maxLateness = 0;
+}
+
 Time
 RealtimeSimulatorImpl::RealtimeNow (void) const
 {
@@ -820,6 +990,13 @@ RealtimeSimulatorImpl::GetContext (void) const
   return m_currentContext;
 }
 
+uint64_t
+RealtimeSimulatorImpl::GetEventCount (void) const
+{
+  CriticalSection cs (m_mutex);
+  return m_eventCount;
+}
+
 void 
 RealtimeSimulatorImpl::SetSynchronizationMode (enum SynchronizationMode mode)
 {
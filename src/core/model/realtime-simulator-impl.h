@@ -30,8 +30,12 @@
 #include "assert.h"
 #include "log.h"
 #include "system-mutex.h"
+#include "nstime.h"
+#include "traced-callback.h"
 
 #include <list>
+#include <vector>
+#include <atomic>
 
 /**
  * \file
@@ -52,6 +56,26 @@ namespace ns3 {
  * \ingroup realtime
  *
  * Realtime version of SimulatorImpl.
+ *
+ * Events scheduled by other threads, such as the reader threads of
+ * FdNetDevice and TapBridge, normally take the same mutex as the main
+ * thread.  With the LockFreeInjection attribute set, these events are
+ * instead pushed onto a lock-free list which the main thread merges
+ * into the event list before each wait, so that injection never
+ * blocks the simulation thread.  Combined with the SleepGuard and
+ * YieldGuard attributes of ns3::WallClockSynchronizer, which control
+ * how the synchronizer splits a wait between sleeping, yielding and
+ * spinning, this gives a low-jitter mode:
+ * \code
+ *   Config::SetDefault ("ns3::RealtimeSimulatorImpl::LockFreeInjection", BooleanValue (true));
+ *   Config::SetDefault ("ns3::WallClockSynchronizer::SleepGuard", TimeValue (MicroSeconds (500)));
+ *   Config::SetDefault ("ns3::WallClockSynchronizer::YieldGuard", TimeValue (MicroSeconds (50)));
+ * \endcode
+ *
+ * The lateness of each event, the real time elapsed between its
+ * timestamp and the start of its execution, is reported by the
+ * EventLateness trace source and accumulated in a histogram, see
+ * GetLatenessHistogram().
  */
 class RealtimeSimulatorImpl : public SimulatorImpl
 {
@@ -107,6 +131,7 @@ public:
   virtual void SetScheduler (ObjectFactory schedulerFactory);
   virtual uint32_t GetSystemId (void) const; 
   virtual uint32_t GetContext (void) const;
+  virtual uint64_t GetEventCount (void) const;
 
   /** \copydoc ScheduleWithContext(uint32_t,const Time&,EventImpl*) */
   void ScheduleRealtimeWithContext (uint32_t context, const Time &delay, EventImpl *event);
@@ -154,7 +179,78 @@ public:
    */
   Time GetHardLimit (void) const;
 
+  /** Number of buckets of the lateness histogram. */
+  static const uint32_t LATENESS_BUCKETS = 24;
+  /**
+   * Get the histogram of the lateness of the events executed so far.
+   *
+   * Bucket 0 counts the events which started less than 1 us late,
+   * bucket i counts the events which started between 2^(i-1) and
+   * 2^i us late, and the last bucket also counts all the events
+   * which were later than that.
+   *
+   * The statistics are updated by the main thread, so this should
+   * be called from the main thread or after Run() returned.
+   *
+   * \returns The LATENESS_BUCKETS counters of the histogram.
+   */
+  std::vector<uint64_t> GetLatenessHistogram (void) const;
+  /**
+   * Get the largest lateness of the events executed so far.
+   * \returns The maximum lateness.
+   */
+  Time GetMaximumLateness (void) const;
+  /** Clear the lateness histogram and the maximum lateness. */
+  void ResetLatenessStatistics (void);
+
+  /**
+   * TracedCallback signature for the lateness of an event.
+   *
+   * \param [in] lateness The real time elapsed between the timestamp
+   *            of the event and the start of its execution.
+   */
+  typedef void (* LatenessTracedCallback)(const Time lateness);
+
 private:
+  /**
+   * An event scheduled by another thread than the main thread,
+   * waiting to be merged into the event list.
+   */
+  struct InjectedEvent
+  {
+    EventImpl *impl;       /**< The event. */
+    uint64_t ts;           /**< Timestamp of the event. */
+    uint32_t context;      /**< Context of the event. */
+    InjectedEvent *next;   /**< Next pending event, in LIFO order. */
+  };
+
+  /**
+   * Schedule an event from another thread than the main thread
+   * without taking #m_mutex.
+   *
+   * \param [in] ts The timestamp of the event.
+   * \param [in] context The context of the event.
+   * \param [in] impl The event.
+   */
+  void Inject (uint64_t ts, uint32_t context, EventImpl *impl);
+  /**
+   * Check if the calling thread should use Inject().
+   * \returns \c true if injection is enabled, the simulator runs and
+   *          this is not the main thread.
+   */
+  bool UseInjection (void) const;
+  /**
+   * Move the injected events to the event list.
+   * Must be called by the main thread with #m_mutex locked.
+   */
+  void MergeInjected (void);
+  /**
+   * Account for the lateness of the event about to be executed.
+   *
+   * \param [in] tsLate The lateness of the event.
+   */
+  void RecordLateness (uint64_t tsLate);
+
   /**
    * Is the simulator running?
    * \returns \c true if we are running.
@@ -181,8 +277,11 @@ private:
   DestroyEvents m_destroyEvents;
   /** Has the stopping condition been reached? */
   bool m_stop;
-  /** Is the simulator currently running. */
-  bool m_running;
+  /**
+   * Is the simulator currently running.  Read by the threads which
+   * schedule events, without the lock.
+   */
+  std::atomic<bool> m_running;
 
   /**
    * \name Mutex-protected variables.
@@ -202,6 +301,8 @@ private:
   uint64_t m_currentTs;
   /**< Execution context. */
   uint32_t m_currentContext;  
+  /**< The event count. */
+  uint64_t m_eventCount;
   /**@}*/
 
   /** Mutex to control access to key state. */  
@@ -218,6 +319,18 @@ private:
 
   /** Main SystemThread. */
   SystemThread::ThreadId m_main;
+
+  /** Do other threads inject their events without locking? */
+  bool m_lockFreeInjection;
+  /** Events injected by other threads, most recent first. */
+  std::atomic<InjectedEvent *> m_injected;
+
+  /** The lateness histogram. */
+  uint64_t m_lateness[LATENESS_BUCKETS];
+  /** The largest lateness seen, in time steps. */
+  uint64_t m_maxLateness;
+  /** Trace source for the lateness of each event. */
+  TracedCallback<Time> m_latenessTrace;
 };
 
 } // namespace ns3
@@ -333,40 +333,85 @@ void PowerOfTwoMatrix (int n, Matrix a1p, Matrix a2p)
 
 namespace ns3 {
 //-------------------------------------------------------------------------
-// Generate the next random number.
+// Generate a block of random numbers.
 //
-double RngStream::RandU01 ()
+// The state is kept in local variables for the whole block, so that
+// it can live in registers, and the two components are computed
+// independently of each other, which lets the compiler interleave
+// their (long latency) divisions.
+//
+void RngStream::Generate (double *values, uint32_t n)
 {
-  int32_t k;
-  double p1, p2, u;
-
-  /* Component 1 */
-  p1 = a12 * m_currentState[1] - a13n * m_currentState[0];
-  k = static_cast<int32_t> (p1 / m1);
-  p1 -= k * m1;
-  if (p1 < 0.0)
+  double s10 = m_currentState[0];
+  double s11 = m_currentState[1];
+  double s12 = m_currentState[2];
+  double s20 = m_currentState[3];
+  double s21 = m_currentState[4];
+  double s22 = m_currentState[5];
+
+  for (uint32_t i = 0; i < n; i++)
     {
-      p1 += m1;
+      int32_t k;
+      double p1, p2;
+
+      /* Component 1 */
+      p1 = a12 * s11 - a13n * s10;
+      k = static_cast<int32_t> (p1 / m1);
+      p1 -= k * m1;
+      if (p1 < 0.0)
+        {
+          p1 += m1;
+        }
+      s10 = s11; s11 = s12; s12 = p1;
+
+      /* Component 2 */
+      p2 = a21 * s22 - a23n * s20;
+      k = static_cast<int32_t> (p2 / m2);
+      p2 -= k * m2;
+      if (p2 < 0.0)
+        {
+          p2 += m2;
+        }
+      s20 = s21; s21 = s22; s22 = p2;
+
+      /* Combination */
+      values[i] = ((p1 > p2) ? (p1 - p2) * norm : (p1 - p2 + m1) * norm);
     }
-  m_currentState[0] = m_currentState[1]; m_currentState[1] = m_currentState[2]; m_currentState[2] = p1;
 
-  /* Component 2 */
-  p2 = a21 * m_currentState[5] - a23n * m_currentState[3];
-  k = static_cast<int32_t> (p2 / m2);
-  p2 -= k * m2;
-  if (p2 < 0.0)
+  m_currentState[0] = s10; m_currentState[1] = s11; m_currentState[2] = s12;
+  m_currentState[3] = s20; m_currentState[4] = s21; m_currentState[5] = s22;
+}
+
+double RngStream::Refill (void)
+{
+  if (m_size == 0)
     {
-      p2 += m2;
+      m_size = 1;
     }
-  m_currentState[3] = m_currentState[4]; m_currentState[4] = m_currentState[5]; m_currentState[5] = p2;
-
-  /* Combination */
-  u = ((p1 > p2) ? (p1 - p2) * norm : (p1 - p2 + m1) * norm);
+  else if (m_size < BUFFER_SIZE)
+    {
+      m_size *= 2;
+    }
+  Generate (m_buffer, m_size);
+  m_next = 1;
+  return m_buffer[0];
+}
 
-  return u;
+void RngStream::RandU01 (double *values, uint32_t n)
+{
+  // First hand out the values which were already generated
+  // so that the sequence is not reordered.
+  while (n > 0 && m_next < m_size)
+    {
+      *values++ = m_buffer[m_next++];
+      n--;
+    }
+  Generate (values, n);
 }
 
 RngStream::RngStream (uint32_t seedNumber, uint64_t stream, uint64_t substream)
+  : m_next (0),
+    m_size (0)
 {
   if (seedNumber >= m1 || seedNumber >= m2 || seedNumber == 0)
     {
@@ -381,11 +426,17 @@ RngStream::RngStream (uint32_t seedNumber, uint64_t stream, uint64_t substream)
 }
 
 RngStream::RngStream(const RngStream& r)
+  : m_next (r.m_next),
+    m_size (r.m_size)
 {
   for (int i = 0; i < 6; ++i)
     {
       m_currentState[i] = r.m_currentState[i];
     }
+  for (uint32_t i = m_next; i < m_size; ++i)
+    {
+      m_buffer[i] = r.m_buffer[i];
+    }
 }
 
 void 
@@ -67,11 +67,39 @@ public:
    * Generate the next random number for this stream.
    * Uniformly distributed between 0 and 1.
    *
+   * The numbers are generated in blocks into an internal buffer,
+   * which this method drains.  The sequence of numbers returned
+   * is identical to the one of the unbuffered generator.
+   *
    * \returns The next random.
    */
-  double RandU01 (void);
+  inline double RandU01 (void);
+  /**
+   * Generate the next \p n random numbers for this stream.
+   * Uniformly distributed between 0 and 1.
+   *
+   * This returns the same numbers, in the same order, as \p n
+   * successive calls to RandU01 (void).
+   *
+   * \param [out] values The array to fill.
+   * \param [in] n The number of values to generate.
+   */
+  void RandU01 (double *values, uint32_t n);
 
 private:
+  /**
+   * Refill the internal buffer and return its first number.
+   * \returns The next random.
+   */
+  double Refill (void);
+  /**
+   * Run the MRG32k3a recurrence to generate a block of numbers.
+   *
+   * \param [out] values The array to fill.
+   * \param [in] n The number of values to generate.
+   */
+  void Generate (double *values, uint32_t n);
+
   /**
    * Advance \p state of the RNG by leaps and bounds.
    *
@@ -83,8 +111,33 @@ private:
 
   /** The RNG state vector. */
   double m_currentState[6];
+
+  /** The maximum number of values generated ahead of time. */
+  static const uint32_t BUFFER_SIZE = 64;
+  /** The values generated ahead of time. */
+  double m_buffer[BUFFER_SIZE];
+  /** The index of the next value to return from \c m_buffer. */
+  uint32_t m_next;
+  /**
+   * The number of values stored in \c m_buffer by the last refill.
+   *
+   * This starts at one and doubles up to \c BUFFER_SIZE with each
+   * refill, so that streams which are seldom used do not pay
+   * for a full block.  It is zero until the first refill.
+   */
+  uint32_t m_size;
 };
 
+double
+RngStream::RandU01 (void)
+{
+  if (m_next < m_size)
+    {
+      return m_buffer[m_next++];
+    }
+  return Refill ();
+}
+
 } // namespace ns3
 
 #endif
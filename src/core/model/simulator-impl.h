@@ -99,6 +99,13 @@ public:
   virtual uint32_t GetSystemId () const = 0; 
   /** \copydoc Simulator::GetContext */
   virtual uint32_t GetContext (void) const = 0;
+  /**
+   * \copydoc Simulator::GetEventCount
+   *
+   * The default implementation does not count the events and
+   * returns 0.
+   */
+  virtual uint64_t GetEventCount (void) const;
 };
 
 } // namespace ns3
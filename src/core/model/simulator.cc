@@ -107,6 +107,30 @@ NodePrinter (std::ostream &os)
     }
 }
 
+/**
+ * \ingroup logbinary
+ * Default LogBinaryTimeSource implementation.
+ *
+ * \returns The current simulation time, in nanoseconds.
+ */
+static int64_t
+TimeSource (void)
+{
+  return Simulator::Now ().GetNanoSeconds ();
+}
+
+/**
+ * \ingroup logbinary
+ * Default LogBinaryNodeSource implementation.
+ *
+ * \returns The current simulation context.
+ */
+static uint32_t
+NodeSource (void)
+{
+  return Simulator::GetContext ();
+}
+
 /**
  * \ingroup simulator
  * \brief Get the static SimulatorImpl instance.
@@ -157,6 +181,8 @@ static SimulatorImpl * GetImpl (void)
 //
       LogSetTimePrinter (&TimePrinter);
       LogSetNodePrinter (&NodePrinter);
+      LogBinarySetTimeSource (&TimeSource);
+      LogBinarySetNodeSource (&NodeSource);
     }
   return *pimpl;
 }
@@ -178,6 +204,8 @@ Simulator::Destroy (void)
    */
   LogSetTimePrinter (0);
   LogSetNodePrinter (0);
+  LogBinarySetTimeSource (0);
+  LogBinarySetNodeSource (0);
   (*pimpl)->Destroy ();
   (*pimpl)->Unref ();
   *pimpl = 0;
@@ -355,6 +383,12 @@ Simulator::GetContext (void)
   return GetImpl ()->GetContext ();
 }
 
+uint64_t
+Simulator::GetEventCount (void)
+{
+  return GetImpl ()->GetEventCount ();
+}
+
 uint32_t
 Simulator::GetSystemId (void)
 {
@@ -184,6 +184,17 @@ public:
    */
   static uint32_t GetContext (void);
 
+  /**
+   * Get the number of events executed.
+   *
+   * The count starts at zero when the simulator is created, and an
+   * event is counted when it is removed from the event list to run,
+   * canceled events included.
+   *
+   * @return The number of events executed.
+   */
+  static uint64_t GetEventCount (void);
+
   /** Context enum values. */
   enum {
     /**
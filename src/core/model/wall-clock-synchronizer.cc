@@ -20,6 +20,7 @@
 #include <ctime>       // clock_t
 #include <sys/time.h>  // gettimeofday
                        // clock_getres: glibc < 2.17, link with librt
+#include <sched.h>     // sched_yield
 
 #include "log.h"
 #include "system-condition.h"
@@ -44,6 +45,18 @@ WallClockSynchronizer::GetTypeId (void)
   static TypeId tid = TypeId ("ns3::WallClockSynchronizer")
     .SetParent<Synchronizer> ()
     .SetGroupName ("Core")
+    .AddAttribute ("SleepGuard",
+                   "Stop sleeping this long before the next event is due; "
+                   "zero for three jiffies of the system clock.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&WallClockSynchronizer::m_sleepGuard),
+                   MakeTimeChecker (Seconds (0)))
+    .AddAttribute ("YieldGuard",
+                   "Stop yielding the processor and start spinning this long "
+                   "before the next event is due; zero to spin only.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&WallClockSynchronizer::m_yieldGuard),
+                   MakeTimeChecker (Seconds (0)))
   ;
   return tid;
 }
@@ -221,10 +234,14 @@ WallClockSynchronizer::DoSynchronize (uint64_t nsCurrent, uint64_t nsDelay)
 // waiting (doing nothing).
 //
 // I'm not really sure about this number -- a boss of mine once said, "pick
-// a number and it'll be wrong."  But this works for now.
-//
-// \todo Hardcoded tunable parameter below.
+// a number and it'll be wrong."  But this works for now.  It can be set with
+// the SleepGuard attribute; the default of zero keeps three jiffies.
 //
+  if (!m_sleepGuard.IsZero ())
+    {
+      uint64_t nsSleepGuard = m_sleepGuard.GetNanoSeconds ();
+      numberJiffies = ns > nsSleepGuard ? (ns - nsSleepGuard) / m_jiffy + 3 : 0;
+    }
   if (numberJiffies > 3)
     {
       NS_LOG_INFO ("SleepWait for " << numberJiffies * m_jiffy << " ns");
@@ -271,6 +288,20 @@ WallClockSynchronizer::DoSynchronize (uint64_t nsCurrent, uint64_t nsDelay)
       return true;
     }
 //
+// If we are further than YieldGuard from the deadline, let the other
+// threads run until we get there.  Sleeping again would likely overshoot.
+//
+  uint64_t nsYieldGuard = m_yieldGuard.GetNanoSeconds ();
+  if (nsYieldGuard != 0 && (uint64_t)(-nsDrift) > nsYieldGuard)
+    {
+      NS_LOG_INFO ("YieldWait until " << nsCurrent + nsDelay - nsYieldGuard);
+      if (YieldWait (nsCurrent + nsDelay - nsYieldGuard) == false)
+        {
+          NS_LOG_INFO ("YieldWait interrupted");
+          return false;
+        }
+    }
+//
 // There are some number of nanoseconds left over and we need to wait until
 // the time defined by nsDrift.  We'll do a SpinWait since the usual case 
 // will be that we are doing this Spinwait after we've gotten a rough delay
@@ -332,6 +363,26 @@ WallClockSynchronizer::SpinWait (uint64_t ns)
   return true;
 }
 
+bool
+WallClockSynchronizer::YieldWait (uint64_t ns)
+{
+  NS_LOG_FUNCTION (this << ns);
+  for (;;)
+    {
+      if (GetNormalizedRealtime () >= ns)
+        {
+          return true;
+        }
+      if (m_condition.GetCondition ())
+        {
+          return false;
+        }
+      sched_yield ();
+    }
+// Quiet compiler
+  return true;
+}
+
 bool
 WallClockSynchronizer::SleepWait (uint64_t ns)
 {
@@ -21,6 +21,7 @@
 
 #include "system-condition.h"
 #include "synchronizer.h"
+#include "nstime.h"
 
 /**
  * @file
@@ -60,6 +61,15 @@ namespace ns3 {
  * to use the function @c clock_nanosleep() to sleep until a simulation Time
  * specified by the caller. 
  *
+ * The wait for the next event is split in three steps: the
+ * synchronizer sleeps until SleepGuard before the deadline, then
+ * yields the processor until YieldGuard before the deadline, and
+ * spins for the remaining time.  The default SleepGuard of zero keeps
+ * the historical behavior of sleeping until three jiffies before the
+ * deadline, and the default YieldGuard of zero disables the yield
+ * step.  Larger guards trade CPU time for a smaller jitter, since a
+ * sleep often ends much later than requested.
+ *
  * @todo Add more on jiffies, sleep, processes, etc.
  *
  * @internal
@@ -126,6 +136,19 @@ protected:
    *          @c false if we retured because the condition was set.
    */
   bool SleepWait (uint64_t ns);
+  /**
+   * @brief Yield the processor until the normalized realtime equals the
+   * argument or the condition variable becomes @c true.
+   *
+   * This is a busy-wait which lets the other runnable threads use the
+   * processor, for the part of the wait too short to sleep reliably
+   * but too long to spin.
+   *
+   * @param [in] ns The target normalized real time we should wait for.
+   * @returns @c true if we reached the target time,
+   *          @c false if we retured because the condition was set.
+   */
+  bool YieldWait (uint64_t ns);
 
   // Inherited from Synchronizer
   virtual void DoSetOrigin (uint64_t ns);
@@ -193,6 +216,10 @@ protected:
   uint64_t m_jiffy;
   /** Time recorded by DoEventStart. */
   uint64_t m_nsEventStart;
+  /** Time before the deadline at which sleeping stops, zero for three jiffies. */
+  Time m_sleepGuard;
+  /** Time before the deadline at which yielding stops. */
+  Time m_yieldGuard;
 
   /** Thread synchronizer. */
   SystemCondition m_condition;
@@ -0,0 +1,328 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/nstime.h"
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#include "ns3/system-condition.h"
+#endif /* HAVE_PTHREAD_H */
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <cstdio>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("LogBinaryTest");
+
+// ===========================================================================
+// Test case checking that the NS_LOG macros recorded by the binary
+// backend are rendered by LogBinaryDecode exactly as the synchronous
+// backend prints them.
+// ===========================================================================
+class LogBinaryTestCase : public TestCase
+{
+public:
+  LogBinaryTestCase ();
+  virtual ~LogBinaryTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /** Run a small simulation which logs a few messages. */
+  void Simulate (void);
+  /**
+   * Log a few messages from a scheduled event.
+   * \param [in] value A value to log.
+   */
+  void Log (uint32_t value);
+};
+
+LogBinaryTestCase::LogBinaryTestCase ()
+  : TestCase ("Check the binary logging backend")
+{
+}
+
+LogBinaryTestCase::~LogBinaryTestCase ()
+{
+}
+
+void
+LogBinaryTestCase::Log (uint32_t value)
+{
+  NS_LOG_FUNCTION (value);
+  NS_LOG_DEBUG ("value " << value);
+  NS_LOG_WARN ("warning " << value + 1);
+}
+
+void
+LogBinaryTestCase::Simulate (void)
+{
+  Simulator::ScheduleWithContext (3, Seconds (1.5), &LogBinaryTestCase::Log, this, 7);
+  Simulator::Schedule (MilliSeconds (2), &LogBinaryTestCase::Log, this, 11);
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+void
+LogBinaryTestCase::DoRun (void)
+{
+#ifdef NS3_LOG_ENABLE
+  LogComponentEnable ("LogBinaryTest", LOG_LEVEL_ALL);
+  LogComponentEnable ("LogBinaryTest", LOG_PREFIX_ALL);
+
+  // Text backend.
+  std::ostringstream text;
+  std::streambuf *saved = std::clog.rdbuf (text.rdbuf ());
+  Simulate ();
+  std::clog.rdbuf (saved);
+
+  // Binary backend.
+  std::string filename = CreateTempDirFilename ("log-binary.nslog");
+  LogBinaryEnable (filename);
+  Simulate ();
+  LogBinaryDisable ();
+
+  LogComponentDisable ("LogBinaryTest", LOG_LEVEL_ALL);
+  LogComponentDisable ("LogBinaryTest", LOG_PREFIX_ALL);
+
+  std::ifstream is (filename.c_str (), std::ios::binary);
+  std::ostringstream decoded;
+  NS_TEST_ASSERT_MSG_EQ (LogBinaryDecode (is, decoded), true, "Invalid binary log");
+  NS_TEST_ASSERT_MSG_NE (text.str (), "", "Nothing was logged");
+  NS_TEST_ASSERT_MSG_EQ (decoded.str (), text.str (), "Unexpected rendering of the binary log");
+  is.close ();
+  std::remove (filename.c_str ());
+#endif /* NS3_LOG_ENABLE */
+}
+
+// ===========================================================================
+// Test case checking that a message whose expression itself logs is
+// recorded along with the nested message, and that std::clog is left
+// untouched.
+// ===========================================================================
+class LogBinaryNestedTestCase : public TestCase
+{
+public:
+  LogBinaryNestedTestCase ();
+  virtual ~LogBinaryNestedTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Log a message, and return a value to log.
+   * \returns The value.
+   */
+  std::string Inner (void);
+};
+
+LogBinaryNestedTestCase::LogBinaryNestedTestCase ()
+  : TestCase ("Check nested messages with the binary logging backend")
+{
+}
+
+LogBinaryNestedTestCase::~LogBinaryNestedTestCase ()
+{
+}
+
+std::string
+LogBinaryNestedTestCase::Inner (void)
+{
+  NS_LOG_INFO ("inner");
+  return "inner1";
+}
+
+void
+LogBinaryNestedTestCase::DoRun (void)
+{
+#ifdef NS3_LOG_ENABLE
+  LogComponentEnable ("LogBinaryTest", LOG_LEVEL_INFO);
+
+  std::streambuf *clogBuffer = std::clog.rdbuf ();
+  std::string filename = CreateTempDirFilename ("log-binary-nested.nslog");
+  LogBinaryEnable (filename);
+  NS_LOG_INFO ("outer " << Inner ());
+  LogBinaryDisable ();
+
+  LogComponentDisable ("LogBinaryTest", LOG_LEVEL_INFO);
+
+  NS_TEST_ASSERT_MSG_EQ (std::clog.rdbuf (), clogBuffer, "std::clog was redirected");
+  NS_TEST_ASSERT_MSG_EQ (std::clog.good (), true, "std::clog is in error");
+
+  std::ifstream is (filename.c_str (), std::ios::binary);
+  std::ostringstream decoded;
+  NS_TEST_ASSERT_MSG_EQ (LogBinaryDecode (is, decoded), true, "Invalid binary log");
+  NS_TEST_ASSERT_MSG_EQ (decoded.str (), "inner\nouter inner1\n", "Unexpected rendering of the binary log");
+  is.close ();
+  std::remove (filename.c_str ());
+#endif /* NS3_LOG_ENABLE */
+}
+
+#ifdef HAVE_PTHREAD_H
+// ===========================================================================
+// Test case checking that LogBinaryDisable writes the records buffered
+// by another thread, which is still running.
+// ===========================================================================
+class LogBinaryThreadTestCase : public TestCase
+{
+public:
+  LogBinaryThreadTestCase ();
+  virtual ~LogBinaryThreadTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /** Log a message, then wait until the backend is disabled. */
+  void Log (void);
+
+  SystemCondition m_logged;     //!< Set when the thread has logged.
+  SystemCondition m_disabled;   //!< Set when the backend is disabled.
+};
+
+LogBinaryThreadTestCase::LogBinaryThreadTestCase ()
+  : TestCase ("Check that the binary logging backend writes the records of all threads")
+{
+}
+
+LogBinaryThreadTestCase::~LogBinaryThreadTestCase ()
+{
+}
+
+void
+LogBinaryThreadTestCase::Log (void)
+{
+  NS_LOG_INFO ("thread");
+  m_logged.SetCondition (true);
+  m_logged.Signal ();
+  while (!m_disabled.GetCondition ())
+    {
+      m_disabled.TimedWait (1000000);
+    }
+}
+
+void
+LogBinaryThreadTestCase::DoRun (void)
+{
+#ifdef NS3_LOG_ENABLE
+  LogComponentEnable ("LogBinaryTest", LOG_LEVEL_INFO);
+
+  std::string filename = CreateTempDirFilename ("log-binary-thread.nslog");
+  LogBinaryEnable (filename);
+  m_logged.SetCondition (false);
+  m_disabled.SetCondition (false);
+  Ptr<SystemThread> thread = Create<SystemThread> (MakeCallback (&LogBinaryThreadTestCase::Log, this));
+  thread->Start ();
+  while (!m_logged.GetCondition ())
+    {
+      m_logged.TimedWait (1000000);
+    }
+  NS_LOG_INFO ("main");
+  LogBinaryDisable ();
+  m_disabled.SetCondition (true);
+  m_disabled.Signal ();
+  thread->Join ();
+
+  LogComponentDisable ("LogBinaryTest", LOG_LEVEL_INFO);
+
+  std::ifstream is (filename.c_str (), std::ios::binary);
+  std::ostringstream decoded;
+  NS_TEST_ASSERT_MSG_EQ (LogBinaryDecode (is, decoded), true, "Invalid binary log");
+  NS_TEST_ASSERT_MSG_NE (decoded.str ().find ("thread\n"), std::string::npos, "Record of the thread lost");
+  NS_TEST_ASSERT_MSG_NE (decoded.str ().find ("main\n"), std::string::npos, "Record of the main thread lost");
+  is.close ();
+  std::remove (filename.c_str ());
+#endif /* NS3_LOG_ENABLE */
+}
+#endif /* HAVE_PTHREAD_H */
+
+// The context of the messages below is written to std::clog, as the
+// definitions of out-of-tree modules may do.
+#undef NS_LOG_APPEND_CONTEXT
+#define NS_LOG_APPEND_CONTEXT std::clog << "[ctx] "
+
+// ===========================================================================
+// Test case checking that a context written to std::clog is recorded
+// by the binary backend, and that std::clog is restored afterwards.
+// ===========================================================================
+class LogBinaryClogContextTestCase : public TestCase
+{
+public:
+  LogBinaryClogContextTestCase ();
+  virtual ~LogBinaryClogContextTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+LogBinaryClogContextTestCase::LogBinaryClogContextTestCase ()
+  : TestCase ("Check a context written to std::clog with the binary logging backend")
+{
+}
+
+LogBinaryClogContextTestCase::~LogBinaryClogContextTestCase ()
+{
+}
+
+void
+LogBinaryClogContextTestCase::DoRun (void)
+{
+#ifdef NS3_LOG_ENABLE
+  LogComponentEnable ("LogBinaryTest", LOG_LEVEL_INFO);
+
+  std::ostringstream text;
+  std::streambuf *saved = std::clog.rdbuf (text.rdbuf ());
+  std::string filename = CreateTempDirFilename ("log-binary-clog.nslog");
+  LogBinaryEnable (filename);
+  NS_LOG_INFO ("message");
+  LogBinaryDisable ();
+  NS_TEST_ASSERT_MSG_EQ (std::clog.rdbuf (), text.rdbuf (), "std::clog not restored");
+  std::clog.rdbuf (saved);
+
+  LogComponentDisable ("LogBinaryTest", LOG_LEVEL_INFO);
+
+  NS_TEST_ASSERT_MSG_EQ (text.str (), "", "The context was written to std::clog");
+  std::ifstream is (filename.c_str (), std::ios::binary);
+  std::ostringstream decoded;
+  NS_TEST_ASSERT_MSG_EQ (LogBinaryDecode (is, decoded), true, "Invalid binary log");
+  NS_TEST_ASSERT_MSG_EQ (decoded.str (), "[ctx] message\n", "Unexpected rendering of the binary log");
+  is.close ();
+  std::remove (filename.c_str ());
+#endif /* NS3_LOG_ENABLE */
+}
+
+class LogBinaryTestSuite : public TestSuite
+{
+public:
+  LogBinaryTestSuite ();
+};
+
+LogBinaryTestSuite::LogBinaryTestSuite ()
+  : TestSuite ("log-binary", UNIT)
+{
+  AddTestCase (new LogBinaryTestCase, TestCase::QUICK);
+  AddTestCase (new LogBinaryNestedTestCase, TestCase::QUICK);
+#ifdef HAVE_PTHREAD_H
+  AddTestCase (new LogBinaryThreadTestCase, TestCase::QUICK);
+#endif /* HAVE_PTHREAD_H */
+  AddTestCase (new LogBinaryClogContextTestCase, TestCase::QUICK);
+}
+
+static LogBinaryTestSuite logBinaryTestSuite;
@@ -359,6 +359,61 @@ AggregateObjectTestCase::DoRun (void)
   NS_TEST_ASSERT_MSG_NE (baseA, 0, "Unable to GetObject on released object");
 }
 
+// ===========================================================================
+// Test case to make sure that repeated lookups in an aggregate, which are
+// served from the aggregate lookup cache, return the same results as the
+// first ones, and that the cache follows changes in the aggregation.
+// ===========================================================================
+class AggregateLookupCacheTestCase : public TestCase
+{
+public:
+  AggregateLookupCacheTestCase ();
+  virtual ~AggregateLookupCacheTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+AggregateLookupCacheTestCase::AggregateLookupCacheTestCase ()
+  : TestCase ("Check Object aggregate lookup cache")
+{
+}
+
+AggregateLookupCacheTestCase::~AggregateLookupCacheTestCase ()
+{
+}
+
+void
+AggregateLookupCacheTestCase::DoRun (void)
+{
+  Ptr<DerivedA> derivedA = CreateObject<DerivedA> ();
+  Ptr<BaseB> baseB = CreateObject<BaseB> ();
+  derivedA->AggregateObject (baseB);
+
+  //
+  // Exact, parent and unsuccessful lookups, repeated so that the second
+  // round is answered by the cache.
+  //
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (baseB->GetObject<BaseA> (DerivedA::GetTypeId ()), derivedA, "Exact lookup returns different Ptr");
+      NS_TEST_ASSERT_MSG_EQ (baseB->GetObject<BaseA> (BaseA::GetTypeId ()), derivedA, "Parent lookup returns different Ptr");
+      NS_TEST_ASSERT_MSG_EQ (baseB->GetObject<BaseB> (), baseB, "Lookup of BaseB returns different Ptr");
+      NS_TEST_ASSERT_MSG_EQ (derivedA->GetObject<DerivedB> (), 0, "Unexpectedly found a DerivedB");
+    }
+
+  //
+  // A previously unsuccessful lookup must succeed once a matching Object
+  // is aggregated.
+  //
+  Ptr<DerivedB> derivedB = CreateObject<DerivedB> ();
+  NS_TEST_ASSERT_MSG_EQ (derivedB->GetObject<BaseA> (), 0, "Unexpectedly found a BaseA");
+  Ptr<DerivedA> other = CreateObject<DerivedA> ();
+  derivedB->AggregateObject (other);
+  NS_TEST_ASSERT_MSG_EQ (derivedB->GetObject<BaseA> (), other, "Cannot GetObject for a newly aggregated BaseA");
+  NS_TEST_ASSERT_MSG_EQ (other->GetObject<BaseB> (), derivedB, "Cannot GetObject for BaseB through the new aggregate");
+}
+
 // ===========================================================================
 // Test case to make sure that an Object factory can create Objects
 // ===========================================================================
@@ -445,6 +500,7 @@ ObjectTestSuite::ObjectTestSuite ()
 {
   AddTestCase (new CreateObjectTestCase, TestCase::QUICK);
   AddTestCase (new AggregateObjectTestCase, TestCase::QUICK);
+  AddTestCase (new AggregateLookupCacheTestCase, TestCase::QUICK);
   AddTestCase (new ObjectFactoryTestCase, TestCase::QUICK);
 }
 
@@ -0,0 +1,124 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
+#include "ns3/object-factory.h"
+#include "ns3/random-variable-stream.h"
+#include <vector>
+
+using namespace ns3;
+
+// ===========================================================================
+// Test case checking that RandomVariableStream::GetValues returns the
+// same values as successive calls to GetValue on a stream with the same
+// stream number, whatever the size of the blocks and even when block
+// and scalar calls are mixed.
+// ===========================================================================
+class RandomVariableStreamBlockTestCase : public TestCase
+{
+public:
+  RandomVariableStreamBlockTestCase (std::string name, ObjectFactory factory);
+  virtual ~RandomVariableStreamBlockTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /** The factory of the two streams to compare. */
+  ObjectFactory m_factory;
+};
+
+RandomVariableStreamBlockTestCase::RandomVariableStreamBlockTestCase (std::string name, ObjectFactory factory)
+  : TestCase ("Check block generation of " + name),
+    m_factory (factory)
+{
+}
+
+RandomVariableStreamBlockTestCase::~RandomVariableStreamBlockTestCase ()
+{
+}
+
+void
+RandomVariableStreamBlockTestCase::DoRun (void)
+{
+  Ptr<RandomVariableStream> scalar = m_factory.Create<RandomVariableStream> ();
+  Ptr<RandomVariableStream> block = m_factory.Create<RandomVariableStream> ();
+  scalar->SetStream (17);
+  block->SetStream (17);
+
+  // Block sizes smaller than, equal to, and larger than the internal
+  // buffer of the underlying RngStream, with scalar calls in between.
+  uint32_t sizes[] = { 1, 3, 0, 64, 7, 100, 1, 200, 5 };
+  std::vector<double> values;
+  for (uint32_t i = 0; i < sizeof (sizes) / sizeof (sizes[0]); i++)
+    {
+      values.resize (sizes[i] + 1);
+      block->GetValues (&values[0], sizes[i]);
+      for (uint32_t j = 0; j < sizes[i]; j++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (values[j], scalar->GetValue (), "Block value " << j << " of block " << i << " differs");
+        }
+      NS_TEST_ASSERT_MSG_EQ (block->GetValue (), scalar->GetValue (), "Scalar value after block " << i << " differs");
+    }
+}
+
+class RandomVariableStreamBlockTestSuite : public TestSuite
+{
+public:
+  RandomVariableStreamBlockTestSuite ();
+private:
+  /**
+   * Add a test case for a type of RandomVariableStream.
+   * \param [in] name The name of the test case.
+   * \param [in] factory The factory of the RandomVariableStream.
+   */
+  void AddFactory (std::string name, ObjectFactory factory);
+};
+
+RandomVariableStreamBlockTestSuite::RandomVariableStreamBlockTestSuite ()
+  : TestSuite ("random-variable-stream-block", UNIT)
+{
+  ObjectFactory factory;
+
+  factory.SetTypeId ("ns3::UniformRandomVariable");
+  factory.Set ("Min", DoubleValue (-3.0));
+  factory.Set ("Max", DoubleValue (12.5));
+  AddFactory ("uniform values", factory);
+  factory.Set ("Antithetic", BooleanValue (true));
+  AddFactory ("antithetic uniform values", factory);
+
+  factory = ObjectFactory ();
+  factory.SetTypeId ("ns3::ExponentialRandomVariable");
+  factory.Set ("Mean", DoubleValue (2.0));
+  AddFactory ("exponential values", factory);
+  factory.Set ("Antithetic", BooleanValue (true));
+  AddFactory ("antithetic exponential values", factory);
+  factory.Set ("Bound", DoubleValue (3.0));
+  AddFactory ("bounded exponential values", factory);
+
+  factory = ObjectFactory ();
+  factory.SetTypeId ("ns3::NormalRandomVariable");
+  AddFactory ("normal values", factory);
+}
+
+void
+RandomVariableStreamBlockTestSuite::AddFactory (std::string name, ObjectFactory factory)
+{
+  AddTestCase (new RandomVariableStreamBlockTestCase (name, factory), TestCase::QUICK);
+}
+
+static RandomVariableStreamBlockTestSuite randomVariableStreamBlockTestSuite;
@@ -131,11 +131,15 @@ SimulatorEventsTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (!a.IsExpired (), true, "");
   Simulator::Cancel (a);
   NS_TEST_EXPECT_MSG_EQ (a.IsExpired (), true, "");
+  NS_TEST_EXPECT_MSG_EQ (Simulator::GetEventCount (), 0, "No event ran yet");
   Simulator::Run ();
   NS_TEST_EXPECT_MSG_EQ (m_a, true, "Event A did not run ?");
   NS_TEST_EXPECT_MSG_EQ (m_b, true, "Event B did not run ?");
   NS_TEST_EXPECT_MSG_EQ (m_c, true, "Event C did not run ?");
   NS_TEST_EXPECT_MSG_EQ (m_d, true, "Event D did not run ?");
+  // Events A (canceled, but still taken from the event list), B and D
+  // are counted; C was removed before it could run.
+  NS_TEST_EXPECT_MSG_EQ (Simulator::GetEventCount (), 3, "Wrong event count");
 
   EventId anId = Simulator::ScheduleNow (&SimulatorEventsTestCase::Eventfoo0, this);
   EventId anotherId = anId;
@@ -25,7 +25,9 @@
 #include "ns3/calendar-scheduler.h"
 #include "ns3/config.h"
 #include "ns3/string.h"
+#include "ns3/boolean.h"
 #include "ns3/system-thread.h"
+#include "ns3/realtime-simulator-impl.h"
 
 #include <ctime>
 #include <list>
@@ -38,7 +40,8 @@ using namespace ns3;
 class ThreadedSimulatorEventsTestCase : public TestCase
 {
 public:
-  ThreadedSimulatorEventsTestCase (ObjectFactory schedulerFactory, const std::string &simulatorType, unsigned int threads);
+  ThreadedSimulatorEventsTestCase (ObjectFactory schedulerFactory, const std::string &simulatorType, unsigned int threads,
+                                   bool lockFree = false);
   void EventA (int a);
   void EventB (int b);
   void EventC (int c);
@@ -55,6 +58,7 @@ public:
   bool m_stop;
   ObjectFactory m_schedulerFactory;
   std::string m_simulatorType;
+  bool m_lockFree;
   std::string m_error;
   std::list<Ptr<SystemThread> > m_threadlist;
 
@@ -64,12 +68,15 @@ private:
   virtual void DoTeardown (void);
 };
 
-ThreadedSimulatorEventsTestCase::ThreadedSimulatorEventsTestCase (ObjectFactory schedulerFactory, const std::string &simulatorType, unsigned int threads)
+ThreadedSimulatorEventsTestCase::ThreadedSimulatorEventsTestCase (ObjectFactory schedulerFactory, const std::string &simulatorType, unsigned int threads,
+                                                                  bool lockFree)
   : TestCase ("Check that threaded event handling is working with " + 
-              schedulerFactory.GetTypeId ().GetName () + " in " + simulatorType),
+              schedulerFactory.GetTypeId ().GetName () + " in " + simulatorType +
+              (lockFree ? " with lock-free injection" : "")),
     m_threads (threads),
     m_schedulerFactory (schedulerFactory),
-    m_simulatorType (simulatorType)
+    m_simulatorType (simulatorType),
+    m_lockFree (lockFree)
 {
 }
 
@@ -178,6 +185,10 @@ ThreadedSimulatorEventsTestCase::DoSetup (void)
     {
       Config::SetGlobal ("SimulatorImplementationType", StringValue (m_simulatorType));
     }
+  if (m_lockFree)
+    {
+      Config::SetDefault ("ns3::RealtimeSimulatorImpl::LockFreeInjection", BooleanValue (true));
+    }
   
   m_error = "";
   
@@ -199,6 +210,7 @@ ThreadedSimulatorEventsTestCase::DoTeardown (void)
 {
   m_threadlist.clear();
  
+  Config::SetDefault ("ns3::RealtimeSimulatorImpl::LockFreeInjection", BooleanValue (false));
   Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
 }
 void 
@@ -217,6 +229,19 @@ ThreadedSimulatorEventsTestCase::DoRun (void)
     }
   
   Simulator::Run ();
+
+  Ptr<RealtimeSimulatorImpl> realtime = DynamicCast<RealtimeSimulatorImpl> (Simulator::GetImplementation ());
+  if (realtime != 0)
+    {
+      std::vector<uint64_t> lateness = realtime->GetLatenessHistogram ();
+      uint64_t events = 0;
+      for (uint32_t i = 0; i < lateness.size (); ++i)
+        {
+          events += lateness[i];
+        }
+      NS_TEST_EXPECT_MSG_GT (events, 4 * m_d, "Missing lateness statistics");
+    }
+
   Simulator::Destroy ();
 
   NS_TEST_EXPECT_MSG_EQ (m_error.empty(), true, m_error.c_str());
@@ -262,5 +287,12 @@ public:
               }
           }
       }
+#ifdef HAVE_RT
+    factory.SetTypeId ("ns3::MapScheduler");
+    for (unsigned int j=0; j < (sizeof(threadcounts) / sizeof(threadcounts[0])); ++j)
+      {
+        AddTestCase (new ThreadedSimulatorEventsTestCase (factory, "ns3::RealtimeSimulatorImpl", threadcounts[j], true), TestCase::QUICK);
+      }
+#endif
   }
 } g_threadedSimulatorTestSuite;
@@ -107,8 +107,8 @@ InternetStackHelper::InternetStackHelper ()
     m_ipv4Enabled (true),
     m_ipv6Enabled (true),
     m_ipv4ArpJitterEnabled (true),
-    m_ipv6NsRsJitterEnabled (true)
-
+    m_ipv6NsRsJitterEnabled (true),
+    m_lightweightEndpoint (false)
 {
   Initialize ();
 }
@@ -143,6 +143,7 @@ InternetStackHelper::InternetStackHelper (const InternetStackHelper &o)
   m_tcpFactory = o.m_tcpFactory;
   m_ipv4ArpJitterEnabled = o.m_ipv4ArpJitterEnabled;
   m_ipv6NsRsJitterEnabled = o.m_ipv6NsRsJitterEnabled;
+  m_lightweightEndpoint = o.m_lightweightEndpoint;
 }
 
 InternetStackHelper &
@@ -168,6 +169,7 @@ InternetStackHelper::Reset (void)
   m_ipv6Enabled = true;
   m_ipv4ArpJitterEnabled = true;
   m_ipv6NsRsJitterEnabled = true;
+  m_lightweightEndpoint = false;
   Initialize ();
 }
 
@@ -206,6 +208,11 @@ void InternetStackHelper::SetIpv6NsRsJitter (bool enable)
   m_ipv6NsRsJitterEnabled = enable;
 }
 
+void InternetStackHelper::SetLightweightEndpoint (bool enable)
+{
+  m_lightweightEndpoint = enable;
+}
+
 int64_t
 InternetStackHelper::AssignStreams (NodeContainer c, int64_t stream)
 {
@@ -291,6 +298,12 @@ InternetStackHelper::CreateAndAggregateObjectFromTypeId (Ptr<Node> node, const s
 void
 InternetStackHelper::Install (Ptr<Node> node) const
 {
+  if (m_lightweightEndpoint)
+    {
+      InstallLightweightEndpoint (node);
+      return;
+    }
+
   if (m_ipv4Enabled)
     {
       if (node->GetObject<Ipv4> () != 0)
@@ -353,6 +366,36 @@ InternetStackHelper::Install (Ptr<Node> node) const
     }
 }
 
+void
+InternetStackHelper::InstallLightweightEndpoint (Ptr<Node> node) const
+{
+  if (node->GetObject<Ipv4> () != 0)
+    {
+      NS_FATAL_ERROR ("InternetStackHelper::Install (): Aggregating " 
+                      "an InternetStack to a node with an existing Ipv4 object");
+      return;
+    }
+
+  CreateAndAggregateObjectFromTypeId (node, "ns3::ArpL3Protocol");
+  CreateAndAggregateObjectFromTypeId (node, "ns3::Ipv4L3Protocol");
+  CreateAndAggregateObjectFromTypeId (node, "ns3::Icmpv4L4Protocol");
+  if (m_ipv4ArpJitterEnabled == false)
+    {
+      Ptr<ArpL3Protocol> arp = node->GetObject<ArpL3Protocol> ();
+      NS_ASSERT (arp);
+      arp->SetAttribute ("RequestJitter", StringValue ("ns3::ConstantRandomVariable[Constant=0.0]"));
+    }
+  // A leaf node only needs its connected routes and a default route:
+  // no list routing, and no global routing with its router interface.
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  Ptr<Ipv4StaticRouting> ipv4Routing = CreateObject<Ipv4StaticRouting> ();
+  ipv4->SetRoutingProtocol (ipv4Routing);
+
+  CreateAndAggregateObjectFromTypeId (node, "ns3::TrafficControlLayer");
+  CreateAndAggregateObjectFromTypeId (node, "ns3::UdpL4Protocol");
+  node->AggregateObject (m_tcpFactory.Create<Object> ());
+}
+
 void
 InternetStackHelper::Install (std::string nodeName) const
 {
@@ -82,6 +82,20 @@ class Ipv6RoutingHelper;
  *  - a PacketSocketFactory
  *  - Ipv4 routing (a list routing object, a global routing object, and a static routing object)
  *  - Ipv6 routing (a static routing object)
+ *
+ * With SetLightweightEndpoint, the helper installs a reduced stack meant
+ * for large populations of leaf nodes with a single interface:
+ *  - ns3::ArpL3Protocol
+ *  - ns3::Ipv4L3Protocol
+ *  - ns3::Icmpv4L4Protocol
+ *  - ns3::UdpL4Protocol
+ *  - ns3::TrafficControlLayer
+ *  - a TCP based on the TCP factory provided
+ *  - Ipv4 routing (a static routing object only)
+ *
+ * The default route of such nodes is not known when the stack is
+ * installed; it is set once the interface has an address, e.g., with
+ * Ipv4StaticRouting::SetDefaultRoute.
  */
 class InternetStackHelper : public PcapHelperForIpv4, public PcapHelperForIpv6, 
                             public AsciiTraceHelperForIpv4, public AsciiTraceHelperForIpv6
@@ -220,6 +234,17 @@ public:
    */
   void SetIpv6NsRsJitter (bool enable);
 
+  /**
+   * \brief Enable/disable the lightweight endpoint stack.
+   *
+   * When enabled, Install aggregates an IPv4-only stack with a single
+   * static routing object, without IPv6, list or global routing, and
+   * packet sockets.  The IPv4 and IPv6 install states are ignored.
+   *
+   * \param enable enable state
+   */
+  void SetLightweightEndpoint (bool enable);
+
   /**
   * Assign a fixed random variable stream number to the random variables
   * used by this model.  Return the number of streams (possibly zero) that
@@ -319,6 +344,12 @@ private:
    */
   static void CreateAndAggregateObjectFromTypeId (Ptr<Node> node, const std::string typeId);
 
+  /**
+   * \brief Aggregate the lightweight endpoint stack to a node.
+   * \param node the node
+   */
+  void InstallLightweightEndpoint (Ptr<Node> node) const;
+
   /**
    * \brief checks if there is an hook to a Pcap wrapper
    * \param ipv4 pointer to the IPv4 object
@@ -366,6 +397,11 @@ private:
    * \brief IPv6 IPv6 NS and RS Jitter state (enabled/disabled) ?
    */
   bool m_ipv6NsRsJitterEnabled;
+
+  /**
+   * \brief Lightweight endpoint stack install state (enabled/disabled) ?
+   */
+  bool m_lightweightEndpoint;
 };
 
 } // namespace ns3
@@ -0,0 +1,283 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <fstream>
+#include <list>
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/simulator.h"
+#include "ns3/node-list.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/ipv4-interface.h"
+#include "ns3/arp-cache.h"
+#include "ns3/ipv4-static-routing.h"
+#include "ns3/ipv4-routing-table-entry.h"
+#include "ns3/ipv4-static-routing-helper.h"
+#include "ipv4-checkpoint-helper.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("Ipv4CheckpointHelper");
+
+/// Version of the checkpoint format.
+static const uint32_t CHECKPOINT_VERSION = 1;
+
+void
+Ipv4CheckpointHelper::SaveAll (Ptr<OutputStreamWrapper> stream)
+{
+  NS_LOG_FUNCTION (stream);
+  std::ostream *os = stream->GetStream ();
+  *os << "ns3-ipv4-checkpoint " << CHECKPOINT_VERSION << std::endl;
+  *os << "time " << Simulator::Now ().GetTimeStep () << std::endl;
+  for (uint32_t i = 0; i < NodeList::GetNNodes (); i++)
+    {
+      Save (NodeList::GetNode (i), *os);
+    }
+  *os << "end" << std::endl;
+}
+
+void
+Ipv4CheckpointHelper::SaveAllAt (Time saveTime, Ptr<OutputStreamWrapper> stream)
+{
+  NS_LOG_FUNCTION (saveTime << stream);
+  Simulator::Schedule (saveTime, &Ipv4CheckpointHelper::SaveAll, stream);
+}
+
+void
+Ipv4CheckpointHelper::Save (Ptr<Node> node, std::ostream &os)
+{
+  NS_LOG_FUNCTION (node);
+  Ptr<Ipv4L3Protocol> ipv4 = node->GetObject<Ipv4L3Protocol> ();
+  if (ipv4 == 0)
+    {
+      return;
+    }
+  os << "node " << node->GetId () << " " << ipv4->GetNInterfaces () << std::endl;
+
+  for (uint32_t i = 0; i < ipv4->GetNInterfaces (); i++)
+    {
+      for (uint32_t j = 0; j < ipv4->GetNAddresses (i); j++)
+        {
+          Ipv4InterfaceAddress address = ipv4->GetAddress (i, j);
+          os << "address " << i << " " << address.GetLocal ()
+             << " " << address.GetMask () << std::endl;
+        }
+    }
+
+  Ipv4StaticRoutingHelper helper;
+  Ptr<Ipv4StaticRouting> routing = helper.GetStaticRouting (ipv4);
+  if (routing != 0)
+    {
+      for (uint32_t i = 0; i < routing->GetNRoutes (); i++)
+        {
+          Ipv4RoutingTableEntry route = routing->GetRoute (i);
+          os << "route " << route.GetDestNetwork ()
+             << " " << route.GetDestNetworkMask ()
+             << " " << route.GetGateway ()
+             << " " << route.GetInterface ()
+             << " " << routing->GetMetric (i) << std::endl;
+        }
+    }
+
+  for (uint32_t i = 0; i < ipv4->GetNInterfaces (); i++)
+    {
+      Ptr<ArpCache> cache = ipv4->GetInterface (i)->GetArpCache ();
+      if (cache == 0)
+        {
+          continue;
+        }
+      // Only the resolved entries are worth saving, the others are
+      // transient.
+      std::list<ArpCache::Entry *> entries = cache->GetEntries ();
+      for (std::list<ArpCache::Entry *>::iterator j = entries.begin (); j != entries.end (); j++)
+        {
+          ArpCache::Entry *entry = *j;
+          if (entry->IsAlive () || entry->IsPermanent ())
+            {
+              os << "arp " << i << " " << entry->GetIpv4Address ()
+                 << " " << entry->GetMacAddress ()
+                 << (entry->IsPermanent () ? " permanent" : " alive") << std::endl;
+            }
+        }
+    }
+}
+
+void
+Ipv4CheckpointHelper::RestoreAll (std::string filename)
+{
+  NS_LOG_FUNCTION (filename);
+  std::ifstream is (filename.c_str ());
+  NS_ABORT_MSG_UNLESS (is.is_open (), "Could not open checkpoint " << filename);
+  RestoreAll (is);
+}
+
+void
+Ipv4CheckpointHelper::RestoreAll (std::istream &is)
+{
+  NS_LOG_FUNCTION (&is);
+  std::string keyword;
+  uint32_t version = 0;
+  is >> keyword >> version;
+  NS_ABORT_MSG_UNLESS (is && keyword == "ns3-ipv4-checkpoint" && version == CHECKPOINT_VERSION,
+                       "Not a version " << CHECKPOINT_VERSION << " IPv4 checkpoint");
+  int64_t ts;
+  is >> keyword >> ts;
+  NS_ABORT_MSG_UNLESS (is && keyword == "time", "Checkpoint time expected");
+
+  // Advance the simulation time to the time of the checkpoint, so
+  // that the restored timers start from there.  This runs the
+  // simulator, which is only valid before the simulation starts, and
+  // only the events of the current time, such as the initialization
+  // of the nodes, may run before the checkpoint time.
+  Time when = TimeStep (ts);
+  NS_ABORT_MSG_IF (when < Simulator::Now (),
+                   "Checkpoint time " << when << " is in the past");
+  NS_ABORT_MSG_UNLESS (Simulator::GetEventCount () == 0,
+                       "Checkpoint restored after the simulation started");
+  if (when > Simulator::Now ())
+    {
+      Simulator::Stop (Seconds (0));
+      Simulator::Run ();
+      // Only the stop event may run until the checkpoint time.  The
+      // count stays at zero if the simulator does not count events.
+      uint64_t count = Simulator::GetEventCount ();
+      Simulator::Stop (when - Simulator::Now ());
+      Simulator::Run ();
+      NS_ABORT_MSG_UNLESS (count == 0 || Simulator::GetEventCount () == count + 1,
+                           "Events scheduled before the checkpoint time " << when);
+    }
+
+  while (is >> keyword)
+    {
+      if (keyword == "end")
+        {
+          return;
+        }
+      NS_ABORT_MSG_UNLESS (keyword == "node", "Unexpected " << keyword << " in checkpoint");
+      uint32_t id;
+      uint32_t nInterfaces;
+      is >> id >> nInterfaces;
+      NS_ABORT_MSG_UNLESS (is && id < NodeList::GetNNodes (),
+                           "Checkpoint of unknown node " << id);
+      Restore (NodeList::GetNode (id), is, nInterfaces);
+    }
+  NS_FATAL_ERROR ("Truncated checkpoint");
+}
+
+void
+Ipv4CheckpointHelper::Restore (Ptr<Node> node, std::istream &is, uint32_t nInterfaces)
+{
+  NS_LOG_FUNCTION (node << nInterfaces);
+  Ptr<Ipv4L3Protocol> ipv4 = node->GetObject<Ipv4L3Protocol> ();
+  NS_ABORT_MSG_UNLESS (ipv4 != 0, "Node " << node->GetId () << " has no IPv4 stack");
+  NS_ABORT_MSG_UNLESS (ipv4->GetNInterfaces () == nInterfaces,
+                       "Node " << node->GetId () << " has " << ipv4->GetNInterfaces ()
+                               << " interfaces instead of " << nInterfaces);
+
+  Ipv4StaticRoutingHelper helper;
+  Ptr<Ipv4StaticRouting> routing = helper.GetStaticRouting (ipv4);
+  bool routesCleared = false;
+  for (uint32_t i = 0; i < ipv4->GetNInterfaces (); i++)
+    {
+      Ptr<ArpCache> cache = ipv4->GetInterface (i)->GetArpCache ();
+      if (cache != 0)
+        {
+          cache->Flush ();
+        }
+    }
+
+  std::string keyword;
+  while (is.peek () != EOF)
+    {
+      std::streampos position = is.tellg ();
+      is >> keyword;
+      if (keyword == "address")
+        {
+          uint32_t interface;
+          std::string local, mask;
+          is >> interface >> local >> mask;
+          NS_ABORT_MSG_UNLESS (is && interface < nInterfaces, "Invalid checkpoint address");
+          bool found = false;
+          for (uint32_t j = 0; j < ipv4->GetNAddresses (interface); j++)
+            {
+              Ipv4InterfaceAddress address = ipv4->GetAddress (interface, j);
+              found |= address.GetLocal () == Ipv4Address (local.c_str ())
+                && address.GetMask () == Ipv4Mask (mask.c_str ());
+            }
+          NS_ABORT_MSG_UNLESS (found, "Node " << node->GetId () << " interface " << interface
+                                              << " has no address " << local << "/" << mask);
+        }
+      else if (keyword == "route")
+        {
+          std::string network, mask, gateway;
+          uint32_t interface, metric;
+          is >> network >> mask >> gateway >> interface >> metric;
+          NS_ABORT_MSG_UNLESS (is && interface < nInterfaces, "Invalid checkpoint route");
+          NS_ABORT_MSG_UNLESS (routing != 0, "Node " << node->GetId () << " has no static routing");
+          if (!routesCleared)
+            {
+              // The saved table replaces the routes added while the
+              // topology was built, including the interface routes.
+              while (routing->GetNRoutes () != 0)
+                {
+                  routing->RemoveRoute (0);
+                }
+              routesCleared = true;
+            }
+          Ipv4Address nextHop (gateway.c_str ());
+          if (nextHop == Ipv4Address::GetZero ())
+            {
+              routing->AddNetworkRouteTo (Ipv4Address (network.c_str ()), Ipv4Mask (mask.c_str ()),
+                                          interface, metric);
+            }
+          else
+            {
+              routing->AddNetworkRouteTo (Ipv4Address (network.c_str ()), Ipv4Mask (mask.c_str ()),
+                                          nextHop, interface, metric);
+            }
+        }
+      else if (keyword == "arp")
+        {
+          uint32_t interface;
+          std::string destination, state;
+          Address mac;
+          is >> interface >> destination >> mac >> state;
+          NS_ABORT_MSG_UNLESS (is && interface < nInterfaces, "Invalid checkpoint ARP entry");
+          Ptr<ArpCache> cache = ipv4->GetInterface (interface)->GetArpCache ();
+          NS_ABORT_MSG_UNLESS (cache != 0, "Node " << node->GetId () << " interface " << interface
+                                                   << " has no ARP cache");
+          ArpCache::Entry *entry = cache->Add (Ipv4Address (destination.c_str ()));
+          entry->SetMacAddresss (mac);
+          if (state == "permanent")
+            {
+              entry->MarkPermanent ();
+            }
+          else
+            {
+              // New entries are alive: restart their timeout from now.
+              entry->UpdateSeen ();
+            }
+        }
+      else
+        {
+          // Next node or end of the checkpoint.
+          is.seekg (position);
+          return;
+        }
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,118 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef IPV4_CHECKPOINT_HELPER_H
+#define IPV4_CHECKPOINT_HELPER_H
+
+#include <iostream>
+#include <string>
+#include "ns3/ptr.h"
+#include "ns3/nstime.h"
+#include "ns3/node.h"
+#include "ns3/output-stream-wrapper.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup ipv4Helpers
+ *
+ * \brief Save the warmed-up state of an IPv4 network and restore it
+ * in a fresh simulation.
+ *
+ * A checkpoint records the simulation time and, for each node of the
+ * NodeList with an IPv4 stack, the addresses of its interfaces, the
+ * routes of its Ipv4StaticRouting protocol and the resolved entries
+ * of its ARP caches.  It is a text file:
+ * \verbatim
+   ns3-ipv4-checkpoint 1
+   time 7200000000000
+   node 0 2
+   address 1 10.1.1.1 255.255.255.0
+   route 10.1.2.0 255.255.255.0 10.1.1.2 1 0
+   arp 1 10.1.1.2 00-06-00:00:00:00:00:02 alive
+   end
+   \endverbatim
+ *
+ * Restoring is meant for a simulation script which builds the same
+ * topology as the one which saved the checkpoint, in a new process:
+ * nodes, devices and addresses must be created in the same order, so
+ * that node ids, interface indexes and MAC addresses match.  Restore()
+ * checks the interface addresses and aborts if they differ.
+ *
+ * This first version targets wired topologies with static routing.
+ * Pending events are not saved: RestoreAll() advances the simulation
+ * time to the checkpoint time by running the simulator, after the
+ * topology is built and before the applications are installed.  It
+ * must be called before Simulator::Run(), not from an event, and
+ * only the events of the current time, such as the initialization of
+ * the nodes, may be scheduled before the checkpoint time: it aborts
+ * otherwise.  Routes computed by
+ * Ipv4GlobalRoutingHelper::PopulateRoutingTables are not saved, since
+ * they are cheap to recompute, and attribute values can be saved and
+ * loaded with the ConfigStore.
+ */
+class Ipv4CheckpointHelper
+{
+public:
+  /**
+   * \brief Write a checkpoint of all the nodes.
+   * \param stream The output stream object to use
+   */
+  static void SaveAll (Ptr<OutputStreamWrapper> stream);
+
+  /**
+   * \brief Write a checkpoint of all the nodes at a particular time.
+   * \param saveTime the time at which the checkpoint is written.
+   * \param stream The output stream object to use
+   */
+  static void SaveAllAt (Time saveTime, Ptr<OutputStreamWrapper> stream);
+
+  /**
+   * \brief Restore all the nodes from a checkpoint.
+   * \param is The checkpoint.
+   *
+   * Aborts if the checkpoint is invalid or does not match the
+   * topology, if the simulation already ran events, or if events
+   * other than those of the current time are scheduled before the
+   * checkpoint time.
+   */
+  static void RestoreAll (std::istream &is);
+
+  /**
+   * \brief Restore all the nodes from a checkpoint file.
+   * \param filename The name of the checkpoint file.
+   */
+  static void RestoreAll (std::string filename);
+
+private:
+  /**
+   * \brief Write the checkpoint of a node.
+   * \param node The node to save
+   * \param os The output stream
+   */
+  static void Save (Ptr<Node> node, std::ostream &os);
+  /**
+   * \brief Restore a node from its checkpoint.
+   * \param node The node to restore
+   * \param is The input stream, positioned after the node line
+   * \param nInterfaces The number of interfaces of the saved node
+   */
+  static void Restore (Ptr<Node> node, std::istream &is, uint32_t nInterfaces);
+};
+
+} // namespace ns3
+
+#endif /* IPV4_CHECKPOINT_HELPER_H */
@@ -82,6 +82,12 @@ public:
    * Users must first call PopulateRoutingTables() and then may subsequently
    * call RecomputeRoutingTables() at any later time in the simulation.
    *
+   * When the GlobalRoutingIncremental global value is true, the default,
+   * only the routers whose shortest paths may be changed by the changes
+   * of the topology calculate their routes again; the others get them
+   * from their previous shortest paths.  The routing tables are the same
+   * as after a full calculation.  GlobalRouteManager::GetNRecomputedRoots ()
+   * tells how many routers calculated their routes.
    */
   static void RecomputeRoutingTables (void);
 private:
@@ -0,0 +1,172 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/node.h"
+#include "ns3/node-list.h"
+#include "ns3/boolean.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/ipv4-interface.h"
+#include "ns3/arp-cache.h"
+#include "ns3/ipv6-l3-protocol.h"
+#include "ns3/ipv6-interface.h"
+#include "ns3/ndisc-cache.h"
+#include "ns3/icmpv6-l4-protocol.h"
+#include "neighbor-cache-helper.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("NeighborCacheHelper");
+
+NeighborCacheHelper::NeighborCacheHelper ()
+{
+}
+
+void
+NeighborCacheHelper::PopulateNeighborCache (void) const
+{
+  NS_LOG_FUNCTION (this);
+  for (NodeList::Iterator i = NodeList::Begin (); i != NodeList::End (); ++i)
+    {
+      Ptr<Node> node = *i;
+      for (uint32_t j = 0; j < node->GetNDevices (); ++j)
+        {
+          PopulateDevice (node->GetDevice (j));
+        }
+    }
+}
+
+void
+NeighborCacheHelper::PopulateNeighborCache (Ptr<Channel> channel) const
+{
+  NS_LOG_FUNCTION (this << channel);
+  for (uint32_t i = 0; i < channel->GetNDevices (); ++i)
+    {
+      PopulateDevice (channel->GetDevice (i));
+    }
+}
+
+void
+NeighborCacheHelper::PopulateNeighborCache (const NetDeviceContainer &c) const
+{
+  NS_LOG_FUNCTION (this);
+  for (NetDeviceContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+    {
+      PopulateDevice (*i);
+    }
+}
+
+void
+NeighborCacheHelper::SuppressNeighborDiscovery (const NodeContainer &c) const
+{
+  NS_LOG_FUNCTION (this);
+  for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+    {
+      Ptr<Icmpv6L4Protocol> icmpv6 = (*i)->GetObject<Icmpv6L4Protocol> ();
+      if (icmpv6)
+        {
+          icmpv6->SetAttribute ("DAD", BooleanValue (false));
+        }
+    }
+}
+
+void
+NeighborCacheHelper::SuppressNeighborDiscovery (void) const
+{
+  NS_LOG_FUNCTION (this);
+  SuppressNeighborDiscovery (NodeContainer::GetGlobal ());
+}
+
+void
+NeighborCacheHelper::PopulateDevice (Ptr<NetDevice> device) const
+{
+  NS_LOG_FUNCTION (this << device);
+  Ptr<Channel> channel = device->GetChannel ();
+  if (channel == 0)
+    {
+      return;
+    }
+  for (uint32_t i = 0; i < channel->GetNDevices (); ++i)
+    {
+      Ptr<NetDevice> neighbor = channel->GetDevice (i);
+      if (neighbor != device)
+        {
+          AddNeighbor (device, neighbor);
+        }
+    }
+}
+
+void
+NeighborCacheHelper::AddNeighbor (Ptr<NetDevice> device, Ptr<NetDevice> neighbor) const
+{
+  NS_LOG_FUNCTION (this << device << neighbor);
+  // The devices which do not need ARP do not resolve the neighbors
+  if (!device->NeedsArp ())
+    {
+      return;
+    }
+
+  Ptr<Ipv4L3Protocol> ipv4 = device->GetNode ()->GetObject<Ipv4L3Protocol> ();
+  Ptr<Ipv4L3Protocol> neighborIpv4 = neighbor->GetNode ()->GetObject<Ipv4L3Protocol> ();
+  if (ipv4 && neighborIpv4)
+    {
+      int32_t interface = ipv4->GetInterfaceForDevice (device);
+      int32_t neighborInterface = neighborIpv4->GetInterfaceForDevice (neighbor);
+      Ptr<ArpCache> cache = interface >= 0 ? ipv4->GetInterface (interface)->GetArpCache () : 0;
+      if (cache && neighborInterface >= 0)
+        {
+          Ptr<Ipv4Interface> iface = neighborIpv4->GetInterface (neighborInterface);
+          for (uint32_t i = 0; i < iface->GetNAddresses (); ++i)
+            {
+              Ipv4Address address = iface->GetAddress (i).GetLocal ();
+              ArpCache::Entry *entry = cache->Lookup (address);
+              if (entry == 0)
+                {
+                  entry = cache->Add (address);
+                }
+              entry->SetMacAddresss (neighbor->GetAddress ());
+              entry->MarkPermanent ();
+            }
+        }
+    }
+
+  Ptr<Ipv6L3Protocol> ipv6 = device->GetNode ()->GetObject<Ipv6L3Protocol> ();
+  Ptr<Ipv6L3Protocol> neighborIpv6 = neighbor->GetNode ()->GetObject<Ipv6L3Protocol> ();
+  if (ipv6 && neighborIpv6)
+    {
+      int32_t interface = ipv6->GetInterfaceForDevice (device);
+      int32_t neighborInterface = neighborIpv6->GetInterfaceForDevice (neighbor);
+      Ptr<NdiscCache> cache = interface >= 0 ? ipv6->GetInterface (interface)->GetNdiscCache () : 0;
+      if (cache && neighborInterface >= 0)
+        {
+          Ptr<Ipv6Interface> iface = neighborIpv6->GetInterface (neighborInterface);
+          for (uint32_t i = 0; i < iface->GetNAddresses (); ++i)
+            {
+              Ipv6Address address = iface->GetAddress (i).GetAddress ();
+              NdiscCache::Entry *entry = cache->Lookup (address);
+              if (entry == 0)
+                {
+                  entry = cache->Add (address);
+                }
+              entry->SetMacAddress (neighbor->GetAddress ());
+              entry->SetRouter (iface->IsForwarding ());
+              entry->MarkPermanent ();
+            }
+        }
+    }
+}
+
+} // namespace ns3
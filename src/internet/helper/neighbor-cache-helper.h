@@ -0,0 +1,112 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NEIGHBOR_CACHE_HELPER_H
+#define NEIGHBOR_CACHE_HELPER_H
+
+#include "ns3/ptr.h"
+#include "ns3/channel.h"
+#include "ns3/net-device.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup ipv4Helpers
+ * \ingroup ipv6Helpers
+ *
+ * \brief Helper class that preloads the ARP and NDP caches with the
+ * on-link neighbors
+ *
+ * The neighbors of a device are the IPv4 and IPv6 addresses of the other
+ * devices attached to its channel.  Each of them is added to the
+ * ns3::ArpCache or ns3::NdiscCache of the interface of the device as a
+ * PERMANENT entry, which never expires and is never probed, so that the
+ * first packet to a neighbor is sent at once instead of waiting for the
+ * ARP reply or Neighbor Advertisement.
+ *
+ * The caches are computed from the addresses assigned when the helper
+ * is called: call it after the IP address assignment.  The neighbors
+ * reached through a bridge, and the addresses added later, are not in
+ * the caches, and are resolved by the protocols as usual.
+ */
+class NeighborCacheHelper
+{
+public:
+  NeighborCacheHelper ();
+
+  /**
+   * \brief Populate the caches of the devices of all the nodes
+   */
+  void PopulateNeighborCache (void) const;
+
+  /**
+   * \brief Populate the caches of the devices attached to a channel
+   * \param channel the channel
+   */
+  void PopulateNeighborCache (Ptr<Channel> channel) const;
+
+  /**
+   * \brief Populate the caches of the devices of a container
+   *
+   * The caches hold the neighbors of each device on its channel, in the
+   * container or not.
+   *
+   * \param c the devices
+   */
+  void PopulateNeighborCache (const NetDeviceContainer &c) const;
+
+  /**
+   * \brief Stop the nodes from sending the neighbor discovery messages of
+   * the IPv6 address assignment
+   *
+   * Sets the ns3::Icmpv6L4Protocol "DAD" attribute of the nodes, which
+   * disables the Duplicate Address Detection of the addresses and the
+   * Router Solicitation which follows it.  Call it after installing the
+   * internet stack and before assigning the IPv6 addresses.
+   *
+   * Along with the populated caches, a node sends no ARP or NDP message
+   * to an on-link neighbor.
+   *
+   * \param c the nodes
+   */
+  void SuppressNeighborDiscovery (const NodeContainer &c) const;
+
+  /**
+   * \brief Stop all the nodes from sending the neighbor discovery
+   * messages of the IPv6 address assignment
+   */
+  void SuppressNeighborDiscovery (void) const;
+
+private:
+  /**
+   * \brief Populate the caches of a device with its neighbors
+   * \param device the device
+   */
+  void PopulateDevice (Ptr<NetDevice> device) const;
+
+  /**
+   * \brief Add the addresses of a neighbor to the caches of a device
+   * \param device the device
+   * \param neighbor the device of the neighbor
+   */
+  void AddNeighbor (Ptr<NetDevice> device, Ptr<NetDevice> neighbor) const;
+};
+
+} // namespace ns3
+
+#endif /* NEIGHBOR_CACHE_HELPER_H */
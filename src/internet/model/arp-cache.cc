@@ -313,6 +313,18 @@ ArpCache::LookupInverse (Address to)
   return entryList;
 }
 
+std::list<ArpCache::Entry *>
+ArpCache::GetEntries (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  std::list<ArpCache::Entry *> entryList;
+  for (CacheI i = m_arpCache.begin (); i != m_arpCache.end (); i++)
+    {
+      entryList.push_back ((*i).second);
+    }
+  return entryList;
+}
 
 ArpCache::Entry *
 ArpCache::Lookup (Ipv4Address to)
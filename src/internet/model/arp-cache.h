@@ -154,6 +154,11 @@ public:
    * \return A std::list of ArpCache::Entry with info about layer 2
    */
   std::list<ArpCache::Entry *> LookupInverse (Address destination);
+  /**
+   * \brief Get all the entries of the ARP cache
+   * \return A std::list of all the ArpCache::Entry, in no particular order
+   */
+  std::list<ArpCache::Entry *> GetEntries (void);
   /**
    * \brief Add an Ipv4Address to this ARP cache
    */
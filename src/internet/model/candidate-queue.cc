@@ -49,24 +49,33 @@ operator<< (std::ostream& os, const SPFVertex::VertexType& t)
 std::ostream& 
 operator<< (std::ostream& os, const CandidateQueue& q)
 {
-  typedef CandidateQueue::CandidateList_t List_t;
-  typedef List_t::const_iterator CIter_t;
-  const CandidateQueue::CandidateList_t& list = q.m_candidates;
+  // Print the candidates in the order they would be popped.
+  std::vector<uint32_t> slots;
+  for (uint32_t i = 0; i < q.m_heap.size (); i++)
+    {
+      std::vector<uint32_t>::iterator j = slots.begin ();
+      while (j != slots.end () && q.Before (*j, q.m_heap[i]))
+        {
+          j++;
+        }
+      slots.insert (j, q.m_heap[i]);
+    }
 
   os << "*** CandidateQueue Begin (<id, distance, LSA-type>) ***" << std::endl;
-  for (CIter_t iter = list.begin (); iter != list.end (); iter++)
+  for (std::vector<uint32_t>::const_iterator iter = slots.begin (); iter != slots.end (); iter++)
     {
+      SPFVertex *v = q.m_slots[*iter].vertex;
       os << "<" 
-      << (*iter)->GetVertexId () << ", "
-      << (*iter)->GetDistanceFromRoot () << ", "
-      << (*iter)->GetVertexType () << ">" << std::endl;
+      << v->GetVertexId () << ", "
+      << v->GetDistanceFromRoot () << ", "
+      << v->GetVertexType () << ">" << std::endl;
     }
   os << "*** CandidateQueue End ***";
   return os;
 }
 
 CandidateQueue::CandidateQueue()
-  : m_candidates ()
+  : m_order (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -81,7 +90,7 @@ void
 CandidateQueue::Clear (void)
 {
   NS_LOG_FUNCTION (this);
-  while (!m_candidates.empty ())
+  while (!m_heap.empty ())
     {
       SPFVertex *p = Pop ();
       delete p;
@@ -94,24 +103,51 @@ CandidateQueue::Push (SPFVertex *vNew)
 {
   NS_LOG_FUNCTION (this << vNew);
 
-  CandidateList_t::iterator i = std::upper_bound (
-      m_candidates.begin (), m_candidates.end (), vNew,
-      &CandidateQueue::CompareSPFVertex
-      );
-  m_candidates.insert (i, vNew);
+  uint32_t slot;
+  if (m_free.empty ())
+    {
+      slot = m_slots.size ();
+      m_slots.push_back (Candidate ());
+    }
+  else
+    {
+      slot = m_free.back ();
+      m_free.pop_back ();
+    }
+  m_slots[slot].vertex = vNew;
+  m_slots[slot].order = m_order++;
+  // Find () returns the first vertex pushed with an ID.
+  m_index.insert (std::make_pair (vNew->GetVertexId (), slot));
+  m_heap.push_back (slot);
+  m_slots[slot].position = m_heap.size () - 1;
+  SiftUp (m_heap.size () - 1);
 }
 
 SPFVertex *
 CandidateQueue::Pop (void)
 {
   NS_LOG_FUNCTION (this);
-  if (m_candidates.empty ())
+  if (m_heap.empty ())
     {
       return 0;
     }
 
-  SPFVertex *v = m_candidates.front ();
-  m_candidates.pop_front ();
+  uint32_t slot = m_heap.front ();
+  SPFVertex *v = m_slots[slot].vertex;
+  uint32_t last = m_heap.back ();
+  m_heap.pop_back ();
+  if (!m_heap.empty ())
+    {
+      Place (0, last);
+      SiftDown (0);
+    }
+  std::map<Ipv4Address, uint32_t>::iterator i = m_index.find (v->GetVertexId ());
+  if (i != m_index.end () && i->second == slot)
+    {
+      m_index.erase (i);
+    }
+  m_slots[slot].vertex = 0;
+  m_free.push_back (slot);
   return v;
 }
 
@@ -119,44 +155,38 @@ SPFVertex *
 CandidateQueue::Top (void) const
 {
   NS_LOG_FUNCTION (this);
-  if (m_candidates.empty ())
+  if (m_heap.empty ())
     {
       return 0;
     }
 
-  return m_candidates.front ();
+  return m_slots[m_heap.front ()].vertex;
 }
 
 bool
 CandidateQueue::Empty (void) const
 {
   NS_LOG_FUNCTION (this);
-  return m_candidates.empty ();
+  return m_heap.empty ();
 }
 
 uint32_t
 CandidateQueue::Size (void) const
 {
   NS_LOG_FUNCTION (this);
-  return m_candidates.size ();
+  return m_heap.size ();
 }
 
 SPFVertex *
 CandidateQueue::Find (const Ipv4Address addr) const
 {
   NS_LOG_FUNCTION (this);
-  CandidateList_t::const_iterator i = m_candidates.begin ();
-
-  for (; i != m_candidates.end (); i++)
+  std::map<Ipv4Address, uint32_t>::const_iterator i = m_index.find (addr);
+  if (i == m_index.end ())
     {
-      SPFVertex *v = *i;
-      if (v->GetVertexId () == addr)
-        {
-          return v;
-        }
+      return 0;
     }
-
-  return 0;
+  return m_slots[i->second].vertex;
 }
 
 void
@@ -164,11 +194,94 @@ CandidateQueue::Reorder (void)
 {
   NS_LOG_FUNCTION (this);
 
-  m_candidates.sort (&CandidateQueue::CompareSPFVertex);
+  for (uint32_t i = m_heap.size () / 2; i > 0; i--)
+    {
+      SiftDown (i - 1);
+    }
   NS_LOG_LOGIC ("After reordering the CandidateQueue");
   NS_LOG_LOGIC (*this);
 }
 
+void
+CandidateQueue::DecreaseKey (SPFVertex *v)
+{
+  NS_LOG_FUNCTION (this << v);
+
+  std::map<Ipv4Address, uint32_t>::const_iterator i = m_index.find (v->GetVertexId ());
+  NS_ASSERT_MSG (i != m_index.end () && m_slots[i->second].vertex == v,
+                 "CandidateQueue::DecreaseKey (): vertex not in the queue");
+  m_slots[i->second].order = m_order++;
+  SiftUp (m_slots[i->second].position);
+  NS_LOG_LOGIC ("After decreasing the distance of " << v->GetVertexId ());
+  NS_LOG_LOGIC (*this);
+}
+
+bool
+CandidateQueue::Before (uint32_t s1, uint32_t s2) const
+{
+  const Candidate &c1 = m_slots[s1];
+  const Candidate &c2 = m_slots[s2];
+  if (CompareSPFVertex (c1.vertex, c2.vertex))
+    {
+      return true;
+    }
+  if (CompareSPFVertex (c2.vertex, c1.vertex))
+    {
+      return false;
+    }
+  return c1.order < c2.order;
+}
+
+void
+CandidateQueue::SiftUp (uint32_t position)
+{
+  uint32_t slot = m_heap[position];
+  while (position > 0)
+    {
+      uint32_t parent = (position - 1) / 2;
+      if (!Before (slot, m_heap[parent]))
+        {
+          break;
+        }
+      Place (position, m_heap[parent]);
+      position = parent;
+    }
+  Place (position, slot);
+}
+
+void
+CandidateQueue::SiftDown (uint32_t position)
+{
+  uint32_t slot = m_heap[position];
+  uint32_t size = m_heap.size ();
+  for (;;)
+    {
+      uint32_t child = 2 * position + 1;
+      if (child >= size)
+        {
+          break;
+        }
+      if (child + 1 < size && Before (m_heap[child + 1], m_heap[child]))
+        {
+          child++;
+        }
+      if (!Before (m_heap[child], slot))
+        {
+          break;
+        }
+      Place (position, m_heap[child]);
+      position = child;
+    }
+  Place (position, slot);
+}
+
+void
+CandidateQueue::Place (uint32_t position, uint32_t slot)
+{
+  m_heap[position] = slot;
+  m_slots[slot].position = position;
+}
+
 /*
  * In this implementation, SPFVertex follows the ordering where
  * a vertex is ranked first if its GetDistanceFromRoot () is smaller;
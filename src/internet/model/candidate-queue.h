@@ -22,7 +22,8 @@
 #define CANDIDATE_QUEUE_H
 
 #include <stdint.h>
-#include <list>
+#include <map>
+#include <vector>
 #include "ns3/ipv4-address.h"
 
 namespace ns3 {
@@ -44,9 +45,15 @@ class SPFVertex;
  * priority queue.
  *
  * Although a STL priority_queue almost does what we want, the requirement
- * for a Find () operation, the dynamic nature of the data and the derived
- * requirement for a Reorder () operation led us to implement this simple 
- * enhanced priority queue.
+ * for a Find () operation and the dynamic nature of the data led us to
+ * implement this enhanced priority queue: a binary heap whose vertices are
+ * indexed by vertex ID, so that Find () is logarithmic and the position of
+ * a vertex whose distance decreased can be restored by DecreaseKey ()
+ * instead of reordering the whole queue.
+ *
+ * At equal distance, network vertices come before router vertices, and
+ * vertices of the same type come in the order they were pushed or, for the
+ * vertices whose distance decreased, in the order of their last decrease.
  */
 class CandidateQueue
 {
@@ -148,12 +155,27 @@ public:
  * increasing distance.
  *
  * This method is provided in case the values of m_distanceFromRoot change
- * during the routing calculations.
+ * during the routing calculations.  When the distance of a single vertex
+ * decreased, DecreaseKey () does the same in logarithmic time.
  *
  * @see SPFVertex
  */
   void Reorder (void);
 
+/**
+ * @brief Restores the position of a vertex of the Candidate Queue whose
+ * m_distanceFromRoot decreased.
+ *
+ * The vertex is then ordered after the other vertices of its new
+ * distance and type.  These were all before it in the queue sorted by
+ * the previous distances, so this is the order the stable sort of
+ * Reorder () gave.
+ *
+ * @see SPFVertex
+ * @param v The Shortest Path First Vertex, returned by Find ().
+ */
+  void DecreaseKey (SPFVertex *v);
+
 private:
 /**
  * Candidate Queue copy construction is disallowed (not implemented) to 
@@ -184,8 +206,50 @@ private:
  */
   static bool CompareSPFVertex (const SPFVertex* v1, const SPFVertex* v2);
 
-  typedef std::list<SPFVertex*> CandidateList_t; //!< container of SPFVertex pointers
-  CandidateList_t m_candidates;  //!< SPFVertex candidates
+  /**
+   * \brief A vertex of the queue.
+   */
+  struct Candidate
+  {
+    SPFVertex *vertex; //!< the vertex
+    uint64_t order;    //!< the rank of the vertex among those of equal distance and type
+    uint32_t position; //!< the position of the candidate in the heap
+  };
+
+  /**
+   * \brief return true if the candidate of slot s1 should be popped before
+   * that of slot s2
+   *
+   * \param s1 first slot
+   * \param s2 second slot
+   * \return True if the candidate of s1 should be popped first
+   */
+  bool Before (uint32_t s1, uint32_t s2) const;
+
+  /**
+   * \brief Move the candidate at a position of the heap up, to its place.
+   * \param position the position
+   */
+  void SiftUp (uint32_t position);
+
+  /**
+   * \brief Move the candidate at a position of the heap down, to its place.
+   * \param position the position
+   */
+  void SiftDown (uint32_t position);
+
+  /**
+   * \brief Put a slot at a position of the heap.
+   * \param position the position
+   * \param slot the slot
+   */
+  void Place (uint32_t position, uint32_t slot);
+
+  std::vector<Candidate> m_slots;  //!< the candidates, in slots reused once popped
+  std::vector<uint32_t> m_free;  //!< the free slots
+  std::vector<uint32_t> m_heap;  //!< the binary heap of the slots of the candidates
+  std::map<Ipv4Address, uint32_t> m_index;  //!< the slots of the candidates, by vertex ID
+  uint64_t m_order;  //!< the order of the next candidate pushed or decreased
 
   /**
    * \brief Stream insertion operator.
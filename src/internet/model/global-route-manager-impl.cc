@@ -26,6 +26,7 @@
 #include <vector>
 #include <queue>
 #include <algorithm>
+#include <iterator>
 #include <iostream>
 #include "ns3/assert.h"
 #include "ns3/fatal-error.h"
@@ -35,6 +36,15 @@
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/ipv4-list-routing.h"
 #include "ns3/mpi-interface.h"
+#include "ns3/global-value.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+#include <unistd.h>
+#include "ns3/system-thread.h"
+#include "ns3/system-mutex.h"
+#endif
 #include "global-router-interface.h"
 #include "global-route-manager-impl.h"
 #include "candidate-queue.h"
@@ -44,6 +54,137 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("GlobalRouteManagerImpl");
 
+/**
+ * \ingroup globalrouting
+ * \brief The number of threads computing the global routes.
+ */
+static GlobalValue g_globalRoutingThreads =
+  GlobalValue ("GlobalRoutingThreads",
+               "The number of threads running the SPF calculations of "
+               "the global routing, 0 for one per processor",
+               UintegerValue (1),
+               MakeUintegerChecker<uint32_t> ());
+
+/**
+ * \ingroup globalrouting
+ * \brief Whether the global routes are updated incrementally.
+ */
+static GlobalValue g_globalRoutingIncremental =
+  GlobalValue ("GlobalRoutingIncremental",
+               "Whether the global routes are updated after a change of "
+               "the topology by calculating again only the SPF trees the "
+               "change may modify",
+               BooleanValue (true),
+               MakeBooleanChecker ());
+
+/**
+ * \ingroup globalrouting
+ * \brief Whether the global routes are aggregated into compact routes.
+ */
+static GlobalValue g_globalRoutingAggregateRoutes =
+  GlobalValue ("GlobalRoutingAggregateRoutes",
+               "Whether the host and network routes of each node are "
+               "aggregated into prefixes with the same next hops, and "
+               "stored as compact routes",
+               BooleanValue (false),
+               MakeBooleanChecker ());
+
+// ---------------------------------------------------------------------------
+//
+// SPFVertexArena Implementation
+//
+// ---------------------------------------------------------------------------
+
+namespace {
+
+/**
+ * \ingroup globalrouting
+ * \brief Check whether any log component is enabled.
+ *
+ * The SPF calculations log through several components, such as
+ * CandidateQueue, GlobalRouter, Object and SystemMutex, which are not
+ * safe to log from several threads.
+ *
+ * \returns true if a log component has a level enabled
+ */
+bool
+IsAnyLogEnabled (void)
+{
+  LogComponent::ComponentList *components = LogComponent::GetComponentList ();
+  for (LogComponent::ComponentList::const_iterator i = components->begin ();
+       i != components->end (); ++i)
+    {
+      if (!i->second->IsNoneEnabled ())
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+/**
+ * The header of the blocks of the vertices: the arena of the block, or 0
+ * for the heap.  Its size keeps the vertex aligned.
+ */
+union SPFVertexBlockHeader
+{
+  SPFVertexArena *arena; //!< the arena of the block
+  double alignDouble; //!< alignment
+  uint64_t alignInteger; //!< alignment
+};
+
+/// The number of blocks of the chunks of the arenas
+const size_t SPF_ARENA_CHUNK_BLOCKS = 1024;
+
+} // anonymous namespace
+
+SPFVertexArena::SPFVertexArena ()
+  : m_blockSize (0),
+    m_chunkUsed (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+SPFVertexArena::~SPFVertexArena ()
+{
+  NS_LOG_FUNCTION (this);
+  for (uint32_t i = 0; i < m_chunks.size (); i++)
+    {
+      delete [] m_chunks[i];
+    }
+}
+
+void*
+SPFVertexArena::Allocate (size_t size)
+{
+  if (m_blockSize == 0)
+    {
+      m_blockSize = size;
+    }
+  NS_ASSERT_MSG (size == m_blockSize, "SPFVertexArena::Allocate (): blocks of different sizes");
+  if (!m_free.empty ())
+    {
+      void *block = m_free.back ();
+      m_free.pop_back ();
+      return block;
+    }
+  if (m_chunks.empty () || m_chunkUsed == m_blockSize * SPF_ARENA_CHUNK_BLOCKS)
+    {
+      m_chunks.push_back (new char [m_blockSize * SPF_ARENA_CHUNK_BLOCKS]);
+      m_chunkUsed = 0;
+    }
+  void *block = m_chunks.back () + m_chunkUsed;
+  m_chunkUsed += m_blockSize;
+  return block;
+}
+
+void
+SPFVertexArena::Release (void *block)
+{
+  m_free.push_back (block);
+}
+
+
 /**
  * \brief Stream insertion operator.
  *
@@ -123,6 +264,48 @@ SPFVertex::SPFVertex (GlobalRoutingLSA* lsa) :
     }
 }
 
+void*
+SPFVertex::operator new (size_t size)
+{
+  SPFVertexBlockHeader *header =
+    static_cast<SPFVertexBlockHeader *> (::operator new (sizeof (SPFVertexBlockHeader) + size));
+  header->arena = 0;
+  return header + 1;
+}
+
+void*
+SPFVertex::operator new (size_t size, SPFVertexArena &arena)
+{
+  SPFVertexBlockHeader *header =
+    static_cast<SPFVertexBlockHeader *> (arena.Allocate (sizeof (SPFVertexBlockHeader) + size));
+  header->arena = &arena;
+  return header + 1;
+}
+
+void
+SPFVertex::operator delete (void *p)
+{
+  if (p == 0)
+    {
+      return;
+    }
+  SPFVertexBlockHeader *header = static_cast<SPFVertexBlockHeader *> (p) - 1;
+  if (header->arena != 0)
+    {
+      header->arena->Release (header);
+    }
+  else
+    {
+      ::operator delete (header);
+    }
+}
+
+void
+SPFVertex::operator delete (void *p, SPFVertexArena &arena)
+{
+  arena.Release (static_cast<SPFVertexBlockHeader *> (p) - 1);
+}
+
 SPFVertex::~SPFVertex ()
 {
   NS_LOG_FUNCTION (this);
@@ -470,7 +653,34 @@ GlobalRouteManagerLSDB::Insert (Ipv4Address addr, GlobalRoutingLSA* lsa)
     } 
   else
     {
-      m_database.insert (LSDBPair_t (addr, lsa));
+      if (!m_database.insert (LSDBPair_t (addr, lsa)).second)
+        {
+          return;
+        }
+      uint32_t index = m_lsas.size ();
+      m_lsaIndex[lsa] = index;
+      m_lsas.push_back (lsa);
+//
+// GetLSAByLinkData returns the first LSA, in the order of the database,
+// with a transit network record of the link data.
+//
+      for (uint32_t j = 0; j < lsa->GetNLinkRecords (); j++)
+        {
+          GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
+          if (lr->GetLinkType () != GlobalRoutingLinkRecord::TransitNetwork)
+            {
+              continue;
+            }
+          std::map<Ipv4Address, LSDBPair_t>::iterator i = m_linkDataIndex.find (lr->GetLinkData ());
+          if (i == m_linkDataIndex.end ())
+            {
+              m_linkDataIndex.insert (std::make_pair (lr->GetLinkData (), LSDBPair_t (addr, lsa)));
+            }
+          else if (addr < i->second.first)
+            {
+              i->second = LSDBPair_t (addr, lsa);
+            }
+        }
     }
 }
 
@@ -495,13 +705,10 @@ GlobalRouteManagerLSDB::GetLSA (Ipv4Address addr) const
 //
 // Look up an LSA by its address.
 //
-  LSDBMap_t::const_iterator i;
-  for (i= m_database.begin (); i!= m_database.end (); i++)
+  LSDBMap_t::const_iterator i = m_database.find (addr);
+  if (i != m_database.end ())
     {
-      if (i->first == addr)
-        {
-          return i->second;
-        }
+      return i->second;
     }
   return 0;
 }
@@ -511,44 +718,86 @@ GlobalRouteManagerLSDB::GetLSAByLinkData (Ipv4Address addr) const
 {
   NS_LOG_FUNCTION (this << addr);
 //
-// Look up an LSA by its address.
+// Look up an LSA by the link data of its transit network records.
 //
-  LSDBMap_t::const_iterator i;
-  for (i= m_database.begin (); i!= m_database.end (); i++)
+  std::map<Ipv4Address, LSDBPair_t>::const_iterator i = m_linkDataIndex.find (addr);
+  if (i != m_linkDataIndex.end ())
     {
-      GlobalRoutingLSA* temp = i->second;
-// Iterate among temp's Link Records
-      for (uint32_t j = 0; j < temp->GetNLinkRecords (); j++)
-        {
-          GlobalRoutingLinkRecord *lr = temp->GetLinkRecord (j);
-          if ( lr->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork &&
-               lr->GetLinkData () == addr)
-            {
-              return temp;
-            }
-        }
+      return i->second.second;
     }
   return 0;
 }
 
+uint32_t
+GlobalRouteManagerLSDB::GetNumLSAs () const
+{
+  NS_LOG_FUNCTION (this);
+  return m_lsas.size ();
+}
+
+GlobalRoutingLSA*
+GlobalRouteManagerLSDB::GetLSAByIndex (uint32_t index) const
+{
+  NS_LOG_FUNCTION (this << index);
+  return m_lsas.at (index);
+}
+
+uint32_t
+GlobalRouteManagerLSDB::GetLSAIndex (GlobalRoutingLSA* lsa) const
+{
+  NS_LOG_FUNCTION (this << lsa);
+  std::map<GlobalRoutingLSA*, uint32_t>::const_iterator i = m_lsaIndex.find (lsa);
+  NS_ASSERT_MSG (i != m_lsaIndex.end (), "GlobalRouteManagerLSDB::GetLSAIndex (): LSA not in the database");
+  return i->second;
+}
+
 // ---------------------------------------------------------------------------
 //
 // GlobalRouteManagerImpl Implementation
 //
 // ---------------------------------------------------------------------------
 
+/**
+ * \brief The roots shared by the threads of a parallel calculation.
+ */
+struct GlobalRouteManagerImpl::SPFWork
+{
+  std::vector<SPFRoot*> *roots; //!< the roots of the calculations
+  uint32_t next; //!< the index of the next root to calculate
+  uint32_t end; //!< the index of the root after the last one to calculate
+#ifdef HAVE_PTHREAD_H
+  SystemMutex mutex; //!< the mutex protecting next
+#endif /* HAVE_PTHREAD_H */
+};
+
 GlobalRouteManagerImpl::GlobalRouteManagerImpl () 
   :
-    m_spfroot (0)
+    m_spfroot (0),
+    m_ownsLsdb (true),
+    m_root (0),
+    m_work (0),
+    m_nRecomputedRoots (0)
 {
   NS_LOG_FUNCTION (this);
   m_lsdb = new GlobalRouteManagerLSDB ();
 }
 
+GlobalRouteManagerImpl::GlobalRouteManagerImpl (GlobalRouteManagerLSDB* lsdb)
+  :
+    m_spfroot (0),
+    m_lsdb (lsdb),
+    m_ownsLsdb (false),
+    m_root (0),
+    m_work (0),
+    m_nRecomputedRoots (0)
+{
+  NS_LOG_FUNCTION (this << lsdb);
+}
+
 GlobalRouteManagerImpl::~GlobalRouteManagerImpl ()
 {
   NS_LOG_FUNCTION (this);
-  if (m_lsdb)
+  if (m_lsdb && m_ownsLsdb)
     {
       delete m_lsdb;
     }
@@ -578,20 +827,11 @@ GlobalRouteManagerImpl::DeleteGlobalRoutes ()
         {
           continue;
         }
-      Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-      uint32_t j = 0;
-      uint32_t nRoutes = gr->GetNRoutes ();
-      NS_LOG_LOGIC ("Deleting " << gr->GetNRoutes ()<< " routes from node " << node->GetId ());
-      // Each time we delete route 0, the route index shifts downward
-      // We can delete all routes if we delete the route numbered 0
-      // nRoutes times
-      for (j = 0; j < nRoutes; j++)
-        {
-          NS_LOG_LOGIC ("Deleting global route " << j << " from node " << node->GetId ());
-          gr->RemoveRoute (0);
-        }
-      NS_LOG_LOGIC ("Deleted " << j << " global routes from node "<< node->GetId ());
+      NS_LOG_LOGIC ("Deleting global routes from node " << node->GetId ());
+      DeleteRoutes (router->GetRoutingProtocol ());
     }
+  m_roots.clear ();
+  m_lsaNumbers.clear ();
   if (m_lsdb)
     {
       NS_LOG_LOGIC ("Deleting LSDB, creating new one");
@@ -693,41 +933,1087 @@ GlobalRouteManagerImpl::BuildGlobalRoutingDatabase ()
 // list becomes empty. 
 //
 void
-GlobalRouteManagerImpl::InitializeRoutes ()
+GlobalRouteManagerImpl::InitializeRoutes ()
+{
+  NS_LOG_FUNCTION (this);
+//
+// Walk the list of nodes in the system, and gather the nodes participating
+// in routing.
+//
+  NS_LOG_INFO ("About to start SPF calculation");
+  NumberVertices ();
+  bool incremental = IsIncremental ();
+  bool aggregated = IsAggregated ();
+  m_roots.clear ();
+  m_roots.resize (NodeList::GetNNodes ());
+  std::vector<SPFRoot*> roots;
+  uint32_t systemId = MpiInterface::GetSystemId ();
+  NodeList::Iterator listEnd = NodeList::End ();
+  for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
+    {
+      Ptr<Node> node = *i;
+//
+// Look for the GlobalRouter interface that indicates that the node is
+// participating in routing.
+//
+      Ptr<GlobalRouter> rtr = 
+        node->GetObject<GlobalRouter> ();
+
+      // Ignore nodes that are not assigned to our systemId (distributed sim)
+      if (node->GetSystemId () != systemId) 
+        {
+          continue;
+        }
+
+//
+// if the node has a global router interface, then run the global routing
+// algorithms.
+//
+      if (rtr && rtr->GetNumLSAs () )
+        {
+          SPFRoot &root = m_roots[node->GetId ()];
+          InitializeRoot (node, rtr->GetRouterId (), root);
+          root.cached = incremental;
+          root.aggregated = aggregated;
+          roots.push_back (&root);
+        }
+    }
+  CalculateRoots (roots, false);
+  m_nRecomputedRoots = roots.size ();
+  NS_LOG_INFO ("Finished SPF calculation");
+}
+
+void
+GlobalRouteManagerImpl::CalculateRoots (std::vector<SPFRoot*> &roots, bool replace)
+{
+  NS_LOG_FUNCTION (this << roots.size () << replace);
+  uint32_t nThreads = std::min<uint32_t> (GetNThreads (), roots.size ());
+#ifdef HAVE_PTHREAD_H
+//
+// The log messages of the calculations are only meaningful in sequence,
+// and the logging code is not thread safe.
+//
+  if (nThreads > 1 && !IsAnyLogEnabled ())
+    {
+      std::vector<GlobalRouteManagerImpl *> calculators;
+      for (uint32_t i = 0; i < nThreads; i++)
+        {
+          calculators.push_back (new GlobalRouteManagerImpl (m_lsdb));
+          calculators.back ()->m_lsaNumbers = m_lsaNumbers;
+        }
+//
+// The routes of a batch of roots are kept until they are installed, which
+// bounds the memory they use.
+//
+      uint32_t batchSize = nThreads * 32;
+      for (uint32_t begin = 0; begin < roots.size (); begin += batchSize)
+        {
+          SPFWork work;
+          work.roots = &roots;
+          work.next = begin;
+          work.end = std::min<uint32_t> (begin + batchSize, roots.size ());
+          std::vector<Ptr<SystemThread> > threads;
+          for (uint32_t i = 0; i < nThreads; i++)
+            {
+              calculators[i]->m_work = &work;
+              threads.push_back (Create<SystemThread> (MakeCallback (&GlobalRouteManagerImpl::SPFCalculateWork,
+                                                                     calculators[i])));
+              threads.back ()->Start ();
+            }
+          for (uint32_t i = 0; i < nThreads; i++)
+            {
+              threads[i]->Join ();
+              calculators[i]->m_work = 0;
+            }
+          for (uint32_t i = begin; i < work.end; i++)
+            {
+              InstallRoutes (*roots[i], replace);
+              std::vector<SPFRoute> ().swap (roots[i]->routes);
+            }
+        }
+      for (uint32_t i = 0; i < nThreads; i++)
+        {
+          delete calculators[i];
+        }
+      return;
+    }
+#endif /* HAVE_PTHREAD_H */
+  for (uint32_t i = 0; i < roots.size (); i++)
+    {
+      m_root = roots[i];
+      SPFCalculate (m_root->routerId);
+      if (m_root->aggregated)
+        {
+          AggregateRoutes (m_root->routes);
+        }
+      InstallRoutes (*m_root, replace);
+      std::vector<SPFRoute> ().swap (m_root->routes);
+    }
+  m_root = 0;
+}
+
+//
+// After a change of the topology, a new LSDB is built and compared with the
+// previous one.  The SPF trees are only calculated again for the routers
+// whose tree may be changed.  The other routers whose tree holds a vertex
+// whose LSA changed get their routes again from the cached tree and the new
+// LSAs, in the order of a full calculation.  The routing tables are then
+// patched where their routes differ, rather than emptied and filled again.
+//
+void
+GlobalRouteManagerImpl::UpdateRoutes ()
+{
+  NS_LOG_FUNCTION (this);
+  if (!IsIncremental () || m_roots.empty ())
+    {
+      DeleteGlobalRoutes ();
+      BuildGlobalRoutingDatabase ();
+      InitializeRoutes ();
+      return;
+    }
+//
+// Build the new LSDB, keeping the previous one for the comparison.
+//
+  GlobalRouteManagerLSDB* oldLsdb = m_lsdb;
+  std::vector<uint32_t> oldNumbers;
+  oldNumbers.swap (m_lsaNumbers);
+  m_lsdb = new GlobalRouteManagerLSDB ();
+  BuildGlobalRoutingDatabase ();
+  NumberVertices ();
+  uint32_t nVertices = m_vertexNumbers.size ();
+//
+// Find the vertices whose LSA changed, appeared or disappeared.
+//
+  std::vector<Ipv4Address> changed;
+  SPFChange change;
+  std::vector<bool> &network = change.network;
+  network.resize (nVertices, false);
+  std::vector<GlobalRoutingLSA*> lsas (nVertices, 0);
+  for (uint32_t i = 0; i < m_lsdb->GetNumLSAs (); i++)
+    {
+      GlobalRoutingLSA* lsa = m_lsdb->GetLSAByIndex (i);
+      uint32_t number = m_lsaNumbers[i];
+      lsas[number] = lsa;
+      network[number] = lsa->GetLSType () == GlobalRoutingLSA::NetworkLSA;
+      GlobalRoutingLSA* oldLsa = oldLsdb->GetLSA (lsa->GetLinkStateId ());
+      if (oldLsa == 0 || !IsSameLSA (oldLsa, lsa))
+        {
+          changed.push_back (lsa->GetLinkStateId ());
+        }
+      if (oldLsa != 0 && !IsSameLSA (oldLsa, lsa))
+        {
+          change.changed.push_back (number);
+          change.oldEdges.push_back (std::vector<SPFEdge> ());
+          GetLSAEdges (oldLsdb, oldNumbers, oldLsa, number, change.oldEdges.back ());
+          change.newEdges.push_back (std::vector<SPFEdge> ());
+          GetLSAEdges (m_lsdb, m_lsaNumbers, lsa, number, change.newEdges.back ());
+        }
+    }
+  for (uint32_t i = 0; i < oldLsdb->GetNumLSAs (); i++)
+    {
+      GlobalRoutingLSA* oldLsa = oldLsdb->GetLSAByIndex (i);
+      if (m_lsdb->GetLSA (oldLsa->GetLinkStateId ()) == 0)
+        {
+          network[oldNumbers[i]] = oldLsa->GetLSType () == GlobalRoutingLSA::NetworkLSA;
+          changed.push_back (oldLsa->GetLinkStateId ());
+        }
+    }
+  bool externalsChanged = !IsSameExtLSAs (oldLsdb, m_lsdb);
+  NS_LOG_LOGIC (changed.size () << " LSAs changed");
+//
+// Find the edges which were removed or added.
+//
+  std::vector<SPFEdge> oldEdges;
+  std::vector<SPFEdge> newEdges;
+  GetEdges (oldLsdb, oldNumbers, oldEdges);
+  GetEdges (m_lsdb, m_lsaNumbers, newEdges);
+  std::vector<SPFEdge> &removed = change.removed;
+  std::vector<SPFEdge> &added = change.added;
+  std::set_difference (oldEdges.begin (), oldEdges.end (), newEdges.begin (), newEdges.end (),
+                       std::back_inserter (removed));
+  std::set_difference (newEdges.begin (), newEdges.end (), oldEdges.begin (), oldEdges.end (),
+                       std::back_inserter (added));
+//
+// The next hops of a root are given by its LSA, the LSAs of its neighbors
+// and the LSAs of the routers behind its networks.  The roots for which a
+// changed vertex is one of these are near the change.
+//
+  std::vector<std::vector<uint32_t> > sources (nVertices);
+  for (uint32_t i = 0; i < oldEdges.size (); i++)
+    {
+      sources[oldEdges[i].to].push_back (oldEdges[i].from);
+    }
+  for (uint32_t i = 0; i < added.size (); i++)
+    {
+      sources[added[i].to].push_back (added[i].from);
+    }
+  std::vector<bool> near (nVertices, false);
+  for (uint32_t i = 0; i < changed.size (); i++)
+    {
+      uint32_t u = m_vertexNumbers[changed[i]];
+      near[u] = true;
+      for (uint32_t j = 0; j < sources[u].size (); j++)
+        {
+          uint32_t x = sources[u][j];
+          near[x] = true;
+          if (network[x])
+            {
+              for (uint32_t k = 0; k < sources[x].size (); k++)
+                {
+                  near[sources[x][k]] = true;
+                }
+            }
+        }
+    }
+//
+// Install the routes of the roots whose tree is not changed again, and
+// gather the other roots.
+//
+  m_roots.resize (NodeList::GetNNodes ());
+  bool aggregated = IsAggregated ();
+  std::vector<SPFRoot*> roots;
+  uint32_t systemId = MpiInterface::GetSystemId ();
+  NodeList::Iterator listEnd = NodeList::End ();
+  for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
+    {
+      Ptr<Node> node = *i;
+      Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter> ();
+      SPFRoot &root = m_roots[node->GetId ()];
+      if (node->GetSystemId () != systemId || !rtr || rtr->GetNumLSAs () == 0)
+        {
+//
+// A node which is no longer a root loses its routes, as with
+// DeleteGlobalRoutes.
+//
+          if (root.routing)
+            {
+              DeleteRoutes (root.routing);
+              InitializeRoot (0, Ipv4Address (), root);
+            }
+          continue;
+        }
+      SPFRoot current;
+      InitializeRoot (node, rtr->GetRouterId (), current);
+      current.aggregated = aggregated;
+      uint32_t number = m_vertexNumbers[current.routerId];
+      bool kept = root.cached
+        && root.routing == current.routing
+        && root.routerId == current.routerId
+        && root.addresses == current.addresses
+        && root.aggregated == current.aggregated
+        && !near[number]
+        && !externalsChanged
+        && (root.stub || !IsTreeChanged (root, change));
+      if (kept)
+        {
+          if (root.stub)
+            {
+              continue;
+            }
+//
+// The routes to the changed vertices are given by their new LSAs.  The
+// routes of the table are replaced by all the routes of the root, in the
+// order of a full calculation; those in place are kept.
+//
+          bool reached = false;
+          for (uint32_t j = 0; j < changed.size () && !reached; j++)
+            {
+              reached = GetCachedDistance (root, m_vertexNumbers[changed[j]]) != SPF_INFINITY;
+            }
+          if (reached)
+            {
+              GetCachedRoutes (root, lsas);
+              if (root.aggregated)
+                {
+                  AggregateRoutes (root.routes);
+                }
+              InstallRoutes (root, true);
+              std::vector<SPFRoute> ().swap (root.routes);
+            }
+          continue;
+        }
+      if (root.routing && root.routing != current.routing)
+        {
+          DeleteRoutes (root.routing);
+        }
+      root = current;
+      root.cached = true;
+      roots.push_back (&root);
+    }
+  delete oldLsdb;
+  NS_LOG_LOGIC ("Calculating " << roots.size () << " SPF trees again");
+  CalculateRoots (roots, true);
+  m_nRecomputedRoots = roots.size ();
+}
+
+uint32_t
+GlobalRouteManagerImpl::GetNRecomputedRoots () const
+{
+  NS_LOG_FUNCTION (this);
+  return m_nRecomputedRoots;
+}
+
+bool
+GlobalRouteManagerImpl::SPFEdge::operator< (const SPFEdge &e) const
+{
+  if (from != e.from)
+    {
+      return from < e.from;
+    }
+  if (to != e.to)
+    {
+      return to < e.to;
+    }
+  return metric < e.metric;
+}
+
+bool
+GlobalRouteManagerImpl::IsIncremental (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  BooleanValue incremental;
+  g_globalRoutingIncremental.GetValue (incremental);
+  return incremental.Get ();
+}
+
+bool
+GlobalRouteManagerImpl::IsAggregated (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  BooleanValue aggregated;
+  g_globalRoutingAggregateRoutes.GetValue (aggregated);
+  return aggregated.Get ();
+}
+
+namespace {
+
+/**
+ * A prefix of the aggregated routes, with the index of its next hops.
+ */
+struct AggregatePrefix
+{
+  uint32_t network; //!< the network, with its host bits cleared
+  uint8_t length; //!< the prefix length
+  uint32_t hops; //!< the index of the next hops of the prefix
+};
+
+/**
+ * Get the mask of a prefix length.
+ * \param length the prefix length
+ * \returns the mask
+ */
+uint32_t
+GetPrefixMask (uint8_t length)
+{
+  return length == 0 ? 0 : 0xffffffffu << (32 - length);
+}
+
+/**
+ * Compare two prefixes by network, then by length, so that a prefix
+ * comes right before the prefixes it contains.
+ * \param a the first prefix
+ * \param b the second prefix
+ * \returns true if a comes first
+ */
+bool
+IsPrefixBefore (const AggregatePrefix &a, const AggregatePrefix &b)
+{
+  if (a.network != b.network)
+    {
+      return a.network < b.network;
+    }
+  return a.length < b.length;
+}
+
+/**
+ * Test if a prefix contains another.
+ * \param a the first prefix
+ * \param b the second prefix
+ * \returns true if a contains b
+ */
+bool
+IsPrefixOf (const AggregatePrefix &a, const AggregatePrefix &b)
+{
+  return a.length <= b.length && (b.network & GetPrefixMask (a.length)) == a.network;
+}
+
+} // anonymous namespace
+
+void
+GlobalRouteManagerImpl::AggregateRoutes (std::vector<SPFRoute> &routes)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  typedef std::pair<uint32_t, uint32_t> NextHop; // the next hop and the interface
+  typedef std::pair<uint8_t, uint32_t> Prefix; // the prefix length and the network
+//
+// Gather the distinct next hops of each prefix, in order, and keep the
+// external routes as they are.
+//
+  std::vector<SPFRoute> aggregated;
+  std::map<Prefix, std::pair<SPFRoute::Type, std::vector<NextHop> > > prefixes;
+  for (std::vector<SPFRoute>::const_iterator i = routes.begin (); i != routes.end (); i++)
+    {
+      if (i->type == SPFRoute::EXTERNAL)
+        {
+          aggregated.push_back (*i);
+          continue;
+        }
+      NS_ASSERT (i->type == SPFRoute::HOST || i->type == SPFRoute::NETWORK);
+      uint8_t length = i->type == SPFRoute::HOST ? 32 : i->mask.GetPrefixLength ();
+      Prefix prefix (length, i->dest.Get () & GetPrefixMask (length));
+      std::pair<SPFRoute::Type, std::vector<NextHop> > &entry = prefixes[prefix];
+      if (entry.second.empty ())
+        {
+          entry.first = i->type;
+        }
+      else if (entry.first != i->type)
+        {
+          NS_LOG_LOGIC ("Host and network routes to " << i->dest << ", not aggregated");
+          return;
+        }
+      NextHop hop (i->nextHop.Get (), i->interface);
+      if (std::find (entry.second.begin (), entry.second.end (), hop) == entry.second.end ())
+        {
+          entry.second.push_back (hop);
+        }
+    }
+//
+// The first matching network route is used, whatever its length: nested
+// networks are left as they are.  Each distinct list of next hops is
+// stored once.
+//
+  std::vector<AggregatePrefix> networks;
+  std::map<std::vector<NextHop>, uint32_t> hopIndices;
+  std::vector<const std::vector<NextHop> *> hops;
+  std::map<Prefix, uint32_t> table;
+  for (std::map<Prefix, std::pair<SPFRoute::Type, std::vector<NextHop> > >::const_iterator i = prefixes.begin ();
+       i != prefixes.end (); i++)
+    {
+      std::pair<std::map<std::vector<NextHop>, uint32_t>::iterator, bool> inserted =
+        hopIndices.insert (std::make_pair (i->second.second, hops.size ()));
+      if (inserted.second)
+        {
+          hops.push_back (&inserted.first->first);
+        }
+      table[i->first] = inserted.first->second;
+      if (i->second.first == SPFRoute::NETWORK)
+        {
+          AggregatePrefix network = { i->first.second, i->first.first, 0 };
+          networks.push_back (network);
+        }
+    }
+  std::sort (networks.begin (), networks.end (), &IsPrefixBefore);
+  for (uint32_t i = 1; i < networks.size (); i++)
+    {
+      if (IsPrefixOf (networks[i - 1], networks[i]))
+        {
+          NS_LOG_LOGIC ("Nested networks, not aggregated");
+          return;
+        }
+    }
+//
+// Merge the sibling prefixes with the same next hops, from the longest.
+//
+  for (uint8_t length = 32; length > 0; length--)
+    {
+      uint32_t bit = 1u << (32 - length);
+      std::vector<Prefix> merged;
+      std::map<Prefix, uint32_t>::const_iterator end = table.lower_bound (Prefix (length + 1, 0));
+      for (std::map<Prefix, uint32_t>::const_iterator i = table.lower_bound (Prefix (length, 0)); i != end; i++)
+        {
+          if (i->first.second & bit)
+            {
+              continue;
+            }
+          std::map<Prefix, uint32_t>::const_iterator sibling = table.find (Prefix (length, i->first.second | bit));
+          if (sibling != table.end () && sibling->second == i->second
+              && table.find (Prefix (length - 1, i->first.second)) == table.end ())
+            {
+              merged.push_back (i->first);
+            }
+        }
+      for (uint32_t i = 0; i < merged.size (); i++)
+        {
+          uint32_t index = table[merged[i]];
+          table.erase (merged[i]);
+          table.erase (Prefix (length, merged[i].second | bit));
+          table[Prefix (length - 1, merged[i].second)] = index;
+        }
+    }
+//
+// Drop the prefixes with the same next hops as the longest prefix
+// containing them.
+//
+  std::vector<AggregatePrefix> sorted;
+  for (std::map<Prefix, uint32_t>::const_iterator i = table.begin (); i != table.end (); i++)
+    {
+      AggregatePrefix prefix = { i->first.second, i->first.first, i->second };
+      sorted.push_back (prefix);
+    }
+  std::sort (sorted.begin (), sorted.end (), &IsPrefixBefore);
+  std::vector<AggregatePrefix> containing;
+  for (uint32_t i = 0; i < sorted.size (); i++)
+    {
+      while (!containing.empty () && !IsPrefixOf (containing.back (), sorted[i]))
+        {
+          containing.pop_back ();
+        }
+      if (!containing.empty () && containing.back ().hops == sorted[i].hops)
+        {
+          continue;
+        }
+      containing.push_back (sorted[i]);
+      SPFRoute route;
+      route.type = SPFRoute::COMPACT;
+      route.dest = Ipv4Address (sorted[i].network);
+      route.mask = Ipv4Mask (GetPrefixMask (sorted[i].length));
+      const std::vector<NextHop> &nextHops = *hops[sorted[i].hops];
+      for (uint32_t j = 0; j < nextHops.size (); j++)
+        {
+          route.nextHop = Ipv4Address (nextHops[j].first);
+          route.interface = nextHops[j].second;
+          aggregated.push_back (route);
+        }
+    }
+  NS_LOG_LOGIC (routes.size () << " routes aggregated into " << aggregated.size ());
+  routes.swap (aggregated);
+}
+
+void
+GlobalRouteManagerImpl::NumberVertices (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_lsaNumbers.resize (m_lsdb->GetNumLSAs ());
+  for (uint32_t i = 0; i < m_lsdb->GetNumLSAs (); i++)
+    {
+      uint32_t number = m_vertexNumbers.size ();
+      m_lsaNumbers[i] = m_vertexNumbers.insert (std::make_pair (m_lsdb->GetLSAByIndex (i)->GetLinkStateId (),
+                                                                number)).first->second;
+    }
+}
+
+void
+GlobalRouteManagerImpl::CacheVertex (SPFVertex* v)
+{
+  NS_LOG_FUNCTION (this << v);
+  if (!m_root->cached)
+    {
+      return;
+    }
+  std::vector<SPFVertex::NodeExit_t> exits;
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      exits.push_back (v->GetRootExitDirection (i));
+    }
+  std::pair<std::map<std::vector<SPFVertex::NodeExit_t>, uint32_t>::iterator, bool> exitSet =
+    m_exitSetIndex.insert (std::make_pair (exits, m_root->exitSets.size ()));
+  if (exitSet.second)
+    {
+      m_root->exitSets.push_back (exits);
+    }
+  uint32_t number = m_lsaNumbers[m_lsdb->GetLSAIndex (v->GetLSA ())];
+  if (number >= m_root->distance.size ())
+    {
+      m_root->distance.resize (number + 1, SPF_INFINITY);
+      m_root->exitSet.resize (number + 1, 0);
+    }
+  m_root->distance[number] = v->GetDistanceFromRoot ();
+  m_root->exitSet[number] = exitSet.first->second;
+  m_root->vertices.push_back (number);
+}
+
+uint32_t
+GlobalRouteManagerImpl::GetCachedDistance (const SPFRoot &root, uint32_t vertex)
+{
+  if (vertex >= root.distance.size ())
+    {
+      return SPF_INFINITY;
+    }
+  return root.distance[vertex];
+}
+
+bool
+GlobalRouteManagerImpl::IsTreeChanged (const SPFRoot &root, const SPFChange &change)
+{
+  NS_LOG_FUNCTION (&root << &change);
+//
+// The vertices get their distance, parents and root exits from the edges on
+// the shortest paths, and their place in the candidate queue from the order
+// these edges are followed in.  An edge off the shortest paths may push a
+// vertex in the queue, but the vertex is moved again when an edge on a
+// shortest path reaches it.
+//
+  for (uint32_t i = 0; i < change.removed.size (); i++)
+    {
+      const SPFEdge &e = change.removed[i];
+      uint32_t from = GetCachedDistance (root, e.from);
+      if (from != SPF_INFINITY && from + e.metric == GetCachedDistance (root, e.to))
+        {
+          return true;
+        }
+    }
+  for (uint32_t i = 0; i < change.added.size (); i++)
+    {
+      const SPFEdge &e = change.added[i];
+      uint32_t from = GetCachedDistance (root, e.from);
+      if (from != SPF_INFINITY && from + e.metric <= GetCachedDistance (root, e.to))
+        {
+          return true;
+        }
+    }
+  for (uint32_t i = 0; i < change.changed.size (); i++)
+    {
+      uint32_t from = GetCachedDistance (root, change.changed[i]);
+      if (from == SPF_INFINITY)
+        {
+          continue;
+        }
+      const std::vector<SPFEdge> &oldEdges = change.oldEdges[i];
+      const std::vector<SPFEdge> &newEdges = change.newEdges[i];
+      std::vector<SPFEdge>::const_iterator o = oldEdges.begin ();
+      std::vector<SPFEdge>::const_iterator n = newEdges.begin ();
+      for (;;)
+        {
+          while (o != oldEdges.end () && from + o->metric != GetCachedDistance (root, o->to))
+            {
+              o++;
+            }
+          while (n != newEdges.end () && from + n->metric != GetCachedDistance (root, n->to))
+            {
+              n++;
+            }
+          if (o == oldEdges.end () || n == newEdges.end ())
+            {
+              if (o != oldEdges.end () || n != newEdges.end ())
+                {
+                  return true;
+                }
+              break;
+            }
+          if (o->to != n->to || o->metric != n->metric)
+            {
+              return true;
+            }
+          o++;
+          n++;
+        }
+    }
+  return false;
+}
+
+void
+GlobalRouteManagerImpl::GetLSAEdges (GlobalRouteManagerLSDB* lsdb, const std::vector<uint32_t> &numbers,
+                                     GlobalRoutingLSA* lsa, uint32_t number, std::vector<SPFEdge> &edges)
+{
+  NS_LOG_FUNCTION (lsdb << lsa << number << &edges);
+//
+// These are the edges SPFNext follows.
+//
+  SPFEdge edge;
+  edge.from = number;
+  if (lsa->GetLSType () == GlobalRoutingLSA::NetworkLSA)
+    {
+      edge.metric = 0;
+      for (uint32_t j = 0; j < lsa->GetNAttachedRouters (); j++)
+        {
+          GlobalRoutingLSA* w_lsa = lsdb->GetLSAByLinkData (lsa->GetAttachedRouter (j));
+          if (w_lsa)
+            {
+              edge.to = numbers[lsdb->GetLSAIndex (w_lsa)];
+              edges.push_back (edge);
+            }
+        }
+      return;
+    }
+  for (uint32_t j = 0; j < lsa->GetNLinkRecords (); j++)
+    {
+      GlobalRoutingLinkRecord *l = lsa->GetLinkRecord (j);
+      if (l->GetLinkType () == GlobalRoutingLinkRecord::StubNetwork)
+        {
+          continue;
+        }
+      GlobalRoutingLSA* w_lsa = lsdb->GetLSA (l->GetLinkId ());
+      if (w_lsa)
+        {
+          edge.to = numbers[lsdb->GetLSAIndex (w_lsa)];
+          edge.metric = l->GetMetric ();
+          edges.push_back (edge);
+        }
+    }
+}
+
+void
+GlobalRouteManagerImpl::GetEdges (GlobalRouteManagerLSDB* lsdb, const std::vector<uint32_t> &numbers,
+                                  std::vector<SPFEdge> &edges)
+{
+  NS_LOG_FUNCTION (lsdb << &edges);
+  edges.clear ();
+  for (uint32_t i = 0; i < lsdb->GetNumLSAs (); i++)
+    {
+      GetLSAEdges (lsdb, numbers, lsdb->GetLSAByIndex (i), numbers[i], edges);
+    }
+  std::sort (edges.begin (), edges.end ());
+}
+
+bool
+GlobalRouteManagerImpl::IsSameLSA (GlobalRoutingLSA* a, GlobalRoutingLSA* b)
+{
+  NS_LOG_FUNCTION (a << b);
+  if (a->GetLSType () != b->GetLSType ()
+      || a->GetLinkStateId () != b->GetLinkStateId ()
+      || a->GetAdvertisingRouter () != b->GetAdvertisingRouter ()
+      || a->GetNetworkLSANetworkMask () != b->GetNetworkLSANetworkMask ()
+      || a->GetNAttachedRouters () != b->GetNAttachedRouters ()
+      || a->GetNLinkRecords () != b->GetNLinkRecords ())
+    {
+      return false;
+    }
+  for (uint32_t i = 0; i < a->GetNAttachedRouters (); i++)
+    {
+      if (a->GetAttachedRouter (i) != b->GetAttachedRouter (i))
+        {
+          return false;
+        }
+    }
+  for (uint32_t i = 0; i < a->GetNLinkRecords (); i++)
+    {
+      GlobalRoutingLinkRecord *la = a->GetLinkRecord (i);
+      GlobalRoutingLinkRecord *lb = b->GetLinkRecord (i);
+      if (la->GetLinkType () != lb->GetLinkType ()
+          || la->GetLinkId () != lb->GetLinkId ()
+          || la->GetLinkData () != lb->GetLinkData ()
+          || la->GetMetric () != lb->GetMetric ())
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+bool
+GlobalRouteManagerImpl::IsSameExtLSAs (GlobalRouteManagerLSDB* a, GlobalRouteManagerLSDB* b)
+{
+  NS_LOG_FUNCTION (a << b);
+  if (a->GetNumExtLSAs () != b->GetNumExtLSAs ())
+    {
+      return false;
+    }
+  for (uint32_t i = 0; i < a->GetNumExtLSAs (); i++)
+    {
+      if (!IsSameLSA (a->GetExtLSA (i), b->GetExtLSA (i)))
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+void
+GlobalRouteManagerImpl::GetCachedRoutes (SPFRoot &root, const std::vector<GlobalRoutingLSA*> &lsas) const
+{
+  NS_LOG_FUNCTION (this << &root);
+  SPFRoute route;
+  for (uint32_t i = 1; i < root.vertices.size (); i++)
+    {
+      GlobalRoutingLSA* lsa = lsas[root.vertices[i]];
+      const std::vector<SPFVertex::NodeExit_t> &exits = root.exitSets[root.exitSet[root.vertices[i]]];
+      if (lsa->GetLSType () == GlobalRoutingLSA::NetworkLSA)
+        {
+          route.type = SPFRoute::NETWORK;
+          route.mask = lsa->GetNetworkLSANetworkMask ();
+          route.dest = lsa->GetLinkStateId ().CombineMask (route.mask);
+          for (uint32_t k = 0; k < exits.size (); k++)
+            {
+              if (exits[k].second >= 0)
+                {
+                  route.nextHop = exits[k].first;
+                  route.interface = exits[k].second;
+                  root.routes.push_back (route);
+                }
+            }
+          continue;
+        }
+      for (uint32_t j = 0; j < lsa->GetNLinkRecords (); j++)
+        {
+          GlobalRoutingLinkRecord *l = lsa->GetLinkRecord (j);
+          if (l->GetLinkType () != GlobalRoutingLinkRecord::PointToPoint)
+            {
+              continue;
+            }
+          route.type = SPFRoute::HOST;
+          route.dest = l->GetLinkData ();
+          route.mask = Ipv4Mask::GetOnes ();
+          for (uint32_t k = 0; k < exits.size (); k++)
+            {
+              if (exits[k].second >= 0)
+                {
+                  route.nextHop = exits[k].first;
+                  route.interface = exits[k].second;
+                  root.routes.push_back (route);
+                }
+            }
+        }
+    }
+  for (uint32_t i = 0; i < root.stubVertices.size (); i++)
+    {
+      if (root.stubVertices[i] == root.vertices[0])
+        {
+          continue;
+        }
+      GlobalRoutingLSA* lsa = lsas[root.stubVertices[i]];
+      const std::vector<SPFVertex::NodeExit_t> &exits = root.exitSets[root.exitSet[root.stubVertices[i]]];
+      for (uint32_t j = 0; j < lsa->GetNLinkRecords (); j++)
+        {
+          GlobalRoutingLinkRecord *l = lsa->GetLinkRecord (j);
+          if (l->GetLinkType () != GlobalRoutingLinkRecord::StubNetwork)
+            {
+              continue;
+            }
+          route.type = SPFRoute::NETWORK;
+          route.mask = Ipv4Mask (l->GetLinkData ().Get ());
+          route.dest = l->GetLinkId ().CombineMask (route.mask);
+          for (uint32_t k = 0; k < exits.size (); k++)
+            {
+              if (exits[k].second >= 0)
+                {
+                  route.nextHop = exits[k].first;
+                  route.interface = exits[k].second;
+                  root.routes.push_back (route);
+                }
+            }
+        }
+    }
+//
+// The advertising router of an external LSA is found at most once in the
+// tree, wherever it is.
+//
+  for (uint32_t i = 0; i < m_lsdb->GetNumExtLSAs (); i++)
+    {
+      GlobalRoutingLSA *extlsa = m_lsdb->GetExtLSA (i);
+      std::map<Ipv4Address, uint32_t>::const_iterator number = m_vertexNumbers.find (extlsa->GetAdvertisingRouter ());
+      if (number == m_vertexNumbers.end ()
+          || number->second == root.vertices[0]
+          || GetCachedDistance (root, number->second) == SPF_INFINITY
+          || lsas[number->second] == 0
+          || lsas[number->second]->GetLSType () != GlobalRoutingLSA::RouterLSA)
+        {
+          continue;
+        }
+      const std::vector<SPFVertex::NodeExit_t> &exits = root.exitSets[root.exitSet[number->second]];
+      route.type = SPFRoute::EXTERNAL;
+      route.mask = extlsa->GetNetworkLSANetworkMask ();
+      route.dest = extlsa->GetLinkStateId ().CombineMask (route.mask);
+      for (uint32_t k = 0; k < exits.size (); k++)
+        {
+          if (exits[k].second >= 0)
+            {
+              route.nextHop = exits[k].first;
+              route.interface = exits[k].second;
+              root.routes.push_back (route);
+            }
+        }
+    }
+}
+
+void
+GlobalRouteManagerImpl::DeleteRoutes (Ptr<Ipv4GlobalRouting> routing)
+{
+  NS_LOG_FUNCTION (routing);
+  routing->SetCompactRoutes (std::vector<Ipv4GlobalRouting::CompactRoute> ());
+  uint32_t nRoutes = routing->GetNRoutes ();
+  // Each time we delete route 0, the route index shifts downward
+  // We can delete all routes if we delete the route numbered 0
+  // nRoutes times
+  for (uint32_t j = 0; j < nRoutes; j++)
+    {
+      routing->RemoveRoute (0);
+    }
+}
+
+void
+GlobalRouteManagerImpl::SPFCalculateWork (void)
+{
+  NS_LOG_FUNCTION (this);
+#ifdef HAVE_PTHREAD_H
+  for (;;)
+    {
+      uint32_t index;
+      {
+        CriticalSection cs (m_work->mutex);
+        if (m_work->next == m_work->end)
+          {
+            break;
+          }
+        index = m_work->next++;
+      }
+      m_root = (*m_work->roots)[index];
+      SPFCalculate (m_root->routerId);
+      if (m_root->aggregated)
+        {
+          AggregateRoutes (m_root->routes);
+        }
+    }
+  m_root = 0;
+#endif /* HAVE_PTHREAD_H */
+}
+
+uint32_t
+GlobalRouteManagerImpl::GetNThreads (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  UintegerValue threads;
+  g_globalRoutingThreads.GetValue (threads);
+  uint32_t nThreads = threads.Get ();
+#ifdef HAVE_PTHREAD_H
+  if (nThreads == 0)
+    {
+      long nProcessors = sysconf (_SC_NPROCESSORS_ONLN);
+      nThreads = nProcessors > 0 ? nProcessors : 1;
+    }
+#endif /* HAVE_PTHREAD_H */
+  return std::max<uint32_t> (nThreads, 1);
+}
+
+void
+GlobalRouteManagerImpl::InitializeRoot (Ptr<Node> node, Ipv4Address routerId, SPFRoot &root)
+{
+  NS_LOG_FUNCTION (node << routerId << &root);
+  root.routerId = routerId;
+  root.routing = 0;
+  root.addresses.clear ();
+  root.routes.clear ();
+  root.cached = false;
+  root.stub = false;
+  root.aggregated = false;
+  root.distance.clear ();
+  root.exitSet.clear ();
+  root.exitSets.clear ();
+  root.vertices.clear ();
+  root.stubVertices.clear ();
+  if (node == 0)
+    {
+      return;
+    }
+//
+// Routing information is updated using the Ipv4 interface.  If the node is
+// acting as an IP version 4 router, it should absolutely have an Ipv4
+// interface.
+//
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  NS_ASSERT_MSG (ipv4, 
+                 "GlobalRouteManagerImpl::InitializeRoot (): "
+                 "GetObject for <Ipv4> interface failed");
+  root.addresses.resize (ipv4->GetNInterfaces ());
+  for (uint32_t i = 0; i < ipv4->GetNInterfaces (); i++)
+    {
+      for (uint32_t j = 0; j < ipv4->GetNAddresses (i); j++)
+        {
+          root.addresses[i].push_back (ipv4->GetAddress (i, j).GetLocal ());
+        }
+    }
+  Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
+  NS_ASSERT (router);
+  root.routing = router->GetRoutingProtocol ();
+  NS_ASSERT (root.routing);
+}
+
+void
+GlobalRouteManagerImpl::InstallRoutes (SPFRoot &root, bool replace)
+{
+  NS_LOG_FUNCTION (&root << replace);
+//
+// The routes of a root whose node was not found, as in the unit tests of
+// the LSDB, are dropped.
+//
+  if (root.routing == 0)
+    {
+      return;
+    }
+  std::vector<Ipv4GlobalRouting::CompactRoute> compactRoutes;
+  std::vector<Ipv4RoutingTableEntry> hostRoutes;
+  std::vector<Ipv4RoutingTableEntry> networkRoutes;
+  std::vector<Ipv4RoutingTableEntry> externalRoutes;
+  for (std::vector<SPFRoute>::const_iterator i = root.routes.begin (); i != root.routes.end (); i++)
+    {
+      Ipv4GlobalRouting::CompactRoute compact;
+      switch (i->type)
+        {
+        case SPFRoute::HOST:
+          if (replace)
+            {
+              hostRoutes.push_back (Ipv4RoutingTableEntry::CreateHostRouteTo (i->dest, i->nextHop, i->interface));
+            }
+          else
+            {
+              root.routing->AddHostRouteTo (i->dest, i->nextHop, i->interface);
+            }
+          break;
+        case SPFRoute::NETWORK:
+          if (replace)
+            {
+              networkRoutes.push_back (Ipv4RoutingTableEntry::CreateNetworkRouteTo (i->dest, i->mask,
+                                                                                    i->nextHop, i->interface));
+            }
+          else
+            {
+              root.routing->AddNetworkRouteTo (i->dest, i->mask, i->nextHop, i->interface);
+            }
+          break;
+        case SPFRoute::EXTERNAL:
+          if (replace)
+            {
+              externalRoutes.push_back (Ipv4RoutingTableEntry::CreateNetworkRouteTo (i->dest, i->mask,
+                                                                                     i->nextHop, i->interface));
+            }
+          else
+            {
+              root.routing->AddASExternalRouteTo (i->dest, i->mask, i->nextHop, i->interface);
+            }
+          break;
+        case SPFRoute::COMPACT:
+          compact.network = i->dest.Get ();
+          compact.gateway = i->nextHop.Get ();
+          compact.interface = i->interface;
+          compact.prefixLength = i->mask.GetPrefixLength ();
+          compactRoutes.push_back (compact);
+          break;
+        }
+    }
+  if (replace)
+    {
+      root.routing->SetRoutes (hostRoutes, networkRoutes, externalRoutes);
+    }
+  if (replace || !compactRoutes.empty ())
+    {
+      root.routing->SetCompactRoutes (compactRoutes);
+    }
+}
+
+void
+GlobalRouteManagerImpl::AddRoute (SPFRoute::Type type, Ipv4Address dest, Ipv4Mask mask,
+                                  Ipv4Address nextHop, uint32_t interface)
 {
-  NS_LOG_FUNCTION (this);
-//
-// Walk the list of nodes in the system.
-//
-  NS_LOG_INFO ("About to start SPF calculation");
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
-    {
-      Ptr<Node> node = *i;
-//
-// Look for the GlobalRouter interface that indicates that the node is
-// participating in routing.
-//
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
+  NS_LOG_FUNCTION (this << type << dest << mask << nextHop << interface);
+  NS_ASSERT_MSG (m_root, "GlobalRouteManagerImpl::AddRoute (): Root not set");
+  SPFRoute route;
+  route.type = type;
+  route.dest = dest;
+  route.mask = mask;
+  route.nextHop = nextHop;
+  route.interface = interface;
+  m_root->routes.push_back (route);
+}
 
-      uint32_t systemId = MpiInterface::GetSystemId ();
-      // Ignore nodes that are not assigned to our systemId (distributed sim)
-      if (node->GetSystemId () != systemId) 
-        {
-          continue;
-        }
+GlobalRoutingLSA::SPFStatus
+GlobalRouteManagerImpl::GetLSAStatus (GlobalRoutingLSA* lsa) const
+{
+  return m_lsaStatus[m_lsdb->GetLSAIndex (lsa)];
+}
 
-//
-// if the node has a global router interface, then run the global routing
-// algorithms.
-//
-      if (rtr && rtr->GetNumLSAs () )
-        {
-          SPFCalculate (rtr->GetRouterId ());
-        }
-    }
-  NS_LOG_INFO ("Finished SPF calculation");
+void
+GlobalRouteManagerImpl::SetLSAStatus (GlobalRoutingLSA* lsa, GlobalRoutingLSA::SPFStatus status)
+{
+  m_lsaStatus[m_lsdb->GetLSAIndex (lsa)] = status;
 }
 
 //
@@ -836,7 +2122,7 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
 // If the link is to a router that is already in the shortest path first tree
 // then we have it covered -- ignore it.
 //
-      if (w_lsa->GetStatus () == GlobalRoutingLSA::LSA_SPF_IN_SPFTREE) 
+      if (GetLSAStatus (w_lsa) == GlobalRoutingLSA::LSA_SPF_IN_SPFTREE) 
         {
           NS_LOG_LOGIC ("Skipping ->  LSA "<< 
                         w_lsa->GetLinkStateId () << " already in SPF tree");
@@ -861,7 +2147,7 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
       NS_LOG_LOGIC ("Considering w_lsa " << w_lsa->GetLinkStateId ());
 
 // Is there already vertex w in candidate list?
-      if (w_lsa->GetStatus () == GlobalRoutingLSA::LSA_SPF_NOT_EXPLORED)
+      if (GetLSAStatus (w_lsa) == GlobalRoutingLSA::LSA_SPF_NOT_EXPLORED)
         {
 // Calculate nexthop to w
 // We need to figure out how to actually get to the new router represented
@@ -870,10 +2156,10 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
 // used to forward the packets.
 
 // prepare vertex w
-          w = new SPFVertex (w_lsa);
+          w = new (m_vertexArena) SPFVertex (w_lsa);
           if (SPFNexthopCalculation (v, w, l, distance))
             {
-              w_lsa->SetStatus (GlobalRoutingLSA::LSA_SPF_CANDIDATE);
+              SetLSAStatus (w_lsa, GlobalRoutingLSA::LSA_SPF_CANDIDATE);
 //
 // Push this new vertex onto the priority queue (ordered by distance from the
 // root node).
@@ -888,7 +2174,7 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
             NS_ASSERT_MSG (0, "SPFNexthopCalculation never " 
                            << "return false, but it does now!");
         }
-      else if (w_lsa->GetStatus () == GlobalRoutingLSA::LSA_SPF_CANDIDATE)
+      else if (GetLSAStatus (w_lsa) == GlobalRoutingLSA::LSA_SPF_CANDIDATE)
         {
 //
 // We have already considered the link represented by <w>.  What wse have to
@@ -934,7 +2220,7 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
 // is very different from quagga (blame ns3::GlobalRouteManagerImpl)
 
 // prepare vertex w
-              w = new SPFVertex (w_lsa);
+              w = new (m_vertexArena) SPFVertex (w_lsa);
               SPFNexthopCalculation (v, w, l, distance);
               cw->MergeRootExitDirections (w);
               cw->MergeParent (w);
@@ -958,9 +2244,9 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
                 {
 //
 // If we've changed the cost to get to the vertex represented by <w>, we 
-// must reorder the priority queue keyed to that cost.
+// must restore its position in the priority queue keyed to that cost.
 //
-                  candidate.Reorder ();
+                  candidate.DecreaseKey (cw);
                 }
             } // new lower cost path found
         } // end W is already on the candidate list
@@ -1124,7 +2410,11 @@ GlobalRouteManagerImpl::SPFNexthopCalculation (
         }
       else 
         {
-          w->SetRootExitDirection (v->GetRootExitDirection ());
+//
+// The network may be reached from the root by several equal-cost paths,
+// whose exits the router behind it inherits.
+//
+          w->InheritAllRootExitDirections (v);
         }
     }
   else 
@@ -1247,9 +2537,24 @@ void
 GlobalRouteManagerImpl::DebugSPFCalculate (Ipv4Address root)
 {
   NS_LOG_FUNCTION (this << root);
+  Ptr<Node> node;
+  NodeList::Iterator listEnd = NodeList::End ();
+  for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
+    {
+      Ptr<GlobalRouter> rtr = (*i)->GetObject<GlobalRouter> ();
+      if (rtr && rtr->GetRouterId () == root)
+        {
+          node = *i;
+          break;
+        }
+    }
+  SPFRoot spfRoot;
+  InitializeRoot (node, root, spfRoot);
+  m_root = &spfRoot;
   SPFCalculate (root);
+  InstallRoutes (spfRoot, false);
+  m_root = 0;
 }
-
 //
 // Used to test if a node is a stub, from an OSPF sense.
 // If there is only one link of type 1 or 2, then a default route
@@ -1320,12 +2625,8 @@ GlobalRouteManagerImpl::CheckForStubNode (Ipv4Address root)
               if (lr->GetLinkId () == myRouterId)
                 {
                   // Next hop is stored in the LinkID field of lr
-                  Ptr<GlobalRouter> router = rlsa->GetNode ()->GetObject<GlobalRouter> ();
-                  NS_ASSERT (router);
-                  Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-                  NS_ASSERT (gr);
-                  gr->AddNetworkRouteTo (Ipv4Address ("0.0.0.0"), Ipv4Mask ("0.0.0.0"), lr->GetLinkData (), 
-                                         FindOutgoingInterfaceId (transitLink->GetLinkData ()));
+                  AddRoute (SPFRoute::NETWORK, Ipv4Address ("0.0.0.0"), Ipv4Mask ("0.0.0.0"), lr->GetLinkData (), 
+                            FindOutgoingInterfaceId (transitLink->GetLinkData ()));
                   NS_LOG_LOGIC ("Inserting default route for node " << myRouterId << " to next hop " << 
                                 lr->GetLinkData () << " via interface " << 
                                 FindOutgoingInterfaceId (transitLink->GetLinkData ()));
@@ -1345,9 +2646,10 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 
   SPFVertex *v;
 //
-// Initialize the Link State Database.
+// Initialize the status of the LSAs.  It is kept apart from the LSAs, which
+// other calculations may be using.
 //
-  m_lsdb->Initialize ();
+  m_lsaStatus.assign (m_lsdb->GetNumLSAs (), GlobalRoutingLSA::LSA_SPF_NOT_EXPLORED);
 //
 // The candidate queue is a priority queue of SPFVertex objects, with the top
 // of the queue being the closest vertex in terms of distance from the root
@@ -1360,15 +2662,30 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 // calculation.  Each router (and corresponding network) is a vertex in the
 // shortest path first (SPF) tree.
 //
-  v = new SPFVertex (m_lsdb->GetLSA (root));
+  v = new (m_vertexArena) SPFVertex (m_lsdb->GetLSA (root));
 // 
 // This vertex is the root of the SPF tree and it is distance 0 from the root.
 // We also mark this vertex as being in the SPF tree.
 //
   m_spfroot= v;
   v->SetDistanceFromRoot (0);
-  v->GetLSA ()->SetStatus (GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
+  SetLSAStatus (v->GetLSA (), GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
   NS_LOG_LOGIC ("Starting SPFCalculate for node " << root);
+//
+// Keep the distances and the root exits of the vertices of the tree, which
+// tell UpdateRoutes whether the tree is changed by a change of the LSDB.
+//
+  if (m_root->cached)
+    {
+      m_root->stub = false;
+      m_root->distance.clear ();
+      m_root->exitSet.clear ();
+      m_root->exitSets.clear ();
+      m_root->vertices.clear ();
+      m_root->stubVertices.clear ();
+      m_exitSetIndex.clear ();
+    }
+  CacheVertex (v);
 
 //
 // Optimize SPF calculation, for ns-3.
@@ -1377,9 +2694,10 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 // reached.  Instead, short-circuit this computation and just install
 // a default route in the CheckForStubNode() method.
 //
-  if (NodeList::GetNNodes () > 0 && CheckForStubNode (root))
+  if (m_root->routing && CheckForStubNode (root))
     {
       NS_LOG_LOGIC ("SPFCalculate truncated for stub node " << root);
+      m_root->stub = true;
       delete m_spfroot;
       return;
     }
@@ -1428,7 +2746,8 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 // Update the status field of the vertex to indicate that it is in the SPF
 // tree.
 //
-      v->GetLSA ()->SetStatus (GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
+      SetLSAStatus (v->GetLSA (), GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
+      CacheVertex (v);
 //
 // The current vertex has a parent pointer.  By calling this rather oddly 
 // named method (blame quagga) we add the current vertex to the list of 
@@ -1502,6 +2821,7 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 //
   delete m_spfroot;
   m_spfroot = 0;
+  m_exitSetIndex.clear ();
 }
 
 void
@@ -1560,108 +2880,52 @@ GlobalRouteManagerImpl::SPFAddASExternal (GlobalRoutingLSA *extlsa, SPFVertex *v
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
-//
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
-    {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to QI for that interface.  If there's no GlobalRouter interface, the node
-// in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to QI
-// for that interface.  If the node is acting as an IP version 4 router, it
-// should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "QI for <Ipv4> interface failed");
-//
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          NS_ASSERT_MSG (v->GetLSA (), 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask = extlsa->GetNetworkLSANetworkMask ();
-          Ipv4Address tempip = extlsa->GetLinkStateId ();
-          tempip = tempip.CombineMask (tempmask);
-
-//
-// Here's why we did all of that work.  We're going to add a host route to the
-// host address found in the m_linkData field of the point-to-point link
-// record.  In the case of a point-to-point link, this is the local IP address
-// of the node connected to the link.  Each of these point-to-point links
-// will correspond to a local interface that has an IP address to which
-// the node at the root of the SPF tree can send packets.  The vertex <v> 
-// (corresponding to the node that has these links and interfaces) has 
-// an m_nextHop address precalculated for us that is the address to which the
-// root node should send packets to be forwarded to these IP addresses.
-// Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
-// which the packets should be send for forwarding.
-//
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all next-hop-IPs and out-going-interfaces for reaching
-          // the stub network gateway 'v' from the root node
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
-              if (outIf >= 0)
-                {
-                  gr->AddASExternalRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add external network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative");
-                }
-            }
-          return;
-        } // if
-    } // for
+  NS_ASSERT_MSG (v->GetLSA (), 
+                 "GlobalRouteManagerImpl::SPFAddASExternal (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask = extlsa->GetNetworkLSANetworkMask ();
+  Ipv4Address tempip = extlsa->GetLinkStateId ();
+  tempip = tempip.CombineMask (tempmask);
+
+//
+// Here's why we did all of that work.  We're going to add a route to the
+// external network, for the node at the root of the SPF tree.  The vertex
+// <v> (corresponding to the router advertising the external) has an
+// m_nextHop address precalculated for us that is the address to which the
+// root node should send packets to be forwarded to the network.  Similarly,
+// the vertex <v> has an m_rootOif (outbound interface index) to which the
+// packets should be send for forwarding.
+//
+  // walk through all next-hop-IPs and out-going-interfaces for reaching
+  // the stub network gateway 'v' from the root node
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
+      if (outIf >= 0)
+        {
+          AddRoute (SPFRoute::EXTERNAL, tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Router " << routerId <<
+                        " add external network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
+        }
+      else
+        {
+          NS_LOG_LOGIC ("(Route " << i << ") Router " << routerId <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative");
+        }
+    }
 }
 
-
 // Processing logic from RFC 2328, page 166 and quagga ospf_spf_process_stubs ()
 // stub link records will exist for point-to-point interfaces and for
 // broadcast interfaces for which no neighboring router can be found
@@ -1674,6 +2938,10 @@ GlobalRouteManagerImpl::SPFProcessStubs (SPFVertex* v)
     {
       GlobalRoutingLSA *rlsa = v->GetLSA ();
       NS_LOG_LOGIC ("Processing router LSA with id " << rlsa->GetLinkStateId ());
+      if (m_root->cached)
+        {
+          m_root->stubVertices.push_back (m_lsaNumbers[m_lsdb->GetLSAIndex (rlsa)]);
+        }
       for (uint32_t i = 0; i < rlsa->GetNLinkRecords (); i++)
         {
           NS_LOG_LOGIC ("Examining link " << i << " of " << 
@@ -1720,196 +2988,88 @@ GlobalRouteManagerImpl::SPFIntraAddStub (GlobalRoutingLinkRecord *l, SPFVertex*
   NS_LOG_LOGIC ("Stub is on remote host: " << v->GetVertexId () << "; installing");
 //
 // The root of the Shortest Path First tree is the router to which we are 
-// going to write the actual routing table entries.  The vertex corresponding
-// to this router has a vertex ID which is the router ID of that node.  We're
-// going to use this ID to discover which node it is that we're actually going
-// to update.
+// going to add the actual routing table entries.  The vertex corresponding
+// to this router has a vertex ID which is the router ID of that node.
 //
   Ipv4Address routerId = m_spfroot->GetVertexId ();
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
-//
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
-    {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to QI for that interface.  If there's no GlobalRouter interface, the node
-// in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to QI
-// for that interface.  If the node is acting as an IP version 4 router, it
-// should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "QI for <Ipv4> interface failed");
-//
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          NS_ASSERT_MSG (v->GetLSA (), 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask (l->GetLinkData ().Get ());
-          Ipv4Address tempip = l->GetLinkId ();
-          tempip = tempip.CombineMask (tempmask);
-//
-// Here's why we did all of that work.  We're going to add a host route to the
-// host address found in the m_linkData field of the point-to-point link
-// record.  In the case of a point-to-point link, this is the local IP address
-// of the node connected to the link.  Each of these point-to-point links
-// will correspond to a local interface that has an IP address to which
-// the node at the root of the SPF tree can send packets.  The vertex <v> 
-// (corresponding to the node that has these links and interfaces) has 
-// an m_nextHop address precalculated for us that is the address to which the
-// root node should send packets to be forwarded to these IP addresses.
-// Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
-// which the packets should be send for forwarding.
-//
-
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all next-hop-IPs and out-going-interfaces for reaching
-          // the stub network gateway 'v' from the root node
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
-              if (outIf >= 0)
-                {
-                  gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative");
-                }
-            }
-          return;
-        } // if
-    } // for
+  NS_ASSERT_MSG (v->GetLSA (), 
+                 "GlobalRouteManagerImpl::SPFIntraAddStub (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask (l->GetLinkData ().Get ());
+  Ipv4Address tempip = l->GetLinkId ();
+  tempip = tempip.CombineMask (tempmask);
+//
+// Here's why we did all of that work.  We're going to add a route to the
+// stub network found in the link record.  The vertex <v> (corresponding to
+// the node that has the stub network) has an m_nextHop address
+// precalculated for us that is the address to which the root node should
+// send packets to be forwarded to the network.  Similarly, the vertex <v>
+// has an m_rootOif (outbound interface index) to which the packets should
+// be send for forwarding.
+//
+  // walk through all next-hop-IPs and out-going-interfaces for reaching
+  // the stub network gateway 'v' from the root node
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
+      if (outIf >= 0)
+        {
+          AddRoute (SPFRoute::NETWORK, tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Router " << routerId <<
+                        " add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
+        }
+      else
+        {
+          NS_LOG_LOGIC ("(Route " << i << ") Router " << routerId <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative");
+        }
+    }
 }
-
 //
 // Return the interface number corresponding to a given IP address and mask
-// This is a wrapper around GetInterfaceForPrefix(), but we first
-// have to find the right node pointer to pass to that function.
+// This is the equivalent of GetInterfaceForPrefix() on the node at the root
+// of the SPF tree, whose addresses were gathered by InitializeRoot().
 // If no such interface is found, return -1 (note:  unit test framework
 // for routing assumes -1 to be a legal return value)
 //
 int32_t
-GlobalRouteManagerImpl::FindOutgoingInterfaceId (Ipv4Address a, Ipv4Mask amask)
+GlobalRouteManagerImpl::FindOutgoingInterfaceId (Ipv4Address a, Ipv4Mask amask) const
 {
   NS_LOG_FUNCTION (this << a << amask);
+  NS_ASSERT_MSG (m_root, "GlobalRouteManagerImpl::FindOutgoingInterfaceId (): Root not set");
 //
-// We have an IP address <a> and a vertex ID of the root of the SPF tree.
-// The question is what interface index does this address correspond to.
-// The answer is a little complicated since we have to find a pointer to
-// the node corresponding to the vertex ID, find the Ipv4 interface on that
-// node in order to iterate the interfaces and find the one corresponding to
-// the address in question.
-//
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
-//
-// Walk the list of nodes in the system looking for the one corresponding to
-// the node at the root of the SPF tree.  This is the node for which we are
-// building the routing table.
+// Look through the interfaces on the root node for one that has the IP
+// address we're looking for.  If we find one, return the corresponding
+// interface index, or -1 if not found.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  Ipv4Address prefix = a.CombineMask (amask);
+  for (uint32_t i = 0; i < m_root->addresses.size (); i++)
     {
-      Ptr<Node> node = *i;
-
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-//
-// If the node doesn't have a GlobalRouter interface it can't be the one
-// we're interested in.
-//
-      if (rtr == 0)
-        {
-          continue;
-        }
-
-      if (rtr->GetRouterId () == routerId)
+      for (uint32_t j = 0; j < m_root->addresses[i].size (); j++)
         {
-//
-// This is the node we're building the routing table for.  We're going to need
-// the Ipv4 interface to look for the ipv4 interface index.  Since this node
-// is participating in routing IP version 4 packets, it certainly must have 
-// an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::FindOutgoingInterfaceId (): "
-                         "GetObject for <Ipv4> interface failed");
-//
-// Look through the interfaces on this node for one that has the IP address
-// we're looking for.  If we find one, return the corresponding interface
-// index, or -1 if not found.
-//
-          int32_t interface = ipv4->GetInterfaceForPrefix (a, amask);
-
-#if 0
-          if (interface < 0)
+          if (m_root->addresses[i][j].CombineMask (amask) == prefix)
             {
-              NS_FATAL_ERROR ("GlobalRouteManagerImpl::FindOutgoingInterfaceId(): "
-                              "Expected an interface associated with address a:" << a);
+              return i;
             }
-#endif 
-          return interface;
         }
     }
-//
-// Couldn't find it.
-//
-  NS_LOG_LOGIC ("FindOutgoingInterfaceId():Can't find root node " << routerId);
+  NS_LOG_LOGIC ("FindOutgoingInterfaceId():Can't find interface on root node " << m_root->routerId);
   return -1;
 }
-
 //
 // This method is derived from quagga ospf_intra_add_router ()
 //
@@ -1935,69 +3095,24 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
                  "GlobalRouteManagerImpl::SPFIntraAddRouter (): Root pointer not set");
 //
 // The root of the Shortest Path First tree is the router to which we are 
-// going to write the actual routing table entries.  The vertex corresponding
-// to this router has a vertex ID which is the router ID of that node.  We're
-// going to use this ID to discover which node it is that we're actually going
-// to update.
+// going to add the actual routing table entries.  The vertex corresponding
+// to this router has a vertex ID which is the router ID of that node.
 //
   Ipv4Address routerId = m_spfroot->GetVertexId ();
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
-//
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
-    {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to GetObject for that interface.  If there's no GlobalRouter interface, 
-// the node in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to 
-// GetObject for that interface.  If the node is acting as an IP version 4 
-// router, it should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "GetObject for <Ipv4> interface failed");
-//
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          GlobalRoutingLSA *lsa = v->GetLSA ();
-          NS_ASSERT_MSG (lsa, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
+  GlobalRoutingLSA *lsa = v->GetLSA ();
+  NS_ASSERT_MSG (lsa, 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "Expected valid LSA in SPFVertex* v");
 
-          uint32_t nLinkRecords = lsa->GetNLinkRecords ();
+  uint32_t nLinkRecords = lsa->GetNLinkRecords ();
 //
 // Iterate through the link records on the vertex to which we're going to add
 // routes.  To make sure we're being clear, we're going to add routing table
@@ -2006,18 +3121,18 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 // the local side of the point-to-point links found on the node described by
 // the vertex <v>.
 //
-          NS_LOG_LOGIC (" Node " << node->GetId () <<
-                        " found " << nLinkRecords << " link records in LSA " << lsa << "with LinkStateId "<< lsa->GetLinkStateId ());
-          for (uint32_t j = 0; j < nLinkRecords; ++j)
-            {
+  NS_LOG_LOGIC (" Router " << routerId <<
+                " found " << nLinkRecords << " link records in LSA " << lsa << "with LinkStateId "<< lsa->GetLinkStateId ());
+  for (uint32_t j = 0; j < nLinkRecords; ++j)
+    {
 //
 // We are only concerned about point-to-point links
 //
-              GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
-              if (lr->GetLinkType () != GlobalRoutingLinkRecord::PointToPoint)
-                {
-                  continue;
-                }
+      GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
+      if (lr->GetLinkType () != GlobalRoutingLinkRecord::PointToPoint)
+        {
+          continue;
+        }
 //
 // Here's why we did all of that work.  We're going to add a host route to the
 // host address found in the m_linkData field of the point-to-point link
@@ -2031,47 +3146,32 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 // Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
 // which the packets should be send for forwarding.
 //
-              Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-              if (router == 0)
-                {
-                  continue;
-                }
-              Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-              NS_ASSERT (gr);
-              // walk through all available exit directions due to ECMP,
-              // and add host route for each of the exit direction toward
-              // the vertex 'v'
-              for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-                {
-                  SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-                  Ipv4Address nextHop = exit.first;
-                  int32_t outIf = exit.second;
-                  if (outIf >= 0)
-                    {
-                      gr->AddHostRouteTo (lr->GetLinkData (), nextHop,
-                                          outIf);
-                      NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                    " adding host route to " << lr->GetLinkData () <<
-                                    " using next hop " << nextHop <<
-                                    " and outgoing interface " << outIf);
-                    }
-                  else
-                    {
-                      NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                    " NOT able to add host route to " << lr->GetLinkData () <<
-                                    " using next hop " << nextHop <<
-                                    " since outgoing interface id is negative " << outIf);
-                    }
-                } // for all routes from the root the vertex 'v'
+      // walk through all available exit directions due to ECMP,
+      // and add host route for each of the exit direction toward
+      // the vertex 'v'
+      for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+        {
+          SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+          Ipv4Address nextHop = exit.first;
+          int32_t outIf = exit.second;
+          if (outIf >= 0)
+            {
+              AddRoute (SPFRoute::HOST, lr->GetLinkData (), Ipv4Mask::GetOnes (), nextHop, outIf);
+              NS_LOG_LOGIC ("(Route " << i << ") Router " << routerId <<
+                            " adding host route to " << lr->GetLinkData () <<
+                            " using next hop " << nextHop <<
+                            " and outgoing interface " << outIf);
             }
-//
-// Done adding the routes for the selected node.
-//
-          return;
-        }
+          else
+            {
+              NS_LOG_LOGIC ("(Route " << i << ") Router " << routerId <<
+                            " NOT able to add host route to " << lr->GetLinkData () <<
+                            " using next hop " << nextHop <<
+                            " since outgoing interface id is negative " << outIf);
+            }
+        } // for all routes from the root the vertex 'v'
     }
-}
-void
+}void
 GlobalRouteManagerImpl::SPFIntraAddTransit (SPFVertex* v)
 {
   NS_LOG_FUNCTION (this << v);
@@ -2080,106 +3180,51 @@ GlobalRouteManagerImpl::SPFIntraAddTransit (SPFVertex* v)
                  "GlobalRouteManagerImpl::SPFIntraAddTransit (): Root pointer not set");
 //
 // The root of the Shortest Path First tree is the router to which we are 
-// going to write the actual routing table entries.  The vertex corresponding
-// to this router has a vertex ID which is the router ID of that node.  We're
-// going to use this ID to discover which node it is that we're actually going
-// to update.
+// going to add the actual routing table entries.  The vertex corresponding
+// to this router has a vertex ID which is the router ID of that node.
 //
   Ipv4Address routerId = m_spfroot->GetVertexId ();
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
-//
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
-    {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to GetObject for that interface.  If there's no GlobalRouter interface, 
-// the node in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to 
-// GetObject for that interface.  If the node is acting as an IP version 4 
-// router, it should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
-                         "GetObject for <Ipv4> interface failed");
-//
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          GlobalRoutingLSA *lsa = v->GetLSA ();
-          NS_ASSERT_MSG (lsa, 
-                         "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask = lsa->GetNetworkLSANetworkMask ();
-          Ipv4Address tempip = lsa->GetLinkStateId ();
-          tempip = tempip.CombineMask (tempmask);
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all available exit directions due to ECMP,
-          // and add host route for each of the exit direction toward
-          // the vertex 'v'
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
+  GlobalRoutingLSA *lsa = v->GetLSA ();
+  NS_ASSERT_MSG (lsa, 
+                 "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask = lsa->GetNetworkLSANetworkMask ();
+  Ipv4Address tempip = lsa->GetLinkStateId ();
+  tempip = tempip.CombineMask (tempmask);
+  // walk through all available exit directions due to ECMP,
+  // and add host route for each of the exit direction toward
+  // the vertex 'v'
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
 
-              if (outIf >= 0)
-                {
-                  gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative " << outIf);
-                }
-            }
+      if (outIf >= 0)
+        {
+          AddRoute (SPFRoute::NETWORK, tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Router " << routerId <<
+                        " add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
         }
-    } 
+      else
+        {
+          NS_LOG_LOGIC ("(Route " << i << ") Router " << routerId <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative " << outIf);
+        }
+    }
 }
-
 // Derived from quagga ospf_vertex_add_parents ()
 //
 // This is a somewhat oddly named method (blame quagga).  Although you might
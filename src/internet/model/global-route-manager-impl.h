@@ -38,6 +38,56 @@ const uint32_t SPF_INFINITY = 0xffffffff; //!< "infinite" distance between nodes
 
 class CandidateQueue;
 class Ipv4GlobalRouting;
+class Node;
+
+/**
+ * \ingroup globalrouting
+ *
+ * @brief The memory of the SPFVertex objects of one SPF calculation thread.
+ *
+ * The vertices are carved from large chunks, and their memory is kept on
+ * a free list when they are deleted.  The successive SPF calculations of
+ * a thread thus reuse the same memory, without contending for the heap
+ * with the other threads.  An arena must only be used by one thread.
+ */
+class SPFVertexArena
+{
+public:
+  SPFVertexArena ();
+  ~SPFVertexArena ();
+
+  /**
+   * @brief Allocate a block.
+   * @param size the size of the block
+   * @returns the block
+   */
+  void* Allocate (size_t size);
+
+  /**
+   * @brief Put a block back on the free list.
+   * @param block the block
+   */
+  void Release (void *block);
+
+private:
+  /**
+   * @brief The SPFVertexArena copy construction is disallowed.
+   * @param arena object to copy from
+   */
+  SPFVertexArena (SPFVertexArena& arena);
+
+  /**
+   * @brief The SPFVertexArena copy assignment operator is disallowed.
+   * @param arena object to copy from
+   * @returns the copied object
+   */
+  SPFVertexArena& operator= (SPFVertexArena& arena);
+
+  std::vector<char *> m_chunks; //!< the chunks the blocks are carved from
+  std::vector<void *> m_free; //!< the released blocks
+  size_t m_blockSize; //!< the size of the blocks, set by the first allocation
+  size_t m_chunkUsed; //!< the number of bytes used in the last chunk
+};
 
 /**
  * \ingroup globalrouting
@@ -525,6 +575,35 @@ public:
    */
   void ClearVertexProcessed (void);
 
+  /**
+   * @brief Allocate a vertex on the heap.
+   * @param size the size of the vertex
+   * @returns the memory of the vertex
+   */
+  static void* operator new (size_t size);
+
+  /**
+   * @brief Allocate a vertex from an arena.
+   * @param size the size of the vertex
+   * @param arena the arena
+   * @returns the memory of the vertex
+   */
+  static void* operator new (size_t size, SPFVertexArena &arena);
+
+  /**
+   * @brief Release the memory of a vertex, to the heap or to its arena.
+   * @param p the memory of the vertex
+   */
+  static void operator delete (void *p);
+
+  /**
+   * @brief Release the memory of a vertex allocated from an arena, whose
+   * construction failed.
+   * @param p the memory of the vertex
+   * @param arena the arena
+   */
+  static void operator delete (void *p, SPFVertexArena &arena);
+
 private:
   VertexType m_vertexType; //!< Vertex type
   Ipv4Address m_vertexId; //!< Vertex ID
@@ -641,6 +720,35 @@ public:
  */
   GlobalRoutingLSA* GetLSAByLinkData (Ipv4Address addr) const;
 
+/**
+ * @brief Get the number of Link State Advertisements, external ones
+ * excluded.
+ *
+ * @returns the number of Link State Advertisements.
+ */
+  uint32_t GetNumLSAs () const;
+
+/**
+ * @brief Get the index of a Link State Advertisement of the database.
+ *
+ * The indices, from 0 to GetNumLSAs () - 1, let the SPF calculations keep
+ * the status of the LSAs in their own arrays, since several calculations
+ * may use the database at the same time.
+ *
+ * @param lsa A Link State Advertisement of the database, not an external
+ * one.
+ * @returns the index of the LSA.
+ */
+  uint32_t GetLSAIndex (GlobalRoutingLSA* lsa) const;
+
+/**
+ * @brief Get a Link State Advertisement of the database by its index.
+ *
+ * @param index the index of the LSA, from 0 to GetNumLSAs () - 1.
+ * @returns the Link State Advertisement.
+ */
+  GlobalRoutingLSA* GetLSAByIndex (uint32_t index) const;
+
 /**
  * @brief Set all LSA flags to an initialized state, for SPF computation
  *
@@ -681,6 +789,9 @@ private:
 
   LSDBMap_t m_database; //!< database of IPv4 addresses / Link State Advertisements
   std::vector<GlobalRoutingLSA*> m_extdatabase; //!< database of External Link State Advertisements
+  std::map<Ipv4Address, LSDBPair_t> m_linkDataIndex; //!< the first LSA of m_database with a transit network link record, by link data
+  std::map<GlobalRoutingLSA*, uint32_t> m_lsaIndex; //!< the indices of the LSAs of m_database
+  std::vector<GlobalRoutingLSA*> m_lsas; //!< the LSAs of m_database, by index
 
 /**
  * @brief GlobalRouteManagerLSDB copy construction is disallowed.  There's no 
@@ -732,9 +843,50 @@ public:
 /**
  * @brief Compute routes using a Dijkstra SPF computation and populate
  * per-node forwarding tables
+ *
+ * The SPF calculations of the routers are independent: they are spread
+ * over the number of threads set by the GlobalRoutingThreads global value,
+ * 1 by default, or run in sequence when a log component is enabled.
+ * Each thread only reads the LSDB, and the routes it computes are added to
+ * the forwarding tables by the main thread, in the order of the node list,
+ * so that the tables do not depend on the number of threads.
  */
   virtual void InitializeRoutes ();
 
+/**
+ * @brief Update the routes after a change of the topology, such as an
+ * interface going up or down.
+ *
+ * This is equivalent to calling DeleteGlobalRoutes (),
+ * BuildGlobalRoutingDatabase () and InitializeRoutes (), but when the
+ * GlobalRoutingIncremental global value is true, only the SPF trees that
+ * the change may modify are calculated again.  The new LSDB is compared
+ * with the previous one, and a router is calculated again if:
+ * - its LSA, the LSA of one of its neighbors or the LSA of a router behind
+ *   one of its networks changed, since these give its next hops;
+ * - a link was removed from its shortest paths, or a link which was added
+ *   gives a path as short as a shortest path;
+ * - a vertex of its tree whose LSA changed lists the links on its shortest
+ *   paths in another order;
+ * - the external LSAs changed.
+ *
+ * The other routers keep their shortest paths.  If their tree holds a
+ * vertex whose LSA changed, their routes are computed again from the
+ * cached tree and the new LSAs.  The routes of each router replace those
+ * of its routing table with Ipv4GlobalRouting::SetRoutes, which keeps the
+ * routes in place.  The routing tables then hold the same routes, in the
+ * same order, as after a full calculation.
+ */
+  virtual void UpdateRoutes ();
+
+/**
+ * @brief Get the number of routers whose SPF tree was calculated by the
+ * last call to InitializeRoutes () or UpdateRoutes ().
+ *
+ * @returns the number of SPF calculations
+ */
+  uint32_t GetNRecomputedRoots () const;
+
 /**
  * @brief Debugging routine; allow client code to supply a pre-built LSDB
  */
@@ -766,8 +918,308 @@ private:
  */
   GlobalRouteManagerImpl& operator= (GlobalRouteManagerImpl& srmi);
 
+  /**
+   * @brief A route computed for the root of an SPF calculation.
+   *
+   * The routes are installed in the routing table of the root node by the
+   * main thread, once the calculation is over.
+   */
+  struct SPFRoute
+  {
+    /**
+     * @brief The routing table the route goes to.
+     */
+    enum Type
+    {
+      HOST,      //!< Ipv4GlobalRouting::AddHostRouteTo
+      NETWORK,   //!< Ipv4GlobalRouting::AddNetworkRouteTo
+      EXTERNAL,  //!< Ipv4GlobalRouting::AddASExternalRouteTo
+      COMPACT    //!< Ipv4GlobalRouting::SetCompactRoutes
+    } type; //!< the routing table
+    Ipv4Address dest; //!< the destination host or network
+    Ipv4Mask mask; //!< the mask of the destination network
+    Ipv4Address nextHop; //!< the next hop
+    uint32_t interface; //!< the outgoing interface
+  };
+
+  /**
+   * @brief The node at the root of an SPF calculation.
+   *
+   * What the calculation needs to know of the node is gathered beforehand
+   * by the main thread, so that the calculation does not touch the objects
+   * of the simulation.
+   */
+  struct SPFRoot
+  {
+    Ipv4Address routerId; //!< the router ID of the node
+    Ptr<Ipv4GlobalRouting> routing; //!< the routing protocol of the node, if found
+    std::vector<std::vector<Ipv4Address> > addresses; //!< the addresses of the interfaces of the node
+    std::vector<SPFRoute> routes; //!< the routes computed for the node
+    bool cached; //!< whether the calculation keeps the tree below for UpdateRoutes
+    bool stub; //!< whether the node is a stub, whose calculation was truncated
+    bool aggregated; //!< whether the routes are aggregated into compact routes
+    std::vector<uint32_t> distance; //!< the distance of the vertices in the tree, SPF_INFINITY if not reached, by vertex number
+    std::vector<uint32_t> exitSet; //!< the root exits of the vertices in the tree, as indices in exitSets, by vertex number
+    std::vector<std::vector<SPFVertex::NodeExit_t> > exitSets; //!< the distinct sets of root exits of the tree
+    std::vector<uint32_t> vertices; //!< the vertices of the tree, in the order they were added to it, from the root
+    std::vector<uint32_t> stubVertices; //!< the routers of the tree, in the order SPFProcessStubs visits them
+  };
+
+  /**
+   * @brief An edge of the graph of the LSDB, between vertex numbers.
+   */
+  struct SPFEdge
+  {
+    uint32_t from; //!< the vertex the edge leaves
+    uint32_t to; //!< the vertex the edge reaches
+    uint32_t metric; //!< the cost of the edge
+    /**
+     * @brief Compare two edges.
+     * @param e the other edge
+     * @returns true if this edge comes first
+     */
+    bool operator< (const SPFEdge &e) const;
+  };
+
+  /**
+   * @brief The changes of the graph between two LSDBs.
+   */
+  struct SPFChange
+  {
+    std::vector<SPFEdge> removed; //!< the edges which were removed
+    std::vector<SPFEdge> added; //!< the edges which were added
+    std::vector<uint32_t> changed; //!< the vertices in both LSDBs whose LSA changed
+    std::vector<std::vector<SPFEdge> > oldEdges; //!< the edges leaving the changed vertices in the previous LSDB, in the order of their LSA
+    std::vector<std::vector<SPFEdge> > newEdges; //!< the edges leaving the changed vertices in the new LSDB, in the order of their LSA
+    std::vector<bool> network; //!< whether the vertices are networks
+  };
+
+  /// @brief The roots shared by the threads of a parallel calculation
+  struct SPFWork;
+
+  /**
+   * @brief Create a calculator for the threads of a parallel calculation.
+   *
+   * @param lsdb the Link State DataBase, shared with the main calculator
+   */
+  GlobalRouteManagerImpl (GlobalRouteManagerLSDB* lsdb);
+
   SPFVertex* m_spfroot; //!< the root node
   GlobalRouteManagerLSDB* m_lsdb; //!< the Link State DataBase (LSDB) of the Global Route Manager
+  bool m_ownsLsdb; //!< whether the LSDB is deleted with this object
+  SPFRoot* m_root; //!< the node the current calculation is for
+  std::vector<GlobalRoutingLSA::SPFStatus> m_lsaStatus; //!< the status of the LSAs in the current calculation, by LSA index
+  SPFVertexArena m_vertexArena; //!< the memory of the vertices of the calculations
+  SPFWork* m_work; //!< the roots to calculate, for the thread calculators
+  std::map<Ipv4Address, uint32_t> m_vertexNumbers; //!< the numbers of the vertices, by link state ID, kept from one LSDB to the next
+  std::vector<uint32_t> m_lsaNumbers; //!< the vertex numbers of the LSAs of the LSDB, by LSA index
+  std::map<std::vector<SPFVertex::NodeExit_t>, uint32_t> m_exitSetIndex; //!< the indices of the root exit sets of the current calculation
+  std::vector<SPFRoot> m_roots; //!< the roots of the last calculation, by node ID
+  uint32_t m_nRecomputedRoots; //!< the number of SPF calculations of the last update
+
+  /**
+   * \brief Get the number of threads to calculate the routes with.
+   *
+   * \returns the value of the GlobalRoutingThreads global value, or the
+   * number of processors if 0
+   */
+  static uint32_t GetNThreads (void);
+
+  /**
+   * \brief Whether the routes are updated incrementally.
+   *
+   * \returns the value of the GlobalRoutingIncremental global value
+   */
+  static bool IsIncremental (void);
+
+  /**
+   * \brief Whether the routes are aggregated.
+   *
+   * \returns the value of the GlobalRoutingAggregateRoutes global value
+   */
+  static bool IsAggregated (void);
+
+  /**
+   * \brief Replace the host and network routes of a root by aggregated
+   * compact routes which forward the same way.
+   *
+   * The host routes and the network routes are gathered by prefix, with
+   * their distinct next hops in order.  Two sibling prefixes with the same
+   * next hops are merged into their parent prefix, if it has no routes of
+   * its own, and a prefix with the same next hops as the longest prefix
+   * containing it is dropped.  The routes are left as they are if network
+   * prefixes contain one another, since the network routes are not
+   * selected by longest prefix.
+   *
+   * \param [in,out] routes the routes of the root
+   */
+  static void AggregateRoutes (std::vector<SPFRoute> &routes);
+
+  /**
+   * \brief Number the vertices of the LSDB, keeping the numbers of the
+   * link state IDs seen before.
+   */
+  void NumberVertices (void);
+
+  /**
+   * \brief Calculate the routes of some roots and install them, using the
+   * threads set by the GlobalRoutingThreads global value.
+   *
+   * \param roots the roots to calculate
+   * \param replace whether the routes replace those of the routing tables,
+   * rather than being added to them
+   */
+  void CalculateRoots (std::vector<SPFRoot*> &roots, bool replace);
+
+  /**
+   * \brief Record the distance, the root exits and the order of a vertex
+   * in the tree of the root of the calculation, if the root is cached.
+   *
+   * \param v the vertex, just added to the tree
+   */
+  void CacheVertex (SPFVertex* v);
+
+  /**
+   * \brief Get the distance of a vertex in the tree of a cached root.
+   *
+   * \param root the root
+   * \param vertex the number of the vertex
+   * \returns the distance, or SPF_INFINITY if the vertex is not in the tree
+   */
+  static uint32_t GetCachedDistance (const SPFRoot &root, uint32_t vertex);
+
+  /**
+   * \brief Test if the tree of a cached root may be modified by a change
+   * of the edges of the graph.
+   *
+   * The vertices of the tree are added in the same order, with the same
+   * distances, parents and root exits, as long as the edges on the
+   * shortest paths are the same and each vertex follows them in the same
+   * order: the other edges only reach vertices which get a shorter path
+   * later on.  The tree is thus unchanged if no edge on a shortest path is
+   * removed, no edge added gives a path as short as a shortest path, and
+   * the changed vertices of the tree keep the order of their edges on the
+   * shortest paths.
+   *
+   * \param root the root
+   * \param change the change of the graph
+   * \returns true if the tree may be modified
+   */
+  static bool IsTreeChanged (const SPFRoot &root, const SPFChange &change);
+
+  /**
+   * \brief Get the edges of the graph which leave a vertex of an LSDB, in
+   * the order of its LSA.
+   *
+   * \param lsdb the LSDB
+   * \param numbers the vertex numbers of the LSAs of the LSDB, by LSA index
+   * \param lsa the LSA of the vertex
+   * \param number the vertex number of the vertex
+   * \param [out] edges the edges, appended
+   */
+  static void GetLSAEdges (GlobalRouteManagerLSDB* lsdb, const std::vector<uint32_t> &numbers,
+                           GlobalRoutingLSA* lsa, uint32_t number, std::vector<SPFEdge> &edges);
+
+  /**
+   * \brief Get the sorted edges of the graph of an LSDB.
+   *
+   * \param lsdb the LSDB
+   * \param numbers the vertex numbers of the LSAs of the LSDB, by LSA index
+   * \param [out] edges the edges
+   */
+  static void GetEdges (GlobalRouteManagerLSDB* lsdb, const std::vector<uint32_t> &numbers,
+                        std::vector<SPFEdge> &edges);
+
+  /**
+   * \brief Test if two LSAs describe the same vertex the same way.
+   *
+   * \param a the first LSA
+   * \param b the second LSA
+   * \returns true if the LSAs have the same content
+   */
+  static bool IsSameLSA (GlobalRoutingLSA* a, GlobalRoutingLSA* b);
+
+  /**
+   * \brief Test if two lists of external LSAs have the same content.
+   *
+   * \param a the first LSDB
+   * \param b the second LSDB
+   * \returns true if the external LSAs of the LSDBs are the same
+   */
+  static bool IsSameExtLSAs (GlobalRouteManagerLSDB* a, GlobalRouteManagerLSDB* b);
+
+  /**
+   * \brief Get the routes of a cached root whose tree is unchanged, in the
+   * order the SPF calculation adds them: SPFIntraAddRouter and
+   * SPFIntraAddTransit in the order of the tree, SPFIntraAddStub in the
+   * order of SPFProcessStubs, then SPFAddASExternal for each external LSA.
+   *
+   * \param root the root, whose routes are appended
+   * \param lsas the LSAs of the LSDB, by vertex number
+   */
+  void GetCachedRoutes (SPFRoot &root, const std::vector<GlobalRoutingLSA*> &lsas) const;
+
+  /**
+   * \brief Delete all the routes of a routing table.
+   *
+   * \param routing the routing protocol
+   */
+  static void DeleteRoutes (Ptr<Ipv4GlobalRouting> routing);
+
+  /**
+   * \brief Gather what the SPF calculation needs to know of a node.
+   *
+   * \param node the node
+   * \param routerId the router ID of the node
+   * \param [out] root the root of the calculation
+   */
+  static void InitializeRoot (Ptr<Node> node, Ipv4Address routerId, SPFRoot &root);
+
+  /**
+   * \brief Install the routes computed for a node in its routing table.
+   *
+   * The routes replace the routes of the table with
+   * Ipv4GlobalRouting::SetRoutes, which keeps the routes already in place,
+   * or are added after them.
+   *
+   * \param root the root of the calculation
+   * \param replace whether the routes replace those of the table
+   */
+  static void InstallRoutes (SPFRoot &root, bool replace);
+
+  /**
+   * \brief Calculate the routes of the roots of the work, until none is
+   * left.  This is the function of the threads of a parallel calculation.
+   */
+  void SPFCalculateWork (void);
+
+  /**
+   * \brief Record a route for the root of the calculation.
+   *
+   * \param type the routing table of the route
+   * \param dest the destination host or network
+   * \param mask the mask of the destination network
+   * \param nextHop the next hop
+   * \param interface the outgoing interface
+   */
+  void AddRoute (SPFRoute::Type type, Ipv4Address dest, Ipv4Mask mask,
+                 Ipv4Address nextHop, uint32_t interface);
+
+  /**
+   * \brief Get the status of an LSA in the current calculation.
+   *
+   * \param lsa the LSA
+   * \returns the status of the LSA
+   */
+  GlobalRoutingLSA::SPFStatus GetLSAStatus (GlobalRoutingLSA* lsa) const;
+
+  /**
+   * \brief Set the status of an LSA in the current calculation.
+   *
+   * \param lsa the LSA
+   * \param status the status of the LSA
+   */
+  void SetLSAStatus (GlobalRoutingLSA* lsa, GlobalRoutingLSA::SPFStatus status);
 
   /**
    * \brief Test if a node is a stub, from an OSPF sense.
@@ -935,8 +1387,8 @@ private:
   /**
    * \brief Return the interface number corresponding to a given IP address and mask
    *
-   * This is a wrapper around GetInterfaceForPrefix(), but we first
-   * have to find the right node pointer to pass to that function.
+   * This is the equivalent of Ipv4::GetInterfaceForPrefix() on the root
+   * node, using the addresses of its interfaces gathered beforehand.
    * If no such interface is found, return -1 (note:  unit test framework
    * for routing assumes -1 to be a legal return value)
    *
@@ -945,7 +1397,7 @@ private:
    * \return the outgoing interface number
    */
   int32_t FindOutgoingInterfaceId (Ipv4Address a, 
-                                   Ipv4Mask amask = Ipv4Mask ("255.255.255.255"));
+                                   Ipv4Mask amask = Ipv4Mask ("255.255.255.255")) const;
 };
 
 } // namespace ns3
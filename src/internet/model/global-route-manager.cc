@@ -58,6 +58,22 @@ GlobalRouteManager::InitializeRoutes (void)
   InitializeRoutes ();
 }
 
+void
+GlobalRouteManager::UpdateRoutes (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  SimulationSingleton<GlobalRouteManagerImpl>::Get ()->
+  UpdateRoutes ();
+}
+
+uint32_t
+GlobalRouteManager::GetNRecomputedRoots (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  return SimulationSingleton<GlobalRouteManagerImpl>::Get ()->
+         GetNRecomputedRoots ();
+}
+
 uint32_t
 GlobalRouteManager::AllocateRouterId (void)
 {
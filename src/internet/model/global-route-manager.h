@@ -64,6 +64,22 @@ public:
  */
   static void InitializeRoutes ();
 
+/**
+ * @brief Update the routes after a change of the topology, calculating
+ * again only the SPF trees the change may modify
+ *
+ * @see GlobalRouteManagerImpl::UpdateRoutes
+ */
+  static void UpdateRoutes ();
+
+/**
+ * @brief Get the number of routers whose SPF tree was calculated by the
+ * last call to InitializeRoutes () or UpdateRoutes ().
+ *
+ * @returns the number of SPF calculations
+ */
+  static uint32_t GetNRecomputedRoots ();
+
 private:
 /**
  * @brief Global Route Manager copy construction is disallowed.  There's no 
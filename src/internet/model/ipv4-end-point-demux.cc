@@ -22,14 +22,16 @@
 #include "ipv4-end-point.h"
 #include "ipv4-interface-address.h"
 #include "ns3/log.h"
-
+#include <algorithm>
+#include <iterator>
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("Ipv4EndPointDemux");
 
 Ipv4EndPointDemux::Ipv4EndPointDemux ()
-  : m_ephemeral (49152), m_portLast (65535), m_portFirst (49152)
+  : m_ephemeral (49152), m_portLast (65535), m_portFirst (49152),
+    m_nextOrder (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -37,41 +39,154 @@ Ipv4EndPointDemux::Ipv4EndPointDemux ()
 Ipv4EndPointDemux::~Ipv4EndPointDemux ()
 {
   NS_LOG_FUNCTION (this);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  for (std::map<uint64_t, Ipv4EndPoint *>::iterator i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
     {
-      Ipv4EndPoint *endPoint = *i;
+      Ipv4EndPoint *endPoint = i->second;
       delete endPoint;
     }
   m_endPoints.clear ();
+  m_connected.clear ();
+  m_wildcards.clear ();
 }
 
 bool
-Ipv4EndPointDemux::LookupPortLocal (uint16_t port)
+Ipv4EndPointDemux::FourTuple::operator< (const FourTuple &tuple) const
 {
-  NS_LOG_FUNCTION (this << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  if (localPort != tuple.localPort)
+    {
+      return localPort < tuple.localPort;
+    }
+  if (localAddress != tuple.localAddress)
+    {
+      return localAddress < tuple.localAddress;
+    }
+  if (peerAddress != tuple.peerAddress)
+    {
+      return peerAddress < tuple.peerAddress;
+    }
+  return peerPort < tuple.peerPort;
+}
+
+bool
+Ipv4EndPointDemux::IsConnected (Ipv4EndPoint *endPoint)
+{
+  return endPoint->GetLocalAddress () != Ipv4Address::GetAny ()
+         && endPoint->GetPeerAddress () != Ipv4Address::GetAny ()
+         && endPoint->GetPeerPort () != 0;
+}
+
+Ipv4EndPointDemux::FourTuple
+Ipv4EndPointDemux::GetFourTuple (Ipv4EndPoint *endPoint)
+{
+  FourTuple tuple;
+  tuple.localPort = endPoint->GetLocalPort ();
+  tuple.localAddress = endPoint->GetLocalAddress ();
+  tuple.peerAddress = endPoint->GetPeerAddress ();
+  tuple.peerPort = endPoint->GetPeerPort ();
+  return tuple;
+}
+
+bool
+Ipv4EndPointDemux::IsAllocatedBefore (Ipv4EndPoint *a, Ipv4EndPoint *b)
+{
+  return a->m_demuxOrder < b->m_demuxOrder;
+}
+
+void
+Ipv4EndPointDemux::Insert (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  endPoint->m_demux = this;
+  endPoint->m_demuxOrder = m_nextOrder++;
+  m_endPoints[endPoint->m_demuxOrder] = endPoint;
+  AddIndex (endPoint);
+}
+
+void
+Ipv4EndPointDemux::AddIndex (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  Bucket &bucket = IsConnected (endPoint) ? m_connected[GetFourTuple (endPoint)]
+    : m_wildcards[endPoint->GetLocalPort ()];
+  bucket.insert (std::upper_bound (bucket.begin (), bucket.end (), endPoint, &IsAllocatedBefore),
+                 endPoint);
+}
+
+void
+Ipv4EndPointDemux::RemoveIndex (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  if (IsConnected (endPoint))
+    {
+      std::map<FourTuple, Bucket>::iterator i = m_connected.find (GetFourTuple (endPoint));
+      NS_ASSERT (i != m_connected.end ());
+      i->second.erase (std::lower_bound (i->second.begin (), i->second.end (), endPoint, &IsAllocatedBefore));
+      if (i->second.empty ())
+        {
+          m_connected.erase (i);
+        }
+    }
+  else
     {
-      if ((*i)->GetLocalPort  () == port) 
+      std::map<uint16_t, Bucket>::iterator i = m_wildcards.find (endPoint->GetLocalPort ());
+      NS_ASSERT (i != m_wildcards.end ());
+      i->second.erase (std::lower_bound (i->second.begin (), i->second.end (), endPoint, &IsAllocatedBefore));
+      if (i->second.empty ())
         {
-          return true;
+          m_wildcards.erase (i);
         }
     }
-  return false;
+}
+
+void
+Ipv4EndPointDemux::GetPortEndPoints (uint16_t port, Bucket &endPoints)
+{
+  NS_LOG_FUNCTION (this << port);
+  std::map<uint16_t, Bucket>::const_iterator wildcards = m_wildcards.find (port);
+  if (wildcards != m_wildcards.end ())
+    {
+      endPoints = wildcards->second;
+    }
+  FourTuple first = { port, Ipv4Address::GetZero (), Ipv4Address::GetZero (), 0 };
+  for (std::map<FourTuple, Bucket>::const_iterator i = m_connected.lower_bound (first);
+       i != m_connected.end () && i->first.localPort == port; i++)
+    {
+      endPoints.insert (endPoints.end (), i->second.begin (), i->second.end ());
+    }
+  std::sort (endPoints.begin (), endPoints.end (), &IsAllocatedBefore);
+}
+
+bool
+Ipv4EndPointDemux::LookupPortLocal (uint16_t port)
+{
+  NS_LOG_FUNCTION (this << port);
+  if (m_wildcards.find (port) != m_wildcards.end ())
+    {
+      return true;
+    }
+  FourTuple first = { port, Ipv4Address::GetZero (), Ipv4Address::GetZero (), 0 };
+  std::map<FourTuple, Bucket>::const_iterator i = m_connected.lower_bound (first);
+  return i != m_connected.end () && i->first.localPort == port;
 }
 
 bool
 Ipv4EndPointDemux::LookupLocal (Ipv4Address addr, uint16_t port)
 {
   NS_LOG_FUNCTION (this << addr << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  std::map<uint16_t, Bucket>::const_iterator wildcards = m_wildcards.find (port);
+  if (wildcards != m_wildcards.end ())
     {
-      if ((*i)->GetLocalPort () == port &&
-          (*i)->GetLocalAddress () == addr) 
+      for (Bucket::const_iterator i = wildcards->second.begin (); i != wildcards->second.end (); i++)
         {
-          return true;
+          if ((*i)->GetLocalAddress () == addr)
+            {
+              return true;
+            }
         }
     }
-  return false;
+  FourTuple first = { port, addr, Ipv4Address::GetZero (), 0 };
+  std::map<FourTuple, Bucket>::const_iterator i = m_connected.lower_bound (first);
+  return i != m_connected.end () && i->first.localPort == port && i->first.localAddress == addr;
 }
 
 Ipv4EndPoint *
@@ -85,7 +200,7 @@ Ipv4EndPointDemux::Allocate (void)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (Ipv4Address::GetAny (), port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -101,7 +216,7 @@ Ipv4EndPointDemux::Allocate (Ipv4Address address)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -124,7 +239,7 @@ Ipv4EndPointDemux::Allocate (Ipv4Address address, uint16_t port)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -134,21 +249,31 @@ Ipv4EndPointDemux::Allocate (Ipv4Address localAddress, uint16_t localPort,
                              Ipv4Address peerAddress, uint16_t peerPort)
 {
   NS_LOG_FUNCTION (this << localAddress << localPort << peerAddress << peerPort);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  FourTuple tuple = { localPort, localAddress, peerAddress, peerPort };
+  bool found = m_connected.find (tuple) != m_connected.end ();
+  std::map<uint16_t, Bucket>::const_iterator wildcards = m_wildcards.find (localPort);
+  if (!found && wildcards != m_wildcards.end ())
     {
-      if ((*i)->GetLocalPort () == localPort &&
-          (*i)->GetLocalAddress () == localAddress &&
-          (*i)->GetPeerPort () == peerPort &&
-          (*i)->GetPeerAddress () == peerAddress) 
+      for (Bucket::const_iterator i = wildcards->second.begin (); i != wildcards->second.end (); i++)
         {
-          NS_LOG_WARN ("No way we can allocate this end-point.");
-          /* no way we can allocate this end-point. */
-          return 0;
+          if ((*i)->GetLocalAddress () == localAddress &&
+              (*i)->GetPeerPort () == peerPort &&
+              (*i)->GetPeerAddress () == peerAddress)
+            {
+              found = true;
+              break;
+            }
         }
     }
+  if (found)
+    {
+      NS_LOG_WARN ("No way we can allocate this end-point.");
+      /* no way we can allocate this end-point. */
+      return 0;
+    }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (localAddress, localPort);
   endPoint->SetPeer (peerAddress, peerPort);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
 
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
 
@@ -159,14 +284,13 @@ void
 Ipv4EndPointDemux::DeAllocate (Ipv4EndPoint *endPoint)
 {
   NS_LOG_FUNCTION (this << endPoint);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  std::map<uint64_t, Ipv4EndPoint *>::iterator i = m_endPoints.find (endPoint->m_demuxOrder);
+  if (i != m_endPoints.end () && i->second == endPoint)
     {
-      if (*i == endPoint)
-        {
-          delete endPoint;
-          m_endPoints.erase (i);
-          break;
-        }
+      RemoveIndex (endPoint);
+      m_endPoints.erase (i);
+      endPoint->m_demux = 0;
+      delete endPoint;
     }
 }
 
@@ -179,9 +303,9 @@ Ipv4EndPointDemux::GetAllEndPoints (void)
   NS_LOG_FUNCTION (this);
   EndPoints ret;
 
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  for (std::map<uint64_t, Ipv4EndPoint *>::iterator i = m_endPoints.begin (); i != m_endPoints.end (); i++)
     {
-      Ipv4EndPoint* endP = *i;
+      Ipv4EndPoint* endP = i->second;
       ret.push_back (endP);
     }
   return ret;
@@ -206,7 +330,44 @@ Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport,
   EndPoints retval4; // Exact match on all 4
 
   NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  bool subnetDirected = false;
+  Ipv4Address incomingInterfaceAddr = daddr;  // may be a broadcast
+  for (uint32_t i = 0; incomingInterface && i < incomingInterface->GetNAddresses (); i++)
+    {
+      Ipv4InterfaceAddress addr = incomingInterface->GetAddress (i);
+      if (addr.GetLocal ().CombineMask (addr.GetMask ()) == daddr.CombineMask (addr.GetMask ()) &&
+          daddr.IsSubnetDirectedBroadcast (addr.GetMask ()))
+        {
+          subnetDirected = true;
+          incomingInterfaceAddr = addr.GetLocal ();
+        }
+    }
+  bool isBroadcast = (daddr.IsBroadcast () || subnetDirected == true);
+  NS_LOG_DEBUG ("dest addr " << daddr << " broadcast? " << isBroadcast);
+
+  // The end points which may match: the wildcard end points of the port,
+  // and the end points whose four-tuple is the one of the packet, with the
+  // address of the interface as local address for a broadcast.
+  Bucket candidates;
+  std::map<uint16_t, Bucket>::const_iterator wildcards = m_wildcards.find (dport);
+  FourTuple tuple = { dport, isBroadcast ? incomingInterfaceAddr : daddr, saddr, sport };
+  std::map<FourTuple, Bucket>::const_iterator connected = m_connected.find (tuple);
+  if (wildcards != m_wildcards.end () && connected != m_connected.end ())
+    {
+      std::merge (wildcards->second.begin (), wildcards->second.end (),
+                  connected->second.begin (), connected->second.end (),
+                  std::back_inserter (candidates), &IsAllocatedBefore);
+    }
+  else if (wildcards != m_wildcards.end ())
+    {
+      candidates = wildcards->second;
+    }
+  else if (connected != m_connected.end ())
+    {
+      candidates = connected->second;
+    }
+
+  for (Bucket::const_iterator i = candidates.begin (); i != candidates.end (); i++)
     {
       Ipv4EndPoint* endP = *i;
 
@@ -241,20 +402,6 @@ Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport,
               continue;
             }
         }
-      bool subnetDirected = false;
-      Ipv4Address incomingInterfaceAddr = daddr;  // may be a broadcast
-      for (uint32_t i = 0; i < incomingInterface->GetNAddresses (); i++)
-        {
-          Ipv4InterfaceAddress addr = incomingInterface->GetAddress (i);
-          if (addr.GetLocal ().CombineMask (addr.GetMask ()) == daddr.CombineMask (addr.GetMask ()) &&
-              daddr.IsSubnetDirectedBroadcast (addr.GetMask ()))
-            {
-              subnetDirected = true;
-              incomingInterfaceAddr = addr.GetLocal ();
-            }
-        }
-      bool isBroadcast = (daddr.IsBroadcast () || subnetDirected == true);
-      NS_LOG_DEBUG ("dest addr " << daddr << " broadcast? " << isBroadcast);
       bool localAddressMatchesWildCard = 
         endP->GetLocalAddress () == Ipv4Address::GetAny ();
       bool localAddressMatchesExact = endP->GetLocalAddress () == daddr;
@@ -330,7 +477,9 @@ Ipv4EndPointDemux::SimpleLookup (Ipv4Address daddr,
   // function.
   uint32_t genericity = 3;
   Ipv4EndPoint *generic = 0;
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  Bucket endPoints;
+  GetPortEndPoints (dport, endPoints);
+  for (Bucket::const_iterator i = endPoints.begin (); i != endPoints.end (); i++) 
     {
       if ((*i)->GetLocalPort () != dport) 
         {
@@ -23,6 +23,8 @@
 
 #include <stdint.h>
 #include <list>
+#include <map>
+#include <vector>
 #include "ns3/ipv4-address.h"
 #include "ipv4-interface.h"
 
@@ -40,6 +42,13 @@ class Ipv4EndPoint;
  * of endpoints, and has APIs to add and find endpoints in this demux.  This
  * code is shared in common to TCP and UDP protocols in ns3.  This demux
  * sits between ns3's layer four and the socket layer
+ *
+ * The endpoints are indexed on two levels: the endpoints whose four-tuple
+ * is fully set, such as the connected TCP sockets, by four-tuple, and the
+ * other ones, such as the listening sockets, by local port.  A lookup only
+ * examines the endpoints of one four-tuple and the wildcard endpoints of
+ * the destination port, in the order they were allocated.  The endpoints
+ * tell the demux when their addresses or ports change.
  */
 
 class Ipv4EndPointDemux {
@@ -185,10 +194,98 @@ private:
    */
   uint16_t m_portFirst;
 
+  friend class Ipv4EndPoint;
+
+  /**
+   * \brief The four-tuple of an end point whose addresses and ports are
+   * all set.
+   */
+  struct FourTuple
+  {
+    uint16_t localPort;        //!< The local port.
+    Ipv4Address localAddress;  //!< The local address.
+    Ipv4Address peerAddress;   //!< The peer address.
+    uint16_t peerPort;         //!< The peer port.
+
+    /**
+     * \brief Compare two four-tuples, by local port first.
+     * \param tuple The other four-tuple.
+     * \returns true if this four-tuple comes first.
+     */
+    bool operator< (const FourTuple &tuple) const;
+  };
+
+  /**
+   * \brief End points, in their allocation order.
+   */
+  typedef std::vector<Ipv4EndPoint *> Bucket;
+
+  /**
+   * \brief Add an end point to the demux.
+   * \param endPoint The end point.
+   */
+  void Insert (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Index an end point by its current four-tuple.
+   * \param endPoint The end point.
+   */
+  void AddIndex (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Remove an end point from the index of its current four-tuple.
+   * \param endPoint The end point.
+   */
+  void RemoveIndex (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Test if the four-tuple of an end point is fully set.
+   * \param endPoint The end point.
+   * \returns true if the end point is indexed by four-tuple.
+   */
+  static bool IsConnected (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Get the four-tuple of an end point.
+   * \param endPoint The end point.
+   * \returns The four-tuple.
+   */
+  static FourTuple GetFourTuple (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Compare end points by allocation order.
+   * \param a The first end point.
+   * \param b The second end point.
+   * \returns true if a was allocated first.
+   */
+  static bool IsAllocatedBefore (Ipv4EndPoint *a, Ipv4EndPoint *b);
+
+  /**
+   * \brief Get the end points of a local port.
+   * \param port The local port.
+   * \param [out] endPoints The end points, in their allocation order.
+   */
+  void GetPortEndPoints (uint16_t port, Bucket &endPoints);
+
+  /**
+   * \brief The IPv4 end points, by allocation order.
+   */
+  std::map<uint64_t, Ipv4EndPoint *> m_endPoints;
+
+  /**
+   * \brief The allocation order of the next end point.
+   */
+  uint64_t m_nextOrder;
+
+  /**
+   * \brief The end points whose four-tuple is fully set, by four-tuple.
+   */
+  std::map<FourTuple, Bucket> m_connected;
+
   /**
-   * \brief A list of IPv4 end points.
+   * \brief The other end points, by local port.
    */
-  EndPoints m_endPoints;
+  std::map<uint16_t, Bucket> m_wildcards;
 };
 
 } // namespace ns3
@@ -18,6 +18,8 @@
 
 #include <vector>
 #include <iomanip>
+#include <algorithm>
+#include <iterator>
 #include "ns3/names.h"
 #include "ns3/log.h"
 #include "ns3/simulator.h"
@@ -37,6 +39,21 @@ NS_LOG_COMPONENT_DEFINE ("Ipv4GlobalRouting");
 
 NS_OBJECT_ENSURE_REGISTERED (Ipv4GlobalRouting);
 
+namespace {
+
+/**
+ * \param a A matching route.
+ * \param b A matching route.
+ * \returns true if a was added before b.
+ */
+bool
+IsAddedBefore (const Ipv4RoutingTableTrie::Match &a, const Ipv4RoutingTableTrie::Match &b)
+{
+  return a.order < b.order;
+}
+
+} // anonymous namespace
+
 TypeId 
 Ipv4GlobalRouting::GetTypeId (void)
 { 
@@ -80,6 +97,7 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, nextHop, interface);
   m_hostRoutes.push_back (route);
+  m_hostRouteTrie.Insert (dest, 32, route);
 }
 
 void 
@@ -90,6 +108,7 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, interface);
   m_hostRoutes.push_back (route);
+  m_hostRouteTrie.Insert (dest, 32, route);
 }
 
 void 
@@ -105,6 +124,7 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_networkRoutes.push_back (route);
+  m_networkRouteTrie.Insert (network, networkMask.GetPrefixLength (), route);
 }
 
 void 
@@ -118,6 +138,7 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         networkMask,
                                                         interface);
   m_networkRoutes.push_back (route);
+  m_networkRouteTrie.Insert (network, networkMask.GetPrefixLength (), route);
 }
 
 void 
@@ -133,6 +154,220 @@ Ipv4GlobalRouting::AddASExternalRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_ASexternalRoutes.push_back (route);
+  m_ASexternalRouteTrie.Insert (network, networkMask.GetPrefixLength (), route);
+}
+
+namespace {
+
+/**
+ * Compare compact routes by decreasing prefix length, then by network.
+ * \param a The first route.
+ * \param b The second route.
+ * \returns true if a comes before b.
+ */
+bool
+IsCompactBefore (const Ipv4GlobalRouting::CompactRoute &a, const Ipv4GlobalRouting::CompactRoute &b)
+{
+  if (a.prefixLength != b.prefixLength)
+    {
+      return a.prefixLength > b.prefixLength;
+    }
+  return a.network < b.network;
+}
+
+/**
+ * Compare the network of a compact route with an address.
+ * \param a The route.
+ * \param network The address.
+ * \returns true if the network of the route is lower.
+ */
+bool
+IsCompactNetworkBelow (const Ipv4GlobalRouting::CompactRoute &a, uint32_t network)
+{
+  return a.network < network;
+}
+
+/**
+ * Above this number of new routes in a list, all the routes kept after
+ * them are indexed again, rather than those overlapping a new route.
+ */
+const uint32_t MAX_OVERLAP_CHECKS = 16;
+
+/**
+ * \param a A route.
+ * \param b A route.
+ * \returns true if the routes have the same destination, gateway and
+ * interface.
+ */
+bool
+IsSameRoute (const Ipv4RoutingTableEntry &a, const Ipv4RoutingTableEntry &b)
+{
+  return a.GetDest () == b.GetDest ()
+         && a.GetDestNetworkMask () == b.GetDestNetworkMask ()
+         && a.GetGateway () == b.GetGateway ()
+         && a.GetInterface () == b.GetInterface ();
+}
+
+/**
+ * \param a A route.
+ * \param b A route.
+ * \returns true if an address may match both routes.
+ */
+bool
+IsOverlapping (const Ipv4RoutingTableEntry &a, const Ipv4RoutingTableEntry &b)
+{
+  uint32_t mask = a.GetDestNetworkMask ().Get () & b.GetDestNetworkMask ().Get ();
+  return ((a.GetDestNetwork ().Get () ^ b.GetDestNetwork ().Get ()) & mask) == 0;
+}
+
+} // anonymous namespace
+
+void
+Ipv4GlobalRouting::SetCompactRoutes (const std::vector<CompactRoute> &routes)
+{
+  NS_LOG_FUNCTION (this << routes.size ());
+  std::vector<CompactRoute> (routes).swap (m_compactRoutes);
+  m_compactBegin.clear ();
+  if (m_compactRoutes.empty ())
+    {
+      std::vector<uint32_t> ().swap (m_compactBegin);
+      return;
+    }
+  // The equal-cost routes of a prefix keep their order.
+  std::stable_sort (m_compactRoutes.begin (), m_compactRoutes.end (), &IsCompactBefore);
+  m_compactBegin.resize (34);
+  uint32_t i = 0;
+  for (uint32_t length = 0; length <= 33; length++)
+    {
+      while (i < m_compactRoutes.size () && m_compactRoutes[i].prefixLength > 32 - (int)length)
+        {
+          i++;
+        }
+      m_compactBegin[length] = i;
+    }
+}
+
+void
+Ipv4GlobalRouting::SetRoutes (const std::vector<Ipv4RoutingTableEntry> &hostRoutes,
+                              const std::vector<Ipv4RoutingTableEntry> &networkRoutes,
+                              const std::vector<Ipv4RoutingTableEntry> &externalRoutes)
+{
+  NS_LOG_FUNCTION (this << hostRoutes.size () << networkRoutes.size () << externalRoutes.size ());
+  ReplaceRoutes (m_hostRoutes, m_hostRouteTrie, hostRoutes);
+  ReplaceRoutes (m_networkRoutes, m_networkRouteTrie, networkRoutes);
+  ReplaceRoutes (m_ASexternalRoutes, m_ASexternalRouteTrie, externalRoutes);
+}
+
+void
+Ipv4GlobalRouting::ReplaceRoutes (std::list<Ipv4RoutingTableEntry *> &routes,
+                                  Ipv4RoutingTableTrie &trie,
+                                  const std::vector<Ipv4RoutingTableEntry> &newRoutes)
+{
+  NS_LOG_FUNCTION (&routes << &trie << newRoutes.size ());
+  // Skip the routes in place at the start, then at the end of the list.
+  std::list<Ipv4RoutingTableEntry *>::iterator first = routes.begin ();
+  uint32_t begin = 0;
+  while (first != routes.end () && begin < newRoutes.size ()
+         && IsSameRoute (**first, newRoutes[begin]))
+    {
+      ++first;
+      ++begin;
+    }
+  std::list<Ipv4RoutingTableEntry *>::iterator last = routes.end ();
+  uint32_t end = newRoutes.size ();
+  while (last != first && end > begin)
+    {
+      std::list<Ipv4RoutingTableEntry *>::iterator previous = last;
+      --previous;
+      if (!IsSameRoute (**previous, newRoutes[end - 1]))
+        {
+          break;
+        }
+      last = previous;
+      --end;
+    }
+  NS_LOG_LOGIC ("Replacing the routes from " << begin << ": "
+                << std::distance (first, last) << " removed, " << end - begin << " added");
+  while (first != last)
+    {
+      trie.Remove ((*first)->GetDestNetwork (),
+                   (*first)->GetDestNetworkMask ().GetPrefixLength (), *first);
+      delete *first;
+      first = routes.erase (first);
+    }
+  if (begin == end)
+    {
+      return;
+    }
+  for (uint32_t i = begin; i < end; i++)
+    {
+      Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry (newRoutes[i]);
+      routes.insert (last, route);
+      trie.Insert (route->GetDestNetwork (), route->GetDestNetworkMask ().GetPrefixLength (), route);
+    }
+  // The lookups return the matching routes in insertion order: the routes
+  // kept at the end which an address may match along with a new route are
+  // indexed again, after the new routes.
+  for (std::list<Ipv4RoutingTableEntry *>::iterator i = last; i != routes.end (); ++i)
+    {
+      bool overlapping = end - begin > MAX_OVERLAP_CHECKS;
+      for (uint32_t j = begin; j < end && !overlapping; j++)
+        {
+          overlapping = IsOverlapping (**i, newRoutes[j]);
+        }
+      if (overlapping)
+        {
+          uint8_t prefixLength = (*i)->GetDestNetworkMask ().GetPrefixLength ();
+          trie.Remove ((*i)->GetDestNetwork (), prefixLength, *i);
+          trie.Insert ((*i)->GetDestNetwork (), prefixLength, *i);
+        }
+    }
+}
+
+void
+Ipv4GlobalRouting::LookupCompact (Ipv4Address dest, Ptr<NetDevice> oif,
+                                  std::vector<Ipv4RoutingTableEntry> &routes) const
+{
+  NS_LOG_FUNCTION (this << dest << oif);
+  if (m_compactRoutes.empty ())
+    {
+      return;
+    }
+  uint32_t address = dest.Get ();
+  for (uint32_t i = 0; i <= 32; i++)
+    {
+      std::vector<CompactRoute>::const_iterator begin = m_compactRoutes.begin () + m_compactBegin[i];
+      std::vector<CompactRoute>::const_iterator end = m_compactRoutes.begin () + m_compactBegin[i + 1];
+      if (begin == end)
+        {
+          continue;
+        }
+      uint32_t length = 32 - i;
+      uint32_t network = length == 0 ? 0 : address & (0xffffffffu << i);
+      for (std::vector<CompactRoute>::const_iterator j = std::lower_bound (begin, end, network, &IsCompactNetworkBelow);
+           j != end && j->network == network; j++)
+        {
+          if (oif != 0 && oif != m_ipv4->GetNetDevice (j->interface))
+            {
+              NS_LOG_LOGIC ("Not on requested interface, skipping");
+              continue;
+            }
+          routes.push_back (GetCompactEntry (*j));
+        }
+      if (!routes.empty ())
+        {
+          return;
+        }
+    }
+}
+
+Ipv4RoutingTableEntry
+Ipv4GlobalRouting::GetCompactEntry (const CompactRoute &route)
+{
+  return Ipv4RoutingTableEntry::CreateNetworkRouteTo (Ipv4Address (route.network),
+                                                      Ipv4Mask (route.prefixLength == 0 ? 0 : 0xffffffffu << (32 - route.prefixLength)),
+                                                      Ipv4Address (route.gateway),
+                                                      route.interface);
 }
 
 
@@ -146,72 +381,79 @@ Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
   typedef std::vector<Ipv4RoutingTableEntry*> RouteVec_t;
   RouteVec_t allRoutes;
 
+  // The tries return the matching routes; the routes are then selected
+  // as the lists used to be scanned: all the matching host routes, else
+  // all the matching network routes, else the first external route,
+  // in the order they were added.  The compact routes of the longest
+  // matching prefix, if any, come before the network routes.
+  std::vector<Ipv4RoutingTableTrie::Match> matches;
   NS_LOG_LOGIC ("Number of m_hostRoutes = " << m_hostRoutes.size ());
-  for (HostRoutesCI i = m_hostRoutes.begin (); 
-       i != m_hostRoutes.end (); 
-       i++) 
+  m_hostRouteTrie.Lookup (dest, matches);
+  for (uint32_t i = 0; i < matches.size (); i++)
     {
-      NS_ASSERT ((*i)->IsHost ());
-      if ((*i)->GetDest ().IsEqual (dest)) 
+      Ipv4RoutingTableEntry *route = matches[i].route;
+      NS_ASSERT (route->IsHost () && route->GetDest ().IsEqual (dest));
+      if (oif != 0)
         {
-          if (oif != 0)
+          if (oif != m_ipv4->GetNetDevice (route->GetInterface ()))
             {
-              if (oif != m_ipv4->GetNetDevice ((*i)->GetInterface ()))
-                {
-                  NS_LOG_LOGIC ("Not on requested interface, skipping");
-                  continue;
-                }
+              NS_LOG_LOGIC ("Not on requested interface, skipping");
+              continue;
             }
-          allRoutes.push_back (*i);
-          NS_LOG_LOGIC (allRoutes.size () << "Found global host route" << *i); 
         }
+      allRoutes.push_back (route);
+      NS_LOG_LOGIC (allRoutes.size () << "Found global host route" << route);
     }
+  std::vector<Ipv4RoutingTableEntry> compactRoutes;
   if (allRoutes.size () == 0) // if no host route is found
+    {
+      LookupCompact (dest, oif, compactRoutes);
+      for (uint32_t j = 0; j < compactRoutes.size (); j++)
+        {
+          allRoutes.push_back (&compactRoutes[j]);
+          NS_LOG_LOGIC (allRoutes.size () << "Found global compact route" << compactRoutes[j]);
+        }
+    }
+  if (allRoutes.size () == 0) // if no host or compact route is found
     {
       NS_LOG_LOGIC ("Number of m_networkRoutes" << m_networkRoutes.size ());
-      for (NetworkRoutesI j = m_networkRoutes.begin (); 
-           j != m_networkRoutes.end (); 
-           j++) 
+      matches.clear ();
+      m_networkRouteTrie.Lookup (dest, matches);
+      std::sort (matches.begin (), matches.end (), &IsAddedBefore);
+      for (uint32_t j = 0; j < matches.size (); j++)
         {
-          Ipv4Mask mask = (*j)->GetDestNetworkMask ();
-          Ipv4Address entry = (*j)->GetDestNetwork ();
-          if (mask.IsMatch (dest, entry)) 
+          Ipv4RoutingTableEntry *route = matches[j].route;
+          if (oif != 0)
             {
-              if (oif != 0)
+              if (oif != m_ipv4->GetNetDevice (route->GetInterface ()))
                 {
-                  if (oif != m_ipv4->GetNetDevice ((*j)->GetInterface ()))
-                    {
-                      NS_LOG_LOGIC ("Not on requested interface, skipping");
-                      continue;
-                    }
+                  NS_LOG_LOGIC ("Not on requested interface, skipping");
+                  continue;
                 }
-              allRoutes.push_back (*j);
-              NS_LOG_LOGIC (allRoutes.size () << "Found global network route" << *j);
             }
+          allRoutes.push_back (route);
+          NS_LOG_LOGIC (allRoutes.size () << "Found global network route" << route);
         }
     }
   if (allRoutes.size () == 0)  // consider external if no host/network found
     {
-      for (ASExternalRoutesI k = m_ASexternalRoutes.begin ();
-           k != m_ASexternalRoutes.end ();
-           k++)
+      matches.clear ();
+      m_ASexternalRouteTrie.Lookup (dest, matches);
+      std::sort (matches.begin (), matches.end (), &IsAddedBefore);
+      for (uint32_t k = 0; k < matches.size (); k++)
         {
-          Ipv4Mask mask = (*k)->GetDestNetworkMask ();
-          Ipv4Address entry = (*k)->GetDestNetwork ();
-          if (mask.IsMatch (dest, entry))
+          Ipv4RoutingTableEntry *route = matches[k].route;
+          NS_LOG_LOGIC ("Found external route" << route);
+          if (oif != 0)
             {
-              NS_LOG_LOGIC ("Found external route" << *k);
-              if (oif != 0)
+              if (oif != m_ipv4->GetNetDevice (route->GetInterface ()))
                 {
-                  if (oif != m_ipv4->GetNetDevice ((*k)->GetInterface ()))
-                    {
-                      NS_LOG_LOGIC ("Not on requested interface, skipping");
-                      continue;
-                    }
+                  NS_LOG_LOGIC ("Not on requested interface, skipping");
+                  continue;
                 }
-              allRoutes.push_back (*k);
-              break;
             }
+          allRoutes.push_back (route);
+          break;
         }
     }
   if (allRoutes.size () > 0 ) // if route(s) is found
@@ -253,6 +495,7 @@ Ipv4GlobalRouting::GetNRoutes (void) const
   n += m_hostRoutes.size ();
   n += m_networkRoutes.size ();
   n += m_ASexternalRoutes.size ();
+  n += m_compactRoutes.size ();
   return n;
 }
 
@@ -301,6 +544,12 @@ Ipv4GlobalRouting::GetRoute (uint32_t index) const
         }
       tmp++;
     }
+  index -= m_ASexternalRoutes.size ();
+  if (index < m_compactRoutes.size ())
+    {
+      m_compactEntry = GetCompactEntry (m_compactRoutes[index]);
+      return &m_compactEntry;
+    }
   NS_ASSERT (false);
   // quiet compiler.
   return 0;
@@ -319,6 +568,7 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
           if (tmp  == index)
             {
               NS_LOG_LOGIC ("Removing route " << index << "; size = " << m_hostRoutes.size ());
+              m_hostRouteTrie.Remove ((*i)->GetDest (), 32, *i);
               delete *i;
               m_hostRoutes.erase (i);
               NS_LOG_LOGIC ("Done removing host route " << index << "; host route remaining size = " << m_hostRoutes.size ());
@@ -336,6 +586,8 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
       if (tmp == index)
         {
           NS_LOG_LOGIC ("Removing route " << index << "; size = " << m_networkRoutes.size ());
+          m_networkRouteTrie.Remove ((*j)->GetDestNetwork (),
+                                     (*j)->GetDestNetworkMask ().GetPrefixLength (), *j);
           delete *j;
           m_networkRoutes.erase (j);
           NS_LOG_LOGIC ("Done removing network route " << index << "; network route remaining size = " << m_networkRoutes.size ());
@@ -352,6 +604,8 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
       if (tmp == index)
         {
           NS_LOG_LOGIC ("Removing route " << index << "; size = " << m_ASexternalRoutes.size ());
+          m_ASexternalRouteTrie.Remove ((*k)->GetDestNetwork (),
+                                        (*k)->GetDestNetworkMask ().GetPrefixLength (), *k);
           delete *k;
           m_ASexternalRoutes.erase (k);
           NS_LOG_LOGIC ("Done removing network route " << index << "; network route remaining size = " << m_networkRoutes.size ());
@@ -359,6 +613,20 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
         }
       tmp++;
     }
+  index -= m_ASexternalRoutes.size ();
+  if (index < m_compactRoutes.size ())
+    {
+      NS_LOG_LOGIC ("Removing compact route " << index << "; size = " << m_compactRoutes.size ());
+      m_compactRoutes.erase (m_compactRoutes.begin () + index);
+      for (uint32_t i = 0; i < m_compactBegin.size (); i++)
+        {
+          if (m_compactBegin[i] > index)
+            {
+              m_compactBegin[i]--;
+            }
+        }
+      return;
+    }
   NS_ASSERT (false);
 }
 
@@ -392,6 +660,10 @@ Ipv4GlobalRouting::DoDispose (void)
     {
       delete (*l);
     }
+  m_hostRouteTrie.Clear ();
+  m_networkRouteTrie.Clear ();
+  m_ASexternalRouteTrie.Clear ();
+  SetCompactRoutes (std::vector<CompactRoute> ());
 
   Ipv4RoutingProtocol::DoDispose ();
 }
@@ -537,9 +809,7 @@ Ipv4GlobalRouting::NotifyInterfaceUp (uint32_t i)
   NS_LOG_FUNCTION (this << i);
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::UpdateRoutes ();
     }
 }
 
@@ -549,9 +819,7 @@ Ipv4GlobalRouting::NotifyInterfaceDown (uint32_t i)
   NS_LOG_FUNCTION (this << i);
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::UpdateRoutes ();
     }
 }
 
@@ -561,9 +829,7 @@ Ipv4GlobalRouting::NotifyAddAddress (uint32_t interface, Ipv4InterfaceAddress ad
   NS_LOG_FUNCTION (this << interface << address);
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::UpdateRoutes ();
     }
 }
 
@@ -573,9 +839,7 @@ Ipv4GlobalRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress
   NS_LOG_FUNCTION (this << interface << address);
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::UpdateRoutes ();
     }
 }
 
@@ -21,6 +21,7 @@
 #define IPV4_GLOBAL_ROUTING_H
 
 #include <list>
+#include <vector>
 #include <stdint.h>
 #include "ns3/ipv4-address.h"
 #include "ns3/ipv4-header.h"
@@ -28,6 +29,8 @@
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/random-variable-stream.h"
+#include "ns3/ipv4-routing-table-trie.h"
+#include "ns3/ipv4-routing-table-entry.h"
 
 namespace ns3 {
 
@@ -71,6 +74,22 @@ class Node;
 class Ipv4GlobalRouting : public Ipv4RoutingProtocol
 {
 public:
+  /**
+   * \brief A route of the compact routing table.
+   *
+   * The global route manager may install the routes to the hosts and
+   * networks of the area as aggregated prefixes, which are kept in a
+   * sorted array of these records instead of separately allocated
+   * Ipv4RoutingTableEntry objects.
+   */
+  struct CompactRoute
+  {
+    uint32_t network;      //!< The destination network, with its host bits cleared.
+    uint32_t gateway;      //!< The next hop.
+    uint32_t interface;    //!< The outgoing interface.
+    uint8_t prefixLength;  //!< The prefix length of the destination network.
+  };
+
   /**
    * \brief Get the type ID.
    * \return the object TypeId
@@ -169,6 +188,34 @@ public:
                              Ipv4Address nextHop,
                              uint32_t interface);
 
+  /**
+   * \brief Replace the compact routes of the table.
+   *
+   * The compact routes are looked up by longest prefix, after the host
+   * routes and before the network routes.  The routes of the same prefix
+   * are equal-cost routes, in the order given.  They come after the
+   * external routes in the route indices.
+   *
+   * \param routes The routes.
+   */
+  void SetCompactRoutes (const std::vector<CompactRoute> &routes);
+
+  /**
+   * \brief Replace the host, network and external routes of the table.
+   *
+   * The table then holds the given routes, looked up and numbered as if
+   * it had been emptied and they had been added in order.  The routes
+   * which are already in place at the start and at the end of each list
+   * are kept, so that replacing a large table by a similar one is cheap.
+   *
+   * \param hostRoutes The routes to hosts.
+   * \param networkRoutes The routes to networks.
+   * \param externalRoutes The external routes.
+   */
+  void SetRoutes (const std::vector<Ipv4RoutingTableEntry> &hostRoutes,
+                  const std::vector<Ipv4RoutingTableEntry> &networkRoutes,
+                  const std::vector<Ipv4RoutingTableEntry> &externalRoutes);
+
   /**
    * \brief Get the number of individual unicast routes that have been added
    * to the routing table.
@@ -193,7 +240,8 @@ public:
    * \param i The index (into the routing table) of the route to retrieve.  If
    * the default route has been set, it will occupy index zero.
    * \return If route is set, a pointer to that Ipv4RoutingTableEntry is returned, otherwise
-   * a zero pointer is returned.
+   * a zero pointer is returned.  The entry of a compact route is a copy,
+   * valid until the next call.
    *
    * \see Ipv4RoutingTableEntry
    * \see Ipv4GlobalRouting::RemoveRoute
@@ -268,10 +316,49 @@ private:
    */
   Ptr<Ipv4Route> LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif = 0);
 
+  /**
+   * \brief Find the compact routes of the longest prefix containing an
+   * address.
+   * \param dest The destination address.
+   * \param oif The output interface if any (put 0 otherwise).
+   * \param [out] routes The matching routes, as routing table entries.
+   */
+  void LookupCompact (Ipv4Address dest, Ptr<NetDevice> oif,
+                      std::vector<Ipv4RoutingTableEntry> &routes) const;
+
+  /**
+   * \brief Make a routing table entry of a compact route.
+   * \param route The compact route.
+   * \returns The entry.
+   */
+  static Ipv4RoutingTableEntry GetCompactEntry (const CompactRoute &route);
+
+  /**
+   * \brief Replace the routes of a list and of its index, keeping the
+   * routes already in place at the start and at the end of the list.
+   * \param routes The list.
+   * \param trie The index of the list.
+   * \param newRoutes The new routes, in order.
+   */
+  static void ReplaceRoutes (std::list<Ipv4RoutingTableEntry *> &routes,
+                             Ipv4RoutingTableTrie &trie,
+                             const std::vector<Ipv4RoutingTableEntry> &newRoutes);
+
   HostRoutes m_hostRoutes;             //!< Routes to hosts
   NetworkRoutes m_networkRoutes;       //!< Routes to networks
   ASExternalRoutes m_ASexternalRoutes; //!< External routes imported
 
+  Ipv4RoutingTableTrie m_hostRouteTrie;       //!< Index of the routes to hosts
+  Ipv4RoutingTableTrie m_networkRouteTrie;    //!< Index of the routes to networks
+  Ipv4RoutingTableTrie m_ASexternalRouteTrie; //!< Index of the external routes
+
+  /// Compact routes, by decreasing prefix length, then by network
+  std::vector<CompactRoute> m_compactRoutes;
+  /// Index in m_compactRoutes of the first route of prefix length 32 - i, and the end
+  std::vector<uint32_t> m_compactBegin;
+  /// Copy of the compact route last returned by GetRoute
+  mutable Ipv4RoutingTableEntry m_compactEntry;
+
   Ptr<Ipv4> m_ipv4; //!< associated IPv4 instance
 };
 
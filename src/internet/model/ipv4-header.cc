@@ -30,6 +30,28 @@ NS_LOG_COMPONENT_DEFINE ("Ipv4Header");
 
 NS_OBJECT_ENSURE_REGISTERED (Ipv4Header);
 
+/**
+ * \brief Update a checksum for the change of one of the words it covers
+ *
+ * See RFC 1624, eqn. 3.  The words are taken as Buffer::Iterator::ReadU16
+ * reads them, as the checksum is.
+ *
+ * \param checksum the checksum
+ * \param oldWord the word before the change
+ * \param newWord the word after the change
+ * \return the updated checksum
+ */
+static uint16_t
+UpdateChecksum (uint16_t checksum, uint16_t oldWord, uint16_t newWord)
+{
+  uint32_t sum = static_cast<uint16_t> (~checksum) + static_cast<uint16_t> (~oldWord) + newWord;
+  while (sum >> 16)
+    {
+      sum = (sum & 0xffff) + (sum >> 16);
+    }
+  return ~sum;
+}
+
 Ipv4Header::Ipv4Header ()
   : m_calcChecksum (false),
     m_payloadSize (0),
@@ -41,6 +63,7 @@ Ipv4Header::Ipv4Header ()
     m_fragmentOffset (0),
     m_checksum (0),
     m_goodChecksum (true),
+    m_checksumValid (false),
     m_headerSize(5*4)
 {
 }
@@ -57,6 +80,7 @@ Ipv4Header::SetPayloadSize (uint16_t size)
 {
   NS_LOG_FUNCTION (this << size);
   m_payloadSize = size;
+  m_checksumValid = false;
 }
 uint16_t
 Ipv4Header::GetPayloadSize (void) const
@@ -76,6 +100,7 @@ Ipv4Header::SetIdentification (uint16_t identification)
 {
   NS_LOG_FUNCTION (this << identification);
   m_identification = identification;
+  m_checksumValid = false;
 }
 
 void 
@@ -83,6 +108,7 @@ Ipv4Header::SetTos (uint8_t tos)
 {
   NS_LOG_FUNCTION (this << static_cast<uint32_t> (tos));
   m_tos = tos;
+  m_checksumValid = false;
 }
 
 void
@@ -91,6 +117,7 @@ Ipv4Header::SetDscp (DscpType dscp)
   NS_LOG_FUNCTION (this << dscp);
   m_tos &= 0x3; // Clear out the DSCP part, retain 2 bits of ECN
   m_tos |= (dscp << 2);
+  m_checksumValid = false;
 }
 
 void
@@ -99,6 +126,7 @@ Ipv4Header::SetEcn (EcnType ecn)
   NS_LOG_FUNCTION (this << ecn);
   m_tos &= 0xFC; // Clear out the ECN part, retain 6 bits of DSCP
   m_tos |= ecn;
+  m_checksumValid = false;
 }
 
 Ipv4Header::DscpType 
@@ -201,12 +229,14 @@ Ipv4Header::SetMoreFragments (void)
 {
   NS_LOG_FUNCTION (this);
   m_flags |= MORE_FRAGMENTS;
+  m_checksumValid = false;
 }
 void
 Ipv4Header::SetLastFragment (void)
 {
   NS_LOG_FUNCTION (this);
   m_flags &= ~MORE_FRAGMENTS;
+  m_checksumValid = false;
 }
 bool 
 Ipv4Header::IsLastFragment (void) const
@@ -220,12 +250,14 @@ Ipv4Header::SetDontFragment (void)
 {
   NS_LOG_FUNCTION (this);
   m_flags |= DONT_FRAGMENT;
+  m_checksumValid = false;
 }
 void 
 Ipv4Header::SetMayFragment (void)
 {
   NS_LOG_FUNCTION (this);
   m_flags &= ~DONT_FRAGMENT;
+  m_checksumValid = false;
 }
 bool 
 Ipv4Header::IsDontFragment (void) const
@@ -241,6 +273,7 @@ Ipv4Header::SetFragmentOffset (uint16_t offsetBytes)
   // check if the user is trying to set an invalid offset
   NS_ABORT_MSG_IF ((offsetBytes & 0x7), "offsetBytes must be multiple of 8 bytes");
   m_fragmentOffset = offsetBytes;
+  m_checksumValid = false;
 }
 uint16_t 
 Ipv4Header::GetFragmentOffset (void) const
@@ -259,6 +292,10 @@ void
 Ipv4Header::SetTtl (uint8_t ttl)
 {
   NS_LOG_FUNCTION (this << static_cast<uint32_t> (ttl));
+  if (m_checksumValid)
+    { // The TTL shares its word with the protocol
+      m_checksum = UpdateChecksum (m_checksum, m_ttl | (m_protocol << 8), ttl | (m_protocol << 8));
+    }
   m_ttl = ttl;
 }
 uint8_t 
@@ -279,6 +316,7 @@ Ipv4Header::SetProtocol (uint8_t protocol)
 {
   NS_LOG_FUNCTION (this << static_cast<uint32_t> (protocol));
   m_protocol = protocol;
+  m_checksumValid = false;
 }
 
 void 
@@ -286,6 +324,7 @@ Ipv4Header::SetSource (Ipv4Address source)
 {
   NS_LOG_FUNCTION (this << source);
   m_source = source;
+  m_checksumValid = false;
 }
 Ipv4Address
 Ipv4Header::GetSource (void) const
@@ -299,6 +338,7 @@ Ipv4Header::SetDestination (Ipv4Address dst)
 {
   NS_LOG_FUNCTION (this << dst);
   m_destination = dst;
+  m_checksumValid = false;
 }
 Ipv4Address
 Ipv4Header::GetDestination (void) const
@@ -409,7 +449,13 @@ Ipv4Header::Serialize (Buffer::Iterator start) const
   i.WriteHtonU32 (m_source.Get ());
   i.WriteHtonU32 (m_destination.Get ());
 
-  if (m_calcChecksum) 
+  if (m_calcChecksum && m_checksumValid)
+    { // The checksum was received, and updated since
+      i = start;
+      i.Next (10);
+      i.WriteU16 (m_checksum);
+    }
+  else if (m_calcChecksum) 
     {
       i = start;
       uint16_t checksum = i.CalculateIpChecksum (20);
@@ -469,6 +515,12 @@ Ipv4Header::Deserialize (Buffer::Iterator start)
       NS_LOG_LOGIC ("checksum=" <<checksum);
 
       m_goodChecksum = (checksum == 0);
+      // Options are not serialized again, and change the checksum
+      m_checksumValid = m_goodChecksum && headerSize == 20;
+    }
+  else
+    {
+      m_checksumValid = false;
     }
   return GetSerializedSize ();
 }
@@ -256,6 +256,7 @@ private:
   Ipv4Address m_destination; //!< destination address
   uint16_t m_checksum; //!< checksum
   bool m_goodChecksum; //!< true if checksum is correct
+  bool m_checksumValid; //!< true if m_checksum is the checksum of the fields
   uint16_t m_headerSize; //!< IP header size
 };
 
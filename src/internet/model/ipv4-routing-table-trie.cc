@@ -0,0 +1,257 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include "ipv4-routing-table-trie.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("Ipv4RoutingTableTrie");
+
+namespace {
+
+/**
+ * \param length A prefix length.
+ * \returns The mask of the prefix length.
+ */
+inline uint32_t
+PrefixMask (uint8_t length)
+{
+  return length == 0 ? 0 : 0xffffffff << (32 - length);
+}
+
+/**
+ * \param address An address.
+ * \param position A bit position, 0 being the most significant bit.
+ * \returns The bit at the position.
+ */
+inline uint32_t
+BitAt (uint32_t address, uint8_t position)
+{
+  return (address >> (31 - position)) & 1;
+}
+
+/**
+ * \param a An address.
+ * \param b An address.
+ * \param max The maximum length.
+ * \returns The length of the common prefix of the addresses, at most max.
+ */
+uint8_t
+CommonPrefixLength (uint32_t a, uint32_t b, uint8_t max)
+{
+  uint8_t length = 0;
+  while (length < max && BitAt (a, length) == BitAt (b, length))
+    {
+      length++;
+    }
+  return length;
+}
+
+} // anonymous namespace
+
+Ipv4RoutingTableTrie::Ipv4RoutingTableTrie ()
+  : m_root (CreateNode (0, 0)),
+    m_n (0),
+    m_nextOrder (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+Ipv4RoutingTableTrie::~Ipv4RoutingTableTrie ()
+{
+  NS_LOG_FUNCTION (this);
+  DeleteNode (m_root);
+}
+
+Ipv4RoutingTableTrie::Node *
+Ipv4RoutingTableTrie::CreateNode (uint32_t prefix, uint8_t length)
+{
+  Node *node = new Node;
+  node->prefix = prefix & PrefixMask (length);
+  node->length = length;
+  node->children[0] = 0;
+  node->children[1] = 0;
+  return node;
+}
+
+void
+Ipv4RoutingTableTrie::DeleteNode (Node *node)
+{
+  if (node != 0)
+    {
+      DeleteNode (node->children[0]);
+      DeleteNode (node->children[1]);
+      delete node;
+    }
+}
+
+void
+Ipv4RoutingTableTrie::Insert (Ipv4Address network, uint8_t prefixLength,
+                              Ipv4RoutingTableEntry *route, uint32_t metric)
+{
+  NS_LOG_FUNCTION (this << network << static_cast<uint32_t> (prefixLength) << route << metric);
+  NS_ASSERT (prefixLength <= 32);
+  uint32_t key = network.Get () & PrefixMask (prefixLength);
+  Match match;
+  match.route = route;
+  match.metric = metric;
+  match.order = m_nextOrder++;
+  match.prefixLength = prefixLength;
+  m_n++;
+
+  // The prefix of node is always a prefix of the key.
+  Node *node = m_root;
+  while (node->length < prefixLength)
+    {
+      Node **link = &node->children[BitAt (key, node->length)];
+      Node *child = *link;
+      if (child == 0)
+        {
+          *link = CreateNode (key, prefixLength);
+          (*link)->entries.push_back (match);
+          return;
+        }
+      uint8_t common = CommonPrefixLength (child->prefix, key,
+                                           std::min (child->length, prefixLength));
+      if (common == child->length)
+        {
+          node = child;
+          continue;
+        }
+      // The key diverges from, or is a prefix of, the prefix of the child:
+      // a node is inserted in between.
+      Node *parent = CreateNode (key, common);
+      parent->children[BitAt (child->prefix, common)] = child;
+      *link = parent;
+      if (common == prefixLength)
+        {
+          parent->entries.push_back (match);
+        }
+      else
+        {
+          Node *leaf = CreateNode (key, prefixLength);
+          leaf->entries.push_back (match);
+          parent->children[BitAt (key, common)] = leaf;
+        }
+      return;
+    }
+  NS_ASSERT (node->length == prefixLength && node->prefix == key);
+  node->entries.push_back (match);
+}
+
+void
+Ipv4RoutingTableTrie::Remove (Ipv4Address network, uint8_t prefixLength,
+                              Ipv4RoutingTableEntry *route)
+{
+  NS_LOG_FUNCTION (this << network << static_cast<uint32_t> (prefixLength) << route);
+  uint32_t key = network.Get () & PrefixMask (prefixLength);
+
+  // The links leading to the node of the prefix.
+  Node **path[33];
+  uint32_t depth = 0;
+  Node **link = &m_root;
+  while (*link != 0 && (*link)->length < prefixLength)
+    {
+      if (((*link)->prefix ^ key) & PrefixMask ((*link)->length))
+        {
+          break;
+        }
+      path[depth++] = link;
+      link = &(*link)->children[BitAt (key, (*link)->length)];
+    }
+  Node *node = *link;
+  if (node == 0 || node->length != prefixLength || node->prefix != key)
+    {
+      NS_ASSERT_MSG (false, "Route not found in the trie");
+      return;
+    }
+  std::vector<Match>::iterator i = node->entries.begin ();
+  while (i != node->entries.end () && i->route != route)
+    {
+      i++;
+    }
+  NS_ASSERT_MSG (i != node->entries.end (), "Route not found in the trie");
+  if (i == node->entries.end ())
+    {
+      return;
+    }
+  node->entries.erase (i);
+  m_n--;
+
+  // Remove the nodes left without entries nor branches, up the path.
+  while (node != m_root && node->entries.empty ())
+    {
+      if (node->children[0] != 0 && node->children[1] != 0)
+        {
+          break;
+        }
+      *link = node->children[0] != 0 ? node->children[0] : node->children[1];
+      delete node;
+      if (*link != 0 || depth == 0)
+        {
+          break;
+        }
+      link = path[--depth];
+      node = *link;
+    }
+}
+
+void
+Ipv4RoutingTableTrie::Clear (void)
+{
+  NS_LOG_FUNCTION (this);
+  DeleteNode (m_root);
+  m_root = CreateNode (0, 0);
+  m_n = 0;
+}
+
+uint32_t
+Ipv4RoutingTableTrie::GetN (void) const
+{
+  return m_n;
+}
+
+void
+Ipv4RoutingTableTrie::Lookup (Ipv4Address dest, std::vector<Match> &matches) const
+{
+  NS_LOG_FUNCTION (this << dest);
+  uint32_t address = dest.Get ();
+  const Node *found[33];
+  uint32_t n = 0;
+  const Node *node = m_root;
+  while (node != 0 && ((node->prefix ^ address) & PrefixMask (node->length)) == 0)
+    {
+      if (!node->entries.empty ())
+        {
+          found[n++] = node;
+        }
+      if (node->length == 32)
+        {
+          break;
+        }
+      node = node->children[BitAt (address, node->length)];
+    }
+  while (n > 0)
+    {
+      const std::vector<Match> &entries = found[--n]->entries;
+      matches.insert (matches.end (), entries.begin (), entries.end ());
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,140 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef IPV4_ROUTING_TABLE_TRIE_H
+#define IPV4_ROUTING_TABLE_TRIE_H
+
+#include <vector>
+#include <stdint.h>
+#include "ns3/ipv4-address.h"
+
+namespace ns3 {
+
+class Ipv4RoutingTableEntry;
+
+/**
+ * \ingroup ipv4Routing
+ *
+ * \brief A path-compressed binary trie indexing routing table entries by
+ * destination prefix.
+ *
+ * The routing protocols keep their routes in lists, whose order defines
+ * the route indices and breaks the ties between equivalent routes.  The
+ * trie indexes the same entries so that a lookup only visits the
+ * prefixes of the destination, at most 33 nodes, instead of scanning the
+ * whole list.  It returns every matching entry with its prefix length,
+ * metric and insertion order, so that the routing protocol applies its
+ * own selection rules (longest prefix, metric, ECMP) unchanged.
+ *
+ * The trie does not own the entries.
+ */
+class Ipv4RoutingTableTrie
+{
+public:
+  /**
+   * An entry matching a destination.
+   */
+  struct Match
+  {
+    Ipv4RoutingTableEntry *route; //!< The routing table entry.
+    uint32_t metric;              //!< The metric of the entry.
+    uint32_t order;               //!< The insertion order of the entry.
+    uint8_t prefixLength;         //!< The prefix length of the entry.
+  };
+
+  Ipv4RoutingTableTrie ();
+  ~Ipv4RoutingTableTrie ();
+
+  /**
+   * \brief Index an entry.
+   *
+   * The entries inserted later compare greater in insertion order.
+   *
+   * \param network The destination network of the entry.
+   * \param prefixLength The prefix length of the destination network.
+   * \param route The entry.
+   * \param metric The metric of the entry.
+   */
+  void Insert (Ipv4Address network, uint8_t prefixLength,
+               Ipv4RoutingTableEntry *route, uint32_t metric = 0);
+
+  /**
+   * \brief Remove an entry.
+   *
+   * \param network The destination network the entry was inserted with.
+   * \param prefixLength The prefix length the entry was inserted with.
+   * \param route The entry.
+   */
+  void Remove (Ipv4Address network, uint8_t prefixLength,
+               Ipv4RoutingTableEntry *route);
+
+  /**
+   * \brief Remove all the entries.
+   */
+  void Clear (void);
+
+  /**
+   * \returns The number of entries.
+   */
+  uint32_t GetN (void) const;
+
+  /**
+   * \brief Find the entries whose destination network contains an address.
+   *
+   * The matches are appended by decreasing prefix length and, for the
+   * same prefix, by insertion order.
+   *
+   * \param dest The destination address.
+   * \param [out] matches The matching entries.
+   */
+  void Lookup (Ipv4Address dest, std::vector<Match> &matches) const;
+
+private:
+  /**
+   * A node of the trie: a prefix and the entries of that prefix.
+   */
+  struct Node
+  {
+    uint32_t prefix;              //!< The prefix, with its host bits cleared.
+    uint8_t length;               //!< The length of the prefix.
+    Node *children[2];            //!< The longer prefixes, by their next bit.
+    std::vector<Match> entries;   //!< The entries of this prefix.
+  };
+
+  /**
+   * \brief Create a node.
+   * \param prefix The prefix.
+   * \param length The length of the prefix.
+   * \returns The node.
+   */
+  static Node *CreateNode (uint32_t prefix, uint8_t length);
+  /**
+   * \brief Delete a node and its descendants.
+   * \param node The node.
+   */
+  static void DeleteNode (Node *node);
+
+  Ipv4RoutingTableTrie (const Ipv4RoutingTableTrie &);
+  Ipv4RoutingTableTrie &operator = (const Ipv4RoutingTableTrie &);
+
+  Node *m_root;         //!< The node of the empty prefix.
+  uint32_t m_n;         //!< The number of entries.
+  uint32_t m_nextOrder; //!< The insertion order of the next entry.
+};
+
+} // namespace ns3
+
+#endif /* IPV4_ROUTING_TABLE_TRIE_H */
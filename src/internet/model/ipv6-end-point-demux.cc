@@ -21,6 +21,8 @@
 #include "ipv6-end-point-demux.h"
 #include "ipv6-end-point.h"
 #include "ns3/log.h"
+#include <algorithm>
+#include <iterator>
 
 namespace ns3 {
 
@@ -29,7 +31,8 @@ NS_LOG_COMPONENT_DEFINE ("Ipv6EndPointDemux");
 Ipv6EndPointDemux::Ipv6EndPointDemux ()
   : m_ephemeral (49152),
     m_portFirst (49152),
-    m_portLast (65535)
+    m_portLast (65535),
+    m_nextOrder (0)
 {
   NS_LOG_FUNCTION_NOARGS ();
 }
@@ -37,39 +40,144 @@ Ipv6EndPointDemux::Ipv6EndPointDemux ()
 Ipv6EndPointDemux::~Ipv6EndPointDemux ()
 {
   NS_LOG_FUNCTION_NOARGS ();
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  for (std::map<uint64_t, Ipv6EndPoint *>::iterator i = m_endPoints.begin (); i != m_endPoints.end (); i++)
     {
-      Ipv6EndPoint *endPoint = *i;
+      Ipv6EndPoint *endPoint = i->second;
       delete endPoint;
     }
   m_endPoints.clear ();
+  m_connected.clear ();
+  m_wildcards.clear ();
 }
 
-bool Ipv6EndPointDemux::LookupPortLocal (uint16_t port)
+bool Ipv6EndPointDemux::FourTuple::operator< (const FourTuple &tuple) const
 {
-  NS_LOG_FUNCTION (this << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  if (localPort != tuple.localPort)
     {
-      if ((*i)->GetLocalPort  () == port)
+      return localPort < tuple.localPort;
+    }
+  if (localAddress != tuple.localAddress)
+    {
+      return localAddress < tuple.localAddress;
+    }
+  if (peerAddress != tuple.peerAddress)
+    {
+      return peerAddress < tuple.peerAddress;
+    }
+  return peerPort < tuple.peerPort;
+}
+
+bool Ipv6EndPointDemux::IsConnected (Ipv6EndPoint *endPoint)
+{
+  return endPoint->GetLocalAddress () != Ipv6Address::GetAny ()
+         && endPoint->GetPeerAddress () != Ipv6Address::GetAny ()
+         && endPoint->GetPeerPort () != 0;
+}
+
+Ipv6EndPointDemux::FourTuple Ipv6EndPointDemux::GetFourTuple (Ipv6EndPoint *endPoint)
+{
+  FourTuple tuple;
+  tuple.localPort = endPoint->GetLocalPort ();
+  tuple.localAddress = endPoint->GetLocalAddress ();
+  tuple.peerAddress = endPoint->GetPeerAddress ();
+  tuple.peerPort = endPoint->GetPeerPort ();
+  return tuple;
+}
+
+bool Ipv6EndPointDemux::IsAllocatedBefore (Ipv6EndPoint *a, Ipv6EndPoint *b)
+{
+  return a->m_demuxOrder < b->m_demuxOrder;
+}
+
+void Ipv6EndPointDemux::Insert (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  endPoint->m_demux = this;
+  endPoint->m_demuxOrder = m_nextOrder++;
+  m_endPoints[endPoint->m_demuxOrder] = endPoint;
+  AddIndex (endPoint);
+}
+
+void Ipv6EndPointDemux::AddIndex (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  Bucket &bucket = IsConnected (endPoint) ? m_connected[GetFourTuple (endPoint)]
+    : m_wildcards[endPoint->GetLocalPort ()];
+  bucket.insert (std::upper_bound (bucket.begin (), bucket.end (), endPoint, &IsAllocatedBefore),
+                 endPoint);
+}
+
+void Ipv6EndPointDemux::RemoveIndex (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  if (IsConnected (endPoint))
+    {
+      std::map<FourTuple, Bucket>::iterator i = m_connected.find (GetFourTuple (endPoint));
+      NS_ASSERT (i != m_connected.end ());
+      i->second.erase (std::lower_bound (i->second.begin (), i->second.end (), endPoint, &IsAllocatedBefore));
+      if (i->second.empty ())
+        {
+          m_connected.erase (i);
+        }
+    }
+  else
+    {
+      std::map<uint16_t, Bucket>::iterator i = m_wildcards.find (endPoint->GetLocalPort ());
+      NS_ASSERT (i != m_wildcards.end ());
+      i->second.erase (std::lower_bound (i->second.begin (), i->second.end (), endPoint, &IsAllocatedBefore));
+      if (i->second.empty ())
         {
-          return true;
+          m_wildcards.erase (i);
         }
     }
-  return false;
+}
+
+void Ipv6EndPointDemux::GetPortEndPoints (uint16_t port, Bucket &endPoints)
+{
+  NS_LOG_FUNCTION (this << port);
+  std::map<uint16_t, Bucket>::const_iterator wildcards = m_wildcards.find (port);
+  if (wildcards != m_wildcards.end ())
+    {
+      endPoints = wildcards->second;
+    }
+  FourTuple first = { port, Ipv6Address::GetZero (), Ipv6Address::GetZero (), 0 };
+  for (std::map<FourTuple, Bucket>::const_iterator i = m_connected.lower_bound (first);
+       i != m_connected.end () && i->first.localPort == port; i++)
+    {
+      endPoints.insert (endPoints.end (), i->second.begin (), i->second.end ());
+    }
+  std::sort (endPoints.begin (), endPoints.end (), &IsAllocatedBefore);
+}
+
+bool Ipv6EndPointDemux::LookupPortLocal (uint16_t port)
+{
+  NS_LOG_FUNCTION (this << port);
+  if (m_wildcards.find (port) != m_wildcards.end ())
+    {
+      return true;
+    }
+  FourTuple first = { port, Ipv6Address::GetZero (), Ipv6Address::GetZero (), 0 };
+  std::map<FourTuple, Bucket>::const_iterator i = m_connected.lower_bound (first);
+  return i != m_connected.end () && i->first.localPort == port;
 }
 
 bool Ipv6EndPointDemux::LookupLocal (Ipv6Address addr, uint16_t port)
 {
   NS_LOG_FUNCTION (this << addr << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  std::map<uint16_t, Bucket>::const_iterator wildcards = m_wildcards.find (port);
+  if (wildcards != m_wildcards.end ())
     {
-      if ((*i)->GetLocalPort () == port
-          && (*i)->GetLocalAddress () == addr)
+      for (Bucket::const_iterator i = wildcards->second.begin (); i != wildcards->second.end (); i++)
         {
-          return true;
+          if ((*i)->GetLocalAddress () == addr)
+            {
+              return true;
+            }
         }
     }
-  return false;
+  FourTuple first = { port, addr, Ipv6Address::GetZero (), 0 };
+  std::map<FourTuple, Bucket>::const_iterator i = m_connected.lower_bound (first);
+  return i != m_connected.end () && i->first.localPort == port && i->first.localAddress == addr;
 }
 
 Ipv6EndPoint* Ipv6EndPointDemux::Allocate ()
@@ -82,7 +190,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate ()
       return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (Ipv6Address::GetAny (), port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -97,7 +205,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address address)
       return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -118,7 +226,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address address, uint16_t port)
       return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -127,21 +235,31 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address localAddress, uint16_t lo
                                            Ipv6Address peerAddress, uint16_t peerPort)
 {
   NS_LOG_FUNCTION (this << localAddress << localPort << peerAddress << peerPort);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  FourTuple tuple = { localPort, localAddress, peerAddress, peerPort };
+  bool found = m_connected.find (tuple) != m_connected.end ();
+  std::map<uint16_t, Bucket>::const_iterator wildcards = m_wildcards.find (localPort);
+  if (!found && wildcards != m_wildcards.end ())
     {
-      if ((*i)->GetLocalPort () == localPort
-          && (*i)->GetLocalAddress () == localAddress
-          && (*i)->GetPeerPort () == peerPort
-          && (*i)->GetPeerAddress () == peerAddress)
+      for (Bucket::const_iterator i = wildcards->second.begin (); i != wildcards->second.end (); i++)
         {
-          NS_LOG_WARN ("No way we can allocate this end-point.");
-          /* no way we can allocate this end-point. */
-          return 0;
+          if ((*i)->GetLocalAddress () == localAddress
+              && (*i)->GetPeerPort () == peerPort
+              && (*i)->GetPeerAddress () == peerAddress)
+            {
+              found = true;
+              break;
+            }
         }
     }
+  if (found)
+    {
+      NS_LOG_WARN ("No way we can allocate this end-point.");
+      /* no way we can allocate this end-point. */
+      return 0;
+    }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (localAddress, localPort);
   endPoint->SetPeer (peerAddress, peerPort);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
 
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
 
@@ -151,14 +269,13 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address localAddress, uint16_t lo
 void Ipv6EndPointDemux::DeAllocate (Ipv6EndPoint *endPoint)
 {
   NS_LOG_FUNCTION_NOARGS ();
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  std::map<uint64_t, Ipv6EndPoint *>::iterator i = m_endPoints.find (endPoint->m_demuxOrder);
+  if (i != m_endPoints.end () && i->second == endPoint)
     {
-      if (*i == endPoint)
-        {
-          delete endPoint;
-          m_endPoints.erase (i);
-          break;
-        }
+      RemoveIndex (endPoint);
+      m_endPoints.erase (i);
+      endPoint->m_demux = 0;
+      delete endPoint;
     }
 }
 
@@ -179,7 +296,29 @@ Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::Lookup (Ipv6Address daddr, uint1
   EndPoints retval4; /* Exact match on all 4 */
 
   NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+
+  /* The end points which may match: the wildcard end points of the port,
+     and the end points whose four-tuple is the one of the packet. */
+  Bucket candidates;
+  std::map<uint16_t, Bucket>::const_iterator wildcards = m_wildcards.find (dport);
+  FourTuple tuple = { dport, daddr, saddr, sport };
+  std::map<FourTuple, Bucket>::const_iterator connected = m_connected.find (tuple);
+  if (wildcards != m_wildcards.end () && connected != m_connected.end ())
+    {
+      std::merge (wildcards->second.begin (), wildcards->second.end (),
+                  connected->second.begin (), connected->second.end (),
+                  std::back_inserter (candidates), &IsAllocatedBefore);
+    }
+  else if (wildcards != m_wildcards.end ())
+    {
+      candidates = wildcards->second;
+    }
+  else if (connected != m_connected.end ())
+    {
+      candidates = connected->second;
+    }
+
+  for (Bucket::const_iterator i = candidates.begin (); i != candidates.end (); i++)
     {
       Ipv6EndPoint* endP = *i;
 
@@ -295,8 +434,10 @@ Ipv6EndPoint* Ipv6EndPointDemux::SimpleLookup (Ipv6Address dst, uint16_t dport,
 {
   uint32_t genericity = 3;
   Ipv6EndPoint *generic = 0;
+  Bucket endPoints;
+  GetPortEndPoints (dport, endPoints);
 
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  for (Bucket::const_iterator i = endPoints.begin (); i != endPoints.end (); i++)
     {
       uint32_t tmp = 0;
 
@@ -355,7 +496,12 @@ uint16_t Ipv6EndPointDemux::AllocateEphemeralPort ()
 
 Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::GetEndPoints () const
 {
-  return m_endPoints;
+  EndPoints ret;
+  for (std::map<uint64_t, Ipv6EndPoint *>::const_iterator i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+    {
+      ret.push_back (i->second);
+    }
+  return ret;
 }
 
 } /* namespace ns3 */
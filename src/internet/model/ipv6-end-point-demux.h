@@ -23,6 +23,8 @@
 
 #include <stdint.h>
 #include <list>
+#include <map>
+#include <vector>
 #include "ns3/ipv6-address.h"
 #include "ipv6-interface.h"
 
@@ -34,6 +36,9 @@ class Ipv6EndPoint;
  * \ingroup ipv6
  *
  * \brief Demultiplexer for end points.
+ *
+ * The end points are indexed as in Ipv4EndPointDemux: by four-tuple when
+ * their addresses and ports are all set, by local port otherwise.
  */
 class Ipv6EndPointDemux
 {
@@ -168,10 +173,98 @@ private:
    */
   uint16_t m_portLast;
 
+  friend class Ipv6EndPoint;
+
+  /**
+   * \brief The four-tuple of an end point whose addresses and ports are
+   * all set.
+   */
+  struct FourTuple
+  {
+    uint16_t localPort;        //!< The local port.
+    Ipv6Address localAddress;  //!< The local address.
+    Ipv6Address peerAddress;   //!< The peer address.
+    uint16_t peerPort;         //!< The peer port.
+
+    /**
+     * \brief Compare two four-tuples, by local port first.
+     * \param tuple The other four-tuple.
+     * \returns true if this four-tuple comes first.
+     */
+    bool operator< (const FourTuple &tuple) const;
+  };
+
+  /**
+   * \brief End points, in their allocation order.
+   */
+  typedef std::vector<Ipv6EndPoint *> Bucket;
+
+  /**
+   * \brief Add an end point to the demux.
+   * \param endPoint The end point.
+   */
+  void Insert (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Index an end point by its current four-tuple.
+   * \param endPoint The end point.
+   */
+  void AddIndex (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Remove an end point from the index of its current four-tuple.
+   * \param endPoint The end point.
+   */
+  void RemoveIndex (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Test if the four-tuple of an end point is fully set.
+   * \param endPoint The end point.
+   * \returns true if the end point is indexed by four-tuple.
+   */
+  static bool IsConnected (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Get the four-tuple of an end point.
+   * \param endPoint The end point.
+   * \returns The four-tuple.
+   */
+  static FourTuple GetFourTuple (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Compare end points by allocation order.
+   * \param a The first end point.
+   * \param b The second end point.
+   * \returns true if a was allocated first.
+   */
+  static bool IsAllocatedBefore (Ipv6EndPoint *a, Ipv6EndPoint *b);
+
+  /**
+   * \brief Get the end points of a local port.
+   * \param port The local port.
+   * \param [out] endPoints The end points, in their allocation order.
+   */
+  void GetPortEndPoints (uint16_t port, Bucket &endPoints);
+
+  /**
+   * \brief The IPv6 end points, by allocation order.
+   */
+  std::map<uint64_t, Ipv6EndPoint *> m_endPoints;
+
+  /**
+   * \brief The allocation order of the next end point.
+   */
+  uint64_t m_nextOrder;
+
+  /**
+   * \brief The end points whose four-tuple is fully set, by four-tuple.
+   */
+  std::map<FourTuple, Bucket> m_connected;
+
   /**
-   * \brief A list of IPv6 end points.
+   * \brief The other end points, by local port.
    */
-  EndPoints m_endPoints;
+  std::map<uint16_t, Bucket> m_wildcards;
 };
 
 } /* namespace ns3 */
@@ -156,8 +156,13 @@ TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
       if (maxSeq < tailSeq) tailSeq = maxSeq;
       if (tailSeq < headSeq) headSeq = tailSeq;
     }
-  // Remove overlapped bytes from packet
-  BufIterator i = m_data.begin ();
+  // Remove overlapped bytes from packet. The packets before the one
+  // holding headSeq end before it, and do not overlap.
+  BufIterator i = m_data.upper_bound (headSeq);
+  if (i != m_data.begin ())
+    {
+      --i;
+    }
   while (i != m_data.end () && i->first <= tailSeq)
     {
       SequenceNumber32 lastByteSeq = i->first + SequenceNumber32 (i->second->GetSize ());
@@ -199,16 +204,8 @@ TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
   NS_LOG_LOGIC ("Buffered packet of seqno=" << headSeq << " len=" << p->GetSize ());
   // Update variables
   m_size += p->GetSize ();      // Occupancy
-  for (BufIterator i = m_data.begin (); i != m_data.end (); ++i)
+  for (BufIterator i = m_data.find (m_nextRxSeq); i != m_data.end () && i->first == m_nextRxSeq; ++i)
     {
-      if (i->first < m_nextRxSeq)
-        {
-          continue;
-        }
-      else if (i->first > m_nextRxSeq)
-        {
-          break;
-        };
       m_nextRxSeq = i->first + SequenceNumber32 (i->second->GetSize ());
       m_availBytes += i->second->GetSize ();
     }
@@ -217,9 +214,72 @@ TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
     { // Account for the FIN packet
       ++m_nextRxSeq;
     };
+  if (headSeq > m_nextRxSeq)
+    {
+      AddSackBlock (headSeq, tailSeq);
+    }
+  else
+    { // The blocks reached by the next Rx sequence are now in order
+      while (!m_sackBlocks.empty () && m_sackBlocks.begin ()->first < m_nextRxSeq)
+        {
+          m_sackBlocks.erase (m_sackBlocks.begin ());
+        }
+    }
   return true;
 }
 
+void
+TcpRxBuffer::AddSackBlock (const SequenceNumber32& head, const SequenceNumber32& tail)
+{
+  NS_LOG_FUNCTION (this << head << tail);
+
+  m_lastSackSeq = head;
+  // Merge the blocks which overlap or touch the data
+  SequenceNumber32 left = head;
+  SequenceNumber32 right = tail;
+  std::map<SequenceNumber32, SequenceNumber32>::iterator i = m_sackBlocks.upper_bound (head);
+  if (i != m_sackBlocks.begin ())
+    {
+      --i;
+      if (i->second < head)
+        {
+          ++i;
+        }
+    }
+  while (i != m_sackBlocks.end () && i->first <= tail)
+    {
+      left = std::min (left, i->first);
+      right = std::max (right, i->second);
+      m_sackBlocks.erase (i++);
+    }
+  m_sackBlocks[left] = right;
+}
+
+TcpOptionSack::SackList
+TcpRxBuffer::GetSackList (void) const
+{
+  TcpOptionSack::SackList list;
+  std::map<SequenceNumber32, SequenceNumber32>::const_iterator last = m_sackBlocks.upper_bound (m_lastSackSeq);
+  if (last != m_sackBlocks.begin ())
+    {
+      --last;
+      list.push_back (*last);
+    }
+  else
+    {
+      last = m_sackBlocks.end ();
+    }
+  for (std::map<SequenceNumber32, SequenceNumber32>::const_iterator i = m_sackBlocks.begin ();
+       i != m_sackBlocks.end (); ++i)
+    {
+      if (i != last)
+        {
+          list.push_back (*i);
+        }
+    }
+  return list;
+}
+
 Ptr<Packet>
 TcpRxBuffer::Extract (uint32_t maxSize)
 {
@@ -27,6 +27,7 @@
 #include "ns3/sequence-number.h"
 #include "ns3/ptr.h"
 #include "ns3/tcp-header.h"
+#include "ns3/tcp-option-sack.h"
 
 namespace ns3 {
 class Packet;
@@ -36,6 +37,11 @@ class Packet;
  *
  * \brief class for the reordering buffer that keeps the data from lower layer, i.e.
  *        TcpL4Protocol, sent to the application
+ *
+ * The data is kept as packets indexed by the sequence number of their first
+ * byte, so that a segment is inserted and the next expected sequence number
+ * is updated in logarithmic time.  The blocks of out-of-order data are
+ * kept aside, for the SACK option of the acknowledgments.
  */
 class TcpRxBuffer : public Object
 {
@@ -125,7 +131,25 @@ public:
    */
   Ptr<Packet> Extract (uint32_t maxSize);
 
+  /**
+   * \brief Get the blocks of data received beyond the next Rx sequence
+   *
+   * The block holding the most recently received segment comes first,
+   * as \RFC{2018} requires, then the other blocks in ascending order.
+   *
+   * \returns the blocks of out-of-order data
+   */
+  TcpOptionSack::SackList GetSackList (void) const;
+
 private:
+  /**
+   * \brief Add received out-of-order data to the blocks
+   * \param head the sequence number of the first byte of the data
+   * \param tail the sequence number following the last byte of the data
+   */
+  void AddSackBlock (const SequenceNumber32& head, const SequenceNumber32& tail);
+
+
   /// container for data stored in the buffer
   typedef std::map<SequenceNumber32, Ptr<Packet> >::iterator BufIterator;
   TracedValue<SequenceNumber32> m_nextRxSeq; //!< Seqnum of the first missing byte in data (RCV.NXT)
@@ -135,6 +159,9 @@ private:
   uint32_t m_maxBuffer;                      //!< Upper bound of the number of data bytes in buffer (RCV.WND)
   uint32_t m_availBytes;                     //!< Number of bytes available to read, i.e. contiguous block at head
   std::map<SequenceNumber32, Ptr<Packet> > m_data; //!< Corresponding data (may be null)
+  /// Blocks of out-of-order data, from their left edge to their right edge
+  std::map<SequenceNumber32, SequenceNumber32> m_sackBlocks;
+  SequenceNumber32 m_lastSackSeq;            //!< Seqnum of the last out-of-order data received
 };
 
 } //namepsace ns3
@@ -20,7 +20,7 @@
  */
 
 #define NS_LOG_APPEND_CONTEXT \
-  if (m_node) { std::clog << " [node " << m_node->GetId () << "] "; }
+  if (m_node) { ns3::LogContextStream () << " [node " << m_node->GetId () << "] "; }
 
 #include "ns3/abort.h"
 #include "ns3/node.h"
@@ -49,6 +49,7 @@
 #include "tcp-header.h"
 #include "tcp-option-winscale.h"
 #include "tcp-option-ts.h"
+#include "tcp-option-sack.h"
 #include "rtt-estimator.h"
 #include "tcp-congestion-ops.h"
 
@@ -98,6 +99,10 @@ TcpSocketBase::GetTypeId (void)
                    BooleanValue (true),
                    MakeBooleanAccessor (&TcpSocketBase::m_timestampEnabled),
                    MakeBooleanChecker ())
+    .AddAttribute ("Sack", "Enable or disable the SACK option",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpSocketBase::m_sackEnabled),
+                   MakeBooleanChecker ())
     .AddAttribute ("MinRto",
                    "Minimum retransmit timeout value",
                    TimeValue (Seconds (1.0)), // RFC 6298 says min RTO=1 sec, but Linux uses 200ms.
@@ -311,12 +316,14 @@ TcpSocketBase::TcpSocketBase (void)
     m_sndWindShift (0),
     m_timestampEnabled (true),
     m_timestampToEcho (0),
+    m_sackEnabled (false),
     m_sendPendingDataEvent (),
     // Set m_recover to the initial sequence number
     m_recover (0),
     m_retxThresh (3),
     m_limitedTx (false),
     m_retransOut (0),
+    m_highRxt (0),
     m_congestionControl (0),
     m_isFirstPartialAck (true)
 {
@@ -389,10 +396,12 @@ TcpSocketBase::TcpSocketBase (const TcpSocketBase& sock)
     m_sndWindShift (sock.m_sndWindShift),
     m_timestampEnabled (sock.m_timestampEnabled),
     m_timestampToEcho (sock.m_timestampToEcho),
+    m_sackEnabled (sock.m_sackEnabled),
     m_recover (sock.m_recover),
     m_retxThresh (sock.m_retxThresh),
     m_limitedTx (sock.m_limitedTx),
     m_retransOut (sock.m_retransOut),
+    m_highRxt (sock.m_highRxt),
     m_isFirstPartialAck (sock.m_isFirstPartialAck),
     m_txTrace (sock.m_txTrace),
     m_rxTrace (sock.m_rxTrace)
@@ -1253,6 +1262,12 @@ TcpSocketBase::DoForwardUp (Ptr<Packet> packet, const Address &fromAddress,
           m_timestampEnabled = false;
         }
 
+      // SACK is used only if both ends permit it
+      if (!tcpHeader.HasOption (TcpOption::SACKPERMITTED))
+        {
+          m_sackEnabled = false;
+        }
+
       // Initialize cWnd and ssThresh
       m_tcb->m_cWnd = GetInitialCwnd () * GetSegSize ();
       m_tcb->m_ssThresh = GetInitialSSThresh ();
@@ -1505,11 +1520,20 @@ TcpSocketBase::DupAck ()
         }
     }
   else if (m_tcb->m_congState == TcpSocketState::CA_RECOVERY)
-    { // Increase cwnd for every additional dupack (RFC2582, sec.3 bullet #3)
-      m_tcb->m_cWnd += m_tcb->m_segmentSize;
-      NS_LOG_INFO (m_dupAckCount << " Dupack received in fast recovery mode."
-                   "Increase cwnd to " << m_tcb->m_cWnd);
-      SendPendingData (m_connected);
+    {
+      if (m_sackEnabled && RetransmitLost ())
+        { // The SACKed segment which left the network is replaced by
+          // the retransmission of a lost one (RFC 6675)
+          NS_LOG_INFO (m_dupAckCount << " Dupack received in fast recovery mode."
+                       " Retransmitted up to " << m_highRxt);
+        }
+      else
+        { // Increase cwnd for every additional dupack (RFC2582, sec.3 bullet #3)
+          m_tcb->m_cWnd += m_tcb->m_segmentSize;
+          NS_LOG_INFO (m_dupAckCount << " Dupack received in fast recovery mode."
+                       "Increase cwnd to " << m_tcb->m_cWnd);
+          SendPendingData (m_connected);
+        }
     }
 
   // Artificially call PktsAcked. After all, one segment has been ACKed.
@@ -1533,6 +1557,12 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
 
   m_tcb->m_lastAckedSeq = ackNumber;
 
+  if (m_sackEnabled && tcpHeader.HasOption (TcpOption::SACK))
+    {
+      Ptr<const TcpOptionSack> sack = DynamicCast<const TcpOptionSack> (tcpHeader.GetOption (TcpOption::SACK));
+      m_txBuffer->Update (sack->GetSackList ());
+    }
+
   if (ackNumber == m_txBuffer->HeadSequence ()
       && ackNumber < m_tcb->m_nextTxSequence
       && packet->GetSize () == 0)
@@ -1631,7 +1661,14 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
               m_retransOut  = SafeSubtraction (m_retransOut, 1);  // at least one retransmission
                                                                   // has reached the other side
               m_txBuffer->DiscardUpTo (ackNumber);  //Bug 1850:  retransmit before newack
-              DoRetransmit (); // Assume the next seq is lost. Retransmit lost packet
+              if (m_sackEnabled && m_highRxt > ackNumber)
+                { // The next seq is retransmitted already. Retransmit the next lost hole, if any
+                  RetransmitLost ();
+                }
+              else
+                {
+                  DoRetransmit (); // Assume the next seq is lost. Retransmit lost packet
+                }
 
               if (m_isFirstPartialAck)
                 {
@@ -1670,6 +1707,7 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
               newSegsAcked = (ackNumber - m_recover) / m_tcb->m_segmentSize;
               m_congestionControl->CongestionStateSet (m_tcb, TcpSocketState::CA_OPEN);
               m_tcb->m_congState = TcpSocketState::CA_OPEN;
+              m_highRxt = ackNumber;
 
               NS_LOG_INFO ("Received full ACK for seq " << ackNumber <<
                            ". Leaving fast recovery with cwnd set to " << m_tcb->m_cWnd);
@@ -1687,6 +1725,7 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
             {
               m_congestionControl->CongestionStateSet (m_tcb, TcpSocketState::CA_OPEN);
               m_tcb->m_congState = TcpSocketState::CA_OPEN;
+              m_highRxt = ackNumber;
               NS_LOG_DEBUG ("LOSS -> OPEN");
             }
         }
@@ -2250,6 +2289,11 @@ TcpSocketBase::SendEmptyPacket (uint8_t flags)
           AddOptionWScale (header);
         }
 
+      if (m_sackEnabled)
+        { // The SACK-permitted option is set only on SYN packets
+          header.AppendOption (CreateObject<TcpOptionSackPermitted> ());
+        }
+
       if (m_synCount == 0)
         { // No more connection retries, give up
           NS_LOG_LOGIC ("Connection failed.");
@@ -2667,11 +2711,22 @@ TcpSocketBase::SendPendingData (bool withAck)
                     " pd->Size " << m_txBuffer->Size () <<
                     " pd->SFS " << m_txBuffer->SizeFromSequence (m_tcb->m_nextTxSequence));
 
+      uint32_t s = std::min (w, m_tcb->m_segmentSize);  // Send no more than window
+      if (m_sackEnabled && m_tcb->m_congState == TcpSocketState::CA_LOSS)
+        { // After a timeout, do not send again the data the receiver holds
+          SequenceNumber32 next = m_txBuffer->NextUnsacked (m_tcb->m_nextTxSequence);
+          if (next != m_tcb->m_nextTxSequence)
+            {
+              m_tcb->m_nextTxSequence = next;
+              continue;
+            }
+          s = std::min (s, m_txBuffer->UnsackedSizeFromSequence (next));
+        }
+
       NS_LOG_DEBUG ("Window: " << w <<
                     " cWnd: " << m_tcb->m_cWnd <<
                     " unAck: " << UnAckDataCount ());
 
-      uint32_t s = std::min (w, m_tcb->m_segmentSize);  // Send no more than window
       uint32_t sz = SendDataPacket (m_tcb->m_nextTxSequence, s, withAck);
       nPacketsSent++;                             // Count sent this loop
       m_tcb->m_nextTxSequence += sz;                     // Advance next tx sequence
@@ -2738,6 +2793,10 @@ TcpSocketBase::AvailableWindow () const
   NS_LOG_FUNCTION_NOARGS ();
   uint32_t unack = UnAckDataCount (); // Number of outstanding bytes
   uint32_t win = Window ();           // Number of bytes allowed to be outstanding
+  if (m_sackEnabled && m_tcb->m_congState == TcpSocketState::CA_LOSS)
+    { // The SACKed data skipped after a timeout is not outstanding
+      unack -= m_txBuffer->GetSackedBytes (m_tcb->m_nextTxSequence);
+    }
 
   NS_LOG_DEBUG ("UnAckCount=" << unack << ", Win=" << win);
   return (win < unack) ? 0 : (win - unack);
@@ -2935,6 +2994,10 @@ TcpSocketBase::ReTxTimeout ()
     }
 
   m_recover = m_tcb->m_highTxMark;
+  // The receiver may have discarded the SACKed data (RFC 2018 sec. 8):
+  // the SACK information is collected again from the next ACKs.
+  m_txBuffer->ResetScoreboard ();
+  m_highRxt = m_txBuffer->HeadSequence ();
   Retransmit ();
 }
 
@@ -3109,6 +3172,7 @@ TcpSocketBase::DoRetransmit ()
   // Retransmit a data packet: Call SendDataPacket
   uint32_t sz = SendDataPacket (m_txBuffer->HeadSequence (), m_tcb->m_segmentSize, true);
   ++m_retransOut;
+  m_highRxt = m_txBuffer->HeadSequence () + sz;
 
   // In case of RTO, advance m_tcb->m_nextTxSequence
   m_tcb->m_nextTxSequence = std::max (m_tcb->m_nextTxSequence.Get (), m_txBuffer->HeadSequence () + sz);
@@ -3116,6 +3180,24 @@ TcpSocketBase::DoRetransmit ()
   NS_LOG_DEBUG ("retxing seq " << m_txBuffer->HeadSequence ());
 }
 
+bool
+TcpSocketBase::RetransmitLost ()
+{
+  NS_LOG_FUNCTION (this);
+  SequenceNumber32 seq;
+  uint32_t size;
+  if (!m_txBuffer->NextLost (m_highRxt, (m_retxThresh - 1) * m_tcb->m_segmentSize + 1, seq, size))
+    {
+      return false;
+    }
+  uint32_t sz = SendDataPacket (seq, std::min (size, m_tcb->m_segmentSize), true);
+  ++m_retransOut;
+  m_highRxt = seq + sz;
+
+  NS_LOG_DEBUG ("retxing lost seq " << seq);
+  return true;
+}
+
 void
 TcpSocketBase::CancelAllTimers ()
 {
@@ -3307,6 +3389,13 @@ TcpSocketBase::AddOptions (TcpHeader& header)
     {
       AddOptionTimestamp (header);
     }
+
+  // The SACK option is set on the acknowledgments only
+  if (m_sackEnabled && (header.GetFlags () & TcpHeader::ACK)
+      && !(header.GetFlags () & TcpHeader::SYN))
+    {
+      AddOptionSack (header);
+    }
 }
 
 void
@@ -3406,6 +3495,30 @@ TcpSocketBase::AddOptionTimestamp (TcpHeader& header)
                option->GetTimestamp () << " echo=" << m_timestampToEcho);
 }
 
+void
+TcpSocketBase::AddOptionSack (TcpHeader& header)
+{
+  NS_LOG_FUNCTION (this << header);
+
+  TcpOptionSack::SackList list = m_rxBuffer->GetSackList ();
+  int maxBlocks = (header.GetMaxOptionLength () - header.GetOptionLength () - 2) / 8;
+  if (list.empty () || maxBlocks <= 0)
+    {
+      return;
+    }
+
+  Ptr<TcpOptionSack> option = CreateObject<TcpOptionSack> ();
+  for (TcpOptionSack::SackList::const_iterator it = list.begin ();
+       it != list.end () && option->GetNumSackBlocks () < static_cast<uint32_t> (maxBlocks); ++it)
+    {
+      option->AddSackBlock (*it);
+    }
+
+  header.AppendOption (option);
+  NS_LOG_INFO (m_node->GetId () << " Add option SACK with " <<
+               option->GetNumSackBlocks () << " blocks");
+}
+
 void TcpSocketBase::UpdateWindowSize (const TcpHeader &header)
 {
   NS_LOG_FUNCTION (this << header);
@@ -904,6 +904,17 @@ protected:
    */
   virtual void DoRetransmit (void);
 
+  /**
+   * \brief Retransmit the next lost hole of the SACK scoreboard
+   *
+   * The hole is the first one beyond the data already retransmitted in
+   * this recovery which has at least DupThresh segments SACKed beyond
+   * it (\RFC{6675}).
+   *
+   * \returns true if a hole was retransmitted
+   */
+  bool RetransmitLost (void);
+
   /** \brief Add options to TcpHeader
    *
    * Test each option, and if it is enabled on our side, add it
@@ -963,6 +974,16 @@ protected:
    */
   void AddOptionTimestamp (TcpHeader& header);
 
+  /**
+   * \brief Add the SACK option to the header
+   *
+   * Report the blocks of out-of-order data of the Rx buffer, as many
+   * as fit in the option space left by the other options.
+   *
+   * \param header TcpHeader to which add the option to
+   */
+  void AddOptionSack (TcpHeader& header);
+
   /**
    * \brief Performs a safe subtraction between a and b (a-b)
    *
@@ -1039,6 +1060,8 @@ protected:
   bool     m_timestampEnabled;    //!< Timestamp option enabled
   uint32_t m_timestampToEcho;     //!< Timestamp to echo
 
+  bool     m_sackEnabled;         //!< SACK option enabled (RFC 2018)
+
   EventId m_sendPendingDataEvent; //!< micro-delay event to send pending data
 
   // Fast Retransmit and Recovery
@@ -1046,6 +1069,7 @@ protected:
   uint32_t               m_retxThresh;   //!< Fast Retransmit threshold
   bool                   m_limitedTx;    //!< perform limited transmit
   uint32_t               m_retransOut;   //!< Number of retransmission in this window
+  SequenceNumber32       m_highRxt;      //!< Seqnum following the data retransmitted last (RFC 6675 HighRxt)
 
   // Transmission Control Block
   Ptr<TcpSocketState>    m_tcb;               //!< Congestion control informations
@@ -57,7 +57,7 @@ TcpTxBuffer::GetTypeId (void)
  * initialized below is insignificant.
  */
 TcpTxBuffer::TcpTxBuffer (uint32_t n)
-  : m_firstByteSeq (n), m_size (0), m_maxBuffer (32768), m_data (0)
+  : m_firstByteSeq (n), m_size (0), m_maxBuffer (32768), m_sackedBytes (0)
 {
 }
 
@@ -111,7 +111,7 @@ TcpTxBuffer::Add (Ptr<Packet> p)
     {
       if (p->GetSize () > 0)
         {
-          m_data.push_back (p);
+          m_data.insert (m_data.end (), std::make_pair (TailSequence (), p));
           m_size += p->GetSize ();
           NS_LOG_LOGIC ("Updated size=" << m_size << ", lastSeq=" << m_firstByteSeq + SequenceNumber32 (m_size));
         }
@@ -147,65 +147,67 @@ TcpTxBuffer::CopyFromSequence (uint32_t numBytes, const SequenceNumber32& seq)
       return Create<Packet> (s);
     }
 
-  // Extract data from the buffer and return
-  uint32_t offset = seq - m_firstByteSeq.Get ();
-  uint32_t count = 0;      // Offset of the first byte of a packet in the buffer
-  uint32_t pktSize = 0;
-  bool beginFound = false;
-  int pktCount = 0;
-  Ptr<Packet> outPacket;
-  NS_LOG_LOGIC ("There are " << m_data.size () << " number of packets in buffer");
-  for (BufIterator i = m_data.begin (); i != m_data.end (); ++i)
+  // Make the range [seq, seq+s) a single packet of the buffer, and copy it
+  BufIterator first = SplitAt (seq);
+  BufIterator last = SplitAt (seq + SequenceNumber32 (s));
+  NS_ASSERT (first != m_data.end () && first->first == seq);
+  BufIterator next = first;
+  if (++next != last)
     {
-      pktCount++;
-      pktSize = (*i)->GetSize ();
-      if (!beginFound)
-        { // Look for first fragment
-          if (count + pktSize > offset)
-            {
-              NS_LOG_LOGIC ("First byte found in packet #" << pktCount << " at buffer offset " << count
-                                                           << ", packet len=" << pktSize);
-              beginFound = true;
-              uint32_t packetOffset = offset - count;
-              uint32_t fragmentLength = count + pktSize - offset;
-              if (fragmentLength >= s)
-                { // Data to be copied falls entirely in this packet
-                  return (*i)->CreateFragment (packetOffset, s);
-                }
-              else
-                { // This packet only fulfills part of the request
-                  outPacket = (*i)->CreateFragment (packetOffset, fragmentLength);
-                }
-              NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
-            }
-        }
-      else if (count + pktSize >= offset + s)
-        { // Last packet fragment found
-          NS_LOG_LOGIC ("Last byte found in packet #" << pktCount << " at buffer offset " << count
-                                                      << ", packet len=" << pktSize);
-          uint32_t fragmentLength = offset + s - count;
-          Ptr<Packet> endFragment = (*i)->CreateFragment (0, fragmentLength);
-          outPacket->AddAtEnd (endFragment);
-          NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
-          break;
-        }
-      else
+      NS_LOG_LOGIC ("Merging the packets from " << seq << " to " << seq + SequenceNumber32 (s));
+      Ptr<Packet> outPacket = first->second->Copy ();
+      for (BufIterator i = next; i != last; ++i)
         {
-          NS_LOG_LOGIC ("Appending to output the packet #" << pktCount << " of offset " << count << " len=" << pktSize);
-          outPacket->AddAtEnd (*i);
-          NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
+          outPacket->AddAtEnd (i->second);
         }
-      count += pktSize;
+      m_data.erase (next, last);
+      first->second = outPacket;
     }
-  NS_ASSERT (outPacket->GetSize () == s);
-  return outPacket;
+  NS_ASSERT (first->second->GetSize () == s);
+  return first->second->Copy ();
+}
+
+TcpTxBuffer::BufIterator
+TcpTxBuffer::SplitAt (const SequenceNumber32& seq)
+{
+  NS_LOG_FUNCTION (this << seq);
+  NS_ASSERT (seq >= m_firstByteSeq && seq <= TailSequence ());
+  BufIterator i = m_data.upper_bound (seq);
+  if (i == m_data.begin ())
+    {
+      return i;
+    }
+  --i;
+  if (i->first == seq)
+    {
+      return i;
+    }
+  uint32_t offset = seq - i->first;
+  uint32_t pktSize = i->second->GetSize ();
+  if (offset == pktSize)
+    { // seq is the tail of the buffer
+      return ++i;
+    }
+  NS_LOG_LOGIC ("Splitting the packet of seqno=" << i->first << " len=" << pktSize << " at " << seq);
+  Ptr<Packet> tail = i->second->CreateFragment (offset, pktSize - offset);
+  i->second = i->second->CreateFragment (0, offset);
+  return m_data.insert (++i, std::make_pair (seq, tail));
 }
 
 void
 TcpTxBuffer::SetHeadSequence (const SequenceNumber32& seq)
 {
   NS_LOG_FUNCTION (this << seq);
+  // Data written before the connection is set up is moved along
+  std::map<SequenceNumber32, Ptr<Packet> > data;
+  for (BufIterator i = m_data.begin (); i != m_data.end (); ++i)
+    {
+      data.insert (data.end (), std::make_pair (seq + SequenceNumber32 (i->first - m_firstByteSeq.Get ()), i->second));
+    }
+  m_data.swap (data);
   m_firstByteSeq = seq;
+  m_sacked.clear ();
+  m_sackedBytes = 0;
 }
 
 void
@@ -217,40 +219,145 @@ TcpTxBuffer::DiscardUpTo (const SequenceNumber32& seq)
   // Cases do not need to scan the buffer
   if (m_firstByteSeq >= seq) return;
 
-  // Scan the buffer and discard packets
-  uint32_t offset = seq - m_firstByteSeq.Get ();  // Number of bytes to remove
-  uint32_t pktSize;
-  NS_LOG_LOGIC ("Offset=" << offset);
-  BufIterator i = m_data.begin ();
-  while (i != m_data.end ())
+  // Discard the packets behind the seqnum, and fragment the one holding it
+  SequenceNumber32 tailSeq = TailSequence ();
+  BufIterator i = m_data.upper_bound (seq);
+  if (i != m_data.begin ())
     {
-      if (offset > (*i)->GetSize ())
-        { // This packet is behind the seqnum. Remove this packet from the buffer
-          pktSize = (*i)->GetSize ();
-          m_size -= pktSize;
-          offset -= pktSize;
-          m_firstByteSeq += pktSize;
-          i = m_data.erase (i);
-          NS_LOG_LOGIC ("Removed one packet of size " << pktSize << ", offset=" << offset);
-        }
-      else if (offset > 0)
+      BufIterator last = i;
+      --last;
+      uint32_t offset = seq - last->first;
+      uint32_t pktSize = last->second->GetSize ();
+      if (offset < pktSize)
         { // Part of the packet is behind the seqnum. Fragment
-          pktSize = (*i)->GetSize () - offset;
-          *i = (*i)->CreateFragment (offset, pktSize);
-          m_size -= offset;
-          m_firstByteSeq += offset;
-          NS_LOG_LOGIC ("Fragmented one packet by size " << offset << ", new size=" << pktSize);
-          break;
+          i = m_data.insert (i, std::make_pair (seq, last->second->CreateFragment (offset, pktSize - offset)));
+          NS_LOG_LOGIC ("Fragmented one packet by size " << offset << ", new size=" << pktSize - offset);
         }
+      m_data.erase (m_data.begin (), i);
     }
   // Catching the case of ACKing a FIN
-  if (m_size == 0)
+  m_size = seq < tailSeq ? tailSeq - seq : 0;
+  m_firstByteSeq = seq;
+  // Forget the SACKed blocks behind the seqnum
+  while (!m_sacked.empty () && m_sacked.begin ()->first < seq)
     {
-      m_firstByteSeq = seq;
+      std::map<SequenceNumber32, SequenceNumber32>::iterator first = m_sacked.begin ();
+      SequenceNumber32 right = first->second;
+      m_sackedBytes -= right - first->first;
+      m_sacked.erase (first);
+      if (right > seq)
+        {
+          m_sacked[seq] = right;
+          m_sackedBytes += right - seq;
+        }
     }
   NS_LOG_LOGIC ("size=" << m_size << " headSeq=" << m_firstByteSeq << " maxBuffer=" << m_maxBuffer
                         <<" numPkts="<< m_data.size ());
   NS_ASSERT (m_firstByteSeq == seq);
 }
 
+bool
+TcpTxBuffer::Update (const TcpOptionSack::SackList& list)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t sackedBytes = m_sackedBytes;
+  SequenceNumber32 tailSeq = TailSequence ();
+  for (TcpOptionSack::SackList::const_iterator it = list.begin (); it != list.end (); ++it)
+    {
+      SequenceNumber32 left = std::max (it->first, m_firstByteSeq.Get ());
+      SequenceNumber32 right = std::min (it->second, tailSeq);
+      if (left >= right)
+        {
+          NS_LOG_LOGIC ("Ignoring block [" << it->first << ";" << it->second << "]");
+          continue;
+        }
+      // Merge the blocks which overlap or touch this one
+      std::map<SequenceNumber32, SequenceNumber32>::iterator i = m_sacked.upper_bound (left);
+      if (i != m_sacked.begin ())
+        {
+          --i;
+          if (i->second < left)
+            {
+              ++i;
+            }
+        }
+      while (i != m_sacked.end () && i->first <= right)
+        {
+          left = std::min (left, i->first);
+          right = std::max (right, i->second);
+          m_sackedBytes -= i->second - i->first;
+          m_sacked.erase (i++);
+        }
+      m_sacked[left] = right;
+      m_sackedBytes += right - left;
+    }
+  NS_LOG_LOGIC ("sacked=" << m_sackedBytes << " in " << m_sacked.size () << " blocks");
+  return m_sackedBytes > sackedBytes;
+}
+
+void
+TcpTxBuffer::ResetScoreboard (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_sacked.clear ();
+  m_sackedBytes = 0;
+}
+
+uint32_t
+TcpTxBuffer::GetSackedBytes (const SequenceNumber32& seq) const
+{
+  uint32_t sackedBytes = 0;
+  for (std::map<SequenceNumber32, SequenceNumber32>::const_iterator i = m_sacked.begin ();
+       i != m_sacked.end () && i->first < seq; ++i)
+    {
+      sackedBytes += std::min (i->second, seq) - i->first;
+    }
+  return sackedBytes;
+}
+
+SequenceNumber32
+TcpTxBuffer::NextUnsacked (const SequenceNumber32& seq) const
+{
+  std::map<SequenceNumber32, SequenceNumber32>::const_iterator i = m_sacked.upper_bound (seq);
+  if (i != m_sacked.begin ())
+    {
+      --i;
+      if (i->second > seq)
+        {
+          return i->second;
+        }
+    }
+  return seq;
+}
+
+uint32_t
+TcpTxBuffer::UnsackedSizeFromSequence (const SequenceNumber32& seq) const
+{
+  std::map<SequenceNumber32, SequenceNumber32>::const_iterator i = m_sacked.upper_bound (seq);
+  if (i == m_sacked.end ())
+    {
+      return SizeFromSequence (seq);
+    }
+  return i->first - seq;
+}
+
+bool
+TcpTxBuffer::NextLost (const SequenceNumber32& seq, uint32_t lostThreshold,
+                       SequenceNumber32& lost, uint32_t& size) const
+{
+  NS_LOG_FUNCTION (this << seq << lostThreshold);
+  // The holes further on have fewer SACKed bytes beyond them: only the
+  // first one may be lost
+  SequenceNumber32 hole = NextUnsacked (std::max (seq, m_firstByteSeq.Get ()));
+  std::map<SequenceNumber32, SequenceNumber32>::const_iterator next = m_sacked.upper_bound (hole);
+  if (next == m_sacked.end () || m_sackedBytes - GetSackedBytes (hole) < lostThreshold)
+    {
+      return false;
+    }
+  lost = hole;
+  size = next->first - hole;
+  NS_LOG_LOGIC ("Lost hole at " << lost << " size=" << size);
+  return true;
+}
+
 } // namepsace ns3
@@ -21,12 +21,13 @@
 #ifndef TCP_TX_BUFFER_H
 #define TCP_TX_BUFFER_H
 
-#include <list>
+#include <map>
 #include "ns3/traced-value.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/object.h"
 #include "ns3/sequence-number.h"
 #include "ns3/ptr.h"
+#include "ns3/tcp-option-sack.h"
 
 namespace ns3 {
 class Packet;
@@ -36,6 +37,16 @@ class Packet;
  *
  * \brief class for keeping the data sent by the application to the TCP socket, i.e.
  *        the sending buffer.
+ *
+ * The data is kept as packets indexed by the sequence number of their first
+ * byte.  The packets are split and merged along the boundaries of the
+ * segments copied out of the buffer, so that a segment is found in
+ * logarithmic time and, once transmitted, is held by a single packet: its
+ * retransmissions are copies of that packet, which share its data.
+ *
+ * The buffer also keeps the scoreboard of the data the receiver reported
+ * in SACK options (\RFC{2018}), as merged blocks, so that the socket finds
+ * the data to retransmit without walking the segments in flight.
  */
 class TcpTxBuffer : public Object
 {
@@ -107,6 +118,9 @@ public:
 
   /**
    * Copy data of size numBytes into a packet, data from the range [seq, seq+numBytes)
+   *
+   * The data of the range is then held by a single packet of the buffer.
+   *
    * \param numBytes number of bytes to copy
    * \param seq start sequence number to extract
    * \returns a packet
@@ -127,14 +141,76 @@ public:
    */
   void DiscardUpTo (const SequenceNumber32& seq);
 
+  /**
+   * Add the blocks of a SACK option to the scoreboard.
+   *
+   * The parts of the blocks outside [HeadSequence, TailSequence) are
+   * ignored.
+   *
+   * \param list the blocks of the option
+   * \returns true if data not SACKed before is SACKed
+   */
+  bool Update (const TcpOptionSack::SackList& list);
+
+  /**
+   * Forget all the SACKed blocks, e.g. after a retransmission timeout.
+   */
+  void ResetScoreboard (void);
+
+  /**
+   * Returns the number of SACKed bytes in the range [HeadSequence, seq)
+   * \param seq the sequence number
+   * \returns the number of SACKed bytes before seq
+   */
+  uint32_t GetSackedBytes (const SequenceNumber32& seq) const;
+
+  /**
+   * Returns the first sequence number at or after seq which is not SACKed
+   * \param seq the sequence number
+   * \returns seq, or the right edge of the SACKed block holding it
+   */
+  SequenceNumber32 NextUnsacked (const SequenceNumber32& seq) const;
+
+  /**
+   * Returns the number of bytes from seq, which is not SACKed, up to the
+   * next SACKed block or to the tail of the buffer
+   * \param seq the sequence number
+   * \returns the number of bytes not SACKed from seq
+   */
+  uint32_t UnsackedSizeFromSequence (const SequenceNumber32& seq) const;
+
+  /**
+   * Find the first hole at or after seq deemed lost, i.e. with at least
+   * lostThreshold SACKed bytes beyond it (\RFC{6675} IsLost).
+   *
+   * \param seq the sequence number to search from
+   * \param lostThreshold the number of SACKed bytes beyond a lost hole
+   * \param lost the sequence number of the first byte of the hole
+   * \param size the size of the hole
+   * \returns true if a lost hole is found
+   */
+  bool NextLost (const SequenceNumber32& seq, uint32_t lostThreshold,
+                 SequenceNumber32& lost, uint32_t& size) const;
+
 private:
   /// container for data stored in the buffer
-  typedef std::list<Ptr<Packet> >::iterator BufIterator;
+  typedef std::map<SequenceNumber32, Ptr<Packet> >::iterator BufIterator;
+
+  /**
+   * Get the packet starting at a sequence number, splitting the packet
+   * which holds it if needed.
+   * \param seq the sequence number, in [HeadSequence, TailSequence]
+   * \returns the packet starting at seq, or the end of the buffer
+   */
+  BufIterator SplitAt (const SequenceNumber32& seq);
 
   TracedValue<SequenceNumber32> m_firstByteSeq; //!< Sequence number of the first byte in data (SND.UNA)
   uint32_t m_size;                              //!< Number of data bytes
   uint32_t m_maxBuffer;                         //!< Max number of data bytes in buffer (SND.WND)
-  std::list<Ptr<Packet> > m_data;               //!< Corresponding data (may be null)
+  std::map<SequenceNumber32, Ptr<Packet> > m_data; //!< Corresponding data, by sequence number of their first byte
+  /// SACKed blocks, from their left edge to their right edge
+  std::map<SequenceNumber32, SequenceNumber32> m_sacked;
+  uint32_t m_sackedBytes;                       //!< Number of SACKed bytes
 };
 
 } // namepsace ns3
@@ -0,0 +1,224 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <vector>
+
+#include "ns3/test.h"
+#include "../model/ipv4-end-point-demux.h"
+#include "../model/ipv4-end-point.h"
+#include "../model/ipv6-end-point-demux.h"
+#include "../model/ipv6-end-point.h"
+
+using namespace ns3;
+
+// ===========================================================================
+// Test case checking the lookups of the IPv4 demux with a listening end
+// point and many connected ones, while the end points are connected and
+// deallocated.
+// ===========================================================================
+class Ipv4EndPointDemuxTestCase : public TestCase
+{
+public:
+  Ipv4EndPointDemuxTestCase ();
+  virtual ~Ipv4EndPointDemuxTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+Ipv4EndPointDemuxTestCase::Ipv4EndPointDemuxTestCase ()
+  : TestCase ("Check the lookups of the IPv4 end point demux")
+{
+}
+
+Ipv4EndPointDemuxTestCase::~Ipv4EndPointDemuxTestCase ()
+{
+}
+
+void
+Ipv4EndPointDemuxTestCase::DoRun (void)
+{
+  Ipv4EndPointDemux demux;
+  Ipv4Address local ("10.0.0.1");
+  Ipv4EndPoint *listener = demux.Allocate (80);
+  NS_TEST_ASSERT_MSG_NE (listener, 0, "Listener not allocated");
+  NS_TEST_EXPECT_MSG_EQ (demux.Allocate (80), 0, "Duplicate listener allocated");
+
+  const uint32_t n = 500;
+  std::vector<Ipv4EndPoint *> connected;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ipv4Address peer (0x0a010000 + i);
+      Ipv4EndPoint *endPoint = demux.Allocate (local, 80, peer, 1000 + i % 7);
+      NS_TEST_ASSERT_MSG_NE (endPoint, 0, "Connection " << i << " not allocated");
+      connected.push_back (endPoint);
+    }
+  NS_TEST_EXPECT_MSG_EQ (demux.Allocate (local, 80, Ipv4Address (0x0a010000), 1000), 0,
+                         "Duplicate connection allocated");
+
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ipv4Address peer (0x0a010000 + i);
+      Ipv4EndPointDemux::EndPoints endPoints = demux.Lookup (local, 80, peer, 1000 + i % 7, 0);
+      NS_TEST_ASSERT_MSG_EQ (endPoints.size (), 1, "Wrong number of matches");
+      NS_TEST_EXPECT_MSG_EQ (endPoints.front (), connected[i], "Wrong connection matched");
+      NS_TEST_EXPECT_MSG_EQ (demux.SimpleLookup (local, 80, peer, 1000 + i % 7), connected[i],
+                             "Wrong connection matched");
+      // Another peer port reaches the listener.
+      endPoints = demux.Lookup (local, 80, peer, 999, 0);
+      NS_TEST_ASSERT_MSG_EQ (endPoints.size (), 1, "Wrong number of matches");
+      NS_TEST_EXPECT_MSG_EQ (endPoints.front (), listener, "Listener not matched");
+    }
+  NS_TEST_EXPECT_MSG_EQ (demux.Lookup (local, 81, Ipv4Address (0x0a010000), 1000, 0).size (), 0,
+                         "Unused port matched");
+
+  // An end point bound to an address, then connected.
+  Ipv4EndPoint *bound = demux.Allocate (local, 5000);
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupLocal (local, 5000), true, "Bound end point not found");
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupLocal (Ipv4Address ("10.0.0.2"), 5000), false,
+                         "Bound end point found on another address");
+  Ipv4EndPointDemux::EndPoints endPoints = demux.Lookup (local, 5000, Ipv4Address ("10.2.0.1"), 7, 0);
+  NS_TEST_EXPECT_MSG_EQ (endPoints.size (), 1, "Bound end point not matched");
+  bound->SetPeer (Ipv4Address ("10.2.0.1"), 7);
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupPortLocal (5000), true, "Connected port not found");
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupLocal (local, 5000), true, "Connected end point not found");
+  endPoints = demux.Lookup (local, 5000, Ipv4Address ("10.2.0.1"), 7, 0);
+  NS_TEST_ASSERT_MSG_EQ (endPoints.size (), 1, "Connected end point not matched");
+  NS_TEST_EXPECT_MSG_EQ (endPoints.front (), bound, "Wrong end point matched");
+  endPoints = demux.Lookup (local, 5000, Ipv4Address ("10.2.0.2"), 7, 0);
+  NS_TEST_EXPECT_MSG_EQ (endPoints.size (), 0, "Connected end point matched another peer");
+  NS_TEST_EXPECT_MSG_EQ (demux.Allocate (local, 5000, Ipv4Address ("10.2.0.1"), 7), 0,
+                         "Duplicate of a connected end point allocated");
+
+  // An ephemeral port is never one in use.
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      Ipv4EndPoint *endPoint = demux.Allocate ();
+      NS_TEST_ASSERT_MSG_NE (endPoint, 0, "Ephemeral port not allocated");
+      endPoint->SetLocalAddress (local);
+      endPoint->SetPeer (Ipv4Address ("10.3.0.1"), 80);
+      NS_TEST_EXPECT_MSG_EQ (demux.Lookup (local, endPoint->GetLocalPort (), Ipv4Address ("10.3.0.1"), 80, 0).size (),
+                             1, "Ephemeral port used twice");
+    }
+
+  // Deallocated connections fall back to the listener.
+  for (uint32_t i = 0; i < n; i += 2)
+    {
+      demux.DeAllocate (connected[i]);
+    }
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ipv4Address peer (0x0a010000 + i);
+      endPoints = demux.Lookup (local, 80, peer, 1000 + i % 7, 0);
+      NS_TEST_ASSERT_MSG_EQ (endPoints.size (), 1, "Wrong number of matches");
+      NS_TEST_EXPECT_MSG_EQ (endPoints.front (), i % 2 ? connected[i] : listener, "Wrong end point matched");
+    }
+  endPoints = demux.GetAllEndPoints ();
+  NS_TEST_EXPECT_MSG_EQ (endPoints.size (), 1 + n / 2 + 1 + 100, "Wrong number of end points");
+  NS_TEST_EXPECT_MSG_EQ (endPoints.front (), listener, "End points not in allocation order");
+  demux.DeAllocate (listener);
+  NS_TEST_EXPECT_MSG_EQ (demux.Lookup (local, 80, Ipv4Address ("10.9.0.1"), 1, 0).size (), 0,
+                         "Deallocated listener matched");
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupPortLocal (80), true, "Connections of the port not found");
+}
+
+// ===========================================================================
+// Test case checking the lookups of the IPv6 demux.
+// ===========================================================================
+class Ipv6EndPointDemuxTestCase : public TestCase
+{
+public:
+  Ipv6EndPointDemuxTestCase ();
+  virtual ~Ipv6EndPointDemuxTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+Ipv6EndPointDemuxTestCase::Ipv6EndPointDemuxTestCase ()
+  : TestCase ("Check the lookups of the IPv6 end point demux")
+{
+}
+
+Ipv6EndPointDemuxTestCase::~Ipv6EndPointDemuxTestCase ()
+{
+}
+
+void
+Ipv6EndPointDemuxTestCase::DoRun (void)
+{
+  Ipv6EndPointDemux demux;
+  Ipv6Address local ("2001:1::1");
+  Ipv6EndPoint *listener = demux.Allocate (80);
+  NS_TEST_ASSERT_MSG_NE (listener, 0, "Listener not allocated");
+
+  const uint32_t n = 200;
+  std::vector<Ipv6EndPoint *> connected;
+  std::vector<Ipv6Address> peers;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      uint8_t address[16] = { 0x20, 0x01, 0, 0x02 };
+      address[14] = i / 256;
+      address[15] = i % 256;
+      peers.push_back (Ipv6Address (address));
+      Ipv6EndPoint *endPoint = demux.Allocate (local, 80, peers[i], 1000);
+      NS_TEST_ASSERT_MSG_NE (endPoint, 0, "Connection " << i << " not allocated");
+      connected.push_back (endPoint);
+    }
+  NS_TEST_EXPECT_MSG_EQ (demux.Allocate (local, 80, peers[0], 1000), 0,
+                         "Duplicate connection allocated");
+
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ipv6EndPointDemux::EndPoints endPoints = demux.Lookup (local, 80, peers[i], 1000, 0);
+      NS_TEST_ASSERT_MSG_EQ (endPoints.size (), 1, "Wrong number of matches");
+      NS_TEST_EXPECT_MSG_EQ (endPoints.front (), connected[i], "Wrong connection matched");
+      NS_TEST_EXPECT_MSG_EQ (demux.SimpleLookup (local, 80, peers[i], 1000), connected[i],
+                             "Wrong connection matched");
+    }
+
+  // A connection whose peer changes is found by its new peer only.
+  connected[0]->SetPeer (Ipv6Address ("2001:3::1"), 1000);
+  Ipv6EndPointDemux::EndPoints endPoints = demux.Lookup (local, 80, Ipv6Address ("2001:3::1"), 1000, 0);
+  NS_TEST_ASSERT_MSG_EQ (endPoints.size (), 1, "Wrong number of matches");
+  NS_TEST_EXPECT_MSG_EQ (endPoints.front (), connected[0], "Moved connection not matched");
+  endPoints = demux.Lookup (local, 80, peers[0], 1000, 0);
+  NS_TEST_ASSERT_MSG_EQ (endPoints.size (), 1, "Wrong number of matches");
+  NS_TEST_EXPECT_MSG_EQ (endPoints.front (), listener, "Listener not matched");
+
+  for (uint32_t i = 0; i < n; i++)
+    {
+      demux.DeAllocate (connected[i]);
+    }
+  NS_TEST_EXPECT_MSG_EQ (demux.GetEndPoints ().size (), 1, "Wrong number of end points");
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupLocal (Ipv6Address::GetAny (), 80), true, "Listener not found");
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupLocal (local, 80), false, "Deallocated connection found");
+}
+
+class EndPointDemuxTestSuite : public TestSuite
+{
+public:
+  EndPointDemuxTestSuite ();
+};
+
+EndPointDemuxTestSuite::EndPointDemuxTestSuite ()
+  : TestSuite ("end-point-demux", UNIT)
+{
+  AddTestCase (new Ipv4EndPointDemuxTestCase, TestCase::QUICK);
+  AddTestCase (new Ipv6EndPointDemuxTestCase, TestCase::QUICK);
+}
+
+static EndPointDemuxTestSuite g_endPointDemuxTestSuite;
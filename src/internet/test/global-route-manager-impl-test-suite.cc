@@ -26,7 +26,10 @@
 #include "ns3/global-route-manager-impl.h"
 #include "ns3/candidate-queue.h"
 #include "ns3/simulator.h"
+#include <algorithm>
 #include <cstdlib> // for rand()
+#include <list>
+#include <vector>
 
 using namespace ns3;
 
@@ -214,6 +217,174 @@ GlobalRouteManagerImplTestCase::DoRun (void)
 }
 
 
+// Check the order of the vertices popped from the CandidateQueue, and the
+// decrease of their distances.
+class CandidateQueueTestCase : public TestCase
+{
+public:
+  CandidateQueueTestCase();
+  virtual void DoRun (void);
+};
+
+CandidateQueueTestCase::CandidateQueueTestCase()
+  : TestCase ("CandidateQueueTestCase")
+{
+}
+
+void
+CandidateQueueTestCase::DoRun (void)
+{
+  CandidateQueue candidate;
+  std::vector<SPFVertex *> vertices;
+  for (uint32_t i = 0; i < 200; ++i)
+    {
+      SPFVertex *v = new SPFVertex;
+      v->SetVertexId (Ipv4Address (0x0a000001 + i));
+      v->SetVertexType (i % 3 ? SPFVertex::VertexRouter : SPFVertex::VertexNetwork);
+      v->SetDistanceFromRoot (10 + std::rand () % 20);
+      candidate.Push (v);
+      vertices.push_back (v);
+    }
+  NS_TEST_ASSERT_MSG_EQ (candidate.Size (), 200, "Wrong size");
+  NS_TEST_ASSERT_MSG_EQ (candidate.Find (Ipv4Address ("10.0.0.10")), vertices[9], "Vertex not found");
+  NS_TEST_ASSERT_MSG_EQ (candidate.Find (Ipv4Address ("10.1.0.1")), 0, "Unknown vertex found");
+
+  // Decrease the distance of some vertices, some below all the others.
+  for (uint32_t i = 0; i < 200; i += 7)
+    {
+      SPFVertex *v = candidate.Find (vertices[i]->GetVertexId ());
+      v->SetDistanceFromRoot (v->GetDistanceFromRoot () - (i % 2 ? 10 : 5));
+      candidate.DecreaseKey (v);
+    }
+
+  SPFVertex *previous = 0;
+  std::vector<uint32_t> order;
+  for (uint32_t i = 0; i < 200; ++i)
+    {
+      SPFVertex *v = candidate.Pop ();
+      NS_TEST_ASSERT_MSG_NE (v, 0, "Missing vertex");
+      uint32_t index = v->GetVertexId ().Get () - 0x0a000001;
+      if (previous)
+        {
+          NS_TEST_ASSERT_MSG_GT_OR_EQ (v->GetDistanceFromRoot (), previous->GetDistanceFromRoot (),
+                                       "Vertices not popped by increasing distance");
+          if (v->GetDistanceFromRoot () == previous->GetDistanceFromRoot ())
+            {
+              NS_TEST_ASSERT_MSG_EQ ((previous->GetVertexType () == SPFVertex::VertexRouter
+                                      && v->GetVertexType () == SPFVertex::VertexNetwork), false,
+                                     "Router popped before network at the same distance");
+              // Same distance and type: decreased vertices come last, the
+              // others in the order they were pushed.
+              if (v->GetVertexType () == previous->GetVertexType ())
+                {
+                  uint32_t previousIndex = order.back ();
+                  bool decreased = (index % 7 == 0);
+                  bool previousDecreased = (previousIndex % 7 == 0);
+                  NS_TEST_ASSERT_MSG_EQ ((previousDecreased && !decreased), false,
+                                         "Decreased vertex popped before a pushed one");
+                  NS_TEST_ASSERT_MSG_EQ ((decreased == previousDecreased && index < previousIndex), false,
+                                         "Vertices of equal priority not popped in order");
+                }
+            }
+        }
+      order.push_back (index);
+      if (previous)
+        {
+          delete previous;
+        }
+      previous = v;
+    }
+  delete previous;
+  NS_TEST_ASSERT_MSG_EQ (candidate.Empty (), true, "Queue not empty");
+  NS_TEST_ASSERT_MSG_EQ (candidate.Pop (), 0, "Vertex popped from an empty queue");
+}
+
+// Check that the CandidateQueue pops the vertices of equal cost in the
+// order of the sorted list it replaced: a vertex pushed after those of
+// the same distance and type, and a stable sort of the list after a
+// decrease of the distance of a vertex.
+class CandidateQueueTieTestCase : public TestCase
+{
+public:
+  CandidateQueueTieTestCase();
+  virtual void DoRun (void);
+
+  /**
+   * \brief The order of the vertices in the former list.
+   * \param v1 first vertex
+   * \param v2 second vertex
+   * \return true if v1 comes before v2
+   */
+  static bool ListLess (const SPFVertex *v1, const SPFVertex *v2);
+};
+
+CandidateQueueTieTestCase::CandidateQueueTieTestCase()
+  : TestCase ("CandidateQueueTieTestCase")
+{
+}
+
+bool
+CandidateQueueTieTestCase::ListLess (const SPFVertex *v1, const SPFVertex *v2)
+{
+  if (v1->GetDistanceFromRoot () != v2->GetDistanceFromRoot ())
+    {
+      return v1->GetDistanceFromRoot () < v2->GetDistanceFromRoot ();
+    }
+  return v1->GetVertexType () == SPFVertex::VertexNetwork
+         && v2->GetVertexType () == SPFVertex::VertexRouter;
+}
+
+void
+CandidateQueueTieTestCase::DoRun (void)
+{
+  CandidateQueue candidate;
+  std::list<SPFVertex *> expected;
+  std::vector<SPFVertex *> queued;
+  uint32_t pushed = 0;
+  // Few distinct distances, so that most vertices are equal-cost ties.
+  for (uint32_t step = 0; step < 600; ++step)
+    {
+      uint32_t action = std::rand () % 4;
+      if (action < 2 || queued.empty ())
+        {
+          SPFVertex *v = new SPFVertex;
+          v->SetVertexId (Ipv4Address (0x0a000001 + pushed++));
+          v->SetVertexType (std::rand () % 3 ? SPFVertex::VertexRouter : SPFVertex::VertexNetwork);
+          v->SetDistanceFromRoot (10 + std::rand () % 4);
+          candidate.Push (v);
+          expected.insert (std::upper_bound (expected.begin (), expected.end (), v,
+                                             &CandidateQueueTieTestCase::ListLess), v);
+          queued.push_back (v);
+        }
+      else if (action == 2)
+        {
+          SPFVertex *v = queued[std::rand () % queued.size ()];
+          if (v->GetDistanceFromRoot () > 8)
+            {
+              v->SetDistanceFromRoot (v->GetDistanceFromRoot () - 1 - std::rand () % 2);
+              candidate.DecreaseKey (v);
+              expected.sort (&CandidateQueueTieTestCase::ListLess);
+            }
+        }
+      else
+        {
+          SPFVertex *v = candidate.Pop ();
+          NS_TEST_ASSERT_MSG_EQ (v, expected.front (), "Equal-cost vertices not popped in list order");
+          expected.pop_front ();
+          queued.erase (std::find (queued.begin (), queued.end (), v));
+          delete v;
+        }
+    }
+  while (!expected.empty ())
+    {
+      SPFVertex *v = candidate.Pop ();
+      NS_TEST_ASSERT_MSG_EQ (v, expected.front (), "Equal-cost vertices not popped in list order");
+      expected.pop_front ();
+      delete v;
+    }
+  NS_TEST_ASSERT_MSG_EQ (candidate.Empty (), true, "Queue not empty");
+}
+
 static class GlobalRouteManagerImplTestSuite : public TestSuite
 {
 public:
@@ -221,5 +392,7 @@ public:
     : TestSuite ("global-route-manager-impl", UNIT)
   {
     AddTestCase (new GlobalRouteManagerImplTestCase (), TestCase::QUICK);
+    AddTestCase (new CandidateQueueTestCase (), TestCase::QUICK);
+    AddTestCase (new CandidateQueueTieTestCase (), TestCase::QUICK);
   }
 } g_globalRoutingManagerImplTestSuite;
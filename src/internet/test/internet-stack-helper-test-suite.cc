@@ -0,0 +1,153 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <limits>
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/node-container.h"
+#include "ns3/packet.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-static-routing-helper.h"
+#include "ns3/ipv4-static-routing.h"
+#include "ns3/ipv6.h"
+#include "ns3/global-router-interface.h"
+#include "ns3/packet-socket-factory.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/socket-factory.h"
+#include "ns3/udp-socket-factory.h"
+
+using namespace ns3;
+
+// ===========================================================================
+// Test case checking the objects of the lightweight endpoint stack, and
+// that two endpoints communicate through a router with full stack.
+//
+//   A(endpoint)<--10.1.1.0/24-->B(router)<--10.1.2.0/24-->C(endpoint)
+// ===========================================================================
+class InternetStackHelperEndpointTestCase : public TestCase
+{
+public:
+  InternetStackHelperEndpointTestCase ();
+  virtual ~InternetStackHelperEndpointTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Receive a packet.
+   * \param socket The receiving socket.
+   */
+  void ReceivePkt (Ptr<Socket> socket);
+  /**
+   * Send a packet.
+   * \param socket The sending socket.
+   * \param to The destination address.
+   */
+  void DoSendData (Ptr<Socket> socket, Ipv4Address to);
+
+  uint32_t m_receivedSize; //!< The size of the packet received.
+};
+
+InternetStackHelperEndpointTestCase::InternetStackHelperEndpointTestCase ()
+  : TestCase ("Check the lightweight endpoint stack"),
+    m_receivedSize (0)
+{
+}
+
+InternetStackHelperEndpointTestCase::~InternetStackHelperEndpointTestCase ()
+{
+}
+
+void
+InternetStackHelperEndpointTestCase::ReceivePkt (Ptr<Socket> socket)
+{
+  Ptr<Packet> packet = socket->Recv (std::numeric_limits<uint32_t>::max (), 0);
+  m_receivedSize = packet->GetSize ();
+}
+
+void
+InternetStackHelperEndpointTestCase::DoSendData (Ptr<Socket> socket, Ipv4Address to)
+{
+  NS_TEST_EXPECT_MSG_EQ (socket->SendTo (Create<Packet> (123), 0, InetSocketAddress (to, 1234)),
+                         123, "Packet not sent");
+}
+
+void
+InternetStackHelperEndpointTestCase::DoRun (void)
+{
+  Ptr<Node> nA = CreateObject<Node> ();
+  Ptr<Node> nB = CreateObject<Node> ();
+  Ptr<Node> nC = CreateObject<Node> ();
+
+  InternetStackHelper router;
+  router.Install (nB);
+  InternetStackHelper endpoint;
+  endpoint.SetLightweightEndpoint (true);
+  endpoint.Install (NodeContainer (nA, nC));
+
+  NS_TEST_EXPECT_MSG_EQ ((nA->GetObject<Ipv4> () != 0), true, "No IPv4 on the endpoint");
+  NS_TEST_EXPECT_MSG_EQ ((nA->GetObject<UdpSocketFactory> () != 0), true, "No UDP on the endpoint");
+  NS_TEST_EXPECT_MSG_EQ ((nA->GetObject<Ipv6> () == 0), true, "IPv6 on the endpoint");
+  NS_TEST_EXPECT_MSG_EQ ((nA->GetObject<PacketSocketFactory> () == 0), true, "Packet sockets on the endpoint");
+  NS_TEST_EXPECT_MSG_EQ ((nA->GetObject<GlobalRouter> () == 0), true, "Global routing on the endpoint");
+  Ptr<Ipv4RoutingProtocol> routing = nA->GetObject<Ipv4> ()->GetRoutingProtocol ();
+  NS_TEST_EXPECT_MSG_EQ ((DynamicCast<Ipv4StaticRouting> (routing) != 0), true, "No static routing on the endpoint");
+
+  SimpleNetDeviceHelper devHelper;
+  NetDeviceContainer dAdB = devHelper.Install (NodeContainer (nA, nB));
+  NetDeviceContainer dBdC = devHelper.Install (NodeContainer (nB, nC));
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.1.0", "255.255.255.0");
+  ipv4.Assign (dAdB);
+  ipv4.SetBase ("10.1.2.0", "255.255.255.0");
+  ipv4.Assign (dBdC);
+
+  Ipv4StaticRoutingHelper routingHelper;
+  routingHelper.GetStaticRouting (nA->GetObject<Ipv4> ())->SetDefaultRoute (Ipv4Address ("10.1.1.2"), 1);
+  routingHelper.GetStaticRouting (nC->GetObject<Ipv4> ())->SetDefaultRoute (Ipv4Address ("10.1.2.1"), 1);
+
+  Ptr<Socket> rxSocket = nC->GetObject<UdpSocketFactory> ()->CreateSocket ();
+  NS_TEST_EXPECT_MSG_EQ (rxSocket->Bind (InetSocketAddress (Ipv4Address::GetAny (), 1234)), 0, "trivial");
+  rxSocket->SetRecvCallback (MakeCallback (&InternetStackHelperEndpointTestCase::ReceivePkt, this));
+  Ptr<Socket> txSocket = nA->GetObject<UdpSocketFactory> ()->CreateSocket ();
+
+  Simulator::ScheduleWithContext (nA->GetId (), Seconds (1),
+                                  &InternetStackHelperEndpointTestCase::DoSendData, this, txSocket,
+                                  Ipv4Address ("10.1.2.2"));
+  Simulator::Stop (Seconds (5));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_receivedSize, 123, "Packet not delivered between the endpoints");
+
+  Simulator::Destroy ();
+}
+
+class InternetStackHelperTestSuite : public TestSuite
+{
+public:
+  InternetStackHelperTestSuite ();
+};
+
+InternetStackHelperTestSuite::InternetStackHelperTestSuite ()
+  : TestSuite ("internet-stack-helper", UNIT)
+{
+  AddTestCase (new InternetStackHelperEndpointTestCase, TestCase::QUICK);
+}
+
+static InternetStackHelperTestSuite g_internetStackHelperTestSuite;
@@ -0,0 +1,158 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Checkpoint and restore of a static-routing topology
+
+#include <sstream>
+#include "ns3/inet-socket-address.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-static-routing-helper.h"
+#include "ns3/ipv4-checkpoint-helper.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/ipv4-interface.h"
+#include "ns3/arp-cache.h"
+#include "ns3/node.h"
+#include "ns3/node-container.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include "ns3/test.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simple-channel.h"
+#include "ns3/socket-factory.h"
+#include "ns3/udp-socket-factory.h"
+
+using namespace ns3;
+
+class Ipv4CheckpointTestCase : public TestCase
+{
+public:
+  Ipv4CheckpointTestCase ();
+  virtual ~Ipv4CheckpointTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Build the A<-->B topology, with a static route on A.
+   * \returns The nodes.
+   */
+  NodeContainer Build (void);
+  /**
+   * Send a packet from A to B.
+   * \param socket The socket of A.
+   */
+  void SendData (Ptr<Socket> socket);
+};
+
+Ipv4CheckpointTestCase::Ipv4CheckpointTestCase ()
+  : TestCase ("Save and restore the IPv4 state of a static-routing topology")
+{
+}
+
+Ipv4CheckpointTestCase::~Ipv4CheckpointTestCase ()
+{
+}
+
+NodeContainer
+Ipv4CheckpointTestCase::Build (void)
+{
+  NodeContainer c;
+  c.Create (2);
+
+  InternetStackHelper internet;
+  internet.Install (c);
+
+  // The MAC addresses are set explicitly, since they must be the same
+  // in the two topologies built by this process.
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  NetDeviceContainer devices;
+  for (uint32_t i = 0; i < c.GetN (); i++)
+    {
+      Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+      device->SetAddress (Mac48Address (i == 0 ? "00:00:00:00:0c:01" : "00:00:00:00:0c:02"));
+      device->SetChannel (channel);
+      c.Get (i)->AddDevice (device);
+      devices.Add (device);
+    }
+
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.1.0", "255.255.255.0");
+  ipv4.Assign (devices);
+
+  Ipv4StaticRoutingHelper ipv4RoutingHelper;
+  Ptr<Ipv4StaticRouting> staticRoutingA = ipv4RoutingHelper.GetStaticRouting (c.Get (0)->GetObject<Ipv4> ());
+  staticRoutingA->AddNetworkRouteTo (Ipv4Address ("10.2.0.0"), Ipv4Mask ("/16"), Ipv4Address ("10.1.1.2"), 1, 3);
+  return c;
+}
+
+void
+Ipv4CheckpointTestCase::SendData (Ptr<Socket> socket)
+{
+  Address realTo = InetSocketAddress (Ipv4Address ("10.1.1.2"), 1234);
+  NS_TEST_EXPECT_MSG_EQ (socket->SendTo (Create<Packet> (123), 0, realTo), 123, "Send failed");
+}
+
+void
+Ipv4CheckpointTestCase::DoRun (void)
+{
+  // Warm-up run: resolve B with ARP and save the state at 10s.
+  NodeContainer c = Build ();
+  Ptr<Socket> txSocket = c.Get (0)->GetObject<UdpSocketFactory> ()->CreateSocket ();
+  Simulator::ScheduleWithContext (0, Seconds (5), &Ipv4CheckpointTestCase::SendData, this, txSocket);
+  std::ostringstream saved;
+  Ipv4CheckpointHelper::SaveAllAt (Seconds (10), Create<OutputStreamWrapper> (&saved));
+  Simulator::Stop (Seconds (10));
+  Simulator::Run ();
+  txSocket = 0;
+  c = NodeContainer ();
+  Simulator::Destroy ();
+
+  // Restored run.
+  c = Build ();
+  std::istringstream is (saved.str ());
+  Ipv4CheckpointHelper::RestoreAll (is);
+  NS_TEST_EXPECT_MSG_EQ (Simulator::Now (), Seconds (10), "Simulation time not restored");
+
+  Ptr<ArpCache> cache = c.Get (0)->GetObject<Ipv4L3Protocol> ()->GetInterface (1)->GetArpCache ();
+  ArpCache::Entry *entry = cache->Lookup (Ipv4Address ("10.1.1.2"));
+  NS_TEST_ASSERT_MSG_NE (entry, 0, "ARP entry not restored");
+  NS_TEST_EXPECT_MSG_EQ (entry->IsAlive (), true, "ARP entry not alive");
+  NS_TEST_EXPECT_MSG_EQ (entry->GetMacAddress (), Address (Mac48Address ("00:00:00:00:0c:02")),
+                         "Wrong restored MAC address");
+
+  std::ostringstream resaved;
+  Ipv4CheckpointHelper::SaveAll (Create<OutputStreamWrapper> (&resaved));
+  NS_TEST_EXPECT_MSG_EQ (resaved.str (), saved.str (), "Restored state differs");
+  NS_TEST_EXPECT_MSG_NE (saved.str ().find ("route 10.2.0.0 255.255.0.0 10.1.1.2 1 3"), std::string::npos,
+                         "Static route not saved");
+
+  c = NodeContainer ();
+  Simulator::Destroy ();
+}
+
+class Ipv4CheckpointTestSuite : public TestSuite
+{
+public:
+  Ipv4CheckpointTestSuite ();
+};
+
+Ipv4CheckpointTestSuite::Ipv4CheckpointTestSuite ()
+  : TestSuite ("ipv4-checkpoint", UNIT)
+{
+  AddTestCase (new Ipv4CheckpointTestCase, TestCase::QUICK);
+}
+
+static Ipv4CheckpointTestSuite ipv4CheckpointTestSuite;
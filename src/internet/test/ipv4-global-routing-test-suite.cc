@@ -14,6 +14,7 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <sstream>
 #include <vector>
 #include "ns3/boolean.h"
 #include "ns3/config.h"
@@ -40,7 +41,9 @@
 #include "ns3/ipv4-l3-protocol.h"
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/ipv4-routing-table-entry.h"
+#include "ns3/ipv4-route.h"
 #include "ns3/ipv4-global-routing.h"
+#include "ns3/global-route-manager.h"
 #include "ns3/bridge-helper.h"
 
 using namespace ns3;
@@ -1167,6 +1170,486 @@ Ipv4GlobalRoutingSlash32TestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \ingroup internet
+ * \ingroup tests
+ *
+ * \brief Check that the routes computed by several threads are those
+ * computed by a single thread, in the same order.
+ *
+ * The routers form a grid of point-to-point links, and the routers of the
+ * first row also share a LAN.
+ */
+class Ipv4GlobalRoutingParallelTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingParallelTestCase ();
+  virtual ~Ipv4GlobalRoutingParallelTestCase ();
+
+  /**
+   * \brief Install the internet stack on a grid of routers and connect
+   * them.
+   * \param nodes the routers, side * side of them
+   * \param side the number of routers of a row
+   */
+  static void BuildGrid (NodeContainer nodes, uint32_t side);
+
+  /**
+   * \brief Print the global routes of the nodes, in the order of their
+   * routing tables.
+   * \param nodes the nodes
+   * \returns the routes
+   */
+  static std::string GetRoutes (NodeContainer nodes);
+
+private:
+  virtual void DoRun (void);
+};
+
+Ipv4GlobalRoutingParallelTestCase::Ipv4GlobalRoutingParallelTestCase ()
+  : TestCase ("Global routing computed by several threads")
+{
+}
+
+Ipv4GlobalRoutingParallelTestCase::~Ipv4GlobalRoutingParallelTestCase ()
+{
+}
+
+std::string
+Ipv4GlobalRoutingParallelTestCase::GetRoutes (NodeContainer nodes)
+{
+  std::ostringstream os;
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      Ptr<Ipv4GlobalRouting> routing = nodes.Get (i)->GetObject<Ipv4L3Protocol> ()
+        ->GetRoutingProtocol ()->GetObject<Ipv4GlobalRouting> ();
+      os << "node " << i << std::endl;
+      for (uint32_t j = 0; j < routing->GetNRoutes (); j++)
+        {
+          os << *routing->GetRoute (j) << std::endl;
+        }
+    }
+  return os.str ();
+}
+
+void
+Ipv4GlobalRoutingParallelTestCase::BuildGrid (NodeContainer nodes, uint32_t side)
+{
+  InternetStackHelper internet;
+  Ipv4GlobalRoutingHelper ipv4RoutingHelper;
+  internet.SetRoutingHelper (ipv4RoutingHelper);
+  internet.Install (nodes);
+
+  SimpleNetDeviceHelper p2pHelper;
+  p2pHelper.SetNetDevicePointToPointMode (true);
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.2.0.0", "255.255.255.252");
+  for (uint32_t row = 0; row < side; row++)
+    {
+      for (uint32_t column = 0; column < side; column++)
+        {
+          Ptr<Node> node = nodes.Get (row * side + column);
+          if (column + 1 < side)
+            {
+              ipv4.Assign (p2pHelper.Install (NodeContainer (node, nodes.Get (row * side + column + 1))));
+              ipv4.NewNetwork ();
+            }
+          if (row + 1 < side)
+            {
+              ipv4.Assign (p2pHelper.Install (NodeContainer (node, nodes.Get ((row + 1) * side + column))));
+              ipv4.NewNetwork ();
+            }
+        }
+    }
+  NodeContainer lan;
+  for (uint32_t column = 0; column < side; column++)
+    {
+      lan.Add (nodes.Get (column));
+    }
+  SimpleNetDeviceHelper lanHelper;
+  ipv4.SetBase ("10.3.0.0", "255.255.255.0");
+  ipv4.Assign (lanHelper.Install (lan));
+}
+
+void
+Ipv4GlobalRoutingParallelTestCase::DoRun (void)
+{
+  const uint32_t side = 6;
+  NodeContainer nodes;
+  nodes.Create (side * side);
+  BuildGrid (nodes, side);
+
+  // Without a change of the topology, an incremental update would keep
+  // the routes computed by the single thread.
+  Config::SetGlobal ("GlobalRoutingIncremental", BooleanValue (false));
+  Config::SetGlobal ("GlobalRoutingThreads", UintegerValue (1));
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+  std::string sequential = GetRoutes (nodes);
+  NS_TEST_ASSERT_MSG_NE (sequential.size (), 0, "No routes");
+
+  Config::SetGlobal ("GlobalRoutingThreads", UintegerValue (4));
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  std::string parallel = GetRoutes (nodes);
+  Config::SetGlobal ("GlobalRoutingThreads", UintegerValue (1));
+  Config::SetGlobal ("GlobalRoutingIncremental", BooleanValue (true));
+
+  NS_TEST_EXPECT_MSG_EQ (parallel, sequential, "The routes depend on the number of threads");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet
+ * \ingroup tests
+ *
+ * \brief Check that the incremental update of the routes after a change
+ * of the topology gives the routing tables of a full calculation, in the
+ * same order, without calculating the trees of all the routers.
+ */
+class Ipv4GlobalRoutingIncrementalTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingIncrementalTestCase ();
+  virtual ~Ipv4GlobalRoutingIncrementalTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Update the routes incrementally, and check them against a full
+   * calculation.
+   * \param nodes the nodes
+   * \param event the name of the change of the topology
+   * \returns the number of routers whose tree was calculated
+   */
+  uint32_t CheckUpdate (NodeContainer nodes, std::string event);
+};
+
+Ipv4GlobalRoutingIncrementalTestCase::Ipv4GlobalRoutingIncrementalTestCase ()
+  : TestCase ("Global routing updated incrementally")
+{
+}
+
+Ipv4GlobalRoutingIncrementalTestCase::~Ipv4GlobalRoutingIncrementalTestCase ()
+{
+}
+
+uint32_t
+Ipv4GlobalRoutingIncrementalTestCase::CheckUpdate (NodeContainer nodes, std::string event)
+{
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  uint32_t nRecomputed = GlobalRouteManager::GetNRecomputedRoots ();
+  std::string incremental = Ipv4GlobalRoutingParallelTestCase::GetRoutes (nodes);
+
+  GlobalRouteManager::DeleteGlobalRoutes ();
+  GlobalRouteManager::BuildGlobalRoutingDatabase ();
+  GlobalRouteManager::InitializeRoutes ();
+  std::string full = Ipv4GlobalRoutingParallelTestCase::GetRoutes (nodes);
+
+  NS_TEST_EXPECT_MSG_EQ (incremental, full, "Wrong routes after " << event);
+  return nRecomputed;
+}
+
+void
+Ipv4GlobalRoutingIncrementalTestCase::DoRun (void)
+{
+  const uint32_t side = 6;
+  NodeContainer nodes;
+  nodes.Create (side * side);
+  Ipv4GlobalRoutingParallelTestCase::BuildGrid (nodes, side);
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+  NS_TEST_ASSERT_MSG_EQ (GlobalRouteManager::GetNRecomputedRoots (), nodes.GetN (), "Not all the trees calculated");
+
+  // A link in the middle of the grid.
+  Ptr<Ipv4> ipv4 = nodes.Get (2 * side + 2)->GetObject<Ipv4> ();
+  ipv4->SetDown (2);
+  uint32_t nRecomputed = CheckUpdate (nodes, "a link down");
+  NS_TEST_EXPECT_MSG_GT (nRecomputed, 0, "No tree calculated after a link down");
+  NS_TEST_EXPECT_MSG_LT (nRecomputed, nodes.GetN (), "All the trees calculated after a link down");
+
+  ipv4->SetUp (2);
+  nRecomputed = CheckUpdate (nodes, "a link up");
+  NS_TEST_EXPECT_MSG_GT (nRecomputed, 0, "No tree calculated after a link up");
+  NS_TEST_EXPECT_MSG_LT (nRecomputed, nodes.GetN (), "All the trees calculated after a link up");
+
+  // A router leaving the LAN of the first row.
+  ipv4 = nodes.Get (2)->GetObject<Ipv4> ();
+  ipv4->SetDown (ipv4->GetNInterfaces () - 1);
+  CheckUpdate (nodes, "a LAN interface down");
+  ipv4->SetUp (ipv4->GetNInterfaces () - 1);
+  CheckUpdate (nodes, "a LAN interface up");
+
+  // A longer path, then the shortest one again.
+  ipv4 = nodes.Get (side + 3)->GetObject<Ipv4> ();
+  ipv4->SetMetric (1, 3);
+  CheckUpdate (nodes, "a metric increase");
+  ipv4->SetMetric (1, 1);
+  CheckUpdate (nodes, "a metric decrease");
+
+  nRecomputed = CheckUpdate (nodes, "no change");
+  NS_TEST_EXPECT_MSG_EQ (nRecomputed, 0, "Trees calculated without a change");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet
+ * \ingroup tests
+ *
+ * \brief Check that the aggregated compact routes forward the packets as
+ * the routes they replace, with fewer entries, also after an incremental
+ * update.
+ */
+class Ipv4GlobalRoutingAggregateTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingAggregateTestCase ();
+  virtual ~Ipv4GlobalRoutingAggregateTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Print the route each node selects to the addresses of the
+   * interfaces, to the next addresses and to an unknown address.
+   * \param nodes the nodes
+   * \returns the next hops and output interfaces
+   */
+  std::string GetForwarding (NodeContainer nodes);
+
+  /**
+   * \brief Count the global routes of the nodes.
+   * \param nodes the nodes
+   * \returns the number of routes
+   */
+  uint32_t GetNRoutes (NodeContainer nodes);
+
+  /**
+   * \brief Update the aggregated routes incrementally, and check their
+   * forwarding against a full calculation without aggregation.
+   * \param nodes the nodes
+   * \param event the name of the change of the topology
+   */
+  void CheckUpdate (NodeContainer nodes, std::string event);
+};
+
+Ipv4GlobalRoutingAggregateTestCase::Ipv4GlobalRoutingAggregateTestCase ()
+  : TestCase ("Global routing aggregated into compact routes")
+{
+}
+
+Ipv4GlobalRoutingAggregateTestCase::~Ipv4GlobalRoutingAggregateTestCase ()
+{
+}
+
+std::string
+Ipv4GlobalRoutingAggregateTestCase::GetForwarding (NodeContainer nodes)
+{
+  std::vector<Ipv4Address> destinations;
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      Ptr<Ipv4> ipv4 = nodes.Get (i)->GetObject<Ipv4> ();
+      for (uint32_t j = 1; j < ipv4->GetNInterfaces (); j++)
+        {
+          Ipv4Address address = ipv4->GetAddress (j, 0).GetLocal ();
+          destinations.push_back (address);
+          destinations.push_back (Ipv4Address (address.Get () + 1));
+        }
+    }
+  destinations.push_back (Ipv4Address ("192.168.1.1"));
+
+  std::ostringstream os;
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      Ptr<Ipv4GlobalRouting> routing = nodes.Get (i)->GetObject<Ipv4L3Protocol> ()
+        ->GetRoutingProtocol ()->GetObject<Ipv4GlobalRouting> ();
+      os << "node " << i << std::endl;
+      for (uint32_t j = 0; j < destinations.size (); j++)
+        {
+          Ipv4Header header;
+          header.SetDestination (destinations[j]);
+          Socket::SocketErrno error;
+          Ptr<Ipv4Route> route = routing->RouteOutput (Create<Packet> (), header, 0, error);
+          os << destinations[j] << " ";
+          if (route)
+            {
+              os << route->GetGateway () << " " << route->GetOutputDevice ()->GetIfIndex () << std::endl;
+            }
+          else
+            {
+              os << "none" << std::endl;
+            }
+        }
+    }
+  return os.str ();
+}
+
+uint32_t
+Ipv4GlobalRoutingAggregateTestCase::GetNRoutes (NodeContainer nodes)
+{
+  uint32_t n = 0;
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      n += nodes.Get (i)->GetObject<Ipv4L3Protocol> ()->GetRoutingProtocol ()
+        ->GetObject<Ipv4GlobalRouting> ()->GetNRoutes ();
+    }
+  return n;
+}
+
+void
+Ipv4GlobalRoutingAggregateTestCase::CheckUpdate (NodeContainer nodes, std::string event)
+{
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  std::string aggregated = GetForwarding (nodes);
+
+  Config::SetGlobal ("GlobalRoutingAggregateRoutes", BooleanValue (false));
+  GlobalRouteManager::DeleteGlobalRoutes ();
+  GlobalRouteManager::BuildGlobalRoutingDatabase ();
+  GlobalRouteManager::InitializeRoutes ();
+  std::string full = GetForwarding (nodes);
+  Config::SetGlobal ("GlobalRoutingAggregateRoutes", BooleanValue (true));
+  // The next update calculates the aggregated routes of all the trees again.
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+
+  NS_TEST_EXPECT_MSG_EQ (aggregated, full, "Wrong forwarding after " << event);
+}
+
+void
+Ipv4GlobalRoutingAggregateTestCase::DoRun (void)
+{
+  const uint32_t side = 6;
+  NodeContainer nodes;
+  nodes.Create (side * side);
+  Ipv4GlobalRoutingParallelTestCase::BuildGrid (nodes, side);
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+  std::string full = GetForwarding (nodes);
+  uint32_t nFull = GetNRoutes (nodes);
+
+  Config::SetGlobal ("GlobalRoutingAggregateRoutes", BooleanValue (true));
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  NS_TEST_EXPECT_MSG_EQ (GlobalRouteManager::GetNRecomputedRoots (), nodes.GetN (), "Not all the trees aggregated");
+  NS_TEST_EXPECT_MSG_EQ (GetForwarding (nodes), full, "The aggregated routes forward differently");
+  NS_TEST_EXPECT_MSG_LT (GetNRoutes (nodes), nFull / 2, "The routes are not aggregated");
+
+  Ptr<Ipv4> ipv4 = nodes.Get (2 * side + 2)->GetObject<Ipv4> ();
+  ipv4->SetDown (2);
+  CheckUpdate (nodes, "a link down");
+  ipv4->SetUp (2);
+  CheckUpdate (nodes, "a link up");
+  Config::SetGlobal ("GlobalRoutingAggregateRoutes", BooleanValue (false));
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet
+ * \ingroup tests
+ *
+ * \brief Check that Ipv4GlobalRouting::SetRoutes gives the table of the
+ * new routes added in order, keeping the routes already in place.
+ */
+class Ipv4GlobalRoutingSetRoutesTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingSetRoutesTestCase ();
+  virtual ~Ipv4GlobalRoutingSetRoutesTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Find the output interface of a node to a destination.
+   * \param node the node
+   * \param destination the destination
+   * \returns the interface, or -1 without route
+   */
+  int32_t GetInterface (Ptr<Node> node, Ipv4Address destination);
+};
+
+Ipv4GlobalRoutingSetRoutesTestCase::Ipv4GlobalRoutingSetRoutesTestCase ()
+  : TestCase ("Global routing table replaced in place")
+{
+}
+
+Ipv4GlobalRoutingSetRoutesTestCase::~Ipv4GlobalRoutingSetRoutesTestCase ()
+{
+}
+
+int32_t
+Ipv4GlobalRoutingSetRoutesTestCase::GetInterface (Ptr<Node> node, Ipv4Address destination)
+{
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  Ipv4Header header;
+  header.SetDestination (destination);
+  Socket::SocketErrno error;
+  Ptr<Ipv4Route> route = ipv4->GetRoutingProtocol ()->RouteOutput (Create<Packet> (), header, 0, error);
+  if (route == 0)
+    {
+      return -1;
+    }
+  return ipv4->GetInterfaceForDevice (route->GetOutputDevice ());
+}
+
+void
+Ipv4GlobalRoutingSetRoutesTestCase::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (2);
+  InternetStackHelper internet;
+  Ipv4GlobalRoutingHelper ipv4RoutingHelper;
+  internet.SetRoutingHelper (ipv4RoutingHelper);
+  internet.Install (nodes);
+  SimpleNetDeviceHelper devHelper;
+  Ipv4AddressHelper address ("10.0.1.0", "255.255.255.0");
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      address.Assign (devHelper.Install (nodes));
+      address.NewNetwork ();
+    }
+  Ptr<Ipv4GlobalRouting> routing = nodes.Get (0)->GetObject<Ipv4L3Protocol> ()
+    ->GetRoutingProtocol ()->GetObject<Ipv4GlobalRouting> ();
+
+  Ipv4Mask mask16 ("255.255.0.0");
+  Ipv4Mask mask24 ("255.255.255.0");
+  Ipv4RoutingTableEntry a = Ipv4RoutingTableEntry::CreateNetworkRouteTo ("10.3.0.0", mask16, "10.0.1.2", 1);
+  Ipv4RoutingTableEntry b = Ipv4RoutingTableEntry::CreateNetworkRouteTo ("10.2.0.0", mask16, "10.0.2.2", 2);
+  Ipv4RoutingTableEntry c = Ipv4RoutingTableEntry::CreateNetworkRouteTo ("10.1.1.0", mask24, "10.0.2.2", 2);
+  Ipv4RoutingTableEntry d = Ipv4RoutingTableEntry::CreateNetworkRouteTo ("10.1.0.0", mask16, "10.0.3.2", 3);
+  std::vector<Ipv4RoutingTableEntry> hostRoutes;
+  hostRoutes.push_back (Ipv4RoutingTableEntry::CreateHostRouteTo ("10.4.0.1", "10.0.1.2", 1));
+  std::vector<Ipv4RoutingTableEntry> networkRoutes;
+  networkRoutes.push_back (a);
+  networkRoutes.push_back (b);
+  networkRoutes.push_back (c);
+  routing->SetRoutes (hostRoutes, networkRoutes, std::vector<Ipv4RoutingTableEntry> ());
+  NS_TEST_ASSERT_MSG_EQ (routing->GetNRoutes (), 4, "Wrong number of routes");
+  Ipv4RoutingTableEntry *keptA = routing->GetRoute (1);
+  Ipv4RoutingTableEntry *keptC = routing->GetRoute (3);
+  NS_TEST_EXPECT_MSG_EQ (GetInterface (nodes.Get (0), "10.1.1.1"), 2, "Wrong route before the replacement");
+
+  // d, inserted before c, matches the destinations of c and is looked up
+  // first; b is removed.
+  networkRoutes.clear ();
+  networkRoutes.push_back (a);
+  networkRoutes.push_back (d);
+  networkRoutes.push_back (c);
+  routing->SetRoutes (hostRoutes, networkRoutes, std::vector<Ipv4RoutingTableEntry> ());
+  NS_TEST_ASSERT_MSG_EQ (routing->GetNRoutes (), 4, "Wrong number of routes");
+  NS_TEST_EXPECT_MSG_EQ (routing->GetRoute (1), keptA, "Route in place at the start not kept");
+  NS_TEST_EXPECT_MSG_EQ (routing->GetRoute (3), keptC, "Route in place at the end not kept");
+  NS_TEST_EXPECT_MSG_EQ (routing->GetRoute (2)->GetDestNetwork (), d.GetDestNetwork (), "Wrong route added");
+  NS_TEST_EXPECT_MSG_EQ (GetInterface (nodes.Get (0), "10.1.1.1"), 3, "Routes not looked up in the order of the table");
+  NS_TEST_EXPECT_MSG_EQ (GetInterface (nodes.Get (0), "10.2.0.1"), -1, "Route not removed");
+  NS_TEST_EXPECT_MSG_EQ (GetInterface (nodes.Get (0), "10.4.0.1"), 1, "Wrong host route");
+
+  routing->SetRoutes (std::vector<Ipv4RoutingTableEntry> (), std::vector<Ipv4RoutingTableEntry> (),
+                      std::vector<Ipv4RoutingTableEntry> ());
+  NS_TEST_EXPECT_MSG_EQ (routing->GetNRoutes (), 0, "Routes not removed");
+  NS_TEST_EXPECT_MSG_EQ (GetInterface (nodes.Get (0), "10.1.1.1"), -1, "Route still looked up");
+
+  Simulator::Destroy ();
+}
+
 class Ipv4GlobalRoutingTestSuite : public TestSuite
 {
 public:
@@ -1184,6 +1667,10 @@ Ipv4GlobalRoutingTestSuite::Ipv4GlobalRoutingTestSuite ()
     AddTestCase (new TwoBridgeTest, TestCase::QUICK);
     AddTestCase (new Ipv4DynamicGlobalRoutingTestCase, TestCase::QUICK);
     AddTestCase (new Ipv4GlobalRoutingSlash32TestCase, TestCase::QUICK);
+    AddTestCase (new Ipv4GlobalRoutingParallelTestCase, TestCase::QUICK);
+    AddTestCase (new Ipv4GlobalRoutingIncrementalTestCase, TestCase::QUICK);
+    AddTestCase (new Ipv4GlobalRoutingAggregateTestCase, TestCase::QUICK);
+    AddTestCase (new Ipv4GlobalRoutingSetRoutesTestCase, TestCase::QUICK);
   }
 
 // Do not forget to allocate an instance of this TestSuite
@@ -43,6 +43,7 @@
 #include <string>
 #include <sstream>
 #include <limits>
+#include <cstring>
 #include <netinet/in.h>
 #include <sys/socket.h>
 #include <sys/types.h>
@@ -259,6 +260,66 @@ Ipv4HeaderTest::DoRun (void)
 
   Simulator::Destroy ();
 }
+//-----------------------------------------------------------------------------
+// Check that the checksum of a received header, updated as its TTL is
+// decremented hop after hop, is the checksum computed from scratch.
+class Ipv4HeaderTtlChecksumTest : public TestCase
+{
+public:
+  virtual void DoRun (void);
+  Ipv4HeaderTtlChecksumTest ();
+};
+
+Ipv4HeaderTtlChecksumTest::Ipv4HeaderTtlChecksumTest ()
+  : TestCase ("IPv4 Header TTL Checksum Test")
+{
+}
+
+void
+Ipv4HeaderTtlChecksumTest::DoRun (void)
+{
+  Ipv4Header header;
+  header.EnableChecksum ();
+  header.SetSource (Ipv4Address ("10.1.2.3"));
+  header.SetDestination (Ipv4Address ("192.168.200.1"));
+  header.SetProtocol (17);
+  header.SetPayloadSize (1234);
+  header.SetIdentification (0xbeef);
+  header.SetTtl (255);
+
+  Ptr<Packet> packet = Create<Packet> (1234);
+  packet->AddHeader (header);
+  for (uint32_t ttl = 254; ttl > 0; ttl--)
+    {
+      Ipv4Header received;
+      received.EnableChecksum ();
+      packet->RemoveHeader (received);
+      NS_TEST_ASSERT_MSG_EQ (received.IsChecksumOk (), true, "Bad checksum received at TTL " << ttl + 1);
+      received.SetTtl (ttl);
+      packet->AddHeader (received);
+
+      Ptr<Packet> expected = Create<Packet> (1234);
+      header.SetTtl (ttl);
+      expected->AddHeader (header);
+      uint8_t actualBytes[20];
+      uint8_t expectedBytes[20];
+      packet->CopyData (actualBytes, 20);
+      expected->CopyData (expectedBytes, 20);
+      NS_TEST_ASSERT_MSG_EQ (memcmp (actualBytes, expectedBytes, 20), 0, "Bad header at TTL " << ttl);
+    }
+
+  // Any other change makes the checksum computed again
+  Ipv4Header received;
+  received.EnableChecksum ();
+  packet->RemoveHeader (received);
+  received.SetDestination (Ipv4Address ("10.9.9.9"));
+  received.SetTtl (64);
+  packet->AddHeader (received);
+  received.EnableChecksum ();
+  packet->RemoveHeader (received);
+  NS_TEST_EXPECT_MSG_EQ (received.IsChecksumOk (), true, "Bad checksum after a change of destination");
+}
+
 //-----------------------------------------------------------------------------
 class Ipv4HeaderTestSuite : public TestSuite
 {
@@ -266,5 +327,6 @@ public:
   Ipv4HeaderTestSuite () : TestSuite ("ipv4-header", UNIT)
   {
     AddTestCase (new Ipv4HeaderTest, TestCase::QUICK);
+    AddTestCase (new Ipv4HeaderTtlChecksumTest, TestCase::QUICK);
   }
 } g_ipv4HeaderTestSuite;
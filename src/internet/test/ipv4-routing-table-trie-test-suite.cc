@@ -0,0 +1,178 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <list>
+#include <vector>
+
+#include "ns3/test.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/ipv4-routing-table-entry.h"
+#include "ns3/ipv4-routing-table-trie.h"
+
+using namespace ns3;
+
+// ===========================================================================
+// Test case checking the trie against a scan of the routes, while routes
+// are added and removed.
+// ===========================================================================
+class Ipv4RoutingTableTrieTestCase : public TestCase
+{
+public:
+  Ipv4RoutingTableTrieTestCase ();
+  virtual ~Ipv4RoutingTableTrieTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /// A route and its prefix length.
+  typedef std::pair<Ipv4RoutingTableEntry *, uint8_t> Route;
+
+  /**
+   * Check the matches of an address against a scan of the routes.
+   * \param trie The trie.
+   * \param routes The routes, in insertion order.
+   * \param dest The address.
+   */
+  void CheckLookup (const Ipv4RoutingTableTrie &trie, const std::list<Route> &routes,
+                    Ipv4Address dest);
+};
+
+Ipv4RoutingTableTrieTestCase::Ipv4RoutingTableTrieTestCase ()
+  : TestCase ("Check the lookups of the routing table trie")
+{
+}
+
+Ipv4RoutingTableTrieTestCase::~Ipv4RoutingTableTrieTestCase ()
+{
+}
+
+void
+Ipv4RoutingTableTrieTestCase::CheckLookup (const Ipv4RoutingTableTrie &trie,
+                                           const std::list<Route> &routes,
+                                           Ipv4Address dest)
+{
+  // The expected matches: by decreasing prefix length, then in order.
+  std::vector<Ipv4RoutingTableEntry *> byLength[33];
+  for (std::list<Route>::const_iterator i = routes.begin (); i != routes.end (); i++)
+    {
+      if (i->first->GetDestNetworkMask ().IsMatch (dest, i->first->GetDestNetwork ()))
+        {
+          byLength[i->second].push_back (i->first);
+        }
+    }
+  std::vector<Ipv4RoutingTableEntry *> expected;
+  for (int length = 32; length >= 0; length--)
+    {
+      expected.insert (expected.end (), byLength[length].begin (), byLength[length].end ());
+    }
+  std::vector<Ipv4RoutingTableTrie::Match> matches;
+  trie.Lookup (dest, matches);
+  NS_TEST_ASSERT_MSG_EQ (matches.size (), expected.size (), "Wrong number of matches for " << dest);
+  for (uint32_t i = 0; i < matches.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (matches[i].route, expected[i], "Wrong match " << i << " for " << dest);
+      NS_TEST_EXPECT_MSG_EQ (static_cast<uint32_t> (matches[i].prefixLength),
+                             expected[i]->GetDestNetworkMask ().GetPrefixLength (),
+                             "Wrong prefix length for " << dest);
+      if (i > 0 && matches[i].prefixLength == matches[i - 1].prefixLength)
+        {
+          NS_TEST_EXPECT_MSG_GT (matches[i].order, matches[i - 1].order, "Matches out of order");
+        }
+    }
+}
+
+void
+Ipv4RoutingTableTrieTestCase::DoRun (void)
+{
+  Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable> ();
+  rand->SetStream (1);
+  Ipv4RoutingTableTrie trie;
+  std::list<Route> routes;
+
+  // Prefixes within 10.0.0.0/12 so that they nest, with duplicates.
+  for (uint32_t round = 0; round < 4; round++)
+    {
+      for (uint32_t i = 0; i < 500; i++)
+        {
+          uint8_t length = rand->GetInteger (0, 32);
+          if (i % 5 == 0)
+            {
+              length = 32;
+            }
+          Ipv4Mask mask (length == 0 ? 0 : 0xffffffff << (32 - length));
+          Ipv4Address network (0x0a000000 | rand->GetInteger (0, 0xfffff));
+          Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
+          *route = Ipv4RoutingTableEntry::CreateNetworkRouteTo (network, mask, i);
+          trie.Insert (network, length, route, i);
+          routes.push_back (Route (route, length));
+        }
+      NS_TEST_ASSERT_MSG_EQ (trie.GetN (), routes.size (), "Wrong number of entries");
+
+      for (uint32_t i = 0; i < 200; i++)
+        {
+          CheckLookup (trie, routes, Ipv4Address (0x0a000000 | rand->GetInteger (0, 0xfffff)));
+        }
+      CheckLookup (trie, routes, Ipv4Address ("192.168.1.1"));
+      for (std::list<Route>::iterator i = routes.begin (); i != routes.end (); i++)
+        {
+          CheckLookup (trie, routes, i->first->GetDestNetwork ());
+        }
+
+      // Remove about half of the routes.
+      for (std::list<Route>::iterator i = routes.begin (); i != routes.end (); )
+        {
+          if (rand->GetInteger (0, 1) == 0)
+            {
+              trie.Remove (i->first->GetDestNetwork (), i->second, i->first);
+              delete i->first;
+              i = routes.erase (i);
+            }
+          else
+            {
+              i++;
+            }
+        }
+      NS_TEST_ASSERT_MSG_EQ (trie.GetN (), routes.size (), "Wrong number of entries");
+      for (uint32_t i = 0; i < 200; i++)
+        {
+          CheckLookup (trie, routes, Ipv4Address (0x0a000000 | rand->GetInteger (0, 0xfffff)));
+        }
+    }
+
+  trie.Clear ();
+  NS_TEST_EXPECT_MSG_EQ (trie.GetN (), 0, "Entries left after Clear");
+  std::vector<Ipv4RoutingTableTrie::Match> matches;
+  trie.Lookup (routes.front ().first->GetDestNetwork (), matches);
+  NS_TEST_EXPECT_MSG_EQ (matches.size (), 0, "Match after Clear");
+  for (std::list<Route>::iterator i = routes.begin (); i != routes.end (); i++)
+    {
+      delete i->first;
+    }
+}
+
+class Ipv4RoutingTableTrieTestSuite : public TestSuite
+{
+public:
+  Ipv4RoutingTableTrieTestSuite ();
+};
+
+Ipv4RoutingTableTrieTestSuite::Ipv4RoutingTableTrieTestSuite ()
+  : TestSuite ("ipv4-routing-table-trie", UNIT)
+{
+  AddTestCase (new Ipv4RoutingTableTrieTestCase, TestCase::QUICK);
+}
+
+static Ipv4RoutingTableTrieTestSuite g_ipv4RoutingTableTrieTestSuite;
@@ -0,0 +1,231 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/socket.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/inet6-socket-address.h"
+#include "ns3/node.h"
+#include "ns3/node-container.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv6-address-helper.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/ipv4-interface.h"
+#include "ns3/arp-cache.h"
+#include "ns3/arp-l3-protocol.h"
+#include "ns3/ipv6-l3-protocol.h"
+#include "ns3/ipv6-interface.h"
+#include "ns3/ndisc-cache.h"
+#include "ns3/neighbor-cache-helper.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check that a populated neighbor cache avoids the ARP and NDP
+ * messages before the first packets
+ *
+ * Three nodes share a channel.  The first one sends a UDP packet to the
+ * second one over IPv4 and over IPv6, and the third one counts the
+ * frames on the channel.
+ */
+class NeighborCacheTestCase : public TestCase
+{
+public:
+  /**
+   * \brief Constructor
+   * \param populate populate the caches, and suppress the neighbor discovery
+   */
+  NeighborCacheTestCase (bool populate);
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Send a packet
+   * \param socket the socket
+   * \param to the destination
+   */
+  void SendPacket (Ptr<Socket> socket, Address to);
+
+  /**
+   * \brief Receive the packets of a socket
+   * \param socket the socket
+   */
+  void ReceivePacket (Ptr<Socket> socket);
+
+  /**
+   * \brief Count a frame seen on the channel
+   * \param device the device
+   * \param packet the frame
+   * \param protocol the protocol of the frame
+   * \param from the source
+   * \param to the destination
+   * \param type the type of the frame
+   */
+  void Sniff (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol,
+              const Address &from, const Address &to, NetDevice::PacketType type);
+
+  bool m_populate;      //!< Populate the caches
+  uint32_t m_received;  //!< Number of packets received
+  uint32_t m_frames;    //!< Number of frames seen on the channel
+  uint32_t m_arpFrames; //!< Number of ARP frames seen on the channel
+};
+
+NeighborCacheTestCase::NeighborCacheTestCase (bool populate)
+  : TestCase (populate ? "Populated neighbor caches" : "Neighbor discovery"),
+    m_populate (populate),
+    m_received (0),
+    m_frames (0),
+    m_arpFrames (0)
+{
+}
+
+void
+NeighborCacheTestCase::SendPacket (Ptr<Socket> socket, Address to)
+{
+  NS_TEST_EXPECT_MSG_EQ (socket->SendTo (Create<Packet> (100), 0, to), 100, "Packet not sent");
+}
+
+void
+NeighborCacheTestCase::ReceivePacket (Ptr<Socket> socket)
+{
+  while (socket->Recv ())
+    {
+      ++m_received;
+    }
+}
+
+void
+NeighborCacheTestCase::Sniff (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol,
+                              const Address &from, const Address &to, NetDevice::PacketType type)
+{
+  ++m_frames;
+  if (protocol == ArpL3Protocol::PROT_NUMBER)
+    {
+      ++m_arpFrames;
+    }
+}
+
+void
+NeighborCacheTestCase::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (3);
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  NetDeviceContainer devices;
+  for (uint32_t i = 0; i < nodes.GetN (); ++i)
+    {
+      Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+      device->SetAddress (Mac48Address::Allocate ());
+      device->SetChannel (channel);
+      nodes.Get (i)->AddDevice (device);
+      devices.Add (device);
+    }
+
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  NeighborCacheHelper neighborCache;
+  if (m_populate)
+    {
+      neighborCache.SuppressNeighborDiscovery (nodes);
+    }
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.0.0.0", "255.255.255.0");
+  Ipv4InterfaceContainer ipv4Interfaces = ipv4.Assign (devices);
+  Ipv6AddressHelper ipv6;
+  ipv6.SetBase (Ipv6Address ("2001:1::"), Ipv6Prefix (64));
+  Ipv6InterfaceContainer ipv6Interfaces = ipv6.Assign (devices);
+  if (m_populate)
+    {
+      neighborCache.PopulateNeighborCache (channel);
+
+      Ptr<Ipv4L3Protocol> ipv4L3 = nodes.Get (0)->GetObject<Ipv4L3Protocol> ();
+      Ptr<ArpCache> arpCache = ipv4L3->GetInterface (ipv4Interfaces.Get (0).second)->GetArpCache ();
+      ArpCache::Entry *arpEntry = arpCache->Lookup (ipv4Interfaces.GetAddress (1));
+      NS_TEST_ASSERT_MSG_NE (arpEntry, 0, "Neighbor not in the ARP cache");
+      NS_TEST_EXPECT_MSG_EQ (arpEntry->IsPermanent (), true, "ARP entry not permanent");
+      NS_TEST_EXPECT_MSG_EQ (arpEntry->GetMacAddress (), devices.Get (1)->GetAddress (), "Wrong MAC address");
+      NS_TEST_EXPECT_MSG_EQ (arpCache->GetEntries ().size (), 2, "Wrong number of ARP entries");
+
+      Ptr<Ipv6L3Protocol> ipv6L3 = nodes.Get (0)->GetObject<Ipv6L3Protocol> ();
+      Ptr<NdiscCache> ndiscCache = ipv6L3->GetInterface (ipv6Interfaces.GetInterfaceIndex (0))->GetNdiscCache ();
+      NdiscCache::Entry *ndiscEntry = ndiscCache->Lookup (ipv6Interfaces.GetAddress (1, 1));
+      NS_TEST_ASSERT_MSG_NE (ndiscEntry, 0, "Neighbor not in the NDP cache");
+      NS_TEST_EXPECT_MSG_EQ (ndiscEntry->IsPermanent (), true, "NDP entry not permanent");
+      NS_TEST_EXPECT_MSG_EQ (ndiscEntry->GetMacAddress (), devices.Get (1)->GetAddress (), "Wrong MAC address");
+      ndiscEntry = ndiscCache->Lookup (ipv6Interfaces.GetAddress (1, 0));
+      NS_TEST_ASSERT_MSG_NE (ndiscEntry, 0, "Link-local address of the neighbor not in the NDP cache");
+      NS_TEST_EXPECT_MSG_EQ (ndiscEntry->IsPermanent (), true, "NDP entry not permanent");
+    }
+
+  nodes.Get (2)->RegisterProtocolHandler (MakeCallback (&NeighborCacheTestCase::Sniff, this),
+                                          0, devices.Get (2), true);
+
+  Ptr<Socket> rxSocket = Socket::CreateSocket (nodes.Get (1), UdpSocketFactory::GetTypeId ());
+  rxSocket->Bind (InetSocketAddress (Ipv4Address::GetAny (), 1234));
+  rxSocket->SetRecvCallback (MakeCallback (&NeighborCacheTestCase::ReceivePacket, this));
+  Ptr<Socket> rxSocket6 = Socket::CreateSocket (nodes.Get (1), UdpSocketFactory::GetTypeId ());
+  rxSocket6->Bind (Inet6SocketAddress (Ipv6Address::GetAny (), 1234));
+  rxSocket6->SetRecvCallback (MakeCallback (&NeighborCacheTestCase::ReceivePacket, this));
+
+  Ptr<Socket> txSocket = Socket::CreateSocket (nodes.Get (0), UdpSocketFactory::GetTypeId ());
+  Ptr<Socket> txSocket6 = Socket::CreateSocket (nodes.Get (0), UdpSocketFactory::GetTypeId ());
+  Simulator::Schedule (Seconds (2), &NeighborCacheTestCase::SendPacket, this, txSocket,
+                       InetSocketAddress (ipv4Interfaces.GetAddress (1), 1234));
+  Simulator::Schedule (Seconds (2), &NeighborCacheTestCase::SendPacket, this, txSocket6,
+                       Inet6SocketAddress (ipv6Interfaces.GetAddress (1, 1), 1234));
+  Simulator::Stop (Seconds (3));
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_received, 2, "Packets not received");
+  if (m_populate)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_arpFrames, 0, "ARP frame sent to a known neighbor");
+      NS_TEST_EXPECT_MSG_EQ (m_frames, 2, "Frames other than the packets sent");
+    }
+  else
+    {
+      NS_TEST_EXPECT_MSG_GT (m_arpFrames, 0, "No ARP frame sent");
+      NS_TEST_EXPECT_MSG_GT (m_frames, 2, "No neighbor discovery frame sent");
+    }
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief TestSuite for the NeighborCacheHelper
+ */
+static class NeighborCacheTestSuite : public TestSuite
+{
+public:
+  NeighborCacheTestSuite ()
+    : TestSuite ("neighbor-cache", UNIT)
+  {
+    AddTestCase (new NeighborCacheTestCase (false), TestCase::QUICK);
+    AddTestCase (new NeighborCacheTestCase (true), TestCase::QUICK);
+  }
+} g_neighborCacheTestSuite;
@@ -0,0 +1,320 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <vector>
+
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/tcp-tx-buffer.h"
+#include "ns3/tcp-rx-buffer.h"
+
+using namespace ns3;
+
+namespace {
+
+/**
+ * Create a packet holding the bytes of a stream, which are the low
+ * bytes of their offset in the stream.
+ * \param offset The offset of the first byte.
+ * \param size The size of the packet.
+ * \returns The packet.
+ */
+Ptr<Packet>
+CreateStreamPacket (uint32_t offset, uint32_t size)
+{
+  std::vector<uint8_t> data (size);
+  for (uint32_t i = 0; i < size; i++)
+    {
+      data[i] = (offset + i) & 0xff;
+    }
+  return Create<Packet> (&data[0], size);
+}
+
+/**
+ * Check that a packet holds the bytes of a stream.
+ * \param p The packet.
+ * \param offset The offset of the first byte.
+ * \returns true if the packet holds the bytes from offset.
+ */
+bool
+IsStreamPacket (Ptr<const Packet> p, uint32_t offset)
+{
+  std::vector<uint8_t> data (p->GetSize () + 1);
+  p->CopyData (&data[0], p->GetSize ());
+  for (uint32_t i = 0; i < p->GetSize (); i++)
+    {
+      if (data[i] != ((offset + i) & 0xff))
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+} // anonymous namespace
+
+// ===========================================================================
+// Test case checking the segments copied out of the Tx buffer, across the
+// packets written by the application, while the data is acknowledged.
+// ===========================================================================
+class TcpTxBufferTestCase : public TestCase
+{
+public:
+  TcpTxBufferTestCase ();
+  virtual ~TcpTxBufferTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+TcpTxBufferTestCase::TcpTxBufferTestCase ()
+  : TestCase ("Check the segments of the TCP Tx buffer")
+{
+}
+
+TcpTxBufferTestCase::~TcpTxBufferTestCase ()
+{
+}
+
+void
+TcpTxBufferTestCase::DoRun (void)
+{
+  TcpTxBuffer buffer (0);
+  buffer.SetMaxBufferSize (100000);
+  // Written before the connection is set up
+  NS_TEST_ASSERT_MSG_EQ (buffer.Add (CreateStreamPacket (0, 300)), true, "Packet rejected");
+  SequenceNumber32 isn (0xfffff000); // The sequence numbers wrap around
+  buffer.SetHeadSequence (isn);
+  NS_TEST_EXPECT_MSG_EQ (buffer.TailSequence (), isn + 300, "Wrong tail sequence");
+  for (uint32_t offset = 300; offset < 50000; offset += 700)
+    {
+      NS_TEST_ASSERT_MSG_EQ (buffer.Add (CreateStreamPacket (offset, 700)), true, "Packet rejected");
+    }
+  NS_TEST_EXPECT_MSG_EQ (buffer.Size (), 50000, "Wrong size");
+  NS_TEST_EXPECT_MSG_EQ (buffer.Add (Create<Packet> (60000)), false, "Packet beyond the maximum size accepted");
+
+  // Segments of 536 bytes, across the packets of 700 bytes
+  for (uint32_t offset = 0; offset < 20000; offset += 536)
+    {
+      Ptr<Packet> p = buffer.CopyFromSequence (536, isn + offset);
+      NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 536, "Wrong segment size");
+      NS_TEST_EXPECT_MSG_EQ (IsStreamPacket (p, offset), true, "Wrong segment at " << offset);
+    }
+  // Retransmissions, and a larger segment
+  Ptr<Packet> p = buffer.CopyFromSequence (536, isn + 1072);
+  NS_TEST_EXPECT_MSG_EQ (IsStreamPacket (p, 1072), true, "Wrong retransmission");
+  p = buffer.CopyFromSequence (1500, isn + 1000);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 1500, "Wrong segment size");
+  NS_TEST_EXPECT_MSG_EQ (IsStreamPacket (p, 1000), true, "Wrong segment");
+  p->AddAtEnd (Create<Packet> (10));
+  p = buffer.CopyFromSequence (1500, isn + 1000);
+  NS_TEST_EXPECT_MSG_EQ (p->GetSize (), 1500, "The buffer changed with a copied segment");
+
+  // Partial acknowledgments
+  buffer.DiscardUpTo (isn + 1200);
+  NS_TEST_EXPECT_MSG_EQ (buffer.HeadSequence (), isn + 1200, "Wrong head sequence");
+  NS_TEST_EXPECT_MSG_EQ (buffer.Size (), 48800, "Wrong size");
+  p = buffer.CopyFromSequence (100, isn + 1200);
+  NS_TEST_EXPECT_MSG_EQ (IsStreamPacket (p, 1200), true, "Wrong segment after a partial acknowledgment");
+  buffer.DiscardUpTo (isn + 30001);
+  NS_TEST_EXPECT_MSG_EQ (buffer.SizeFromSequence (isn + 30001), 19999, "Wrong size from sequence");
+  p = buffer.CopyFromSequence (30000, isn + 30001);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 19999, "Segment beyond the tail of the buffer");
+  NS_TEST_EXPECT_MSG_EQ (IsStreamPacket (p, 30001), true, "Wrong last segment");
+
+  // Acknowledgment of the data and of a FIN
+  buffer.DiscardUpTo (isn + 50001);
+  NS_TEST_EXPECT_MSG_EQ (buffer.Size (), 0, "Data left in the buffer");
+  NS_TEST_EXPECT_MSG_EQ (buffer.HeadSequence (), isn + 50001, "Wrong head sequence");
+}
+
+// ===========================================================================
+// Test case checking the data delivered by the Rx buffer, when segments
+// arrive out of order and overlap.
+// ===========================================================================
+class TcpRxBufferTestCase : public TestCase
+{
+public:
+  TcpRxBufferTestCase ();
+  virtual ~TcpRxBufferTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+TcpRxBufferTestCase::TcpRxBufferTestCase ()
+  : TestCase ("Check the reordering of the TCP Rx buffer")
+{
+}
+
+TcpRxBufferTestCase::~TcpRxBufferTestCase ()
+{
+}
+
+void
+TcpRxBufferTestCase::DoRun (void)
+{
+  SequenceNumber32 isn (0xffffff00);
+  TcpRxBuffer buffer (0);
+  buffer.SetMaxBufferSize (100000);
+  buffer.SetNextRxSequence (isn);
+
+  // Every other segment, then the missing ones, in reverse order
+  const uint32_t segmentSize = 1000;
+  const uint32_t n = 40;
+  TcpHeader header;
+  for (uint32_t i = 1; i < n; i += 2)
+    {
+      header.SetSequenceNumber (isn + i * segmentSize);
+      NS_TEST_EXPECT_MSG_EQ (buffer.Add (CreateStreamPacket (i * segmentSize, segmentSize), header), true,
+                             "Segment " << i << " not buffered");
+    }
+  NS_TEST_EXPECT_MSG_EQ (buffer.Available (), 0, "Data available with a hole");
+  NS_TEST_EXPECT_MSG_EQ (buffer.Size (), n / 2 * segmentSize, "Wrong occupancy");
+  // A duplicate, and a segment overlapping a hole and its neighbours
+  header.SetSequenceNumber (isn + segmentSize);
+  NS_TEST_EXPECT_MSG_EQ (buffer.Add (CreateStreamPacket (segmentSize, segmentSize), header), false,
+                         "Duplicate segment buffered");
+  header.SetSequenceNumber (isn + 5 * segmentSize - 100);
+  NS_TEST_EXPECT_MSG_EQ (buffer.Add (CreateStreamPacket (5 * segmentSize - 100, 3 * segmentSize), header), true,
+                         "Overlapping segment not buffered");
+  for (uint32_t i = n; i > 0; i -= 2)
+    {
+      header.SetSequenceNumber (isn + (i - 2) * segmentSize);
+      buffer.Add (CreateStreamPacket ((i - 2) * segmentSize, segmentSize), header);
+    }
+  NS_TEST_EXPECT_MSG_EQ (buffer.NextRxSequence (), isn + n * segmentSize, "Wrong next sequence");
+  NS_TEST_ASSERT_MSG_EQ (buffer.Available (), n * segmentSize, "Wrong available data");
+
+  Ptr<Packet> p = buffer.Extract (1500);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 1500, "Wrong extracted size");
+  NS_TEST_EXPECT_MSG_EQ (IsStreamPacket (p, 0), true, "Wrong extracted data");
+  p = buffer.Extract (n * segmentSize);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), n * segmentSize - 1500, "Wrong extracted size");
+  NS_TEST_EXPECT_MSG_EQ (IsStreamPacket (p, 1500), true, "Wrong extracted data");
+  NS_TEST_EXPECT_MSG_EQ (buffer.Size (), 0, "Data left in the buffer");
+}
+
+// ===========================================================================
+// Test case checking the blocks reported by the Rx buffer, and the
+// scoreboard the Tx buffer builds from them.
+// ===========================================================================
+class TcpSackScoreboardTestCase : public TestCase
+{
+public:
+  TcpSackScoreboardTestCase ();
+  virtual ~TcpSackScoreboardTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+TcpSackScoreboardTestCase::TcpSackScoreboardTestCase ()
+  : TestCase ("Check the SACK blocks and scoreboard of the TCP buffers")
+{
+}
+
+TcpSackScoreboardTestCase::~TcpSackScoreboardTestCase ()
+{
+}
+
+void
+TcpSackScoreboardTestCase::DoRun (void)
+{
+  SequenceNumber32 isn (0xfffff000);
+  const uint32_t segmentSize = 500;
+  TcpTxBuffer txBuffer (0);
+  txBuffer.SetMaxBufferSize (100000);
+  txBuffer.SetHeadSequence (isn);
+  txBuffer.Add (CreateStreamPacket (0, 20 * segmentSize));
+  TcpRxBuffer rxBuffer (0);
+  rxBuffer.SetMaxBufferSize (100000);
+  rxBuffer.SetNextRxSequence (isn);
+
+  // Segments 2 and 6 are lost
+  TcpHeader header;
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      if (i == 2 || i == 6)
+        {
+          continue;
+        }
+      header.SetSequenceNumber (isn + i * segmentSize);
+      rxBuffer.Add (CreateStreamPacket (i * segmentSize, segmentSize), header);
+    }
+  TcpOptionSack::SackList list = rxBuffer.GetSackList ();
+  NS_TEST_ASSERT_MSG_EQ (list.size (), 2, "Wrong number of blocks");
+  NS_TEST_EXPECT_MSG_EQ (list.front ().first, isn + 7 * segmentSize, "Last block not reported first");
+  NS_TEST_EXPECT_MSG_EQ (list.front ().second, isn + 10 * segmentSize, "Wrong right edge");
+  NS_TEST_EXPECT_MSG_EQ (list.back ().first, isn + 3 * segmentSize, "Wrong left edge");
+  NS_TEST_EXPECT_MSG_EQ (list.back ().second, isn + 6 * segmentSize, "Wrong right edge");
+
+  txBuffer.DiscardUpTo (rxBuffer.NextRxSequence ());
+  NS_TEST_EXPECT_MSG_EQ (txBuffer.Update (list), true, "No data newly SACKed");
+  NS_TEST_EXPECT_MSG_EQ (txBuffer.Update (list), false, "Data SACKed twice");
+  NS_TEST_EXPECT_MSG_EQ (txBuffer.GetSackedBytes (isn + 20 * segmentSize), 6 * segmentSize, "Wrong SACKed bytes");
+  NS_TEST_EXPECT_MSG_EQ (txBuffer.NextUnsacked (isn + 4 * segmentSize), isn + 6 * segmentSize,
+                         "SACKed data not skipped");
+  NS_TEST_EXPECT_MSG_EQ (txBuffer.UnsackedSizeFromSequence (isn + 6 * segmentSize), segmentSize,
+                         "Wrong size of the hole");
+
+  // Both holes have three segments SACKed beyond them
+  SequenceNumber32 lost;
+  uint32_t size;
+  uint32_t threshold = 2 * segmentSize + 1;
+  NS_TEST_ASSERT_MSG_EQ (txBuffer.NextLost (isn, threshold, lost, size), true, "Hole not lost");
+  NS_TEST_EXPECT_MSG_EQ (lost, isn + 2 * segmentSize, "Wrong lost hole");
+  NS_TEST_EXPECT_MSG_EQ (size, segmentSize, "Wrong size of the lost hole");
+  NS_TEST_ASSERT_MSG_EQ (txBuffer.NextLost (lost + size, threshold, lost, size), true, "Hole not lost");
+  NS_TEST_EXPECT_MSG_EQ (lost, isn + 6 * segmentSize, "Wrong lost hole");
+  NS_TEST_EXPECT_MSG_EQ (txBuffer.NextLost (lost + size, threshold, lost, size), false,
+                         "Data beyond the SACKed blocks lost");
+
+  // The retransmission of segment 2 joins the first block to the in-order data
+  header.SetSequenceNumber (isn + 2 * segmentSize);
+  rxBuffer.Add (CreateStreamPacket (2 * segmentSize, segmentSize), header);
+  NS_TEST_EXPECT_MSG_EQ (rxBuffer.NextRxSequence (), isn + 6 * segmentSize, "Wrong next sequence");
+  list = rxBuffer.GetSackList ();
+  NS_TEST_ASSERT_MSG_EQ (list.size (), 1, "In-order data reported");
+  txBuffer.DiscardUpTo (rxBuffer.NextRxSequence ());
+  txBuffer.Update (list);
+  NS_TEST_EXPECT_MSG_EQ (txBuffer.GetSackedBytes (isn + 20 * segmentSize), 3 * segmentSize, "Wrong SACKed bytes");
+  NS_TEST_EXPECT_MSG_EQ (txBuffer.NextLost (isn, 3 * segmentSize + 1, lost, size), false,
+                         "Hole lost below the threshold");
+
+  // The acknowledgment of all the data empties the scoreboard
+  header.SetSequenceNumber (isn + 6 * segmentSize);
+  rxBuffer.Add (CreateStreamPacket (6 * segmentSize, segmentSize), header);
+  NS_TEST_EXPECT_MSG_EQ (rxBuffer.GetSackList ().size (), 0, "In-order data reported");
+  txBuffer.DiscardUpTo (rxBuffer.NextRxSequence ());
+  NS_TEST_EXPECT_MSG_EQ (txBuffer.GetSackedBytes (isn + 20 * segmentSize), 0, "SACKed bytes left");
+}
+
+class TcpBufferTestSuite : public TestSuite
+{
+public:
+  TcpBufferTestSuite ();
+};
+
+TcpBufferTestSuite::TcpBufferTestSuite ()
+  : TestSuite ("tcp-buffer", UNIT)
+{
+  AddTestCase (new TcpTxBufferTestCase, TestCase::QUICK);
+  AddTestCase (new TcpRxBufferTestCase, TestCase::QUICK);
+  AddTestCase (new TcpSackScoreboardTestCase, TestCase::QUICK);
+}
+
+static TcpBufferTestSuite g_tcpBufferTestSuite;
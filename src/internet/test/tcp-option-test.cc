@@ -22,6 +22,7 @@
 #include "ns3/tcp-option.h"
 #include "ns3/private/tcp-option-winscale.h"
 #include "ns3/private/tcp-option-ts.h"
+#include "ns3/tcp-option-sack.h"
 
 #include <string.h>
 
@@ -164,6 +165,55 @@ TcpOptionTSTestCase::DoTeardown ()
 {
 }
 
+class TcpOptionSackTestCase : public TestCase
+{
+public:
+  TcpOptionSackTestCase (std::string name);
+
+private:
+  virtual void DoRun (void);
+};
+
+TcpOptionSackTestCase::TcpOptionSackTestCase (std::string name)
+  : TestCase (name)
+{
+}
+
+void
+TcpOptionSackTestCase::DoRun ()
+{
+  Ptr<UniformRandomVariable> x = CreateObject<UniformRandomVariable> ();
+
+  TcpOptionSackPermitted permitted;
+  Buffer buffer;
+  buffer.AddAtStart (permitted.GetSerializedSize ());
+  permitted.Serialize (buffer.Begin ());
+  NS_TEST_EXPECT_MSG_EQ (buffer.Begin ().PeekU8 (), TcpOption::SACKPERMITTED, "Different kind found");
+  NS_TEST_EXPECT_MSG_EQ (permitted.Deserialize (buffer.Begin ()), 2, "Wrong size read");
+
+  for (uint32_t n = 1; n <= 4; ++n)
+    {
+      TcpOptionSack opt;
+      for (uint32_t i = 0; i < n; ++i)
+        {
+          uint32_t left = x->GetInteger ();
+          opt.AddSackBlock (TcpOptionSack::SackBlock (SequenceNumber32 (left),
+                                                      SequenceNumber32 (left + x->GetInteger (1, 65535))));
+        }
+      NS_TEST_EXPECT_MSG_EQ (opt.GetSerializedSize (), 2 + 8 * n, "Wrong size");
+
+      Buffer sackBuffer;
+      sackBuffer.AddAtStart (opt.GetSerializedSize ());
+      opt.Serialize (sackBuffer.Begin ());
+      NS_TEST_EXPECT_MSG_EQ (sackBuffer.Begin ().PeekU8 (), TcpOption::SACK, "Different kind found");
+
+      TcpOptionSack read;
+      NS_TEST_EXPECT_MSG_EQ (read.Deserialize (sackBuffer.Begin ()), opt.GetSerializedSize (), "Wrong size read");
+      NS_TEST_EXPECT_MSG_EQ (read.GetNumSackBlocks (), n, "Different number of blocks found");
+      NS_TEST_EXPECT_MSG_EQ ((read.GetSackList () == opt.GetSackList ()), true, "Different blocks found");
+    }
+}
+
 static class TcpOptionTestSuite : public TestSuite
 {
 public:
@@ -176,6 +226,7 @@ public:
                                               "scale value", i), TestCase::QUICK);
       }
     AddTestCase (new TcpOptionTSTestCase ("Testing serialization of random values for timestamp"), TestCase::QUICK);
+    AddTestCase (new TcpOptionSackTestCase ("Testing serialization of random blocks for SACK"), TestCase::QUICK);
   }
 
 } g_TcpOptionTestSuite;
@@ -0,0 +1,205 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "tcp-general-test.h"
+#include "tcp-error-model.h"
+#include "ns3/node.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpSackTestSuite");
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the negotiation of SACK, and the recovery of a window
+ * which lost several segments
+ *
+ * Three segments of the same window are dropped.  With SACK, the sender
+ * retransmits each of them once, in the round trip of the fast
+ * retransmit.  Without SACK, a lost segment is retransmitted on each
+ * partial ACK, one round trip after the other.
+ */
+class TcpSackTestCase : public TcpGeneralTest
+{
+public:
+  /**
+   * \brief Constructor
+   * \param senderSack SACK enabled on the sender
+   * \param receiverSack SACK enabled on the receiver
+   * \param msg the test message
+   */
+  TcpSackTestCase (bool senderSack, bool receiverSack, const std::string &msg);
+
+protected:
+  virtual void ConfigureEnvironment ();
+  virtual Ptr<ErrorModel> CreateReceiverErrorModel ();
+  virtual Ptr<TcpSocketMsgBase> CreateReceiverSocket (Ptr<Node> node);
+  virtual Ptr<TcpSocketMsgBase> CreateSenderSocket (Ptr<Node> node);
+
+  virtual void Tx (const Ptr<const Packet> p, const TcpHeader&h, SocketWho who);
+  virtual void RTOExpired (const Ptr<const TcpSocketState> tcb, SocketWho who);
+  virtual void FinalChecks ();
+
+  bool m_senderSack;          //!< SACK enabled on the sender
+  bool m_receiverSack;        //!< SACK enabled on the receiver
+  SequenceNumber32 m_highTx;  //!< Highest sequence number sent
+  uint32_t m_retransmissions; //!< Number of retransmitted segments
+  Time m_firstRetransmission; //!< Time of the first retransmission
+  Time m_lastRetransmission;  //!< Time of the last retransmission
+  uint32_t m_sackOptions;     //!< Number of SACK options sent
+  bool m_rtoExpired;          //!< The RTO expired on the sender
+};
+
+TcpSackTestCase::TcpSackTestCase (bool senderSack, bool receiverSack, const std::string &msg)
+  : TcpGeneralTest (msg),
+    m_senderSack (senderSack),
+    m_receiverSack (receiverSack),
+    m_highTx (0),
+    m_retransmissions (0),
+    m_sackOptions (0),
+    m_rtoExpired (false)
+{
+}
+
+void
+TcpSackTestCase::ConfigureEnvironment ()
+{
+  TcpGeneralTest::ConfigureEnvironment ();
+  SetAppPktCount (100);
+}
+
+Ptr<ErrorModel>
+TcpSackTestCase::CreateReceiverErrorModel ()
+{
+  // Segments 20, 22 and 24, in the window of segments 15 to 30
+  Ptr<TcpSeqErrorModel> errorModel = CreateObject<TcpSeqErrorModel> ();
+  errorModel->AddSeqToKill (SequenceNumber32 (1 + 20 * 500));
+  errorModel->AddSeqToKill (SequenceNumber32 (1 + 22 * 500));
+  errorModel->AddSeqToKill (SequenceNumber32 (1 + 24 * 500));
+  return errorModel;
+}
+
+Ptr<TcpSocketMsgBase>
+TcpSackTestCase::CreateReceiverSocket (Ptr<Node> node)
+{
+  Ptr<TcpSocketMsgBase> socket = TcpGeneralTest::CreateReceiverSocket (node);
+  socket->SetAttribute ("Sack", BooleanValue (m_receiverSack));
+  return socket;
+}
+
+Ptr<TcpSocketMsgBase>
+TcpSackTestCase::CreateSenderSocket (Ptr<Node> node)
+{
+  Ptr<TcpSocketMsgBase> socket = TcpGeneralTest::CreateSenderSocket (node);
+  socket->SetAttribute ("Sack", BooleanValue (m_senderSack));
+  return socket;
+}
+
+void
+TcpSackTestCase::Tx (const Ptr<const Packet> p, const TcpHeader &h, SocketWho who)
+{
+  bool sack = m_senderSack && m_receiverSack;
+
+  if (h.GetFlags () & TcpHeader::SYN)
+    {
+      // The receiver permits SACK only in reply to a SYN which does
+      bool enabled = who == SENDER ? m_senderSack : sack;
+      NS_TEST_ASSERT_MSG_EQ (h.HasOption (TcpOption::SACKPERMITTED), enabled,
+                             "Wrong SACK-permitted option in SYN");
+      NS_TEST_ASSERT_MSG_EQ (h.HasOption (TcpOption::SACK), false, "SACK option in SYN");
+      return;
+    }
+  NS_TEST_ASSERT_MSG_EQ (h.HasOption (TcpOption::SACKPERMITTED), false,
+                         "SACK-permitted option in non-SYN packet");
+
+  if (who == RECEIVER)
+    {
+      if (h.HasOption (TcpOption::SACK))
+        {
+          NS_TEST_ASSERT_MSG_EQ (sack, true, "SACK option sent without negotiation");
+          ++m_sackOptions;
+        }
+    }
+  else if (p->GetSize () > 0)
+    {
+      if (h.GetSequenceNumber () < m_highTx)
+        {
+          NS_LOG_INFO ("Retransmission of " << h.GetSequenceNumber ());
+          if (m_retransmissions++ == 0)
+            {
+              m_firstRetransmission = Simulator::Now ();
+            }
+          m_lastRetransmission = Simulator::Now ();
+        }
+      else
+        {
+          m_highTx = h.GetSequenceNumber () + p->GetSize ();
+        }
+    }
+}
+
+void
+TcpSackTestCase::RTOExpired (const Ptr<const TcpSocketState> tcb, SocketWho who)
+{
+  if (who == SENDER)
+    {
+      m_rtoExpired = true;
+    }
+}
+
+void
+TcpSackTestCase::FinalChecks ()
+{
+  if (m_senderSack && m_receiverSack)
+    {
+      NS_TEST_ASSERT_MSG_GT (m_sackOptions, 0, "No SACK option sent");
+      NS_TEST_ASSERT_MSG_EQ (m_rtoExpired, false, "RTO expired during the recovery");
+      NS_TEST_ASSERT_MSG_EQ (m_retransmissions, 3, "Wrong number of retransmissions");
+      NS_TEST_ASSERT_MSG_LT (m_lastRetransmission - m_firstRetransmission,
+                             2 * GetPropagationDelay (),
+                             "Lost segments not retransmitted in one round trip");
+    }
+  else
+    {
+      NS_TEST_ASSERT_MSG_EQ (m_sackOptions, 0, "SACK option sent without negotiation");
+      NS_TEST_ASSERT_MSG_GT_OR_EQ (m_retransmissions, 3, "Lost segments not retransmitted");
+    }
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief TestSuite for the SACK option
+ */
+static class TcpSackTestSuite : public TestSuite
+{
+public:
+  TcpSackTestSuite ()
+    : TestSuite ("tcp-sack", UNIT)
+  {
+    AddTestCase (new TcpSackTestCase (true, true, "SACK enabled"), TestCase::QUICK);
+    AddTestCase (new TcpSackTestCase (true, false, "SACK enabled on the sender only"), TestCase::QUICK);
+    AddTestCase (new TcpSackTestCase (false, true, "SACK enabled on the receiver only"), TestCase::QUICK);
+    AddTestCase (new TcpSackTestCase (false, false, "SACK disabled"), TestCase::QUICK);
+  }
+} g_tcpSackTestSuite;
+
+} // namespace ns3
@@ -222,6 +222,26 @@ public:
   Ptr<OutputStreamWrapper> CreateFileStream (std::string filename, 
                                              std::ios::openmode filemode = std::ios::out);
 
+  /**
+   * @brief Create an output stream object which writes a binary trace file.
+   *
+   * The default trace sinks append compact binary records to the file
+   * instead of formatting text lines; the text written to the stream by
+   * other sinks is kept in order.  The \c decode-binary-trace utility
+   * renders the file in the ASCII trace format.  See BinaryTraceWriter.
+   *
+   * By default, a digest of the first bytes of each packet is stored
+   * instead of the packet.  BinaryTraceWriter::PACKET stores the
+   * packets in full, payload included, so that the decoded file is
+   * identical to the ASCII trace, at the cost of a larger file.
+   *
+   * @param filename file name
+   * @param content the information stored about each packet
+   * @returns a smart pointer to the output stream
+   */
+  Ptr<OutputStreamWrapper> CreateBinaryFileStream (std::string filename,
+                                                   BinaryTraceWriter::Content content = BinaryTraceWriter::DIGEST);
+
   /**
    * @brief Hook a trace source to the default enqueue operation trace sink that
    * does not accept nor log a trace context.
@@ -20,6 +20,7 @@
 #include "buffer.h"
 #include "ns3/assert.h"
 #include "ns3/log.h"
+#include <cstring>
 
 #define LOG_INTERNAL_STATE(y)                                                                    \
   NS_LOG_LOGIC (y << "start="<<m_start<<", end="<<m_end<<", zero start="<<m_zeroAreaStart<<              \
@@ -133,6 +134,7 @@ Buffer::Create (uint32_t dataSize)
           if (data->m_size >= dataSize) 
             {
               data->m_count = 1;
+              data->m_growing = false;
               return data;
             }
           Buffer::Deallocate (data);
@@ -173,6 +175,7 @@ Buffer::Allocate (uint32_t reqSize)
   struct Buffer::Data *data = reinterpret_cast<struct Buffer::Data*>(b);
   data->m_size = reqSize;
   data->m_count = 1;
+  data->m_growing = false;
   return data;
 }
 
@@ -354,6 +357,13 @@ void
 Buffer::AddAtEnd (uint32_t end)
 {
   NS_LOG_FUNCTION (this << end);
+  AddAtEnd (end, 0);
+}
+
+void
+Buffer::AddAtEnd (uint32_t end, uint32_t room)
+{
+  NS_LOG_FUNCTION (this << end << room);
   NS_ASSERT (CheckInternalState ());
   bool isDirty = m_data->m_count > 1 && m_end < m_data->m_dirtyEnd;
   if (GetInternalEnd () + end <= m_data->m_size && !isDirty)
@@ -370,7 +380,7 @@ Buffer::AddAtEnd (uint32_t end)
     } 
   else
     {
-      uint32_t newSize = GetInternalSize () + end;
+      uint32_t newSize = GetInternalSize () + end + room;
       struct Buffer::Data *newData = Buffer::Create (newSize);
       memcpy (newData->m_data, m_data->m_data + m_start, GetInternalSize ());
       m_data->m_count--;
@@ -426,14 +436,45 @@ Buffer::AddAtEnd (const Buffer &o)
       return;
     }
 
-  Buffer dst = CreateFullCopy ();
-  Buffer src = o.CreateFullCopy ();
+  /* Keep a reference to the data of o, which may be this buffer,
+   * and make sure that the bytes are not copied onto themselves.
+   */
+  Buffer src = o;
+  if (src.m_data == m_data)
+    {
+      src = o.CreateFullCopy ();
+      if (src.m_data == m_data)
+        {
+          Buffer tmp;
+          tmp.AddAtEnd (o.GetSize ());
+          tmp.Begin ().Write (o.Begin (), o.End ());
+          src = tmp;
+        }
+    }
 
-  dst.AddAtEnd (src.GetSize ());
-  Buffer::Iterator destStart = dst.End ();
-  destStart.Prev (src.GetSize ());
-  destStart.Write (src.Begin (), src.End ());
-  *this = dst;
+  /* The dirty area of shared data cannot be compared with the end
+   * of a buffer which has a zero area, so the zero area of this
+   * buffer is written as real zeroes first.  The zero area of src
+   * is copied as real zeroes too.  The buffer then grows at its end.
+   * Room for as many bytes again is reserved only if the storage is
+   * not shared and was already grown by a previous addition: a
+   * buffer built by successive additions grows geometrically, while
+   * a copy extended once, such as segments merged by TCP, holds no
+   * unused bytes.
+   */
+  if (m_zeroAreaEnd != m_zeroAreaStart)
+    {
+      *this = CreateFullCopy ();
+    }
+  uint32_t size = src.GetSize ();
+  uint32_t room = m_data->m_count == 1 && m_data->m_growing ? GetInternalSize () : 0;
+  struct Buffer::Data *data = m_data;
+  AddAtEnd (size, room);
+  if (m_data != data)
+    {
+      m_data->m_growing = true;
+    }
+  src.CopyData (m_data->m_data + m_end - size, size);
   NS_ASSERT (CheckInternalState ());
 }
 
@@ -774,6 +815,40 @@ Buffer::CopyData (uint8_t *buffer, uint32_t size) const
   return originalSize - size;
 }
 
+uint32_t
+Buffer::GetSpans (struct Span *spans, uint32_t offset, uint32_t size) const
+{
+  NS_LOG_FUNCTION (this << spans << offset << size);
+  NS_ASSERT (CheckInternalState ());
+  uint32_t n = 0;
+  uint32_t current = m_start + std::min (offset, GetSize ());
+  uint32_t end = current + std::min (size, m_end - current);
+  if (current < m_zeroAreaStart && current < end)
+    {
+      uint32_t last = std::min (end, m_zeroAreaStart);
+      spans[n].data = m_data->m_data + current;
+      spans[n].size = last - current;
+      n++;
+      current = last;
+    }
+  if (current < m_zeroAreaEnd && current < end)
+    {
+      uint32_t last = std::min (end, m_zeroAreaEnd);
+      spans[n].data = 0;
+      spans[n].size = last - current;
+      n++;
+      current = last;
+    }
+  if (current < end)
+    {
+      uint32_t zeroSize = m_zeroAreaEnd - m_zeroAreaStart;
+      spans[n].data = m_data->m_data + current - zeroSize;
+      spans[n].size = end - current;
+      n++;
+    }
+  return n;
+}
+
 /******************************************************
  *            The buffer iterator below.
  ******************************************************/
@@ -1136,18 +1211,85 @@ Buffer::Iterator::CalculateIpChecksum (uint16_t size)
   return CalculateIpChecksum (size, 0);
 }
 
+/**
+ * \brief Sum the 16-bit words of a memory area, as read by ReadU16
+ *
+ * The words are summed 64 bits at a time: the ones' complement sum does
+ * not depend on the byte order (RFC 1071, section 2.B), so the bytes of
+ * the folded sum of native words are those of the folded sum of the
+ * words in any order.  A last odd byte is the low byte of its word.
+ *
+ * \param data the memory area
+ * \param size the size of the area
+ * \return the ones' complement sum, folded to 16 bits
+ */
+static uint16_t
+SumWords (const uint8_t *data, uint32_t size)
+{
+  uint64_t sum = 0;
+  for (; size >= 8; data += 8, size -= 8)
+    {
+      uint64_t word;
+      std::memcpy (&word, data, 8);
+      sum += (word & 0xffffffff) + (word >> 32);
+    }
+  while (sum >> 16)
+    {
+      sum = (sum & 0xffff) + (sum >> 16);
+    }
+  uint16_t folded = sum;
+  uint8_t bytes[2];
+  std::memcpy (bytes, &folded, 2);
+  sum = bytes[0] | (bytes[1] << 8);
+
+  for (; size >= 2; data += 2, size -= 2)
+    {
+      sum += data[0] | (data[1] << 8);
+    }
+  if (size)
+    {
+      sum += data[0];
+    }
+  while (sum >> 16)
+    {
+      sum = (sum & 0xffff) + (sum >> 16);
+    }
+  return sum;
+}
+
 uint16_t
 Buffer::Iterator::CalculateIpChecksum (uint16_t size, uint32_t initialChecksum)
 {
   NS_LOG_FUNCTION (this << size << initialChecksum);
+  NS_ASSERT_MSG (m_current >= m_dataStart &&
+                 m_current + size <= m_dataEnd,
+                 GetReadErrorMessage ());
   /* see RFC 1071 to understand this code. */
-  uint32_t sum = initialChecksum;
-
-  for (int j = 0; j < size/2; j++)
-    sum += ReadU16 ();
-
-  if (size & 1)
-    sum += ReadU8 ();
+  uint64_t sum = initialChecksum;
+  uint32_t end = m_current + size;
+  // A word which straddles two areas shifts the bytes of the second one
+  bool odd = false;
+
+  if (m_current < m_zeroStart)
+    { // The data before the zero area
+      uint32_t n = std::min (end, m_zeroStart) - m_current;
+      sum += SumWords (&m_data[m_current], n);
+      odd = n & 1;
+      m_current += n;
+    }
+  if (m_current < end && m_current < m_zeroEnd)
+    { // The zero area adds nothing
+      uint32_t n = std::min (end, m_zeroEnd) - m_current;
+      odd ^= n & 1;
+      m_current += n;
+    }
+  if (m_current < end)
+    { // The data after the zero area
+      uint32_t n = end - m_current;
+      uint16_t partial = SumWords (&m_data[m_current - (m_zeroEnd - m_zeroStart)], n);
+      sum += odd ? static_cast<uint16_t> ((partial << 8) | (partial >> 8)) : partial;
+      m_current += n;
+    }
 
   while (sum >> 16)
     sum = (sum & 0xffff) + (sum >> 16);
@@ -88,6 +88,13 @@ namespace ns3 {
  * \endverbatim
  *
  * A simple state invariant is that m_start <= m_zeroStart <= m_zeroEnd <= m_end
+ *
+ * The real bytes of a Buffer are always held in a single, contiguous
+ * BufferData, which Buffer::Iterator and the header serializers rely
+ * on. CreateFragment shares the BufferData of the original buffer,
+ * but adding bytes beyond the room left in a BufferData, including
+ * AddAtEnd (const Buffer &), copies them into a new BufferData: there
+ * is no chained storage of shared segments.
  */
 class Buffer 
 {
@@ -523,7 +530,12 @@ private:
   /**
    * \param o the buffer to append to the end of this buffer.
    *
-   * Add bytes at the end of the Buffer.
+   * Add bytes at the end of the Buffer.  When a buffer which does
+   * not share its storage is reallocated for the second time or
+   * more, the new storage has room for as many bytes again, so that
+   * building a large buffer by successive additions takes linear
+   * time.  A buffer extended once, such as a copy of a packet, gets
+   * no extra room.
    * Any call to this method invalidates any Iterator
    * pointing to this Buffer.
    */
@@ -610,6 +622,41 @@ private:
    */
   uint32_t CopyData (uint8_t *buffer, uint32_t size) const;
 
+  /**
+   * \brief A read-only range of contiguous bytes of a Buffer.
+   *
+   * A span either points into the storage of the buffer, or
+   * stands for bytes of the zero-filled virtual area, in which
+   * case its data pointer is zero.
+   */
+  struct Span
+  {
+    uint8_t const *data; //!< The first byte of the span, or 0 for zero-filled bytes.
+    uint32_t size;       //!< The number of bytes of the span.
+  };
+
+  /**
+   * The maximum number of spans returned by GetSpans: the bytes
+   * before the zero area, the zero area, and the bytes after it.
+   */
+  static const uint32_t MAX_SPANS = 3;
+
+  /**
+   * \brief Get read-only views of the content of the buffer, without
+   * copying it.
+   *
+   * The returned spans cover, in order, the bytes of the range
+   * starting at offset, up to the end of the buffer.  Empty spans
+   * are not returned.  The spans are valid until the buffer is
+   * modified or destroyed.
+   *
+   * \param spans the output array, with room for MAX_SPANS spans
+   * \param offset the offset in the buffer of the first byte to view
+   * \param size the maximum number of bytes to view
+   * \returns the number of spans stored in the array
+   */
+  uint32_t GetSpans (struct Span *spans, uint32_t offset, uint32_t size) const;
+
   /**
    * \brief Copy constructor
    * \param o the buffer to copy
@@ -677,6 +724,12 @@ private:
      * end of the area in which user bytes were written.
      */
     uint32_t m_dirtyEnd;
+    /**
+     * set when this data was allocated by AddAtEnd (const Buffer &)
+     * to grow a buffer: a buffer owning it alone reserves room for
+     * its next additions when it grows again.
+     */
+    bool m_growing;
     /**
      * The real data buffer holds _at least_ one byte.
      * Its real size is stored in the m_size field.
@@ -705,6 +758,16 @@ private:
    */
   bool CheckInternalState (void) const;
 
+  /**
+   * \brief Add bytes at the end of the Buffer, with extra room for
+   * the next additions if the storage must be reallocated.
+   *
+   * \param end size to add
+   * \param room size to reserve after the new end of the buffer
+   *        when the storage is reallocated
+   */
+  void AddAtEnd (uint32_t end, uint32_t room);
+
   /**
    * \brief Initializes the buffer with a number of zeroes.
    *
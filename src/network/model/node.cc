@@ -77,7 +77,8 @@ Node::GetTypeId (void)
 
 Node::Node()
   : m_id (0),
-    m_sid (0)
+    m_sid (0),
+    m_handlersGeneration (1)
 {
   NS_LOG_FUNCTION (this);
   Construct ();
@@ -85,7 +86,8 @@ Node::Node()
 
 Node::Node(uint32_t sid)
   : m_id (0),
-    m_sid (sid)
+    m_sid (sid),
+    m_handlersGeneration (1)
 { 
   NS_LOG_FUNCTION (this << sid);
   Construct ();
@@ -185,6 +187,8 @@ Node::DoDispose ()
   NS_LOG_FUNCTION (this);
   m_deviceAdditionListeners.clear ();
   m_handlers.clear ();
+  m_promiscHandlers = 0;
+  m_handlerIndex.clear ();
   for (std::vector<Ptr<NetDevice> >::iterator i = m_devices.begin ();
        i != m_devices.end (); i++)
     {
@@ -255,6 +259,7 @@ Node::RegisterProtocolHandler (ProtocolHandler handler,
     }
 
   m_handlers.push_back (entry);
+  ProtocolHandlersChanged ();
 }
 
 void
@@ -267,11 +272,56 @@ Node::UnregisterProtocolHandler (ProtocolHandler handler)
       if (i->handler.IsEqual (handler))
         {
           m_handlers.erase (i);
+          ProtocolHandlersChanged ();
           break;
         }
     }
 }
 
+void
+Node::ProtocolHandlersChanged (void)
+{
+  NS_LOG_FUNCTION (this);
+  // The lists are replaced rather than modified: a packet may be
+  // dispatched to the previous ones by a caller of this method.
+  Ptr<ProtocolHandlerSnapshot> promiscHandlers = Create<ProtocolHandlerSnapshot> ();
+  for (ProtocolHandlerList::const_iterator i = m_handlers.begin ();
+       i != m_handlers.end (); i++)
+    {
+      if (i->promiscuous)
+        {
+          promiscHandlers->handlers.push_back (*i);
+        }
+    }
+  m_promiscHandlers = promiscHandlers;
+  // The index entries are replaced on their next use.
+  m_handlersGeneration++;
+}
+
+Ptr<const Node::ProtocolHandlerSnapshot>
+Node::GetProtocolHandlers (Ptr<NetDevice> device, uint16_t protocol)
+{
+  struct ProtocolHandlerDispatch &dispatch = m_handlerIndex[std::make_pair (PeekPointer (device), protocol)];
+  if (dispatch.generation != m_handlersGeneration)
+    {
+      NS_LOG_LOGIC ("Index the handlers of device " << device << " and protocol " << protocol);
+      Ptr<ProtocolHandlerSnapshot> handlers = Create<ProtocolHandlerSnapshot> ();
+      for (ProtocolHandlerList::const_iterator i = m_handlers.begin ();
+           i != m_handlers.end (); i++)
+        {
+          if (!i->promiscuous
+              && (i->device == 0 || i->device == device)
+              && (i->protocol == 0 || i->protocol == protocol))
+            {
+              handlers->handlers.push_back (*i);
+            }
+        }
+      dispatch.handlers = handlers;
+      dispatch.generation = m_handlersGeneration;
+    }
+  return dispatch.handlers;
+}
+
 bool
 Node::ChecksumEnabled (void)
 {
@@ -308,10 +358,28 @@ Node::ReceiveFromDevice (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16
   NS_LOG_DEBUG ("Node " << GetId () << " ReceiveFromDevice:  dev "
                         << device->GetIfIndex () << " (type=" << device->GetInstanceTypeId ().GetName ()
                         << ") Packet UID " << packet->GetUid ());
+  if (!promiscuous)
+    {
+      // The handlers may change the registered handlers: iterate
+      // the list in use when the packet arrived.
+      Ptr<const ProtocolHandlerSnapshot> handlers = GetProtocolHandlers (device, protocol);
+      for (ProtocolHandlerList::const_iterator i = handlers->handlers.begin ();
+           i != handlers->handlers.end (); i++)
+        {
+          i->handler (device, packet, protocol, from, to, packetType);
+        }
+      return !handlers->handlers.empty ();
+    }
+
   bool found = false;
 
-  for (ProtocolHandlerList::iterator i = m_handlers.begin ();
-       i != m_handlers.end (); i++)
+  Ptr<const ProtocolHandlerSnapshot> promiscHandlers = m_promiscHandlers;
+  if (promiscHandlers == 0)
+    {
+      return false;
+    }
+  for (ProtocolHandlerList::const_iterator i = promiscHandlers->handlers.begin ();
+       i != promiscHandlers->handlers.end (); i++)
     {
       if (i->device == 0 ||
           (i->device != 0 && i->device == device))
@@ -319,11 +387,8 @@ Node::ReceiveFromDevice (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16
           if (i->protocol == 0 || 
               i->protocol == protocol)
             {
-              if (promiscuous == i->promiscuous)
-                {
-                  i->handler (device, packet, protocol, from, to, packetType);
-                  found = true;
-                }
+              i->handler (device, packet, protocol, from, to, packetType);
+              found = true;
             }
         }
     }
@@ -22,10 +22,13 @@
 #define NODE_H
 
 #include <vector>
+#include <map>
+#include <utility>
 
 #include "ns3/object.h"
 #include "ns3/callback.h"
 #include "ns3/ptr.h"
+#include "ns3/simple-ref-count.h"
 #include "ns3/net-device.h"
 
 namespace ns3 {
@@ -279,6 +282,44 @@ private:
 
   /// Typedef for protocol handlers container
   typedef std::vector<struct Node::ProtocolHandlerEntry> ProtocolHandlerList;
+
+  /**
+   * \brief A list of protocol handlers which is replaced, never modified,
+   * once in use.
+   *
+   * A handler may register or unregister handlers while a packet is
+   * dispatched: the dispatch keeps a reference to the list it iterates.
+   */
+  struct ProtocolHandlerSnapshot : public SimpleRefCount<ProtocolHandlerSnapshot> {
+    ProtocolHandlerList handlers; //!< the handlers, in registration order
+  };
+
+  /**
+   * \brief The non-promiscuous handlers of a device and protocol.
+   */
+  struct ProtocolHandlerDispatch {
+    uint32_t generation;                       //!< the value of m_handlersGeneration when computed
+    Ptr<ProtocolHandlerSnapshot> handlers;     //!< the matching handlers
+  };
+  /// Typedef for the index of the non-promiscuous handlers by device and protocol
+  typedef std::map<std::pair<NetDevice *, uint16_t>, struct ProtocolHandlerDispatch> ProtocolHandlerIndex;
+
+  /**
+   * \brief Get the non-promiscuous handlers of a device and protocol.
+   *
+   * The handlers are looked up in m_handlers on first use and after
+   * any change of the registered handlers.
+   *
+   * \param device the device
+   * \param protocol the protocol
+   * \returns the handlers, in registration order
+   */
+  Ptr<const ProtocolHandlerSnapshot> GetProtocolHandlers (Ptr<NetDevice> device, uint16_t protocol);
+  /**
+   * \brief Update the promiscuous handlers and invalidate the index
+   * after a change of m_handlers.
+   */
+  void ProtocolHandlersChanged (void);
   /// Typedef for NetDevice addition listeners container
   typedef std::vector<DeviceAdditionListener> DeviceAdditionListenerList;
 
@@ -287,6 +328,9 @@ private:
   std::vector<Ptr<NetDevice> > m_devices; //!< Devices associated to this node
   std::vector<Ptr<Application> > m_applications; //!< Applications associated to this node
   ProtocolHandlerList m_handlers; //!< Protocol handlers in the node
+  Ptr<ProtocolHandlerSnapshot> m_promiscHandlers; //!< Promiscuous protocol handlers in the node
+  ProtocolHandlerIndex m_handlerIndex; //!< Non-promiscuous protocol handlers by device and protocol
+  uint32_t m_handlersGeneration; //!< Number of changes of the protocol handlers
   DeviceAdditionListenerList m_deviceAdditionListeners; //!< Device addition listeners in the node
 };
 
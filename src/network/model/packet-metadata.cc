@@ -75,25 +75,51 @@ PacketMetadata::ReserveCopy (uint32_t size)
 {
   NS_LOG_FUNCTION (this << size);
   struct PacketMetadata::Data *newData = PacketMetadata::Create (m_used + size);
-  memcpy (newData->m_data, m_data->m_data, m_used);
-  newData->m_dirtyEnd = m_used;
+  /* Copy the items of this packet only, in list order.  The items
+   * of the headers removed from this packet and the items added by
+   * the other packets which share the data are left behind, so the
+   * copy does not grow with the history of the packet.
+   */
+  uint16_t used = 0;
+  uint16_t head = 0xffff;
+  uint16_t tail = 0xffff;
+  uint16_t current = m_head;
+  while (current != 0xffff)
+    {
+      struct PacketMetadata::SmallItem item;
+      PacketMetadata::ExtraItem extraItem;
+      uint32_t read = ReadItems (current, &item, &extraItem);
+      uint8_t *buffer = &newData->m_data[used];
+      memcpy (buffer, &m_data->m_data[current], read);
+      Append16 (0xffff, buffer);
+      Append16 (tail, buffer + 2);
+      if (tail == 0xffff)
+        {
+          head = used;
+        }
+      else
+        {
+          Append16 (used, &newData->m_data[tail]);
+        }
+      tail = used;
+      used += read;
+      if (current == m_tail)
+        {
+          break;
+        }
+      current = item.next;
+    }
+  newData->m_dirtyEnd = used;
   m_data->m_count--;
   if (m_data->m_count == 0) 
     {
       PacketMetadata::Recycle (m_data);
     }
   m_data = newData;
-  if (m_head != 0xffff)
-    {
-      uint8_t *start;
-      NS_ASSERT (m_tail != 0xffff);
-      // clear the next field of the tail
-      start = &m_data->m_data[m_tail];
-      Append16 (0xffff, start);
-      // clear the prev field of the head
-      start = &m_data->m_data[m_head] + 2;
-      Append16 (0xffff, start);
-    }
+  m_head = head;
+  m_tail = tail;
+  m_used = used;
+  m_removedHead = 0xffff;
 }
 void
 PacketMetadata::Reserve (uint32_t size)
@@ -322,6 +348,7 @@ void
 PacketMetadata::UpdateTail (uint16_t written)
 {
   NS_LOG_FUNCTION (this << written);
+  m_removedHead = 0xffff;
   if (m_head == 0xffff)
     {
       NS_ASSERT (m_tail == 0xffff);
@@ -349,6 +376,7 @@ void
 PacketMetadata::UpdateHead (uint16_t written)
 {
   NS_LOG_FUNCTION (this << written);
+  m_removedHead = 0xffff;
   if (m_head == 0xffff)
     {
       NS_ASSERT (m_tail == 0xffff);
@@ -380,17 +408,24 @@ PacketMetadata::AddSmall (const struct PacketMetadata::SmallItem *item)
   uint32_t typeUidSize = GetUleb128Size (item->typeUid);
   uint32_t sizeSize = GetUleb128Size (item->size);
   uint32_t n =  2 + 2 + typeUidSize + sizeSize + 2;
+  uint16_t next = item->next;
+  uint16_t prev = item->prev;
   if (m_used + n > m_data->m_size ||
       (m_head != 0xffff &&
        m_data->m_count != 1 &&
        m_used != m_data->m_dirtyEnd))
     {
+      // the copy moves the head and the tail of the list.
+      bool nextIsHead = next == m_head;
+      bool prevIsTail = prev == m_tail;
       ReserveCopy (n);
+      next = nextIsHead ? m_head : next;
+      prev = prevIsTail ? m_tail : prev;
     }
   uint8_t *buffer = &m_data->m_data[m_used];
-  Append16 (item->next, buffer);
+  Append16 (next, buffer);
   buffer += 2;
-  Append16 (item->prev, buffer);
+  Append16 (prev, buffer);
   buffer += 2;
   AppendValue (item->typeUid, buffer);
   buffer += typeUidSize;
@@ -423,7 +458,12 @@ PacketMetadata::AddBig (uint32_t next, uint32_t prev,
        m_data->m_count != 1 &&
        m_used != m_data->m_dirtyEnd))
     {
+      // the copy moves the head and the tail of the list.
+      bool nextIsHead = next == m_head;
+      bool prevIsTail = prev == m_tail;
       ReserveCopy (n);
+      next = nextIsHead ? m_head : next;
+      prev = prevIsTail ? m_tail : prev;
     }
 
   uint8_t *buffer = &m_data->m_data[m_used];
@@ -458,6 +498,7 @@ PacketMetadata::ReplaceTail (PacketMetadata::SmallItem *item,
                    available);
 
   NS_ASSERT (m_data != 0);
+  m_removedHead = 0xffff;
   /* If the tail we want to replace is located at the end of the data array,
    * and if there is extra room at the end of this array, then, 
    * we can try to use that extra space to avoid falling in the slow
@@ -670,6 +711,41 @@ PacketMetadata::DoAddHeader (uint32_t uid, uint32_t size)
       return;
     }
 
+  if (m_removedHead != 0xffff)
+    {
+      /* Fast path for a header removed and added again, by a
+       * router for instance: the removed item is linked back in
+       * front of the list, which is cheaper than writing a new item
+       * and never copies data shared with other packets.  The item
+       * keeps its chunk uid.
+       */
+      struct PacketMetadata::SmallItem item;
+      struct PacketMetadata::ExtraItem extraItem;
+      uint16_t removed = m_removedHead;
+      m_removedHead = 0xffff;
+      ReadItems (removed, &item, &extraItem);
+      if (item.typeUid == uid &&
+          item.size == size &&
+          item.next == m_head &&
+          m_head != 0xffff)
+        {
+          // another packet sharing the data may have added an item
+          // in front of the current head since then.
+          ReadItems (m_head, &item, &extraItem);
+          if (item.prev == removed)
+            {
+              m_head = removed;
+              if (m_data->m_count > 1)
+                {
+                  // the other packets must not add items in front
+                  // of the current head anymore.
+                  m_data->m_dirtyEnd = 0xffff;
+                }
+              return;
+            }
+        }
+    }
+
   struct PacketMetadata::SmallItem item;
   item.next = m_head;
   item.prev = 0xffff;
@@ -713,10 +789,16 @@ PacketMetadata::RemoveHeader (const Header &header, uint32_t size)
         }
       return;
     }
+  m_removedHead = 0xffff;
   if (m_head + read == m_used)
     {
       m_used = m_head;
     }
+  else if (m_head != m_tail && item.typeUid == uid)
+    {
+      // the item stays valid below m_used: remember it for DoAddHeader.
+      m_removedHead = m_head;
+    }
   if (m_head == m_tail)
     {
       m_head = 0xffff;
@@ -761,6 +843,7 @@ PacketMetadata::RemoveTrailer (const Trailer &trailer, uint32_t size)
       m_metadataSkipped = true;
       return;
     }
+  m_removedHead = 0xffff;
   struct PacketMetadata::SmallItem item;
   struct PacketMetadata::ExtraItem extraItem;
   uint32_t read = ReadItems (m_tail, &item, &extraItem);
@@ -808,6 +891,14 @@ PacketMetadata::AddAtEnd (PacketMetadata const&o)
       m_metadataSkipped = true;
       return;
     }
+  if (&o == this)
+    {
+      // Keep the items of o in place while items are added to this.
+      PacketMetadata copy = o;
+      AddAtEnd (copy);
+      return;
+    }
+  m_removedHead = 0xffff;
   if (m_tail == 0xffff)
     {
       // We have no items so 'AddAtEnd' is 
@@ -897,6 +988,7 @@ PacketMetadata::RemoveAtStart (uint32_t start)
       return;
     }
   NS_ASSERT (m_data != 0);
+  m_removedHead = 0xffff;
   uint32_t leftToRemove = start;
   uint16_t current = m_head;
   while (current != 0xffff && leftToRemove > 0)
@@ -960,6 +1052,7 @@ PacketMetadata::RemoveAtEnd (uint32_t end)
       return;
     }
   NS_ASSERT (m_data != 0);
+  m_removedHead = 0xffff;
 
   uint32_t leftToRemove = end;
   uint16_t current = m_tail;
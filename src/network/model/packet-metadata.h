@@ -590,6 +590,10 @@ public:
   inline void Reserve (uint32_t n);
   /**
    * \brief Reserve space and make a metadata copy
+   *
+   * Only the items of this packet are copied, next to each other,
+   * so the offsets of the head and of the tail of the list change.
+   *
    * \param n space to reserve
    */
   void ReserveCopy (uint32_t n);
@@ -679,6 +683,12 @@ public:
   uint16_t m_head; //!< list head
   uint16_t m_tail; //!< list tail
   uint16_t m_used; //!< used portion
+  /**
+   * The last header removed from the head of the list, which
+   * DoAddHeader links back in place if the same header is added
+   * again, or 0xffff.
+   */
+  uint16_t m_removedHead;
   uint64_t m_packetUid; //!< packet Uid
 };
 
@@ -691,6 +701,7 @@ PacketMetadata::PacketMetadata (uint64_t uid, uint32_t size)
     m_head (0xffff),
     m_tail (0xffff),
     m_used (0),
+    m_removedHead (0xffff),
     m_packetUid (uid)
 {
   memset (m_data->m_data, 0xff, 4);
@@ -704,6 +715,7 @@ PacketMetadata::PacketMetadata (PacketMetadata const &o)
     m_head (o.m_head),
     m_tail (o.m_tail),
     m_used (o.m_used),
+    m_removedHead (o.m_removedHead),
     m_packetUid (o.m_packetUid)
 {
   NS_ASSERT (m_data != 0);
@@ -729,6 +741,7 @@ PacketMetadata::operator = (PacketMetadata const& o)
   m_head = o.m_head;
   m_tail = o.m_tail;
   m_used = o.m_used;
+  m_removedHead = o.m_removedHead;
   m_packetUid = o.m_packetUid;
   return *this;
 }
@@ -26,9 +26,11 @@
 #include "packet-tag-list.h"
 #include "tag-buffer.h"
 #include "tag.h"
+#include "tag-pool.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
 #include <cstring>
+#include <new>
 
 namespace ns3 {
 
@@ -133,7 +135,7 @@ PacketTagList::COWTraverse (Tag & tag, PacketTagList::COWWriter Writer)
       NS_ASSERT (cur != 0);
       NS_ASSERT (cur->count > 1);
       cur->count--;                       // unmerge cur
-      struct TagData * copy = new struct TagData ();
+      struct TagData * copy = CreateTagData ();
       copy->tid = cur->tid;
       copy->count = 1;
       memcpy (copy->data, cur->data, TagData::MAX_SIZE);
@@ -176,8 +178,8 @@ PacketTagList::RemoveWriter (Tag & tag, bool preMerge,
 
   if (preMerge)
     {
-      // found tid before first merge, so delete cur
-      delete cur;
+      // found tid before first merge, so free cur
+      FreeTagData (cur);
     }
   else
     {
@@ -225,7 +227,7 @@ PacketTagList::ReplaceWriter (Tag & tag, bool preMerge,
       // cur is always a merge at this point
       // need to copy, replace, and link past cur
       cur->count--;                     // unmerge cur
-      struct TagData * copy = new struct TagData ();
+      struct TagData * copy = CreateTagData ();
       copy->tid = tag.GetInstanceTypeId ();
       copy->count = 1;
       tag.Serialize (TagBuffer (copy->data,
@@ -249,7 +251,7 @@ PacketTagList::Add (const Tag &tag) const
     {
       NS_ASSERT_MSG (cur->tid != tag.GetInstanceTypeId (), "Error: cannot add the same kind of tag twice.");
     }
-  struct TagData * head = new struct TagData ();
+  struct TagData * head = CreateTagData ();
   head->count = 1;
   head->next = 0;
   head->tid = tag.GetInstanceTypeId ();
@@ -284,5 +286,19 @@ PacketTagList::Head (void) const
   return m_next;
 }
 
+struct PacketTagList::TagData *
+PacketTagList::CreateTagData (void)
+{
+  void *block = TagPool::Allocate (TagPool::PACKET_TAG, sizeof (struct TagData));
+  return new (block) struct TagData ();
+}
+
+void
+PacketTagList::FreeTagData (struct TagData * data)
+{
+  data->~TagData ();
+  TagPool::Deallocate (TagPool::PACKET_TAG, data, sizeof (struct TagData));
+}
+
 } /* namespace ns3 */
 
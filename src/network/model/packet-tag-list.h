@@ -287,6 +287,19 @@ private:
    */
   bool ReplaceWriter (Tag & tag, bool preMerge, struct TagData * cur, struct TagData ** prevNext);
 
+  /**
+   * Allocate a \ref TagData from the TagPool.
+   *
+   * \returns The new \ref TagData, with a zero-filled #TagData::data.
+   */
+  static struct TagData * CreateTagData (void);
+  /**
+   * Return a \ref TagData to the TagPool.
+   *
+   * \param [in] data The \ref TagData to free.
+   */
+  static void FreeTagData (struct TagData * data);
+
   /**
    * Pointer to first \ref TagData on the list
    */
@@ -350,13 +363,13 @@ PacketTagList::RemoveAll (void)
         }
       if (prev != 0) 
         {
-	  delete prev;
+          FreeTagData (prev);
         }
       prev = cur;
     }
   if (prev != 0) 
     {
-      delete prev;
+      FreeTagData (prev);
     }
   m_next = 0;
 }
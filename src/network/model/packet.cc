@@ -364,6 +364,13 @@ Packet::CopyData (std::ostream *os, uint32_t size) const
   return m_buffer.CopyData (os, size);
 }
 
+uint32_t
+Packet::GetSpans (Buffer::Span *spans, uint32_t offset, uint32_t size) const
+{
+  NS_LOG_FUNCTION (this << spans << offset << size);
+  return m_buffer.GetSpans (spans, offset, size);
+}
+
 uint64_t 
 Packet::GetUid (void) const
 {
@@ -413,6 +413,26 @@ public:
    */
   void CopyData (std::ostream *os, uint32_t size) const;
 
+  /**
+   * \brief Get read-only views of the packet contents, without
+   * copying them.
+   *
+   * This is the way to inspect the payload of a received packet
+   * without allocating memory.  Bytes of the zero-filled payload
+   * created by Packet (uint32_t) are reported by spans with a null
+   * data pointer.
+   *
+   * \param spans the output array, with room for Buffer::MAX_SPANS
+   *        spans
+   * \param offset the offset in the packet of the first byte to view
+   * \param size the maximum number of bytes to view
+   * \returns the number of spans stored in the array
+   *
+   * The spans are valid until the packet is modified or destroyed.
+   * \sa Buffer::GetSpans
+   */
+  uint32_t GetSpans (Buffer::Span *spans, uint32_t offset, uint32_t size) const;
+
   /**
    * \brief performs a COW copy of the packet.
    *
@@ -0,0 +1,250 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "tag-pool.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include <atomic>
+
+/**
+ * \file
+ * \ingroup packet
+ * ns3::TagPool implementation.
+ */
+
+/** The maximum number of free blocks kept for each block size. */
+#define FREE_LIST_SIZE 1000
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TagPool");
+
+namespace {
+
+/** The number of free lists, one for each pooled block size. */
+const uint32_t N_FREE_LISTS = TagPool::MAX_POOLED_SIZE / TagPool::GRANULARITY;
+
+/**
+ * \ingroup packet
+ * A free block, linked in place to the next free block of the same size.
+ */
+struct FreeBlock
+{
+  struct FreeBlock *next; //!< The next free block.
+};
+
+/**
+ * \ingroup packet
+ * The free lists of a thread, and the size of their blocks.
+ */
+struct TagPoolCache
+{
+  TagPoolCache ();
+  ~TagPoolCache ();
+  /** Release all the free blocks. */
+  void Trim (void);
+
+  struct FreeBlock *freeList[N_FREE_LISTS];  //!< The free blocks, by size.
+  uint32_t freeCount[N_FREE_LISTS];          //!< The length of each free list.
+  uint64_t pooledBytes;                      //!< The size of the free blocks.
+};
+
+/**
+ * \ingroup packet
+ * The blocks in use, shared by all the threads: a block may be
+ * released by another thread than the one which allocated it, or
+ * after the cache of its thread is destroyed.
+ */
+struct LiveCounters
+{
+  std::atomic<uint64_t> packetTags;     //!< The number of PacketTagList nodes.
+  std::atomic<uint64_t> byteTagBlocks;  //!< The number of ByteTagList blocks.
+  std::atomic<uint64_t> bytes;          //!< The size of the blocks.
+};
+
+/** The blocks in use, zero-initialized before any dynamic initialization. */
+LiveCounters g_live;
+
+/**
+ * Count a block allocated or released.
+ * \param kind The user of the block.
+ * \param size The size of the block.
+ * \param allocated true if the block is allocated, false if released.
+ */
+void
+CountLive (enum TagPool::Kind kind, uint32_t size, bool allocated)
+{
+  std::atomic<uint64_t> &blocks = kind == TagPool::PACKET_TAG ? g_live.packetTags : g_live.byteTagBlocks;
+  if (allocated)
+    {
+      blocks.fetch_add (1, std::memory_order_relaxed);
+      g_live.bytes.fetch_add (size, std::memory_order_relaxed);
+    }
+  else
+    {
+      blocks.fetch_sub (1, std::memory_order_relaxed);
+      g_live.bytes.fetch_sub (size, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * Set when the cache of the calling thread has been destroyed, at
+ * thread exit.  Tags released later, by static objects for instance,
+ * are then returned to the memory allocator.
+ */
+thread_local bool g_destroyed = false;
+
+TagPoolCache::TagPoolCache ()
+{
+  for (uint32_t i = 0; i < N_FREE_LISTS; i++)
+    {
+      freeList[i] = 0;
+      freeCount[i] = 0;
+    }
+  pooledBytes = 0;
+}
+
+TagPoolCache::~TagPoolCache ()
+{
+  Trim ();
+  g_destroyed = true;
+}
+
+void
+TagPoolCache::Trim (void)
+{
+  for (uint32_t i = 0; i < N_FREE_LISTS; i++)
+    {
+      while (freeList[i] != 0)
+        {
+          struct FreeBlock *block = freeList[i];
+          freeList[i] = block->next;
+          delete [] reinterpret_cast<uint8_t *> (block);
+        }
+      freeCount[i] = 0;
+    }
+  pooledBytes = 0;
+}
+
+/**
+ * Get the cache of the calling thread.
+ * \returns The cache, or 0 if it has been destroyed.
+ */
+struct TagPoolCache *
+GetCache (void)
+{
+  if (g_destroyed)
+    {
+      return 0;
+    }
+  static thread_local TagPoolCache cache;
+  return &cache;
+}
+
+} // unnamed namespace
+
+const uint32_t TagPool::GRANULARITY;
+const uint32_t TagPool::MAX_POOLED_SIZE;
+
+uint32_t
+TagPool::GetBlockSize (uint32_t size)
+{
+  if (size > MAX_POOLED_SIZE)
+    {
+      return size;
+    }
+  if (size == 0)
+    {
+      size = 1;
+    }
+  return (size + GRANULARITY - 1) / GRANULARITY * GRANULARITY;
+}
+
+void *
+TagPool::Allocate (enum Kind kind, uint32_t size)
+{
+  NS_LOG_FUNCTION (kind << size);
+  size = GetBlockSize (size);
+  CountLive (kind, size, true);
+  struct TagPoolCache *cache = GetCache ();
+  void *block = 0;
+  if (cache != 0 && size <= MAX_POOLED_SIZE)
+    {
+      uint32_t i = size / GRANULARITY - 1;
+      if (cache->freeList[i] != 0)
+        {
+          struct FreeBlock *head = cache->freeList[i];
+          cache->freeList[i] = head->next;
+          cache->freeCount[i]--;
+          cache->pooledBytes -= size;
+          block = head;
+        }
+    }
+  if (block == 0)
+    {
+      block = new uint8_t [size];
+    }
+  return block;
+}
+
+void
+TagPool::Deallocate (enum Kind kind, void *block, uint32_t size)
+{
+  NS_LOG_FUNCTION (kind << block << size);
+  NS_ASSERT (block != 0);
+  size = GetBlockSize (size);
+  CountLive (kind, size, false);
+  struct TagPoolCache *cache = GetCache ();
+  if (cache != 0 && size <= MAX_POOLED_SIZE)
+    {
+      uint32_t i = size / GRANULARITY - 1;
+      if (cache->freeCount[i] < FREE_LIST_SIZE)
+        {
+          struct FreeBlock *head = static_cast<struct FreeBlock *> (block);
+          head->next = cache->freeList[i];
+          cache->freeList[i] = head;
+          cache->freeCount[i]++;
+          cache->pooledBytes += size;
+          return;
+        }
+    }
+  delete [] static_cast<uint8_t *> (block);
+}
+
+struct TagPool::Statistics
+TagPool::GetStatistics (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  struct TagPoolCache *cache = GetCache ();
+  struct Statistics stats;
+  stats.livePacketTags = g_live.packetTags.load (std::memory_order_relaxed);
+  stats.liveByteTagBlocks = g_live.byteTagBlocks.load (std::memory_order_relaxed);
+  stats.liveBytes = g_live.bytes.load (std::memory_order_relaxed);
+  stats.pooledBytes = cache != 0 ? cache->pooledBytes : 0;
+  return stats;
+}
+
+void
+TagPool::Trim (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  struct TagPoolCache *cache = GetCache ();
+  if (cache != 0)
+    {
+      cache->Trim ();
+    }
+}
+
+} // namespace ns3
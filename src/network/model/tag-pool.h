@@ -0,0 +1,117 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef TAG_POOL_H
+#define TAG_POOL_H
+
+#include <stdint.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup packet
+ *
+ * \brief Pooled storage of packet tags and byte tags.
+ *
+ * The nodes of PacketTagList and the data blocks of ByteTagList are
+ * allocated from free lists of blocks whose sizes are multiples of
+ * TagPool::GRANULARITY bytes, up to TagPool::MAX_POOLED_SIZE bytes.
+ * Larger blocks are allocated and released directly.  A released
+ * block is kept in the free list of its size, so that the next tag
+ * of the same size reuses it without going through the memory
+ * allocator.
+ *
+ * The free lists belong to the calling thread, so that the pool
+ * needs no locking with the multithreaded simulator implementations.
+ * A block may be released by another thread than the one which
+ * allocated it: it then moves to the free lists of the releasing
+ * thread.  The counts of the blocks in use are shared by all the
+ * threads, so that such a block is counted from its allocation to
+ * its release.
+ */
+class TagPool
+{
+public:
+  /**
+   * The users of the pool, for the statistics.
+   */
+  enum Kind
+  {
+    PACKET_TAG, //!< A node of a PacketTagList, which holds one tag.
+    BYTE_TAG    //!< A data block of a ByteTagList, which holds several tags.
+  };
+
+  /**
+   * The granularity of the sizes of the pooled blocks.
+   */
+  static const uint32_t GRANULARITY = 16;
+  /**
+   * The size of the largest pooled blocks.
+   */
+  static const uint32_t MAX_POOLED_SIZE = 512;
+
+  /**
+   * The statistics of the pool: the blocks in use by all the threads,
+   * and the free blocks of the calling thread.
+   */
+  struct Statistics
+  {
+    uint64_t livePacketTags;      //!< The number of PacketTagList nodes in use.
+    uint64_t liveByteTagBlocks;   //!< The number of ByteTagList blocks in use.
+    uint64_t liveBytes;           //!< The size of all the blocks in use.
+    uint64_t pooledBytes;         //!< The size of the blocks kept in the free lists.
+  };
+
+  /**
+   * Allocate a block.
+   *
+   * \param [in] kind The user of the block.
+   * \param [in] size The minimum size of the block.
+   * \returns The new block, of GetBlockSize (\pname{size}) bytes.
+   */
+  static void *Allocate (enum Kind kind, uint32_t size);
+  /**
+   * Release a block.
+   *
+   * \param [in] kind The user of the block, as passed to Allocate.
+   * \param [in] block The block.
+   * \param [in] size The size of the block, either as passed to
+   *            Allocate or as returned by GetBlockSize.
+   */
+  static void Deallocate (enum Kind kind, void *block, uint32_t size);
+  /**
+   * Get the actual size of the blocks allocated for a request.
+   *
+   * \param [in] size The size requested from Allocate.
+   * \returns The size of the block, which may be used in full.
+   */
+  static uint32_t GetBlockSize (uint32_t size);
+  /**
+   * Get the statistics of the pool.
+   *
+   * \returns The blocks in use by all the threads, and the free blocks
+   * of the calling thread.
+   */
+  static struct Statistics GetStatistics (void);
+  /**
+   * Release the free blocks of the calling thread to the memory
+   * allocator.
+   */
+  static void Trim (void);
+};
+
+} // namespace ns3
+
+#endif /* TAG_POOL_H */
@@ -0,0 +1,284 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/packet.h"
+#include "ns3/ethernet-header.h"
+#include "ns3/llc-snap-header.h"
+#include "ns3/mac48-address.h"
+#include "ns3/trace-helper.h"
+#include "ns3/binary-trace-writer.h"
+
+using namespace ns3;
+
+namespace {
+
+/**
+ * Send an event to the default trace sinks of both streams.
+ * \param ascii The ASCII trace stream.
+ * \param binary The binary trace stream.
+ * \param type The event type.
+ * \param context The context, or an empty string for no context.
+ * \param p The packet.
+ */
+void
+TraceEvent (Ptr<OutputStreamWrapper> ascii, Ptr<OutputStreamWrapper> binary,
+            char type, std::string context, Ptr<const Packet> p)
+{
+  Ptr<OutputStreamWrapper> streams[] = { ascii, binary };
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      switch (type)
+        {
+        case '+':
+          if (context.empty ())
+            {
+              AsciiTraceHelper::DefaultEnqueueSinkWithoutContext (streams[i], p);
+            }
+          else
+            {
+              AsciiTraceHelper::DefaultEnqueueSinkWithContext (streams[i], context, p);
+            }
+          break;
+        case '-':
+          if (context.empty ())
+            {
+              AsciiTraceHelper::DefaultDequeueSinkWithoutContext (streams[i], p);
+            }
+          else
+            {
+              AsciiTraceHelper::DefaultDequeueSinkWithContext (streams[i], context, p);
+            }
+          break;
+        case 'd':
+          if (context.empty ())
+            {
+              AsciiTraceHelper::DefaultDropSinkWithoutContext (streams[i], p);
+            }
+          else
+            {
+              AsciiTraceHelper::DefaultDropSinkWithContext (streams[i], context, p);
+            }
+          break;
+        default:
+          if (context.empty ())
+            {
+              AsciiTraceHelper::DefaultReceiveSinkWithoutContext (streams[i], p);
+            }
+          else
+            {
+              AsciiTraceHelper::DefaultReceiveSinkWithContext (streams[i], context, p);
+            }
+          break;
+        }
+    }
+}
+
+/**
+ * Write a line of text to both streams, as a custom sink would.
+ * \param ascii The ASCII trace stream.
+ * \param binary The binary trace stream.
+ * \param text The text.
+ */
+void
+TraceText (Ptr<OutputStreamWrapper> ascii, Ptr<OutputStreamWrapper> binary, std::string text)
+{
+  *ascii->GetStream () << text << " " << Simulator::Now ().GetSeconds () << std::endl;
+  *binary->GetStream () << text << " " << Simulator::Now ().GetSeconds () << std::endl;
+}
+
+/**
+ * Create a packet with an Ethernet and a LLC/SNAP header.
+ * \param size The size of the payload.
+ * \returns The packet.
+ */
+Ptr<Packet>
+CreateTestPacket (uint32_t size)
+{
+  Ptr<Packet> p = Create<Packet> (size);
+  LlcSnapHeader llc;
+  llc.SetType (0x0800);
+  p->AddHeader (llc);
+  EthernetHeader eth (false);
+  eth.SetSource (Mac48Address ("00:00:00:00:00:01"));
+  eth.SetDestination (Mac48Address ("00:00:00:00:00:02"));
+  eth.SetLengthType (p->GetSize ());
+  p->AddHeader (eth);
+  return p;
+}
+
+/**
+ * Decode a binary trace file.
+ * \param filename The name of the file.
+ * \param [out] text The decoded trace.
+ * \returns \c true if the file is a valid binary trace.
+ */
+bool
+Decode (std::string filename, std::string *text)
+{
+  std::ifstream is (filename.c_str (), std::ios::binary);
+  std::ostringstream os;
+  bool ok = BinaryTraceDecode (is, os);
+  *text = os.str ();
+  return ok;
+}
+
+} // anonymous namespace
+
+// ===========================================================================
+// Test case checking that the binary trace of the default sinks decodes to
+// the same text as the ASCII trace, across several compressed blocks.
+// ===========================================================================
+class BinaryTraceDecodeTestCase : public TestCase
+{
+public:
+  BinaryTraceDecodeTestCase ();
+  virtual ~BinaryTraceDecodeTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+BinaryTraceDecodeTestCase::BinaryTraceDecodeTestCase ()
+  : TestCase ("Check that a binary trace decodes to the ASCII trace")
+{
+}
+
+BinaryTraceDecodeTestCase::~BinaryTraceDecodeTestCase ()
+{
+}
+
+void
+BinaryTraceDecodeTestCase::DoRun (void)
+{
+  Packet::EnablePrinting ();
+
+  std::string filename = CreateTempDirFilename ("binary-trace-test.trb");
+  std::ostringstream ascii;
+  Ptr<OutputStreamWrapper> asciiStream = Create<OutputStreamWrapper> (&ascii);
+  AsciiTraceHelper helper;
+  Ptr<OutputStreamWrapper> binaryStream = helper.CreateBinaryFileStream (filename, BinaryTraceWriter::PACKET);
+  NS_TEST_ASSERT_MSG_EQ ((binaryStream->GetBinaryWriter () != 0), true, "No binary writer");
+
+  // Enough events for several blocks.
+  const char types[] = { '+', '-', 'r', 'd' };
+  for (uint32_t i = 0; i < 4000; i++)
+    {
+      std::ostringstream context;
+      if (i % 3 != 0)
+        {
+          context << "/NodeList/" << i % 7 << "/DeviceList/0/$ns3::SimpleNetDevice/TxQueue/Enqueue";
+        }
+      Simulator::Schedule (MicroSeconds (i * 37), &TraceEvent, asciiStream, binaryStream,
+                           types[i % 4], context.str (), CreateTestPacket (i % 1500));
+      if (i % 500 == 0)
+        {
+          Simulator::Schedule (MicroSeconds (i * 37), &TraceText, asciiStream, binaryStream,
+                               "custom");
+        }
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  Ptr<BinaryTraceWriter> writer = binaryStream->GetBinaryWriter ();
+  binaryStream = 0;
+  writer->Flush ();
+  NS_TEST_EXPECT_MSG_LT (writer->GetFileSize (), ascii.str ().size (),
+                         "The binary trace is larger than the ASCII trace");
+  writer = 0;
+
+  std::string decoded;
+  NS_TEST_ASSERT_MSG_EQ (Decode (filename, &decoded), true, "Invalid binary trace");
+  NS_TEST_EXPECT_MSG_EQ (decoded.size (), ascii.str ().size (), "Decoded trace has the wrong size");
+  NS_TEST_EXPECT_MSG_EQ ((decoded == ascii.str ()), true, "Decoded trace differs from the ASCII trace");
+}
+
+// ===========================================================================
+// Test case checking the records stored without the packets, and the
+// detection of invalid files.
+// ===========================================================================
+class BinaryTraceDigestTestCase : public TestCase
+{
+public:
+  BinaryTraceDigestTestCase ();
+  virtual ~BinaryTraceDigestTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+BinaryTraceDigestTestCase::BinaryTraceDigestTestCase ()
+  : TestCase ("Check the binary trace records without packets")
+{
+}
+
+BinaryTraceDigestTestCase::~BinaryTraceDigestTestCase ()
+{
+}
+
+void
+BinaryTraceDigestTestCase::DoRun (void)
+{
+  std::string filename = CreateTempDirFilename ("binary-trace-digest.trb");
+  Ptr<Packet> p = CreateTestPacket (100);
+  Ptr<Packet> q = CreateTestPacket (100);
+  {
+    Ptr<BinaryTraceWriter> writer = Create<BinaryTraceWriter> (filename, BinaryTraceWriter::DIGEST);
+    writer->Write ('+', 0, p);
+    std::string context = "/NodeList/1";
+    writer->Write ('r', &context, q);
+  }
+
+  std::string decoded;
+  NS_TEST_ASSERT_MSG_EQ (Decode (filename, &decoded), true, "Invalid binary trace");
+  std::istringstream lines (decoded);
+  std::string first, second;
+  std::getline (lines, first);
+  std::getline (lines, second);
+  std::ostringstream expected;
+  expected << "+ 0 Packet uid=" << p->GetUid () << " size=" << p->GetSize () << " digest=0x";
+  NS_TEST_EXPECT_MSG_EQ (first.substr (0, expected.str ().size ()), expected.str (), "Wrong summary line");
+  expected.str ("");
+  expected << "r 0 /NodeList/1 Packet uid=" << q->GetUid () << " size=" << q->GetSize () << " digest=0x";
+  NS_TEST_EXPECT_MSG_EQ (second.substr (0, expected.str ().size ()), expected.str (), "Wrong summary line");
+  // Both packets have the same headers and payload.
+  NS_TEST_EXPECT_MSG_EQ (first.substr (first.find ("digest")), second.substr (second.find ("digest")),
+                         "Identical packets have different digests");
+
+  std::istringstream text ("+ 0.1 /NodeList/0 ns3::EthernetHeader");
+  std::ostringstream os;
+  NS_TEST_EXPECT_MSG_EQ (BinaryTraceDecode (text, os), false, "Text accepted as a binary trace");
+}
+
+class BinaryTraceTestSuite : public TestSuite
+{
+public:
+  BinaryTraceTestSuite ();
+};
+
+BinaryTraceTestSuite::BinaryTraceTestSuite ()
+  : TestSuite ("binary-trace", UNIT)
+{
+  AddTestCase (new BinaryTraceDecodeTestCase, TestCase::QUICK);
+  AddTestCase (new BinaryTraceDigestTestCase, TestCase::QUICK);
+}
+
+static BinaryTraceTestSuite g_binaryTraceTestSuite;
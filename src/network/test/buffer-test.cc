@@ -22,6 +22,8 @@
 #include "ns3/random-variable-stream.h"
 #include "ns3/double.h"
 #include "ns3/test.h"
+#include <vector>
+#include <algorithm>
 
 using namespace ns3;
 
@@ -360,6 +362,241 @@ BufferTest::DoRun (void)
   val2 |= i.ReadU8 ();
   NS_TEST_ASSERT_MSG_EQ (val1, val2, "Bad ReadNtohU16()");
 }
+//-----------------------------------------------------------------------------
+// Check the content of buffers built by successive AddAtEnd (Buffer)
+// and AddAtStart calls, including zero areas and shared storage.
+class BufferAppendTest : public TestCase {
+private:
+  /**
+   * Create a buffer with real bytes around a zero area.
+   * \param seed the value of the first real byte
+   * \param zeroes the size of the zero area
+   * \param expected the content of the new buffer is appended here
+   * \returns the new buffer
+   */
+  Buffer Create (uint8_t seed, uint32_t zeroes, std::vector<uint8_t> &expected);
+  /**
+   * Check the content of a buffer.
+   * \param b the buffer
+   * \param expected its expected content
+   * \param msg the message of the failed checks
+   */
+  void Check (const Buffer &b, const std::vector<uint8_t> &expected, const char *msg);
+public:
+  virtual void DoRun (void);
+  BufferAppendTest ();
+};
+
+BufferAppendTest::BufferAppendTest ()
+  : TestCase ("Buffer::AddAtEnd (Buffer)") {
+}
+
+Buffer
+BufferAppendTest::Create (uint8_t seed, uint32_t zeroes, std::vector<uint8_t> &expected)
+{
+  Buffer b (zeroes);
+  b.AddAtStart (3);
+  b.AddAtEnd (2);
+  Buffer::Iterator i = b.Begin ();
+  for (uint32_t j = 0; j < 3; j++)
+    {
+      i.WriteU8 (seed + j);
+      expected.push_back (seed + j);
+    }
+  expected.insert (expected.end (), zeroes, 0);
+  i.Next (zeroes);
+  i.WriteU8 (seed + 3);
+  i.WriteU8 (seed + 4);
+  expected.push_back (seed + 3);
+  expected.push_back (seed + 4);
+  return b;
+}
+
+void
+BufferAppendTest::Check (const Buffer &b, const std::vector<uint8_t> &expected, const char *msg)
+{
+  NS_TEST_ASSERT_MSG_EQ (b.GetSize (), expected.size (), msg);
+  std::vector<uint8_t> actual (b.GetSize () + 1);
+  b.CopyData (&actual[0], b.GetSize ());
+  actual.resize (b.GetSize ());
+  NS_TEST_EXPECT_MSG_EQ ((actual == expected), true, msg);
+}
+
+void
+BufferAppendTest::DoRun (void)
+{
+  std::vector<uint8_t> expected;
+  Buffer buffer = Create (0x10, 7, expected);
+  std::vector<uint8_t> firstExpected = expected;
+  Buffer first = buffer;
+
+  // Grow by successive additions of buffers with zero areas.
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      Buffer chunk = Create (0x20 + i, i % 5, expected);
+      buffer.AddAtEnd (chunk);
+    }
+  Check (buffer, expected, "Bad content after successive additions");
+  // The copy taken before the additions is unchanged.
+  Check (first, firstExpected, "Shared buffer modified by AddAtEnd");
+
+  // Additions to two buffers sharing the same storage.
+  Buffer other = buffer;
+  std::vector<uint8_t> otherExpected = expected;
+  buffer.AddAtEnd (Create (0x40, 2, expected));
+  other.AddAtEnd (Create (0x50, 1, otherExpected));
+  Check (buffer, expected, "Bad content of the first sharing buffer");
+  Check (other, otherExpected, "Bad content of the second sharing buffer");
+
+  // Addition of a buffer to itself.
+  std::vector<uint8_t> otherCopy = otherExpected;
+  otherExpected.insert (otherExpected.end (), otherCopy.begin (), otherCopy.end ());
+  other.AddAtEnd (other);
+  Check (other, otherExpected, "Bad content after adding a buffer to itself");
+
+  // Headers added after a reallocation.
+  first.AddAtStart (4);
+  first.Begin ().WriteHtonU32 (0x01020304);
+  uint8_t header[] = { 0x01, 0x02, 0x03, 0x04 };
+  firstExpected.insert (firstExpected.begin (), header, header + 4);
+  first.AddAtStart (1);
+  first.Begin ().WriteU8 (0xff);
+  firstExpected.insert (firstExpected.begin (), 0xff);
+  Check (first, firstExpected, "Bad content after AddAtStart");
+}
+
+//-----------------------------------------------------------------------------
+// Check that the spans returned by Buffer::GetSpans cover the same
+// bytes as Buffer::CopyData, for all the ranges of a buffer with real
+// bytes on both sides of a zero area.
+class BufferSpanTest : public TestCase {
+public:
+  virtual void DoRun (void);
+  BufferSpanTest ();
+};
+
+BufferSpanTest::BufferSpanTest ()
+  : TestCase ("Buffer::GetSpans") {
+}
+
+void
+BufferSpanTest::DoRun (void)
+{
+  Buffer buffer (6);
+  buffer.AddAtStart (3);
+  buffer.AddAtEnd (4);
+  Buffer::Iterator i = buffer.Begin ();
+  i.WriteU8 (1);
+  i.WriteU8 (2);
+  i.WriteU8 (3);
+  i.Next (6);
+  i.WriteU8 (4);
+  i.WriteU8 (5);
+  i.WriteU8 (6);
+  i.WriteU8 (7);
+
+  uint32_t size = buffer.GetSize ();
+  std::vector<uint8_t> expected (size);
+  buffer.CopyData (&expected[0], size);
+
+  Buffer::Span spans[Buffer::MAX_SPANS];
+  NS_TEST_ASSERT_MSG_EQ (buffer.GetSpans (spans, 0, size), 3, "Wrong number of spans");
+  NS_TEST_ASSERT_MSG_EQ (spans[0].size, 3, "Wrong size of the first span");
+  NS_TEST_ASSERT_MSG_EQ ((spans[1].data == 0), true, "Zero area not reported");
+  NS_TEST_ASSERT_MSG_EQ (spans[1].size, 6, "Wrong size of the zero area span");
+  NS_TEST_ASSERT_MSG_EQ (spans[2].size, 4, "Wrong size of the last span");
+  NS_TEST_ASSERT_MSG_EQ (buffer.GetSpans (spans, size, 10), 0, "Spans past the end");
+
+  for (uint32_t offset = 0; offset <= size; offset++)
+    {
+      for (uint32_t length = 0; length <= size + 1; length++)
+        {
+          uint32_t n = buffer.GetSpans (spans, offset, length);
+          std::vector<uint8_t> actual;
+          for (uint32_t j = 0; j < n; j++)
+            {
+              NS_TEST_ASSERT_MSG_GT (spans[j].size, 0, "Empty span");
+              if (spans[j].data == 0)
+                {
+                  actual.insert (actual.end (), spans[j].size, 0);
+                }
+              else
+                {
+                  actual.insert (actual.end (), spans[j].data, spans[j].data + spans[j].size);
+                }
+            }
+          uint32_t last = std::min (offset + length, size);
+          std::vector<uint8_t> range (expected.begin () + offset, expected.begin () + last);
+          NS_TEST_ASSERT_MSG_EQ ((actual == range), true,
+                                 "Bad spans for offset=" << offset << " length=" << length);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Check Buffer::Iterator::CalculateIpChecksum against a sum of the words
+// read one at a time, for all the ranges of a buffer with real bytes on
+// both sides of a zero area, which start and end at odd offsets.
+class BufferChecksumTest : public TestCase {
+public:
+  virtual void DoRun (void);
+  BufferChecksumTest ();
+};
+
+BufferChecksumTest::BufferChecksumTest ()
+  : TestCase ("Buffer::Iterator::CalculateIpChecksum") {
+}
+
+void
+BufferChecksumTest::DoRun (void)
+{
+  Buffer buffer (13);
+  buffer.AddAtStart (21);
+  buffer.AddAtEnd (35);
+  Buffer::Iterator i = buffer.Begin ();
+  for (uint32_t j = 0; j < 21; j++)
+    {
+      i.WriteU8 (0x80 + 7 * j);
+    }
+  i.Next (13);
+  for (uint32_t j = 0; j < 35; j++)
+    {
+      i.WriteU8 (0xf1 - 3 * j);
+    }
+
+  uint32_t size = buffer.GetSize ();
+  std::vector<uint8_t> bytes (size);
+  buffer.CopyData (&bytes[0], size);
+
+  for (uint32_t offset = 0; offset < size; offset++)
+    {
+      for (uint32_t length = 0; offset + length <= size; length++)
+        {
+          uint32_t sum = 0x1234;
+          for (uint32_t j = 0; j + 1 < length; j += 2)
+            {
+              sum += bytes[offset + j] | (bytes[offset + j + 1] << 8);
+            }
+          if (length & 1)
+            {
+              sum += bytes[offset + length - 1];
+            }
+          while (sum >> 16)
+            {
+              sum = (sum & 0xffff) + (sum >> 16);
+            }
+          uint16_t expected = ~sum;
+
+          i = buffer.Begin ();
+          i.Next (offset);
+          NS_TEST_ASSERT_MSG_EQ (i.CalculateIpChecksum (length, 0x1234), expected,
+                                 "Bad checksum for offset=" << offset << " length=" << length);
+          NS_TEST_ASSERT_MSG_EQ (i.GetRemainingSize (), size - offset - length,
+                                 "Iterator not moved past the range");
+        }
+    }
+}
+
 //-----------------------------------------------------------------------------
 class BufferTestSuite : public TestSuite
 {
@@ -371,6 +608,9 @@ BufferTestSuite::BufferTestSuite ()
   : TestSuite ("buffer", UNIT)
 {
   AddTestCase (new BufferTest, TestCase::QUICK);
+  AddTestCase (new BufferAppendTest, TestCase::QUICK);
+  AddTestCase (new BufferSpanTest, TestCase::QUICK);
+  AddTestCase (new BufferChecksumTest, TestCase::QUICK);
 }
 
 static BufferTestSuite g_bufferTestSuite;
@@ -19,6 +19,8 @@
 #include "ns3/test.h"
 #include "ns3/drop-tail-queue.h"
 #include "ns3/uinteger.h"
+#include "ns3/enum.h"
+#include <vector>
 
 using namespace ns3;
 
@@ -77,6 +79,68 @@ DropTailQueueTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ ((item == 0), true, "There are really no packets in there");
 }
 
+class DropTailQueueRingTestCase : public TestCase
+{
+public:
+  DropTailQueueRingTestCase ();
+  virtual void DoRun (void);
+};
+
+DropTailQueueRingTestCase::DropTailQueueRingTestCase ()
+  : TestCase ("Check the order of the items across ring buffer wrap-arounds and growth")
+{
+}
+void
+DropTailQueueRingTestCase::DoRun (void)
+{
+  // Packet mode: the ring is full and wraps around many times.
+  Ptr<DropTailQueue> queue = CreateObject<DropTailQueue> ();
+  queue->SetAttribute ("MaxPackets", UintegerValue (5));
+  std::vector<Ptr<Packet> > packets;
+  uint32_t next = 0;
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      packets.push_back (Create<Packet> (i));
+      queue->Enqueue (Create<QueueItem> (packets.back ()));
+      if (i % 3 != 0)
+        {
+          packets.push_back (Create<Packet> (i));
+          queue->Enqueue (Create<QueueItem> (packets.back ()));
+        }
+      while (queue->GetNPackets () > 3)
+        {
+          Ptr<QueueItem> item = queue->Dequeue ();
+          NS_TEST_ASSERT_MSG_EQ (item->GetPacket (), packets[next], "Packet " << next << " out of order");
+          next++;
+        }
+      NS_TEST_ASSERT_MSG_EQ (queue->Peek ()->GetPacket (), packets[next], "Wrong packet at the head");
+    }
+
+  // Byte mode: the ring grows while items wrap around.
+  queue = CreateObject<DropTailQueue> ();
+  queue->SetAttribute ("Mode", EnumValue (Queue::QUEUE_MODE_BYTES));
+  queue->SetAttribute ("MaxBytes", UintegerValue (1000000));
+  packets.clear ();
+  next = 0;
+  for (uint32_t i = 0; i < 1000; i++)
+    {
+      packets.push_back (Create<Packet> (10));
+      NS_TEST_ASSERT_MSG_EQ (queue->Enqueue (Create<QueueItem> (packets.back ())), true, "Packet " << i << " dropped");
+      if (i % 4 == 0)
+        {
+          NS_TEST_ASSERT_MSG_EQ (queue->Remove ()->GetPacket (), packets[next], "Packet " << next << " out of order");
+          next++;
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 750, "Wrong number of packets");
+  while (!queue->IsEmpty ())
+    {
+      NS_TEST_ASSERT_MSG_EQ (queue->Dequeue ()->GetPacket (), packets[next], "Packet " << next << " out of order");
+      next++;
+    }
+  NS_TEST_EXPECT_MSG_EQ (next, 1000, "Packets lost");
+}
+
 static class DropTailQueueTestSuite : public TestSuite
 {
 public:
@@ -84,5 +148,6 @@ public:
     : TestSuite ("drop-tail-queue", UNIT)
   {
     AddTestCase (new DropTailQueueTestCase (), TestCase::QUICK);
+    AddTestCase (new DropTailQueueRingTestCase (), TestCase::QUICK);
   }
 } g_dropTailQueueTestSuite;
@@ -0,0 +1,164 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <string>
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/mac48-address.h"
+
+using namespace ns3;
+
+// ===========================================================================
+// Test case checking which protocol handlers of a node are called, and in
+// which order, for the device and protocol of the received frames.
+// ===========================================================================
+class NodeProtocolHandlerTestCase : public TestCase
+{
+public:
+  NodeProtocolHandlerTestCase ();
+  virtual ~NodeProtocolHandlerTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Record a handler call.
+   * \param name The name of the handler.
+   * \param device The receiving device.
+   * \param packet The packet.
+   * \param protocol The protocol number.
+   * \param from The source address.
+   * \param to The destination address.
+   * \param type The packet type.
+   */
+  void Handle (std::string name, Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol,
+               const Address &from, const Address &to, NetDevice::PacketType type);
+
+  /**
+   * Deliver a frame to a device, in the context of its node.
+   * \param device The receiving device.
+   * \param protocol The protocol number.
+   * \param to The destination address.
+   * \returns The names of the handlers called.
+   */
+  std::string Receive (Ptr<SimpleNetDevice> device, uint16_t protocol, Mac48Address to);
+
+  /**
+   * Deliver a frame to a device.
+   * \param device The receiving device.
+   * \param protocol The protocol number.
+   * \param to The destination address.
+   */
+  void DoReceive (Ptr<SimpleNetDevice> device, uint16_t protocol, Mac48Address to);
+
+  std::string m_calls;  //!< The names of the handlers called.
+};
+
+NodeProtocolHandlerTestCase::NodeProtocolHandlerTestCase ()
+  : TestCase ("Check the dispatch of received frames to the protocol handlers")
+{
+}
+
+NodeProtocolHandlerTestCase::~NodeProtocolHandlerTestCase ()
+{
+}
+
+void
+NodeProtocolHandlerTestCase::Handle (std::string name, Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol,
+                                     const Address &from, const Address &to, NetDevice::PacketType type)
+{
+  m_calls += name;
+}
+
+void
+NodeProtocolHandlerTestCase::DoReceive (Ptr<SimpleNetDevice> device, uint16_t protocol, Mac48Address to)
+{
+  device->Receive (Create<Packet> (10), protocol, to, Mac48Address ("00:00:00:00:00:99"));
+}
+
+std::string
+NodeProtocolHandlerTestCase::Receive (Ptr<SimpleNetDevice> device, uint16_t protocol, Mac48Address to)
+{
+  m_calls.clear ();
+  Simulator::ScheduleWithContext (device->GetNode ()->GetId (), Seconds (0),
+                                  &NodeProtocolHandlerTestCase::DoReceive, this, device, protocol, to);
+  Simulator::Run ();
+  return m_calls;
+}
+
+void
+NodeProtocolHandlerTestCase::DoRun (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<SimpleNetDevice> dev0 = CreateObject<SimpleNetDevice> ();
+  Ptr<SimpleNetDevice> dev1 = CreateObject<SimpleNetDevice> ();
+  Mac48Address addr0 ("00:00:00:00:00:01");
+  Mac48Address addr1 ("00:00:00:00:00:02");
+  dev0->SetAddress (addr0);
+  dev1->SetAddress (addr1);
+  node->AddDevice (dev0);
+  node->AddDevice (dev1);
+
+  Node::ProtocolHandler a = MakeCallback (&NodeProtocolHandlerTestCase::Handle, this).Bind (std::string ("a"));
+  Node::ProtocolHandler b = MakeCallback (&NodeProtocolHandlerTestCase::Handle, this).Bind (std::string ("b"));
+  Node::ProtocolHandler c = MakeCallback (&NodeProtocolHandlerTestCase::Handle, this).Bind (std::string ("c"));
+  Node::ProtocolHandler d = MakeCallback (&NodeProtocolHandlerTestCase::Handle, this).Bind (std::string ("d"));
+  Node::ProtocolHandler p = MakeCallback (&NodeProtocolHandlerTestCase::Handle, this).Bind (std::string ("p"));
+
+  node->RegisterProtocolHandler (a, 0x0800, dev0);
+  node->RegisterProtocolHandler (b, 0, 0);
+  node->RegisterProtocolHandler (c, 0x0800, 0);
+  node->RegisterProtocolHandler (d, 0x0806, dev1);
+
+  NS_TEST_EXPECT_MSG_EQ (Receive (dev0, 0x0800, addr0), "abc", "Wrong handlers for IPv4 on device 0");
+  NS_TEST_EXPECT_MSG_EQ (Receive (dev1, 0x0800, addr1), "bc", "Wrong handlers for IPv4 on device 1");
+  NS_TEST_EXPECT_MSG_EQ (Receive (dev1, 0x0806, addr1), "bd", "Wrong handlers for ARP on device 1");
+  NS_TEST_EXPECT_MSG_EQ (Receive (dev0, 0x0806, addr0), "b", "Wrong handlers for ARP on device 0");
+
+  // Frames for other hosts only reach the promiscuous handlers.
+  node->RegisterProtocolHandler (p, 0x0800, dev0, true);
+  NS_TEST_EXPECT_MSG_EQ (Receive (dev0, 0x0800, addr0), "abcp", "Wrong handlers for IPv4 on device 0");
+  NS_TEST_EXPECT_MSG_EQ (Receive (dev0, 0x0800, addr1), "p", "Wrong handlers for another host");
+  NS_TEST_EXPECT_MSG_EQ (Receive (dev0, 0x0806, addr1), "", "Wrong handlers for another host");
+
+  // The handlers registered and unregistered after the first frames count.
+  node->UnregisterProtocolHandler (b);
+  node->RegisterProtocolHandler (b, 0x0800, dev0);
+  NS_TEST_EXPECT_MSG_EQ (Receive (dev0, 0x0800, addr0), "acbp", "Wrong handlers after re-registration");
+  NS_TEST_EXPECT_MSG_EQ (Receive (dev0, 0x0806, addr0), "", "Wrong handlers after unregistration");
+  node->UnregisterProtocolHandler (p);
+  NS_TEST_EXPECT_MSG_EQ (Receive (dev0, 0x0800, addr1), "", "Promiscuous handler not unregistered");
+
+  Simulator::Destroy ();
+}
+
+class NodeProtocolHandlerTestSuite : public TestSuite
+{
+public:
+  NodeProtocolHandlerTestSuite ();
+};
+
+NodeProtocolHandlerTestSuite::NodeProtocolHandlerTestSuite ()
+  : TestSuite ("node-protocol-handler", UNIT)
+{
+  AddTestCase (new NodeProtocolHandlerTestCase, TestCase::QUICK);
+}
+
+static NodeProtocolHandlerTestSuite g_nodeProtocolHandlerTestSuite;
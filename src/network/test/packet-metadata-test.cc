@@ -821,6 +821,46 @@ PacketMetadataTest::DoRun (void)
                                  p3->GetSize ());
   delete [] buf;
   NS_TEST_EXPECT_MSG_EQ (msg, std::string ("hello world"), "Could not find original data in received packet");
+
+  // Headers removed and added again, as by a router, while copies
+  // of the packet share its metadata.
+  p = Create<Packet> (10);
+  ADD_HEADER (p, 8);
+  ADD_HEADER (p, 20);
+  ADD_TRAILER (p, 4);
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      p1 = p->Copy ();
+      REM_HEADER (p, 20);
+      ADD_HEADER (p, 20);
+      ADD_HEADER (p, 2);
+      CHECK_HISTORY (p, 5, 2, 20, 8, 10, 4);
+      REM_HEADER (p, 2);
+      CHECK_HISTORY (p1, 4, 20, 8, 10, 4);
+    }
+  CHECK_HISTORY (p, 4, 20, 8, 10, 4);
+
+  REM_HEADER (p, 20);
+  p1 = p->Copy ();
+  ADD_HEADER (p, 20);
+  ADD_HEADER (p1, 30);
+  CHECK_HISTORY (p, 4, 20, 8, 10, 4);
+  CHECK_HISTORY (p1, 4, 30, 8, 10, 4);
+  p->RemoveAtEnd (4);
+  CHECK_HISTORY (p, 3, 20, 8, 10);
+  p1->RemoveAtEnd (4);
+  CHECK_HISTORY (p1, 3, 30, 8, 10);
+
+  p = Create<Packet> (10);
+  ADD_HEADER (p, 8);
+  ADD_HEADER (p, 20);
+  ADD_TRAILER (p, 4);
+  REM_HEADER (p, 20);
+  ADD_HEADER (p, 21);
+  CHECK_HISTORY (p, 4, 21, 8, 10, 4);
+  REM_HEADER (p, 21);
+  p->AddAtEnd (p);
+  CHECK_HISTORY (p, 6, 8, 10, 4, 8, 10, 4);
 }
 //-----------------------------------------------------------------------------
 class PacketMetadataTestSuite : public TestSuite
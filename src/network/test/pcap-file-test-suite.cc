@@ -20,11 +20,13 @@
 #include <cstdio>
 #include <cstdlib>
 #include <sstream>
+#include <fstream>
 #include <cstring>
 
 #include "ns3/log.h"
 #include "ns3/test.h"
 #include "ns3/pcap-file.h"
+#include "ns3/pcap-mapped-file.h"
 
 using namespace ns3;
 
@@ -1097,7 +1099,7 @@ DiffTestCase::DoRun (void)
   //
   // Create different PCAP file (with the same timestamps, but different packets) and check that it is indeed different 
   //
-  std::string filename2 = "different.pcap";
+  std::string filename2 = CreateTempDirFilename ("different.pcap");
   PcapFile f;
 
   f.Open (filename2, std::ios::out);
@@ -1121,6 +1123,213 @@ DiffTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (usec, 3696, "Files are different from 2.3696 seconds");
 }
 
+// ===========================================================================
+// Test case to make sure that the PcapMappedFile reads the same records as
+// PcapFile, in both byte orders and timestamp resolutions
+// ===========================================================================
+class MappedReadTestCase : public TestCase
+{
+public:
+  MappedReadTestCase ();
+
+private:
+  virtual void DoSetup (void);
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  std::string m_testFilename;
+};
+
+MappedReadTestCase::MappedReadTestCase ()
+  : TestCase ("Check that PcapMappedFile reads the records in place")
+{
+}
+
+void
+MappedReadTestCase::DoSetup (void)
+{
+  m_testFilename = CreateTempDirFilename ("pcap-mapped.pcap");
+}
+
+void
+MappedReadTestCase::DoTeardown (void)
+{
+  remove (m_testFilename.c_str ());
+}
+
+void
+MappedReadTestCase::DoRun (void)
+{
+  PcapMappedFile m;
+  m.Open (CreateTempDirFilename ("does-not-exist.pcap"));
+  NS_TEST_ASSERT_MSG_EQ (m.Fail (), true, "Open (non-existing-filename) does not return error");
+
+  //
+  // The records of the known good pcap file are the same through both readers.
+  //
+  std::string filename = CreateDataDirFilename ("known.pcap");
+  m.Open (filename);
+  NS_TEST_ASSERT_MSG_EQ (m.Fail (), false, "Open (" << filename << ") returns error");
+  NS_TEST_ASSERT_MSG_EQ (m.GetMagic (), 0xa1b2c3d4, "Incorrect magic number");
+  NS_TEST_ASSERT_MSG_EQ (m.GetSwapMode (), false, "Incorrect swap mode");
+  NS_TEST_ASSERT_MSG_EQ (m.IsNanoSecMode (), false, "Incorrect nanosecond mode");
+  NS_TEST_ASSERT_MSG_EQ (m.GetDataLinkType (), 1, "Incorrect data link type");
+  NS_TEST_ASSERT_MSG_EQ (m.GetSnapLen (), 65535, "Incorrect snap length");
+
+  PcapFile f;
+  f.Open (filename, std::ios::in);
+  uint8_t data[2000];
+  uint32_t tsSec, tsUsec, inclLen, origLen, readLen;
+  PcapMappedFile::Record record;
+  for (uint32_t i = 0; i < N_KNOWN_PACKETS; ++i)
+    {
+      PacketEntry const & p = knownPackets[i];
+      f.Read (data, sizeof(data), tsSec, tsUsec, inclLen, origLen, readLen);
+
+      NS_TEST_ASSERT_MSG_EQ (m.Read (&record), true, "Read() of known good pcap file returns error");
+      NS_TEST_ASSERT_MSG_EQ (record.tsSec, p.tsSec, "Incorrectly read seconds timestap from known good pcap file");
+      NS_TEST_ASSERT_MSG_EQ (record.tsUsec, p.tsUsec, "Incorrectly read microseconds timestap from known good pcap file");
+      NS_TEST_ASSERT_MSG_EQ (record.inclLen, p.inclLen, "Incorrectly read included length from known good packet");
+      NS_TEST_ASSERT_MSG_EQ (record.origLen, p.origLen, "Incorrectly read original length from known good packet");
+      NS_TEST_ASSERT_MSG_EQ (std::memcmp (record.data, data, inclLen), 0, "Incorrect data from known good packet");
+    }
+  NS_TEST_ASSERT_MSG_EQ (m.Read (&record), false, "Read() of known good pcap file at EOF does not return error");
+  NS_TEST_ASSERT_MSG_EQ (m.Eof (), true, "Read() of known good pcap file at EOF does not set eof");
+  NS_TEST_ASSERT_MSG_EQ (m.Fail (), false, "Read() of known good pcap file at EOF sets fail");
+
+  m.Rewind ();
+  NS_TEST_ASSERT_MSG_EQ (m.Read (&record), true, "Read() after Rewind() returns error");
+  NS_TEST_ASSERT_MSG_EQ (record.tsUsec, knownPackets[0].tsUsec, "Rewind() does not go back to the first record");
+  m.Close ();
+
+  //
+  // Swapped files with nanosecond timestamps are converted to the host order.
+  //
+  f.Close ();
+  f.Open (m_testFilename, std::ios::out);
+  f.Init (1234, 5678, 7, true, true);
+  for (uint32_t i = 0; i < N_KNOWN_PACKETS; ++i)
+    {
+      PacketEntry const & p = knownPackets[i];
+      f.Write (p.tsSec, p.tsUsec * 1000, (uint8_t const *)p.data, sizeof (p.data));
+    }
+  f.Close ();
+
+  m.Open (m_testFilename);
+  NS_TEST_ASSERT_MSG_EQ (m.Fail (), false, "Open (" << m_testFilename << ") returns error");
+  NS_TEST_ASSERT_MSG_EQ (m.GetSwapMode (), true, "Incorrect swap mode");
+  NS_TEST_ASSERT_MSG_EQ (m.IsNanoSecMode (), true, "Incorrect nanosecond mode");
+  NS_TEST_ASSERT_MSG_EQ (m.GetDataLinkType (), 1234, "Incorrect data link type");
+  NS_TEST_ASSERT_MSG_EQ (m.GetSnapLen (), 5678, "Incorrect snap length");
+  NS_TEST_ASSERT_MSG_EQ (m.GetTimeZoneOffset (), 7, "Incorrect time zone offset");
+  for (uint32_t i = 0; i < N_KNOWN_PACKETS; ++i)
+    {
+      PacketEntry const & p = knownPackets[i];
+      NS_TEST_ASSERT_MSG_EQ (m.Read (&record), true, "Read() of swapped pcap file returns error");
+      NS_TEST_ASSERT_MSG_EQ (record.tsSec, p.tsSec, "Incorrectly read seconds timestap from swapped pcap file");
+      NS_TEST_ASSERT_MSG_EQ (record.tsUsec, p.tsUsec * 1000, "Incorrectly read nanoseconds timestap from swapped pcap file");
+      NS_TEST_ASSERT_MSG_EQ (record.inclLen, sizeof (p.data), "Incorrectly read included length from swapped pcap file");
+      NS_TEST_ASSERT_MSG_EQ (std::memcmp (record.data, p.data, sizeof (p.data)), 0, "Incorrect data from swapped pcap file");
+    }
+  NS_TEST_ASSERT_MSG_EQ (m.Read (&record), false, "Read() of swapped pcap file at EOF does not return error");
+}
+
+// ===========================================================================
+// Test case to make sure that the buffered writes produce the same file as
+// the direct writes
+// ===========================================================================
+class BufferedWriteTestCase : public TestCase
+{
+public:
+  BufferedWriteTestCase ();
+
+private:
+  virtual void DoSetup (void);
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  /**
+   * Write the known packets several times to a file.
+   * \param filename The name of the file.
+   * \param bufferSize The size of the write buffer.
+   */
+  void WriteFile (std::string const &filename, uint32_t bufferSize);
+
+  std::string m_directFilename;
+  std::string m_bufferedFilename;
+};
+
+BufferedWriteTestCase::BufferedWriteTestCase ()
+  : TestCase ("Check that PcapFile buffered writes produce the same file as direct writes")
+{
+}
+
+void
+BufferedWriteTestCase::DoSetup (void)
+{
+  m_directFilename = CreateTempDirFilename ("pcap-direct.pcap");
+  m_bufferedFilename = CreateTempDirFilename ("pcap-buffered.pcap");
+}
+
+void
+BufferedWriteTestCase::DoTeardown (void)
+{
+  remove (m_directFilename.c_str ());
+  remove (m_bufferedFilename.c_str ());
+}
+
+void
+BufferedWriteTestCase::WriteFile (std::string const &filename, uint32_t bufferSize)
+{
+  PcapFile f;
+  f.Open (filename, std::ios::out);
+  NS_TEST_ASSERT_MSG_EQ (f.Fail (), false, "Open (" << filename << ", \"std::ios::out\") returns error");
+  f.Init (1, N_PACKET_BYTES);
+  f.SetBufferSize (bufferSize);
+  NS_TEST_ASSERT_MSG_EQ (f.GetBufferSize (), bufferSize, "Buffer size not set");
+
+  for (uint32_t round = 0; round < 100; ++round)
+    {
+      for (uint32_t i = 0; i < N_KNOWN_PACKETS; ++i)
+        {
+          PacketEntry const & p = knownPackets[i];
+          f.Write (p.tsSec + round, p.tsUsec, (uint8_t const *)p.data, p.origLen);
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (f.Fail (), false, "Write must not fail");
+
+  //
+  // Every record is in the file once flushed.
+  //
+  f.Flush ();
+  NS_TEST_ASSERT_MSG_EQ (CheckFileLength (filename, 24 + 100 * N_KNOWN_PACKETS * (16 + N_PACKET_BYTES)), true,
+                         "Flush () does not write all the records of " << filename);
+  f.Close ();
+}
+
+void
+BufferedWriteTestCase::DoRun (void)
+{
+  WriteFile (m_directFilename, 0);
+  //
+  // A buffer smaller than a record is handed to the writer after each record,
+  // a larger one after a few records.
+  //
+  for (uint32_t bufferSize = 1; bufferSize <= 1000; bufferSize *= 10)
+    {
+      WriteFile (m_bufferedFilename, bufferSize);
+
+      std::ifstream direct (m_directFilename.c_str (), std::ios::binary);
+      std::ifstream buffered (m_bufferedFilename.c_str (), std::ios::binary);
+      std::ostringstream directData;
+      std::ostringstream bufferedData;
+      directData << direct.rdbuf ();
+      bufferedData << buffered.rdbuf ();
+      NS_TEST_ASSERT_MSG_EQ ((directData.str () == bufferedData.str ()), true,
+                             "Buffered writes with a " << bufferSize << " bytes buffer differ from direct writes");
+    }
+}
+
 class PcapFileTestSuite : public TestSuite
 {
 public:
@@ -1138,6 +1347,8 @@ PcapFileTestSuite::PcapFileTestSuite ()
   AddTestCase (new RecordHeaderTestCase, TestCase::QUICK);
   AddTestCase (new ReadFileTestCase, TestCase::QUICK);
   AddTestCase (new DiffTestCase, TestCase::QUICK);
+  AddTestCase (new MappedReadTestCase, TestCase::QUICK);
+  AddTestCase (new BufferedWriteTestCase, TestCase::QUICK);
 }
 
 static PcapFileTestSuite pcapFileTestSuite;
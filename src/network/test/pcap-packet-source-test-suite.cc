@@ -0,0 +1,142 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <vector>
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/string.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/mac48-address.h"
+#include "ns3/pcap-packet-source.h"
+
+using namespace ns3;
+
+// ===========================================================================
+// Test case checking that the packets of a pcap file are sent through the
+// device at the times of their timestamps, with the addresses and EtherType
+// of their Ethernet header.
+// ===========================================================================
+class PcapPacketSourceTestCase : public TestCase
+{
+public:
+  PcapPacketSourceTestCase ();
+  virtual ~PcapPacketSourceTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Receive a packet.
+   * \param device The receiving device.
+   * \param packet The packet.
+   * \param protocol The protocol number.
+   * \param from The source address.
+   * \param to The destination address.
+   * \param type The packet type.
+   * \returns true.
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol,
+                const Address &from, const Address &to, NetDevice::PacketType type);
+
+  std::vector<Time> m_times;          //!< The reception times.
+  std::vector<uint32_t> m_sizes;      //!< The sizes of the packets received.
+  std::vector<uint16_t> m_protocols;  //!< The protocols of the packets received.
+  std::vector<Address> m_sources;     //!< The sources of the packets received.
+};
+
+PcapPacketSourceTestCase::PcapPacketSourceTestCase ()
+  : TestCase ("Check the replay of a pcap file through a NetDevice")
+{
+}
+
+PcapPacketSourceTestCase::~PcapPacketSourceTestCase ()
+{
+}
+
+bool
+PcapPacketSourceTestCase::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol,
+                                   const Address &from, const Address &to, NetDevice::PacketType type)
+{
+  m_times.push_back (Simulator::Now ());
+  m_sizes.push_back (packet->GetSize ());
+  m_protocols.push_back (protocol);
+  m_sources.push_back (from);
+  return true;
+}
+
+void
+PcapPacketSourceTestCase::DoRun (void)
+{
+  Ptr<Node> txNode = CreateObject<Node> ();
+  Ptr<Node> rxNode = CreateObject<Node> ();
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  Ptr<SimpleNetDevice> txDev = CreateObject<SimpleNetDevice> ();
+  Ptr<SimpleNetDevice> rxDev = CreateObject<SimpleNetDevice> ();
+  txDev->SetAddress (Mac48Address ("00:00:00:00:01:01"));
+  rxDev->SetAddress (Mac48Address ("00:00:00:00:01:02"));
+  txDev->SetChannel (channel);
+  rxDev->SetChannel (channel);
+  txNode->AddDevice (txDev);
+  rxNode->AddDevice (rxDev);
+  rxDev->SetPromiscReceiveCallback (MakeCallback (&PcapPacketSourceTestCase::Receive, this));
+
+  Ptr<PcapPacketSource> source = CreateObject<PcapPacketSource> ();
+  source->SetAttribute ("Filename", StringValue (CreateDataDirFilename ("known.pcap")));
+  txNode->AddApplication (source);
+  source->SetStartTime (Seconds (1));
+  source->SetStopTime (Seconds (10));
+
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  //
+  // The timestamps of known.pcap, relative to the first one, and its packets:
+  // ARP requests and replies around an UDP echo.
+  //
+  const int64_t offsets[] = { 0, 11, 105, 115, 126, 219 };
+  const uint32_t sizes[] = { 46, 46, 1070, 46, 46, 1070 };
+  const uint16_t protocols[] = { 0x0806, 0x0806, 0x0800, 0x0806, 0x0806, 0x0800 };
+
+  NS_TEST_ASSERT_MSG_EQ (source->GetSent (), 6, "Not all the packets were sent");
+  NS_TEST_ASSERT_MSG_EQ (m_times.size (), 6, "Not all the packets were received");
+  for (uint32_t i = 0; i < m_times.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_times[i], Seconds (1) + MicroSeconds (offsets[i]), "Packet " << i << " sent at the wrong time");
+      NS_TEST_EXPECT_MSG_EQ (m_sizes[i], sizes[i] - 14, "Packet " << i << " has the wrong size");
+      NS_TEST_EXPECT_MSG_EQ (m_protocols[i], protocols[i], "Packet " << i << " has the wrong protocol");
+    }
+  // SimpleNetDevice supports SendFrom: the sources are those of the capture.
+  NS_TEST_EXPECT_MSG_EQ (m_sources[0], Address (Mac48Address ("00:00:00:00:00:03")), "Source address not taken from the capture");
+}
+
+class PcapPacketSourceTestSuite : public TestSuite
+{
+public:
+  PcapPacketSourceTestSuite ();
+};
+
+PcapPacketSourceTestSuite::PcapPacketSourceTestSuite ()
+  : TestSuite ("pcap-packet-source", UNIT)
+{
+  SetDataDir (NS_TEST_SOURCEDIR);
+  AddTestCase (new PcapPacketSourceTestCase, TestCase::QUICK);
+}
+
+static PcapPacketSourceTestSuite g_pcapPacketSourceTestSuite;
@@ -0,0 +1,165 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/flow-id-tag.h"
+#include "ns3/tag-pool.h"
+#include "ns3/system-thread.h"
+
+using namespace ns3;
+
+// ===========================================================================
+// Test case checking the sizes of the blocks of the TagPool and its
+// statistics, as packets with packet tags and byte tags are created,
+// copied and destroyed.
+// ===========================================================================
+class TagPoolTestCase : public TestCase
+{
+public:
+  TagPoolTestCase ();
+  virtual ~TagPoolTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+TagPoolTestCase::TagPoolTestCase ()
+  : TestCase ("Check the TagPool block sizes and statistics")
+{
+}
+
+TagPoolTestCase::~TagPoolTestCase ()
+{
+}
+
+void
+TagPoolTestCase::DoRun (void)
+{
+  NS_TEST_ASSERT_MSG_EQ (TagPool::GetBlockSize (0), TagPool::GRANULARITY, "Empty block");
+  NS_TEST_ASSERT_MSG_EQ (TagPool::GetBlockSize (1), TagPool::GRANULARITY, "Small block");
+  NS_TEST_ASSERT_MSG_EQ (TagPool::GetBlockSize (TagPool::GRANULARITY + 1), 2 * TagPool::GRANULARITY, "Rounded block");
+  NS_TEST_ASSERT_MSG_EQ (TagPool::GetBlockSize (TagPool::MAX_POOLED_SIZE), TagPool::MAX_POOLED_SIZE, "Largest pooled block");
+  NS_TEST_ASSERT_MSG_EQ (TagPool::GetBlockSize (TagPool::MAX_POOLED_SIZE + 1), TagPool::MAX_POOLED_SIZE + 1, "Unpooled block");
+
+  TagPool::Statistics before = TagPool::GetStatistics ();
+  {
+    Ptr<Packet> p = Create<Packet> (100);
+    p->AddPacketTag (FlowIdTag (1));
+    p->AddByteTag (FlowIdTag (2));
+    Ptr<Packet> copy = p->Copy ();
+    TagPool::Statistics during = TagPool::GetStatistics ();
+    NS_TEST_ASSERT_MSG_EQ (during.livePacketTags, before.livePacketTags + 1, "Packet tag not counted, or copied");
+    NS_TEST_ASSERT_MSG_EQ (during.liveByteTagBlocks, before.liveByteTagBlocks + 1, "Byte tags not counted, or copied");
+    NS_TEST_ASSERT_MSG_GT (during.liveBytes, before.liveBytes, "Bytes not counted");
+
+    // Diverging copies allocate their own tags.
+    FlowIdTag tag;
+    NS_TEST_ASSERT_MSG_EQ (copy->RemovePacketTag (tag), true, "Shared packet tag not found");
+    NS_TEST_ASSERT_MSG_EQ (tag.GetFlowId (), 1, "Wrong shared packet tag");
+    copy->AddPacketTag (FlowIdTag (3));
+    copy->AddByteTag (FlowIdTag (4));
+    during = TagPool::GetStatistics ();
+    NS_TEST_ASSERT_MSG_EQ (during.livePacketTags, before.livePacketTags + 2, "Packet tags of the copy not counted");
+    NS_TEST_ASSERT_MSG_EQ (during.liveByteTagBlocks, before.liveByteTagBlocks + 2, "Byte tags of the copy not counted");
+
+    NS_TEST_ASSERT_MSG_EQ (copy->RemovePacketTag (tag), true, "Packet tag not found");
+    NS_TEST_ASSERT_MSG_EQ (tag.GetFlowId (), 3, "Wrong packet tag");
+  }
+  TagPool::Statistics after = TagPool::GetStatistics ();
+  NS_TEST_ASSERT_MSG_EQ (after.livePacketTags, before.livePacketTags, "Packet tags leaked");
+  NS_TEST_ASSERT_MSG_EQ (after.liveByteTagBlocks, before.liveByteTagBlocks, "Byte tags leaked");
+  NS_TEST_ASSERT_MSG_EQ (after.liveBytes, before.liveBytes, "Bytes leaked");
+  NS_TEST_ASSERT_MSG_GT (after.pooledBytes, 0, "Released blocks not pooled");
+
+  // The pooled blocks are reused by the next tags.
+  {
+    Ptr<Packet> p = Create<Packet> (100);
+    p->AddPacketTag (FlowIdTag (5));
+    NS_TEST_ASSERT_MSG_LT (TagPool::GetStatistics ().pooledBytes, after.pooledBytes, "Pooled block not reused");
+  }
+
+  TagPool::Trim ();
+  NS_TEST_ASSERT_MSG_EQ (TagPool::GetStatistics ().pooledBytes, 0, "Pooled blocks not released");
+}
+
+// ===========================================================================
+// Test case checking that the tags of a packet released by another
+// thread than the one which created it are no longer counted.
+// ===========================================================================
+class TagPoolThreadTestCase : public TestCase
+{
+public:
+  TagPoolThreadTestCase ();
+  virtual ~TagPoolThreadTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Release a packet.
+   * \param p The packet.
+   */
+  static void Release (Ptr<Packet> *p);
+};
+
+TagPoolThreadTestCase::TagPoolThreadTestCase ()
+  : TestCase ("Check the TagPool statistics of tags released by another thread")
+{
+}
+
+TagPoolThreadTestCase::~TagPoolThreadTestCase ()
+{
+}
+
+void
+TagPoolThreadTestCase::Release (Ptr<Packet> *p)
+{
+  *p = 0;
+}
+
+void
+TagPoolThreadTestCase::DoRun (void)
+{
+  TagPool::Statistics before = TagPool::GetStatistics ();
+  Ptr<Packet> p = Create<Packet> (100);
+  p->AddPacketTag (FlowIdTag (1));
+  p->AddByteTag (FlowIdTag (2));
+
+  Ptr<SystemThread> thread = Create<SystemThread> (MakeBoundCallback (&TagPoolThreadTestCase::Release, &p));
+  thread->Start ();
+  thread->Join ();
+  NS_TEST_ASSERT_MSG_EQ (p, 0, "Packet not released");
+
+  TagPool::Statistics after = TagPool::GetStatistics ();
+  NS_TEST_ASSERT_MSG_EQ (after.livePacketTags, before.livePacketTags, "Packet tag still counted");
+  NS_TEST_ASSERT_MSG_EQ (after.liveByteTagBlocks, before.liveByteTagBlocks, "Byte tags still counted");
+  NS_TEST_ASSERT_MSG_EQ (after.liveBytes, before.liveBytes, "Bytes still counted");
+}
+
+class TagPoolTestSuite : public TestSuite
+{
+public:
+  TagPoolTestSuite ();
+};
+
+TagPoolTestSuite::TagPoolTestSuite ()
+  : TestSuite ("tag-pool", UNIT)
+{
+  AddTestCase (new TagPoolTestCase, TestCase::QUICK);
+  AddTestCase (new TagPoolThreadTestCase, TestCase::QUICK);
+}
+
+static TagPoolTestSuite g_tagPoolTestSuite;
@@ -0,0 +1,506 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <sstream>
+#include "ns3/network-config.h"
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/simulator.h"
+#include "ns3/packet.h"
+#include "crc32.h"
+#include "binary-trace-writer.h"
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("BinaryTraceWriter");
+
+namespace {
+
+/**
+ * Binary trace file format.
+ *
+ * The file starts with the 8 bytes of \c g_magic and continues with a
+ * sequence of blocks.  A block holds: uint8_t BlockCompression,
+ * uint32_t size of the records, uint32_t size of the stored data, then
+ * the stored data.  Records do not span blocks.  All the fields are in
+ * host byte order.
+ *
+ * A record starts with its RecordType.
+ *
+ * A CONTEXT_RECORD defines the context id used by the following
+ * EVENT_RECORDs: uint32_t id, uint16_t length, then the characters.
+ *
+ * An EVENT_RECORD holds: uint8_t event type, uint8_t flags (\c FLAG_*),
+ * double time in seconds, uint32_t context id, uint64_t packet uid,
+ * uint32_t packet size, then the uint32_t digest if \c FLAG_HAS_DIGEST,
+ * then the uint32_t length and the serialized packet if
+ * \c FLAG_HAS_PACKET.
+ *
+ * A TEXT_RECORD holds: uint32_t length, then the characters.
+ */
+const char g_magic[8] = { 'N', 'S', '3', 'T', 'R', 'C', 'B', '1' };
+
+/** The compression of a block of a binary trace file. */
+enum BlockCompression {
+  BLOCK_RAW = 0,    //!< The records are stored as is.
+  BLOCK_ZLIB = 1    //!< The records are compressed with zlib.
+};
+
+/** The type of a record in a binary trace file. */
+enum RecordType {
+  CONTEXT_RECORD = 1,  //!< Definition of a context.
+  EVENT_RECORD = 2,    //!< A packet event.
+  TEXT_RECORD = 3      //!< Text written to the stream.
+};
+
+const uint8_t FLAG_HAS_CONTEXT = 0x01;  //!< The event has a context.
+const uint8_t FLAG_HAS_DIGEST = 0x02;   //!< The record holds a digest.
+const uint8_t FLAG_HAS_PACKET = 0x04;   //!< The record holds the packet.
+
+/** The size of the blocks, before compression. */
+const uint32_t BLOCK_SIZE = 128 * 1024;
+
+/** The number of bytes of the packet covered by the digest. */
+const uint32_t DIGEST_SIZE = 64;
+
+/**
+ * Append a value to a record buffer.
+ * \param [in,out] buffer The buffer.
+ * \param [in] value The value to append.
+ */
+template <typename T>
+void
+Append (std::vector<char> *buffer, T value)
+{
+  const char *p = reinterpret_cast<const char *> (&value);
+  buffer->insert (buffer->end (), p, p + sizeof (T));
+}
+
+/**
+ * Read a value from a binary trace.
+ * \param [in] is The binary trace.
+ * \param [out] value The value read.
+ * \returns \c true if the value could be read.
+ */
+template <typename T>
+bool
+Read (std::istream &is, T *value)
+{
+  is.read (reinterpret_cast<char *> (value), sizeof (T));
+  return is.good ();
+}
+
+/**
+ * Read a string from a binary trace.
+ * \param [in] is The binary trace.
+ * \param [in] length The length of the string.
+ * \param [out] s The string read.
+ * \returns \c true if the string could be read.
+ */
+bool
+ReadString (std::istream &is, uint32_t length, std::string *s)
+{
+  s->resize (length);
+  if (length > 0)
+    {
+      is.read (&(*s)[0], length);
+    }
+  return is.good ();
+}
+
+} // anonymous namespace
+
+BinaryTraceWriter::TextBuffer::TextBuffer (BinaryTraceWriter *writer)
+  : m_writer (writer)
+{
+}
+
+int
+BinaryTraceWriter::TextBuffer::overflow (int c)
+{
+  if (c != traits_type::eof ())
+    {
+      char ch = traits_type::to_char_type (c);
+      m_writer->AppendText (&ch, 1);
+    }
+  return traits_type::not_eof (c);
+}
+
+std::streamsize
+BinaryTraceWriter::TextBuffer::xsputn (const char *s, std::streamsize n)
+{
+  m_writer->AppendText (s, n);
+  return n;
+}
+
+int
+BinaryTraceWriter::TextBuffer::sync (void)
+{
+  // Flushing the text stream, as std::endl does, must not end the
+  // block: the text is written with the next block.
+  return 0;
+}
+
+BinaryTraceWriter::BinaryTraceWriter (std::string filename, enum Content content)
+  : m_content (content),
+    m_fileSize (0),
+    m_textBuffer (this),
+    m_textStream (&m_textBuffer)
+{
+  NS_LOG_FUNCTION (this << filename << content);
+  m_file.open (filename.c_str (), std::ios::out | std::ios::binary);
+  NS_ABORT_MSG_UNLESS (m_file.is_open (), "BinaryTraceWriter::BinaryTraceWriter():  " <<
+                       "Unable to Open " << filename);
+  m_file.write (g_magic, sizeof (g_magic));
+  m_fileSize = sizeof (g_magic);
+  m_block.reserve (BLOCK_SIZE + 1024);
+}
+
+BinaryTraceWriter::~BinaryTraceWriter ()
+{
+  NS_LOG_FUNCTION (this);
+  Flush ();
+  m_file.close ();
+}
+
+std::ostream *
+BinaryTraceWriter::GetTextStream (void)
+{
+  NS_LOG_FUNCTION (this);
+  return &m_textStream;
+}
+
+uint64_t
+BinaryTraceWriter::GetFileSize (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_fileSize;
+}
+
+uint32_t
+BinaryTraceWriter::GetContextId (std::string const &context)
+{
+  std::map<std::string, uint32_t>::const_iterator i = m_contexts.find (context);
+  if (i != m_contexts.end ())
+    {
+      return i->second;
+    }
+  uint32_t id = m_contexts.size ();
+  m_contexts.insert (std::make_pair (context, id));
+  uint16_t length = std::min<std::size_t> (context.size (), 0xffff);
+  Append<uint8_t> (&m_block, CONTEXT_RECORD);
+  Append (&m_block, id);
+  Append (&m_block, length);
+  m_block.insert (m_block.end (), context.begin (), context.begin () + length);
+  return id;
+}
+
+void
+BinaryTraceWriter::Write (char type, std::string const *context, Ptr<const Packet> p)
+{
+  NS_LOG_FUNCTION (this << type << p);
+  EndText ();
+
+  uint8_t flags = 0;
+  uint32_t contextId = 0;
+  if (context != 0)
+    {
+      flags |= FLAG_HAS_CONTEXT;
+      contextId = GetContextId (*context);
+    }
+  if (m_content == DIGEST)
+    {
+      flags |= FLAG_HAS_DIGEST;
+    }
+  else if (m_content == PACKET)
+    {
+      flags |= FLAG_HAS_PACKET;
+    }
+
+  uint32_t size = p->GetSize ();
+  Append<uint8_t> (&m_block, EVENT_RECORD);
+  Append<uint8_t> (&m_block, type);
+  Append (&m_block, flags);
+  Append (&m_block, Simulator::Now ().GetSeconds ());
+  Append (&m_block, contextId);
+  Append (&m_block, p->GetUid ());
+  Append (&m_block, size);
+
+  if (flags & FLAG_HAS_DIGEST)
+    {
+      uint8_t data[DIGEST_SIZE];
+      uint32_t copied = p->CopyData (data, std::min (size, DIGEST_SIZE));
+      Append (&m_block, CRC32Calculate (data, copied));
+    }
+  if (flags & FLAG_HAS_PACKET)
+    {
+      // Packet::Serialize writes 32-bit words.
+      uint32_t serializedSize = p->GetSerializedSize ();
+      m_serialized.resize ((serializedSize + 3) / 4);
+      uint8_t *buffer = reinterpret_cast<uint8_t *> (&m_serialized[0]);
+      if (p->Serialize (buffer, serializedSize) == 0)
+        {
+          NS_LOG_WARN ("Unable to serialize packet " << p->GetUid ());
+          serializedSize = 0;
+        }
+      Append (&m_block, serializedSize);
+      m_block.insert (m_block.end (), buffer, buffer + serializedSize);
+    }
+  EndRecord ();
+}
+
+void
+BinaryTraceWriter::AppendText (const char *s, std::size_t n)
+{
+  m_text.append (s, n);
+}
+
+void
+BinaryTraceWriter::EndText (void)
+{
+  if (m_text.empty ())
+    {
+      return;
+    }
+  Append<uint8_t> (&m_block, TEXT_RECORD);
+  Append<uint32_t> (&m_block, m_text.size ());
+  m_block.insert (m_block.end (), m_text.begin (), m_text.end ());
+  m_text.clear ();
+}
+
+void
+BinaryTraceWriter::EndRecord (void)
+{
+  if (m_block.size () >= BLOCK_SIZE)
+    {
+      Flush ();
+    }
+}
+
+void
+BinaryTraceWriter::Flush (void)
+{
+  NS_LOG_FUNCTION (this);
+  EndText ();
+  if (m_block.empty ())
+    {
+      m_file.flush ();
+      return;
+    }
+
+  uint8_t compression = BLOCK_RAW;
+  uint32_t rawSize = m_block.size ();
+  const char *data = &m_block[0];
+  uint32_t storedSize = rawSize;
+#ifdef HAVE_ZLIB
+  uLongf compressedSize = compressBound (rawSize);
+  m_compressed.resize (compressedSize);
+  if (compress2 (reinterpret_cast<Bytef *> (&m_compressed[0]), &compressedSize,
+                 reinterpret_cast<const Bytef *> (data), rawSize, Z_BEST_SPEED) == Z_OK
+      && compressedSize < rawSize)
+    {
+      compression = BLOCK_ZLIB;
+      data = &m_compressed[0];
+      storedSize = compressedSize;
+    }
+#endif
+
+  m_file.write (reinterpret_cast<const char *> (&compression), sizeof (compression));
+  m_file.write (reinterpret_cast<const char *> (&rawSize), sizeof (rawSize));
+  m_file.write (reinterpret_cast<const char *> (&storedSize), sizeof (storedSize));
+  m_file.write (data, storedSize);
+  m_file.flush ();
+  m_fileSize += sizeof (compression) + sizeof (rawSize) + sizeof (storedSize) + storedSize;
+  m_block.clear ();
+}
+
+namespace {
+
+/**
+ * Render the records of a block in the ASCII trace format.
+ * \param [in] is The records.
+ * \param [in,out] contexts The contexts defined so far.
+ * \param [in,out] os The output stream to print the text on.
+ * \returns \c false if the records are not valid.
+ */
+bool
+DecodeRecords (std::istream &is, std::map<uint32_t, std::string> *contexts, std::ostream &os)
+{
+  std::vector<uint32_t> serialized;
+  while (true)
+    {
+      uint8_t type;
+      if (!Read (is, &type))
+        {
+          // end of block.
+          return true;
+        }
+      if (type == CONTEXT_RECORD)
+        {
+          uint32_t id;
+          uint16_t length;
+          std::string context;
+          if (!Read (is, &id) || !Read (is, &length) || !ReadString (is, length, &context))
+            {
+              return false;
+            }
+          (*contexts)[id] = context;
+          continue;
+        }
+      if (type == TEXT_RECORD)
+        {
+          uint32_t length;
+          std::string text;
+          if (!Read (is, &length) || !ReadString (is, length, &text))
+            {
+              return false;
+            }
+          os << text;
+          continue;
+        }
+      if (type != EVENT_RECORD)
+        {
+          return false;
+        }
+      uint8_t event, flags;
+      double time;
+      uint32_t contextId, size, digest = 0;
+      uint64_t uid;
+      if (!Read (is, &event) || !Read (is, &flags) || !Read (is, &time)
+          || !Read (is, &contextId) || !Read (is, &uid) || !Read (is, &size))
+        {
+          return false;
+        }
+      if ((flags & FLAG_HAS_DIGEST) && !Read (is, &digest))
+        {
+          return false;
+        }
+      Ptr<Packet> p;
+      if (flags & FLAG_HAS_PACKET)
+        {
+          uint32_t length;
+          if (!Read (is, &length))
+            {
+              return false;
+            }
+          serialized.resize ((length + 3) / 4 + 1);
+          is.read (reinterpret_cast<char *> (&serialized[0]), length);
+          if (!is.good ())
+            {
+              return false;
+            }
+          if (length > 0)
+            {
+              p = Create<Packet> (reinterpret_cast<uint8_t const *> (&serialized[0]), length, true);
+            }
+        }
+
+      // Same layout as the default sinks of AsciiTraceHelper.
+      os << event << " " << time << " ";
+      if (flags & FLAG_HAS_CONTEXT)
+        {
+          std::map<uint32_t, std::string>::const_iterator i = contexts->find (contextId);
+          if (i == contexts->end ())
+            {
+              return false;
+            }
+          os << i->second << " ";
+        }
+      if (p != 0)
+        {
+          os << *p << std::endl;
+          continue;
+        }
+      os << "Packet uid=" << uid << " size=" << size;
+      if (flags & FLAG_HAS_DIGEST)
+        {
+          os << " digest=0x" << std::hex << digest << std::dec;
+        }
+      os << std::endl;
+    }
+}
+
+} // anonymous namespace
+
+bool
+BinaryTraceDecode (std::istream &is, std::ostream &os)
+{
+  char magic[sizeof (g_magic)];
+  is.read (magic, sizeof (magic));
+  if (!is.good () || std::memcmp (magic, g_magic, sizeof (g_magic)) != 0)
+    {
+      return false;
+    }
+  std::map<uint32_t, std::string> contexts;
+  std::string stored, records;
+  while (true)
+    {
+      uint8_t compression;
+      uint32_t rawSize, storedSize;
+      if (!Read (is, &compression))
+        {
+          // end of file.
+          return true;
+        }
+      if (!Read (is, &rawSize) || !Read (is, &storedSize)
+          || !ReadString (is, storedSize, &stored))
+        {
+          return false;
+        }
+      if (compression == BLOCK_RAW)
+        {
+          if (rawSize != storedSize)
+            {
+              return false;
+            }
+          records.swap (stored);
+        }
+      else if (compression == BLOCK_ZLIB)
+        {
+#ifdef HAVE_ZLIB
+          records.resize (rawSize);
+          uLongf size = rawSize;
+          if (rawSize == 0
+              || uncompress (reinterpret_cast<Bytef *> (&records[0]), &size,
+                             reinterpret_cast<const Bytef *> (stored.data ()), storedSize) != Z_OK
+              || size != rawSize)
+            {
+              return false;
+            }
+#else
+          NS_FATAL_ERROR ("BinaryTraceDecode(): compressed binary trace, but zlib is not available");
+#endif
+        }
+      else
+        {
+          return false;
+        }
+      std::istringstream block (records);
+      if (!DecodeRecords (block, &contexts, os))
+        {
+          return false;
+        }
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,178 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef BINARY_TRACE_WRITER_H
+#define BINARY_TRACE_WRITER_H
+
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "ns3/ptr.h"
+#include "ns3/simple-ref-count.h"
+
+namespace ns3 {
+
+class Packet;
+
+/**
+ * @brief A compact, block-compressed replacement of the ASCII trace files.
+ *
+ * The default ASCII trace sinks of AsciiTraceHelper format a text line for
+ * each event, including the output of Packet::Print.  When they write to a
+ * stream created by AsciiTraceHelper::CreateBinaryFileStream, they instead
+ * append a fixed-size record to a BinaryTraceWriter: the event type, the
+ * time, the trace context, the packet uid and size and, depending on the
+ * Content, a digest of the packet headers or the serialized packet.
+ * Contexts are stored once and then referred to by id.  The records are
+ * gathered in blocks which are compressed with zlib, when available,
+ * before being written.
+ *
+ * The text written to the stream of the OutputStreamWrapper by other
+ * sinks is kept in the file as text records, in order.
+ *
+ * BinaryTraceDecode(), used by the \c decode-binary-trace utility,
+ * renders the file in the ASCII trace format:
+ * \code
+ *   $ ./waf --run "decode-binary-trace --file=csma.trb" > csma.tr
+ * \endcode
+ * The output is identical to the ASCII trace when the packets are
+ * stored.  Otherwise, the packet uid, size and digest stand for the
+ * packet contents.
+ */
+class BinaryTraceWriter : public SimpleRefCount<BinaryTraceWriter>
+{
+public:
+  /**
+   * The information stored about each packet.
+   */
+  enum Content
+  {
+    SUMMARY,  //!< The uid and size of the packet.
+    DIGEST,   //!< The uid, size and a CRC32 of the first bytes of the packet.
+    PACKET    //!< The uid, size and serialized packet, headers included.
+  };
+
+  /**
+   * Create a binary trace file.
+   *
+   * \param filename The name of the file.
+   * \param content The information stored about each packet.
+   */
+  BinaryTraceWriter (std::string filename, enum Content content);
+  ~BinaryTraceWriter ();
+
+  /**
+   * Append an event record.
+   *
+   * \param type The event type, as the first character of the ASCII
+   * trace line: '+', '-', 'd' or 'r'.
+   * \param context The trace context, or 0 if the sink has none.
+   * \param p The packet.
+   */
+  void Write (char type, std::string const *context, Ptr<const Packet> p);
+
+  /**
+   * Get the stream whose text is stored as text records.
+   *
+   * \returns The stream.
+   */
+  std::ostream *GetTextStream (void);
+
+  /**
+   * Compress and write the records appended so far.
+   */
+  void Flush (void);
+
+  /**
+   * Get the number of bytes written to the file so far.
+   *
+   * \returns The size of the file.
+   */
+  uint64_t GetFileSize (void) const;
+
+private:
+  /**
+   * The buffer of the text stream, which appends text records.
+   */
+  class TextBuffer : public std::streambuf
+  {
+public:
+    /**
+     * Constructor.
+     * \param writer The writer of the text records.
+     */
+    TextBuffer (BinaryTraceWriter *writer);
+
+protected:
+    virtual int overflow (int c);
+    virtual std::streamsize xsputn (const char *s, std::streamsize n);
+    virtual int sync (void);
+
+private:
+    BinaryTraceWriter *m_writer;  //!< The writer of the text records.
+  };
+
+  /**
+   * Append text to the pending text record.
+   * \param s The text.
+   * \param n The length of the text.
+   */
+  void AppendText (const char *s, std::size_t n);
+  /**
+   * Append the pending text record, if any, to the block.
+   */
+  void EndText (void);
+  /**
+   * Get the id of a context, appending its definition on first use.
+   * \param context The context.
+   * \returns The id of the context.
+   */
+  uint32_t GetContextId (std::string const &context);
+  /**
+   * Write the block if it is full.
+   */
+  void EndRecord (void);
+
+  std::ofstream m_file;                          //!< The trace file.
+  enum Content m_content;                        //!< The information stored about the packets.
+  std::vector<char> m_block;                     //!< The records not written yet.
+  std::vector<char> m_compressed;                //!< Scratch space for the compressed blocks.
+  std::vector<uint32_t> m_serialized;            //!< Scratch space for the serialized packets.
+  std::map<std::string, uint32_t> m_contexts;    //!< The ids of the contexts.
+  std::string m_text;                            //!< The pending text record.
+  uint64_t m_fileSize;                           //!< The number of bytes written.
+  TextBuffer m_textBuffer;                       //!< The buffer of the text stream.
+  std::ostream m_textStream;                     //!< The text stream.
+};
+
+/**
+ * Render a binary trace file in the ASCII trace format.
+ *
+ * The stored packets are printed with their headers only if
+ * Packet::EnablePrinting has been called before.
+ *
+ * \param [in] is The binary trace.
+ * \param [in,out] os The output stream to print the text on.
+ * \returns \c false if the input is not a valid binary trace.
+ */
+bool BinaryTraceDecode (std::istream &is, std::ostream &os);
+
+} // namespace ns3
+
+#endif /* BINARY_TRACE_WRITER_H */
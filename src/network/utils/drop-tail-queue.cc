@@ -16,6 +16,7 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <algorithm>
 #include "ns3/log.h"
 #include "drop-tail-queue.h"
 
@@ -25,6 +26,16 @@ NS_LOG_COMPONENT_DEFINE ("DropTailQueue");
 
 NS_OBJECT_ENSURE_REGISTERED (DropTailQueue);
 
+namespace {
+
+/**
+ * The size of the first ring buffer.  The ring buffer is then doubled
+ * as needed, up to "MaxPackets" slots in packet mode.
+ */
+const uint32_t MIN_SLOTS = 16;
+
+} // unnamed namespace
+
 TypeId DropTailQueue::GetTypeId (void)
 {
   static TypeId tid = TypeId ("ns3::DropTailQueue")
@@ -37,7 +48,9 @@ TypeId DropTailQueue::GetTypeId (void)
 
 DropTailQueue::DropTailQueue () :
   Queue (),
-  m_packets ()
+  m_packets (),
+  m_head (0),
+  m_count (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -51,21 +64,72 @@ bool
 DropTailQueue::DoEnqueue (Ptr<QueueItem> item)
 {
   NS_LOG_FUNCTION (this << item);
-  NS_ASSERT (m_packets.size () == GetNPackets ());
-
-  m_packets.push (item);
+  NS_ASSERT (m_count == GetNPackets ());
+
+  if (m_count == m_packets.size ())
+    {
+      Grow ();
+    }
+  uint32_t tail = m_head + m_count;
+  if (tail >= m_packets.size ())
+    {
+      tail -= m_packets.size ();
+    }
+  m_packets[tail] = item;
+  m_count++;
 
   return true;
 }
 
+void
+DropTailQueue::Grow (void)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t size = m_packets.size ();
+  uint32_t newSize = std::max (MIN_SLOTS, 2 * size);
+  if (GetMode () == QUEUE_MODE_PACKETS)
+    {
+      newSize = std::max (std::min (GetMaxPackets (), newSize), size + 1);
+    }
+  NS_LOG_LOGIC ("Ring buffer of " << size << " slots enlarged to " << newSize);
+
+  // Unwrap the items at the start of the new ring buffer.
+  std::vector<Ptr<QueueItem> > packets (newSize);
+  for (uint32_t i = 0; i < m_count; i++)
+    {
+      uint32_t slot = m_head + i;
+      if (slot >= size)
+        {
+          slot -= size;
+        }
+      packets[i] = m_packets[slot];
+    }
+  m_packets.swap (packets);
+  m_head = 0;
+}
+
+Ptr<QueueItem>
+DropTailQueue::PopFront (void)
+{
+  Ptr<QueueItem> item = m_packets[m_head];
+  // Leave the slot empty, so that the queue does not keep the item alive.
+  m_packets[m_head] = 0;
+  m_head++;
+  if (m_head == m_packets.size ())
+    {
+      m_head = 0;
+    }
+  m_count--;
+  return item;
+}
+
 Ptr<QueueItem>
 DropTailQueue::DoDequeue (void)
 {
   NS_LOG_FUNCTION (this);
-  NS_ASSERT (m_packets.size () == GetNPackets ());
+  NS_ASSERT (m_count == GetNPackets ());
 
-  Ptr<QueueItem> item = m_packets.front ();
-  m_packets.pop ();
+  Ptr<QueueItem> item = PopFront ();
 
   NS_LOG_LOGIC ("Popped " << item);
 
@@ -76,10 +140,9 @@ Ptr<QueueItem>
 DropTailQueue::DoRemove (void)
 {
   NS_LOG_FUNCTION (this);
-  NS_ASSERT (m_packets.size () == GetNPackets ());
+  NS_ASSERT (m_count == GetNPackets ());
 
-  Ptr<QueueItem> item = m_packets.front ();
-  m_packets.pop ();
+  Ptr<QueueItem> item = PopFront ();
 
   NS_LOG_LOGIC ("Removed " << item);
 
@@ -90,9 +153,9 @@ Ptr<const QueueItem>
 DropTailQueue::DoPeek (void) const
 {
   NS_LOG_FUNCTION (this);
-  NS_ASSERT (m_packets.size () == GetNPackets ());
+  NS_ASSERT (m_count == GetNPackets ());
 
-  return m_packets.front ();
+  return m_packets[m_head];
 }
 
 } // namespace ns3
@@ -19,7 +19,7 @@
 #ifndef DROPTAIL_H
 #define DROPTAIL_H
 
-#include <queue>
+#include <vector>
 #include "ns3/queue.h"
 
 namespace ns3 {
@@ -28,6 +28,12 @@ namespace ns3 {
  * \ingroup queue
  *
  * \brief A FIFO packet queue that drops tail-end packets on overflow
+ *
+ * The items are stored in a ring buffer.  In packet mode, the ring is
+ * allocated once with one slot per packet allowed by the "MaxPackets"
+ * attribute, so that enqueuing and dequeuing never allocate memory.
+ * In byte mode, the number of packets is not bounded and the ring
+ * doubles in size when it is full.
  */
 class DropTailQueue : public Queue
 {
@@ -52,7 +58,19 @@ private:
   virtual Ptr<QueueItem> DoRemove (void);
   virtual Ptr<const QueueItem> DoPeek (void) const;
 
-  std::queue<Ptr<QueueItem> > m_packets; //!< the items in the queue
+  /**
+   * \brief Enlarge the ring buffer, keeping the items in order
+   */
+  void Grow (void);
+  /**
+   * \brief Remove the item at the head of the ring buffer
+   * \return the item
+   */
+  Ptr<QueueItem> PopFront (void);
+
+  std::vector<Ptr<QueueItem> > m_packets; //!< the slots of the ring buffer
+  uint32_t m_head;                        //!< the slot of the first item
+  uint32_t m_count;                       //!< the number of items in the ring buffer
 };
 
 } // namespace ns3
@@ -17,6 +17,7 @@
  */
 
 #include "output-stream-wrapper.h"
+#include "binary-trace-writer.h"
 #include "ns3/log.h"
 #include "ns3/fatal-impl.h"
 #include "ns3/abort.h"
@@ -46,6 +47,13 @@ OutputStreamWrapper::OutputStreamWrapper (std::ostream* os)
   NS_ABORT_MSG_UNLESS (m_ostream->good (), "Output stream is not vaild for writing.");
 }
 
+OutputStreamWrapper::OutputStreamWrapper (Ptr<BinaryTraceWriter> writer)
+  : m_ostream (writer->GetTextStream ()), m_destroyable (false), m_binaryWriter (writer)
+{
+  NS_LOG_FUNCTION (this << writer);
+  FatalImpl::RegisterStream (m_ostream);
+}
+
 OutputStreamWrapper::~OutputStreamWrapper ()
 {
   NS_LOG_FUNCTION (this);
@@ -61,4 +69,11 @@ OutputStreamWrapper::GetStream (void)
   return m_ostream;
 }
 
+Ptr<BinaryTraceWriter>
+OutputStreamWrapper::GetBinaryWriter (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_binaryWriter;
+}
+
 } // namespace ns3
@@ -23,6 +23,7 @@
 #include "ns3/object.h"
 #include "ns3/ptr.h"
 #include "ns3/simple-ref-count.h"
+#include "binary-trace-writer.h"
 
 namespace ns3 {
 
@@ -81,6 +82,16 @@ public:
    * \param os output stream
    */
   OutputStreamWrapper (std::ostream* os);
+  /**
+   * Constructor
+   *
+   * The stream of the wrapper is the text stream of the writer, and the
+   * default trace sinks of AsciiTraceHelper write binary records to the
+   * writer instead of text.
+   *
+   * \param writer binary trace writer
+   */
+  OutputStreamWrapper (Ptr<BinaryTraceWriter> writer);
   ~OutputStreamWrapper ();
 
   /**
@@ -92,9 +103,16 @@ public:
    */
   std::ostream *GetStream (void);
 
+  /**
+   * \returns the binary trace writer of the wrapper, or 0 if the wrapper
+   * was not created with one
+   */
+  Ptr<BinaryTraceWriter> GetBinaryWriter (void) const;
+
 private:
   std::ostream *m_ostream; //!< The output stream
   bool m_destroyable; //!< Can be destroyed
+  Ptr<BinaryTraceWriter> m_binaryWriter; //!< The binary trace writer, if any
 };
 
 } // namespace ns3
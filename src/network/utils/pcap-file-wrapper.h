@@ -82,6 +82,11 @@ public:
    */
   void Close (void);
 
+  /**
+   * Write the buffered records, if any, to the underlying pcap file.
+   */
+  void Flush (void);
+
   /**
    * Initialize the pcap file associated with this wrapper.  This file must have
    * been previously opened with write permissions.
@@ -102,6 +107,9 @@ public:
    * time zone from UTC/GMT.  For example, Pacific Standard Time in the US is
    * GMT-8, so one would enter -8 for that correction.  Defaults to 0 (UTC).
    *
+   * The records written next are buffered as set by the "BufferSize"
+   * Attribute, see PcapFile::SetBufferSize.
+   *
    * \warning Calling this method on an existing file will result in the loss
    * any existing data.
    */
@@ -224,6 +232,7 @@ private:
   PcapFile m_file; //!< Pcap file
   uint32_t m_snapLen; //!< max length of saved packets
   bool     m_nanosecMode; //!< Timestamps in nanosecond mode
+  uint32_t m_bufferSize; //!< Size of the write buffer, 0 if unbuffered
 };
 
 } // namespace ns3
@@ -20,6 +20,7 @@
 
 #include <iostream>
 #include <cstring>
+#include <list>
 #include "ns3/assert.h"
 #include "ns3/packet.h"
 #include "ns3/fatal-error.h"
@@ -27,8 +28,16 @@
 #include "ns3/header.h"
 #include "ns3/buffer.h"
 #include "pcap-file.h"
+#include "pcap-mapped-file.h"
 #include "ns3/log.h"
 #include "ns3/build-profile.h"
+#include "ns3/simulator.h"
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#include "ns3/system-mutex.h"
+#include "ns3/system-condition.h"
+#endif
 //
 // This file is used as part of the ns-3 test framework, so please refrain from 
 // adding any ns-3 specific constructs such as Packet to this file.
@@ -47,19 +56,401 @@ const uint32_t NS_SWAPPED_MAGIC = 0x4d3cb2a1; /**< Looks this way if byte swappi
 const uint16_t VERSION_MAJOR = 2;             /**< Major version of supported pcap file format */
 const uint16_t VERSION_MINOR = 4;             /**< Minor version of supported pcap file format */
 
+namespace {
+
+/**
+ * The maximum number of blocks queued for the writer thread.  Beyond
+ * this, the writing threads wait for the writer to catch up.
+ */
+const uint32_t MAX_QUEUED_CHUNKS = 64;
+
+/**
+ * The writer of the buffered pcap files.
+ *
+ * The simulation threads queue full blocks of records, which a single
+ * background thread writes to their files.
+ */
+class PcapFileWriter
+{
+public:
+  PcapFileWriter ();
+  ~PcapFileWriter ();
+
+  /**
+   * Queue a block of records for writing.
+   *
+   * This waits for the writer if too many blocks are already queued.
+   * \param [in] file The file to append the records to.
+   * \param [in] chunk The block, which the writer now owns.
+   */
+  void Submit (std::fstream *file, std::vector<char> *chunk);
+  /** Wait until all the blocks queued so far have been written. */
+  void Wait (void);
+  /**
+   * Get an empty block.
+   * \param [in] size The expected size of the block.
+   * \returns The block.
+   */
+  std::vector<char> *Allocate (uint32_t size);
+  /**
+   * Recycle an unused block.
+   * \param [in] chunk The block.
+   */
+  void Release (std::vector<char> *chunk);
+  /**
+   * Flush a file, once the writer thread no longer writes to it.
+   * \param [in] file The file.
+   */
+  void FlushFile (std::fstream *file);
+  /**
+   * Stop the writer thread from Simulator::Destroy, unless already
+   * planned.
+   */
+  void ScheduleStop (void);
+  /**
+   * Write the queued blocks and stop the writer thread.  The thread is
+   * started again by the next block queued.
+   */
+  void Stop (void);
+
+private:
+  /** A block of records and its file. */
+  struct Job
+  {
+    std::fstream *file;        //!< The file.
+    std::vector<char> *chunk;  //!< The block.
+  };
+
+  /** Body of the writer thread. */
+  void Run (void);
+  /**
+   * Write blocks to their files and recycle them.
+   * \param [in] jobs The blocks to write.
+   */
+  void Write (std::list<struct Job> *jobs);
+  /**
+   * Recycle a block, or delete it if enough blocks are already free.
+   * The caller must hold the lock, if any.
+   * \param [in] chunk The empty block.
+   */
+  void DoRelease (std::vector<char> *chunk);
+
+  std::list<struct Job> m_queue;               //!< The blocks to write.
+  std::list<std::vector<char> *> m_free;       //!< Recycled blocks.
+  uint64_t m_submitted;                        //!< The number of blocks queued.
+  uint64_t m_written;                          //!< The number of blocks written.
+  bool m_stop;                                 //!< Stop the writer thread.
+  bool m_stopScheduled;                        //!< Stop planned by Simulator::Destroy.
+#ifdef HAVE_PTHREAD_H
+  SystemMutex m_mutex;                         //!< Protects the queues and counters.
+  SystemMutex m_fileMutex;                     //!< Held while the files are written.
+  SystemCondition m_wakeup;                    //!< Wakes up the writer thread.
+  SystemCondition m_progress;                  //!< Signals written blocks.
+  Ptr<SystemThread> m_thread;                  //!< The writer thread, started on first use.
+#endif
+};
+
+PcapFileWriter::PcapFileWriter ()
+  : m_submitted (0),
+    m_written (0),
+    m_stop (false),
+    m_stopScheduled (false)
+{
+}
+
+PcapFileWriter::~PcapFileWriter ()
+{
+  // The thread is normally stopped by Simulator::Destroy already.
+  Stop ();
+  while (!m_free.empty ())
+    {
+      delete m_free.front ();
+      m_free.pop_front ();
+    }
+}
+
+void
+PcapFileWriter::Submit (std::fstream *file, std::vector<char> *chunk)
+{
+  struct Job job;
+  job.file = file;
+  job.chunk = chunk;
+#ifdef HAVE_PTHREAD_H
+  m_mutex.Lock ();
+  if (m_thread == 0)
+    {
+      m_thread = Create<SystemThread> (MakeCallback (&PcapFileWriter::Run, this));
+      m_thread->Start ();
+    }
+  while (m_queue.size () >= MAX_QUEUED_CHUNKS)
+    {
+      m_progress.SetCondition (false);
+      m_mutex.Unlock ();
+      m_wakeup.SetCondition (true);
+      m_wakeup.Signal ();
+      m_progress.TimedWait (1000000);
+      m_mutex.Lock ();
+    }
+  m_queue.push_back (job);
+  m_submitted++;
+  bool wakeup = m_queue.size () == 1;
+  m_mutex.Unlock ();
+  if (wakeup)
+    {
+      m_wakeup.SetCondition (true);
+      m_wakeup.Signal ();
+    }
+#else
+  std::list<struct Job> jobs;
+  jobs.push_back (job);
+  m_submitted++;
+  Write (&jobs);
+#endif
+}
+
+void
+PcapFileWriter::Wait (void)
+{
+#ifdef HAVE_PTHREAD_H
+  m_mutex.Lock ();
+  uint64_t target = m_submitted;
+  while (m_written < target)
+    {
+      m_progress.SetCondition (false);
+      m_mutex.Unlock ();
+      m_wakeup.SetCondition (true);
+      m_wakeup.Signal ();
+      m_progress.TimedWait (1000000);
+      m_mutex.Lock ();
+    }
+  m_mutex.Unlock ();
+#endif
+}
+
+std::vector<char> *
+PcapFileWriter::Allocate (uint32_t size)
+{
+  std::vector<char> *chunk = 0;
+  {
+#ifdef HAVE_PTHREAD_H
+    CriticalSection cs (m_mutex);
+#endif
+    if (!m_free.empty ())
+      {
+        chunk = m_free.front ();
+        m_free.pop_front ();
+      }
+  }
+  if (chunk == 0)
+    {
+      chunk = new std::vector<char> ();
+    }
+  chunk->reserve (size);
+  return chunk;
+}
+
+void
+PcapFileWriter::Release (std::vector<char> *chunk)
+{
+  chunk->clear ();
+#ifdef HAVE_PTHREAD_H
+  CriticalSection cs (m_mutex);
+#endif
+  DoRelease (chunk);
+}
+
+void
+PcapFileWriter::DoRelease (std::vector<char> *chunk)
+{
+  if (m_free.size () < MAX_QUEUED_CHUNKS)
+    {
+      m_free.push_back (chunk);
+    }
+  else
+    {
+      delete chunk;
+    }
+}
+
+void
+PcapFileWriter::FlushFile (std::fstream *file)
+{
+#ifdef HAVE_PTHREAD_H
+  CriticalSection cs (m_fileMutex);
+#endif
+  file->flush ();
+}
+
+void
+PcapFileWriter::ScheduleStop (void)
+{
+  if (!m_stopScheduled)
+    {
+      m_stopScheduled = true;
+      Simulator::ScheduleDestroy (&PcapFileWriter::Stop, this);
+    }
+}
+
+void
+PcapFileWriter::Stop (void)
+{
+  m_stopScheduled = false;
+#ifdef HAVE_PTHREAD_H
+  m_mutex.Lock ();
+  Ptr<SystemThread> thread = m_thread;
+  m_stop = true;
+  m_mutex.Unlock ();
+  if (thread != 0)
+    {
+      m_wakeup.SetCondition (true);
+      m_wakeup.Signal ();
+      thread->Join ();
+    }
+  // The blocks queued after the last batch of the thread are written
+  // here.  The next block queued starts a new thread.
+  m_mutex.Lock ();
+  std::list<struct Job> jobs;
+  jobs.swap (m_queue);
+  m_thread = 0;
+  m_stop = false;
+  m_mutex.Unlock ();
+  Write (&jobs);
+#else
+  Write (&m_queue);
+#endif
+}
+
+void
+PcapFileWriter::Run (void)
+{
+#ifdef HAVE_PTHREAD_H
+  while (true)
+    {
+      m_wakeup.SetCondition (false);
+      m_mutex.Lock ();
+      std::list<struct Job> jobs;
+      jobs.swap (m_queue);
+      bool stop = m_stop;
+      m_mutex.Unlock ();
+
+      Write (&jobs);
+      if (stop)
+        {
+          break;
+        }
+      m_wakeup.TimedWait (10000000);
+    }
+#endif
+}
+
+void
+PcapFileWriter::Write (std::list<struct Job> *jobs)
+{
+  {
+#ifdef HAVE_PTHREAD_H
+    CriticalSection cs (m_fileMutex);
+#endif
+    for (std::list<struct Job>::iterator i = jobs->begin (); i != jobs->end (); ++i)
+      {
+        if (!i->chunk->empty ())
+          {
+            i->file->write (&(*i->chunk)[0], i->chunk->size ());
+          }
+        i->chunk->clear ();
+      }
+  }
+#ifdef HAVE_PTHREAD_H
+  m_mutex.Lock ();
+#endif
+  for (std::list<struct Job>::iterator i = jobs->begin (); i != jobs->end (); ++i)
+    {
+      DoRelease (i->chunk);
+    }
+  m_written += jobs->size ();
+  jobs->clear ();
+#ifdef HAVE_PTHREAD_H
+  m_mutex.Unlock ();
+  m_progress.SetCondition (true);
+  m_progress.Broadcast ();
+#endif
+}
+
+/**
+ * Get the writer of the buffered pcap files.
+ * \returns The writer.
+ */
+PcapFileWriter *
+GetWriter (void)
+{
+  static PcapFileWriter writer;
+  return &writer;
+}
+
+/**
+ * The stream registered with FatalImpl for a pcap file: its flush
+ * flushes the file once the writer thread no longer writes to it.
+ */
+class PcapFileFatalStream : public std::ostream
+{
+public:
+  /**
+   * Constructor.
+   * \param [in] file The file flushed on fatal errors.
+   */
+  PcapFileFatalStream (std::fstream *file)
+    : std::ostream (0),
+      m_buffer (file)
+  {
+    rdbuf (&m_buffer);
+  }
+
+private:
+  /** The buffer of the stream, which only flushes the file. */
+  class Buffer : public std::streambuf
+  {
+  public:
+    /**
+     * Constructor.
+     * \param [in] file The file.
+     */
+    Buffer (std::fstream *file)
+      : m_file (file)
+    {
+    }
+
+  protected:
+    virtual int sync (void)
+    {
+      GetWriter ()->FlushFile (m_file);
+      return 0;
+    }
+
+  private:
+    std::fstream *m_file;  //!< The file.
+  };
+
+  Buffer m_buffer;  //!< The buffer.
+};
+
+} // unnamed namespace
+
 PcapFile::PcapFile ()
   : m_file (),
     m_swapMode (false),
-    m_nanosecMode (false)
+    m_nanosecMode (false),
+    m_bufferSize (0),
+    m_chunk (0),
+    m_fatalStream (new PcapFileFatalStream (&m_file))
 {
   NS_LOG_FUNCTION (this);
-  FatalImpl::RegisterStream (&m_file); 
+  FatalImpl::RegisterStream (m_fatalStream); 
 }
 
 PcapFile::~PcapFile ()
 {
   NS_LOG_FUNCTION (this);
-  FatalImpl::UnregisterStream (&m_file);
+  FatalImpl::UnregisterStream (m_fatalStream);
+  delete m_fatalStream;
   Close ();
 }
 
@@ -68,18 +459,30 @@ bool
 PcapFile::Fail (void) const
 {
   NS_LOG_FUNCTION (this);
+  if (m_bufferSize != 0)
+    {
+      GetWriter ()->Wait ();
+    }
   return m_file.fail ();
 }
 bool 
 PcapFile::Eof (void) const
 {
   NS_LOG_FUNCTION (this);
+  if (m_bufferSize != 0)
+    {
+      GetWriter ()->Wait ();
+    }
   return m_file.eof ();
 }
 void 
 PcapFile::Clear (void)
 {
   NS_LOG_FUNCTION (this);
+  if (m_bufferSize != 0)
+    {
+      GetWriter ()->Wait ();
+    }
   m_file.clear ();
 }
 
@@ -88,9 +491,98 @@ void
 PcapFile::Close (void)
 {
   NS_LOG_FUNCTION (this);
+  Flush ();
   m_file.close ();
 }
 
+void
+PcapFile::SetBufferSize (uint32_t size)
+{
+  NS_LOG_FUNCTION (this << size);
+  Flush ();
+  m_bufferSize = size;
+  if (m_bufferSize != 0)
+    {
+      GetWriter ()->ScheduleStop ();
+    }
+}
+
+uint32_t
+PcapFile::GetBufferSize (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_bufferSize;
+}
+
+void
+PcapFile::Flush (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_chunk != 0)
+    {
+      SubmitChunk ();
+    }
+  if (m_bufferSize != 0)
+    {
+      GetWriter ()->Wait ();
+      m_file.flush ();
+    }
+}
+
+void
+PcapFile::WriteData (uint8_t const *data, uint32_t size)
+{
+  if (m_bufferSize == 0)
+    {
+      m_file.write ((const char *)data, size);
+    }
+  else
+    {
+      std::memcpy (AppendData (size), data, size);
+    }
+}
+
+uint8_t *
+PcapFile::AppendData (uint32_t size)
+{
+  NS_ASSERT (m_bufferSize != 0);
+  if (m_chunk == 0)
+    {
+      m_chunk = GetWriter ()->Allocate (m_bufferSize);
+    }
+  std::vector<char>::size_type used = m_chunk->size ();
+  m_chunk->resize (used + size);
+  return reinterpret_cast<uint8_t *> (m_chunk->data ()) + used;
+}
+
+void
+PcapFile::EndRecord (void)
+{
+  if (m_bufferSize == 0)
+    {
+      NS_BUILD_DEBUG (m_file.flush ());
+    }
+  else if (m_chunk != 0 && m_chunk->size () >= m_bufferSize)
+    {
+      SubmitChunk ();
+    }
+}
+
+void
+PcapFile::SubmitChunk (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_chunk->empty ())
+    {
+      GetWriter ()->Release (m_chunk);
+    }
+  else
+    {
+      GetWriter ()->Submit (&m_file, m_chunk);
+    }
+  m_chunk = 0;
+}
+
 uint32_t
 PcapFile::GetMagic (void)
 {
@@ -202,6 +694,11 @@ void
 PcapFile::WriteFileHeader (void)
 {
   NS_LOG_FUNCTION (this);
+  //
+  // The records still buffered belong to the previous contents of the file.
+  //
+  Flush ();
+
   //
   // If we're initializing the file, we need to write the pcap file header
   // at the start of the file.
@@ -325,6 +822,7 @@ void
 PcapFile::Open (std::string const &filename, std::ios::openmode mode)
 {
   NS_LOG_FUNCTION (this << filename << mode);
+  Flush ();
   NS_ASSERT ((mode & std::ios::app) == 0);
   NS_ASSERT (!m_file.fail ());
   //
@@ -403,7 +901,7 @@ uint32_t
 PcapFile::WritePacketHeader (uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen)
 {
   NS_LOG_FUNCTION (this << tsSec << tsUsec << totalLen);
-  NS_ASSERT (m_file.good ());
+  NS_ASSERT (m_bufferSize != 0 || m_file.good ());
 
   uint32_t inclLen = totalLen > m_fileHeader.m_snapLen ? m_fileHeader.m_snapLen : totalLen;
 
@@ -422,11 +920,10 @@ PcapFile::WritePacketHeader (uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen)
   // Watch out for memory alignment differences between machines, so write
   // them all individually.
   //
-  m_file.write ((const char *)&header.m_tsSec, sizeof(header.m_tsSec));
-  m_file.write ((const char *)&header.m_tsUsec, sizeof(header.m_tsUsec));
-  m_file.write ((const char *)&header.m_inclLen, sizeof(header.m_inclLen));
-  m_file.write ((const char *)&header.m_origLen, sizeof(header.m_origLen));
-  NS_BUILD_DEBUG(m_file.flush());
+  WriteData ((uint8_t const *)&header.m_tsSec, sizeof(header.m_tsSec));
+  WriteData ((uint8_t const *)&header.m_tsUsec, sizeof(header.m_tsUsec));
+  WriteData ((uint8_t const *)&header.m_inclLen, sizeof(header.m_inclLen));
+  WriteData ((uint8_t const *)&header.m_origLen, sizeof(header.m_origLen));
   return inclLen;
 }
 
@@ -435,8 +932,8 @@ PcapFile::Write (uint32_t tsSec, uint32_t tsUsec, uint8_t const * const data, ui
 {
   NS_LOG_FUNCTION (this << tsSec << tsUsec << &data << totalLen);
   uint32_t inclLen = WritePacketHeader (tsSec, tsUsec, totalLen);
-  m_file.write ((const char *)data, inclLen);
-  NS_BUILD_DEBUG(m_file.flush());
+  WriteData (data, inclLen);
+  EndRecord ();
 }
 
 void 
@@ -444,8 +941,15 @@ PcapFile::Write (uint32_t tsSec, uint32_t tsUsec, Ptr<const Packet> p)
 {
   NS_LOG_FUNCTION (this << tsSec << tsUsec << p);
   uint32_t inclLen = WritePacketHeader (tsSec, tsUsec, p->GetSize ());
-  p->CopyData (&m_file, inclLen);
-  NS_BUILD_DEBUG(m_file.flush());
+  if (m_bufferSize == 0)
+    {
+      p->CopyData (&m_file, inclLen);
+    }
+  else
+    {
+      p->CopyData (AppendData (inclLen), inclLen);
+    }
+  EndRecord ();
 }
 
 void 
@@ -460,9 +964,18 @@ PcapFile::Write (uint32_t tsSec, uint32_t tsUsec, const Header &header, Ptr<cons
   headerBuffer.AddAtStart (headerSize);
   header.Serialize (headerBuffer.Begin ());
   uint32_t toCopy = std::min (headerSize, inclLen);
-  headerBuffer.CopyData (&m_file, toCopy);
   inclLen -= toCopy;
-  p->CopyData (&m_file, inclLen);
+  if (m_bufferSize == 0)
+    {
+      headerBuffer.CopyData (&m_file, toCopy);
+      p->CopyData (&m_file, inclLen);
+    }
+  else
+    {
+      headerBuffer.CopyData (AppendData (toCopy), toCopy);
+      p->CopyData (AppendData (inclLen), inclLen);
+    }
+  EndRecord ();
 }
 
 void
@@ -530,60 +1043,59 @@ PcapFile::Diff (std::string const & f1, std::string const & f2,
                 uint32_t snapLen)
 {
   NS_LOG_FUNCTION (f1 << f2 << sec << usec << snapLen);
-  PcapFile pcap1, pcap2;
-  pcap1.Open (f1, std::ios::in);
-  pcap2.Open (f2, std::ios::in);
+  //
+  // The files are compared in place, which is much faster than reading
+  // their records through Read on large captures.
+  //
+  PcapMappedFile pcap1, pcap2;
+  pcap1.Open (f1);
+  pcap2.Open (f2);
   bool bad = pcap1.Fail () || pcap2.Fail ();
   if (bad)
     {
       return true;
     }
 
-  uint8_t *data1 = new uint8_t [snapLen] ();
-  uint8_t *data2 = new uint8_t [snapLen] ();
+  PcapMappedFile::Record record1;
+  PcapMappedFile::Record record2;
   uint32_t tsSec1 = 0;
-  uint32_t tsSec2 = 0;
   uint32_t tsUsec1 = 0;
-  uint32_t tsUsec2 = 0;
-  uint32_t inclLen1 = 0;
-  uint32_t inclLen2 = 0;
-  uint32_t origLen1 = 0;
-  uint32_t origLen2 = 0;
-  uint32_t readLen1 = 0;
-  uint32_t readLen2 = 0;
   bool diff = false;
 
-  while (!pcap1.Eof () && !pcap2.Eof ())
+  while (true)
     {
-      pcap1.Read (data1, snapLen, tsSec1, tsUsec1, inclLen1, origLen1, readLen1);
-      pcap2.Read (data2, snapLen, tsSec2, tsUsec2, inclLen2, origLen2, readLen2);
+      bool more1 = pcap1.Read (&record1);
+      bool more2 = pcap2.Read (&record2);
 
-      bool same = pcap1.Fail () == pcap2.Fail ();
-      if (!same)
+      if (more1 != more2)
         {
-          diff = true;
+          diff = true; // One file has more packets than the other
           break;
         }
-      if (pcap1.Eof ())
+      if (!more1)
         {
           break;
         }
 
       ++packets;
-      
-      if (tsSec1 != tsSec2 || tsUsec1 != tsUsec2)
+      tsSec1 = record1.tsSec;
+      tsUsec1 = record1.tsUsec;
+
+      if (record1.tsSec != record2.tsSec || record1.tsUsec != record2.tsUsec)
         {
           diff = true; // Next packet timestamps do not match
           break;
         }
 
+      uint32_t readLen1 = std::min (snapLen, record1.inclLen);
+      uint32_t readLen2 = std::min (snapLen, record2.inclLen);
       if (readLen1 != readLen2)
         {
           diff = true; // Packet lengths do not match
           break;
         }
 
-      if (std::memcmp (data1, data2, readLen1) != 0)
+      if (std::memcmp (record1.data, record2.data, readLen1) != 0)
         {
           diff = true; // Packet data do not match
           break;
@@ -592,16 +1104,14 @@ PcapFile::Diff (std::string const & f1, std::string const & f2,
   sec = tsSec1;
   usec = tsUsec1;
 
-  bad = pcap1.Fail () || pcap2.Fail ();
-  bool eof = pcap1.Eof () && pcap2.Eof ();
-  if (bad && !eof)
+  //
+  // A truncated last record makes the files different.
+  //
+  if (pcap1.Fail () || pcap2.Fail ())
     {
       diff = true;
     }
 
-  delete[] data1;
-  delete[] data2;
-
   return diff;
 }
 
@@ -23,6 +23,7 @@
 
 #include <string>
 #include <fstream>
+#include <vector>
 #include <stdint.h>
 #include "ns3/ptr.h"
 
@@ -82,9 +83,50 @@ public:
 
   /**
    * Close the underlying file.
+   *
+   * The buffered records, if any, are written first.
    */
   void Close (void);
 
+  /**
+   * \brief Set the size of the write buffer.
+   *
+   * By default, each record is written to the underlying file as soon as
+   * it is passed to one of the Write methods.  With a non-zero buffer
+   * size, the records are instead appended to an in-memory block, and
+   * each block that reaches \pname{size} bytes is handed to a background
+   * thread which writes it to the file in a single call.  One thread
+   * serves all the buffered pcap files, so that tracing many devices
+   * does not multiply the writer threads.  The file contents are the
+   * same in both modes.
+   *
+   * The state of the underlying iostream reflects the buffered records
+   * only once they have been written: Fail and Eof wait for the
+   * background writes, and Flush writes the records still in memory.
+   * Without threading support, the blocks are written by the calling
+   * thread.  The background thread is stopped by Simulator::Destroy,
+   * after writing the blocks queued.
+   *
+   * \param size The size of the blocks, in bytes, or 0 to write the
+   * records directly.
+   */
+  void SetBufferSize (uint32_t size);
+
+  /**
+   * \returns The size of the write buffer, or 0 if the records are
+   * written directly.
+   */
+  uint32_t GetBufferSize (void) const;
+
+  /**
+   * \brief Write all the buffered records to the file.
+   *
+   * This returns once the records are in the underlying iostream,
+   * which is then flushed.  It does nothing special when the records
+   * are written directly.
+   */
+  void Flush (void);
+
   /**
    * Initialize the pcap file associated with this object.  This file must have
    * been previously opened with write permissions.
@@ -361,6 +403,27 @@ private:
    */
   uint32_t WritePacketHeader (uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen);
 
+  /**
+   * \brief Write bytes of a record, to the file or to the write buffer
+   * \param data the bytes
+   * \param size the number of bytes
+   */
+  void WriteData (uint8_t const *data, uint32_t size);
+  /**
+   * \brief Get room at the end of the write buffer
+   * \param size the number of bytes to append
+   * \returns the start of the room, to be filled by the caller
+   */
+  uint8_t *AppendData (uint32_t size);
+  /**
+   * \brief Hand the write buffer to the writer thread once it is full
+   */
+  void EndRecord (void);
+  /**
+   * \brief Hand the write buffer to the writer thread
+   */
+  void SubmitChunk (void);
+
   /**
    * \brief Read and verify a Pcap file header
    */
@@ -371,6 +434,9 @@ private:
   PcapFileHeader m_fileHeader;  //!< file header
   bool m_swapMode;              //!< swap mode
   bool m_nanosecMode;           //!< nanosecond timestamp mode
+  uint32_t m_bufferSize;        //!< size of the write buffer, 0 if unbuffered
+  std::vector<char> *m_chunk;   //!< write buffer, 0 until the first record
+  std::ostream *m_fatalStream;  //!< flushes m_file on fatal errors, apart from the writer thread
 };
 
 } // namespace ns3
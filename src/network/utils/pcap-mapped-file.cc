@@ -0,0 +1,347 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cstring>
+#include <fstream>
+#include "ns3/core-config.h"
+#include "ns3/log.h"
+#include "pcap-mapped-file.h"
+
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+//
+// This file is used as part of the ns-3 test framework, so please refrain from
+// adding any ns-3 specific constructs such as Packet to this file.
+//
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("PcapMappedFile");
+
+namespace {
+
+const uint32_t MAGIC = 0xa1b2c3d4;            //!< Magic number identifying standard pcap file format
+const uint32_t SWAPPED_MAGIC = 0xd4c3b2a1;    //!< Looks this way if byte swapping is required
+const uint32_t NS_MAGIC = 0xa1b23c4d;         //!< Magic number identifying nanosec resolution pcap file format
+const uint32_t NS_SWAPPED_MAGIC = 0x4d3cb2a1; //!< Looks this way if byte swapping is required
+
+const uint16_t VERSION_MAJOR = 2;             //!< Major version of supported pcap file format
+const uint16_t VERSION_MINOR = 4;             //!< Minor version of supported pcap file format
+
+const uint32_t FILE_HEADER_SIZE = 24;         //!< Size of the pcap file header
+const uint32_t RECORD_HEADER_SIZE = 16;       //!< Size of the pcap record header
+
+} // unnamed namespace
+
+PcapMappedFile::PcapMappedFile ()
+  : m_data (0),
+    m_size (0),
+    m_offset (0),
+    m_mapped (false),
+    m_fail (false),
+    m_swapMode (false),
+    m_nanosecMode (false),
+    m_magicNumber (0),
+    m_versionMajor (0),
+    m_versionMinor (0),
+    m_zone (0),
+    m_sigFigs (0),
+    m_snapLen (0),
+    m_type (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+PcapMappedFile::~PcapMappedFile ()
+{
+  NS_LOG_FUNCTION (this);
+  Close ();
+}
+
+void
+PcapMappedFile::Open (std::string const &filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+  Close ();
+  m_fail = true;
+
+#ifdef HAVE_SYS_MMAN_H
+  int fd = open (filename.c_str (), O_RDONLY);
+  if (fd < 0)
+    {
+      return;
+    }
+  struct stat st;
+  if (fstat (fd, &st) == 0 && st.st_size > 0)
+    {
+      void *data = mmap (0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data != MAP_FAILED)
+        {
+          // The records are usually read once, from start to end.
+          madvise (data, st.st_size, MADV_SEQUENTIAL);
+          m_data = static_cast<uint8_t const *> (data);
+          m_size = st.st_size;
+          m_mapped = true;
+        }
+    }
+  close (fd);
+#endif
+
+  if (m_data == 0)
+    {
+      std::ifstream file (filename.c_str (), std::ios::in | std::ios::binary);
+      if (!file.is_open ())
+        {
+          return;
+        }
+      file.seekg (0, std::ios::end);
+      std::streamoff size = file.tellg ();
+      file.seekg (0, std::ios::beg);
+      if (size <= 0)
+        {
+          return;
+        }
+      uint8_t *data = new uint8_t [size];
+      file.read (reinterpret_cast<char *> (data), size);
+      if (file.fail ())
+        {
+          delete [] data;
+          return;
+        }
+      m_data = data;
+      m_size = size;
+    }
+
+  m_fail = false;
+  ReadAndVerifyFileHeader ();
+}
+
+void
+PcapMappedFile::Close (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_data != 0)
+    {
+#ifdef HAVE_SYS_MMAN_H
+      if (m_mapped)
+        {
+          munmap (const_cast<uint8_t *> (m_data), m_size);
+        }
+#endif
+      if (!m_mapped)
+        {
+          delete [] m_data;
+        }
+    }
+  m_data = 0;
+  m_size = 0;
+  m_offset = 0;
+  m_mapped = false;
+  m_fail = false;
+}
+
+bool
+PcapMappedFile::Fail (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_fail;
+}
+
+bool
+PcapMappedFile::Eof (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_offset >= m_size;
+}
+
+uint16_t
+PcapMappedFile::ReadU16 (uint64_t offset) const
+{
+  uint16_t val;
+  std::memcpy (&val, m_data + offset, sizeof (val));
+  if (m_swapMode)
+    {
+      val = ((val >> 8) & 0x00ff) | ((val << 8) & 0xff00);
+    }
+  return val;
+}
+
+uint32_t
+PcapMappedFile::ReadU32 (uint64_t offset) const
+{
+  uint32_t val;
+  std::memcpy (&val, m_data + offset, sizeof (val));
+  if (m_swapMode)
+    {
+      val = ((val >> 24) & 0x000000ff) | ((val >> 8) & 0x0000ff00) | ((val << 8) & 0x00ff0000) | ((val << 24) & 0xff000000);
+    }
+  return val;
+}
+
+void
+PcapMappedFile::ReadAndVerifyFileHeader (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_size < FILE_HEADER_SIZE)
+    {
+      m_fail = true;
+      return;
+    }
+
+  //
+  // There are four possible magic numbers that can be there.  Normal and byte
+  // swapped versions of the standard magic number, and normal and byte swapped
+  // versions of the magic number indicating nanosecond resolution timestamps.
+  //
+  m_swapMode = false;
+  m_magicNumber = ReadU32 (0);
+  if (m_magicNumber != MAGIC && m_magicNumber != SWAPPED_MAGIC &&
+      m_magicNumber != NS_MAGIC && m_magicNumber != NS_SWAPPED_MAGIC)
+    {
+      m_fail = true;
+      return;
+    }
+  m_swapMode = m_magicNumber == SWAPPED_MAGIC || m_magicNumber == NS_SWAPPED_MAGIC;
+  m_magicNumber = ReadU32 (0);
+  m_nanosecMode = m_magicNumber == NS_MAGIC;
+
+  m_versionMajor = ReadU16 (4);
+  m_versionMinor = ReadU16 (6);
+  m_zone = ReadU32 (8);
+  m_sigFigs = ReadU32 (12);
+  m_snapLen = ReadU32 (16);
+  m_type = ReadU32 (20);
+
+  //
+  // We only deal with one version of the pcap file format, and time zone
+  // offsets corresponding to a real place on the planet.
+  //
+  if (m_versionMajor != VERSION_MAJOR || m_versionMinor != VERSION_MINOR
+      || m_zone < -12 || m_zone > 12)
+    {
+      m_fail = true;
+      return;
+    }
+  m_offset = FILE_HEADER_SIZE;
+}
+
+bool
+PcapMappedFile::Read (struct Record *record)
+{
+  NS_LOG_FUNCTION (this << record);
+  if (m_fail || m_offset >= m_size)
+    {
+      return false;
+    }
+  if (m_size - m_offset < RECORD_HEADER_SIZE)
+    {
+      m_fail = true;
+      return false;
+    }
+  uint32_t inclLen = ReadU32 (m_offset + 8);
+  if (m_size - m_offset - RECORD_HEADER_SIZE < inclLen)
+    {
+      m_fail = true;
+      return false;
+    }
+  record->tsSec = ReadU32 (m_offset);
+  record->tsUsec = ReadU32 (m_offset + 4);
+  record->inclLen = inclLen;
+  record->origLen = ReadU32 (m_offset + 12);
+  record->data = m_data + m_offset + RECORD_HEADER_SIZE;
+  m_offset += RECORD_HEADER_SIZE + inclLen;
+  return true;
+}
+
+void
+PcapMappedFile::Rewind (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_data != 0 && m_size >= FILE_HEADER_SIZE)
+    {
+      m_offset = FILE_HEADER_SIZE;
+    }
+}
+
+bool
+PcapMappedFile::GetSwapMode (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_swapMode;
+}
+
+bool
+PcapMappedFile::IsNanoSecMode (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_nanosecMode;
+}
+
+uint32_t
+PcapMappedFile::GetMagic (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_magicNumber;
+}
+
+uint16_t
+PcapMappedFile::GetVersionMajor (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_versionMajor;
+}
+
+uint16_t
+PcapMappedFile::GetVersionMinor (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_versionMinor;
+}
+
+int32_t
+PcapMappedFile::GetTimeZoneOffset (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_zone;
+}
+
+uint32_t
+PcapMappedFile::GetSigFigs (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_sigFigs;
+}
+
+uint32_t
+PcapMappedFile::GetSnapLen (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_snapLen;
+}
+
+uint32_t
+PcapMappedFile::GetDataLinkType (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_type;
+}
+
+} // namespace ns3
@@ -0,0 +1,171 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PCAP_MAPPED_FILE_H
+#define PCAP_MAPPED_FILE_H
+
+#include <string>
+#include <stdint.h>
+
+namespace ns3 {
+
+/**
+ * \brief A read-only pcap file, mapped in memory.
+ *
+ * The whole file is mapped in memory when it is opened, so that its
+ * records are read in place: PcapMappedFile::Read returns the record
+ * header fields and a pointer to the packet data inside the mapping,
+ * without copying them.  This makes iterating over large captures much
+ * cheaper than PcapFile::Read, which goes through an iostream and
+ * copies each record into a caller buffer.
+ *
+ * Files in the byte order of either endianness, with microsecond or
+ * nanosecond timestamps, are supported.  Where memory mapping is not
+ * available, the file is read in memory at once instead.
+ */
+class PcapMappedFile
+{
+public:
+  /**
+   * \brief A record of the file.
+   */
+  struct Record
+  {
+    uint32_t tsSec;         //!< Seconds part of the timestamp
+    uint32_t tsUsec;        //!< Microseconds part of the timestamp, or nanoseconds in nanosecond mode
+    uint32_t inclLen;       //!< Number of bytes of the packet saved in the file
+    uint32_t origLen;       //!< Actual length of the original packet
+    uint8_t const *data;    //!< The inclLen bytes of the packet, valid until the file is closed
+  };
+
+  PcapMappedFile ();
+  ~PcapMappedFile ();
+
+  /**
+   * Map a pcap file in memory and check its file header.
+   *
+   * The fail bit is set if the file cannot be mapped or does not start
+   * with a valid pcap file header.
+   *
+   * \param filename The name of the file.
+   */
+  void Open (std::string const &filename);
+
+  /**
+   * Unmap the file.  The data of the records read so far become invalid.
+   */
+  void Close (void);
+
+  /**
+   * \return true if the file could not be opened, or if its last record
+   * is truncated.
+   */
+  bool Fail (void) const;
+
+  /**
+   * \return true if all the records have been read.
+   */
+  bool Eof (void) const;
+
+  /**
+   * \brief Read the next record of the file, in place.
+   *
+   * \param [out] record The record.  The header fields are converted to
+   * the host byte order.
+   * \return true if a record was read, false at the end of the file or
+   * if the next record is truncated, in which case the fail bit is set.
+   */
+  bool Read (struct Record *record);
+
+  /**
+   * \brief Go back to the first record of the file.
+   */
+  void Rewind (void);
+
+  /**
+   * \returns true if the file is in the byte order opposite to the host.
+   */
+  bool GetSwapMode (void) const;
+  /**
+   * \returns true if the packet timestamps have nanosecond resolution.
+   */
+  bool IsNanoSecMode (void) const;
+  /**
+   * \returns magic number, as found in the file
+   */
+  uint32_t GetMagic (void) const;
+  /**
+   * \returns major version of the file format
+   */
+  uint16_t GetVersionMajor (void) const;
+  /**
+   * \returns minor version of the file format
+   */
+  uint16_t GetVersionMinor (void) const;
+  /**
+   * \returns time zone offset
+   */
+  int32_t GetTimeZoneOffset (void) const;
+  /**
+   * \returns accuracy of timestamps
+   */
+  uint32_t GetSigFigs (void) const;
+  /**
+   * \returns max length of saved packets
+   */
+  uint32_t GetSnapLen (void) const;
+  /**
+   * \returns data link type of the packets
+   */
+  uint32_t GetDataLinkType (void) const;
+
+private:
+  /**
+   * \brief Read a 16 bits field of the mapping.
+   * \param offset The offset of the field.
+   * \returns The field, in host byte order.
+   */
+  uint16_t ReadU16 (uint64_t offset) const;
+  /**
+   * \brief Read a 32 bits field of the mapping.
+   * \param offset The offset of the field.
+   * \returns The field, in host byte order.
+   */
+  uint32_t ReadU32 (uint64_t offset) const;
+  /**
+   * \brief Check the file header and read its fields.
+   */
+  void ReadAndVerifyFileHeader (void);
+
+  uint8_t const *m_data;    //!< The contents of the file
+  uint64_t m_size;          //!< The size of the file
+  uint64_t m_offset;        //!< The offset of the next record
+  bool m_mapped;            //!< Whether m_data is mapped or allocated
+  bool m_fail;              //!< Fail bit
+  bool m_swapMode;          //!< Swap mode
+  bool m_nanosecMode;       //!< Nanosecond timestamp mode
+  uint32_t m_magicNumber;   //!< Magic number
+  uint16_t m_versionMajor;  //!< Major version
+  uint16_t m_versionMinor;  //!< Minor version
+  int32_t m_zone;           //!< Time zone correction
+  uint32_t m_sigFigs;       //!< Accuracy of timestamps
+  uint32_t m_snapLen;       //!< Maximum length of packet data stored in records
+  uint32_t m_type;          //!< Data link type of packet data
+};
+
+} // namespace ns3
+
+#endif /* PCAP_MAPPED_FILE_H */
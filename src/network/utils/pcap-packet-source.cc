@@ -0,0 +1,177 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/simulator.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/packet.h"
+#include "ns3/node.h"
+#include "ns3/net-device.h"
+#include "ns3/ethernet-header.h"
+#include "ns3/trace-helper.h"
+#include "pcap-packet-source.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("PcapPacketSource");
+
+NS_OBJECT_ENSURE_REGISTERED (PcapPacketSource);
+
+TypeId
+PcapPacketSource::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::PcapPacketSource")
+    .SetParent<Application> ()
+    .SetGroupName("Network")
+    .AddConstructor<PcapPacketSource> ()
+    .AddAttribute ("Filename",
+                   "The name of the pcap file to replay.",
+                   StringValue (""),
+                   MakeStringAccessor (&PcapPacketSource::m_filename),
+                   MakeStringChecker ())
+    .AddAttribute ("Protocol",
+                   "The protocol number of the packets of non-Ethernet captures.",
+                   UintegerValue (0x0800),
+                   MakeUintegerAccessor (&PcapPacketSource::m_protocol),
+                   MakeUintegerChecker<uint16_t> ())
+    .AddTraceSource ("Tx", "A packet has been sent",
+                     MakeTraceSourceAccessor (&PcapPacketSource::m_txTrace),
+                     "ns3::Packet::TracedCallback")
+  ;
+  return tid;
+}
+
+PcapPacketSource::PcapPacketSource ()
+  : m_sent (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+PcapPacketSource::~PcapPacketSource ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+PcapPacketSource::SetNetDevice (Ptr<NetDevice> device)
+{
+  NS_LOG_FUNCTION (this << device);
+  m_device = device;
+}
+
+uint32_t
+PcapPacketSource::GetSent (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_sent;
+}
+
+void
+PcapPacketSource::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_device = 0;
+  m_file.Close ();
+  Application::DoDispose ();
+}
+
+void
+PcapPacketSource::StartApplication (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_device == 0)
+    {
+      NS_ABORT_MSG_IF (GetNode ()->GetNDevices () == 0, "PcapPacketSource: no device to send through");
+      m_device = GetNode ()->GetDevice (0);
+    }
+
+  m_file.Open (m_filename);
+  NS_ABORT_MSG_IF (m_file.Fail (), "PcapPacketSource: unable to read pcap file " << m_filename);
+
+  m_startTime = Simulator::Now ();
+  if (m_file.Read (&m_record))
+    {
+      m_firstTimestamp = GetTimestamp (m_record);
+      m_sendEvent = Simulator::ScheduleNow (&PcapPacketSource::Send, this);
+    }
+}
+
+void
+PcapPacketSource::StopApplication (void)
+{
+  NS_LOG_FUNCTION (this);
+  Simulator::Cancel (m_sendEvent);
+  m_file.Close ();
+}
+
+Time
+PcapPacketSource::GetTimestamp (struct PcapMappedFile::Record const &record) const
+{
+  uint64_t subsec = m_file.IsNanoSecMode () ? record.tsUsec : record.tsUsec * 1000ULL;
+  return NanoSeconds (record.tsSec * 1000000000ULL + subsec);
+}
+
+void
+PcapPacketSource::ScheduleNext (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_file.Read (&m_record))
+    {
+      NS_LOG_INFO ("End of pcap file " << m_filename << " after " << m_sent << " packets");
+      return;
+    }
+  Time when = m_startTime + GetTimestamp (m_record) - m_firstTimestamp;
+  if (when < Simulator::Now ())
+    {
+      // The records of a capture are not always in order.
+      when = Simulator::Now ();
+    }
+  m_sendEvent = Simulator::Schedule (when - Simulator::Now (), &PcapPacketSource::Send, this);
+}
+
+void
+PcapPacketSource::Send (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_sendEvent.IsExpired ());
+
+  Ptr<Packet> p = Create<Packet> (m_record.data, m_record.inclLen);
+  if (m_file.GetDataLinkType () == PcapHelper::DLT_EN10MB && m_record.inclLen >= 14)
+    {
+      EthernetHeader header (false);
+      p->RemoveHeader (header);
+      if (m_device->SupportsSendFrom ())
+        {
+          m_device->SendFrom (p, header.GetSource (), header.GetDestination (), header.GetLengthType ());
+        }
+      else
+        {
+          m_device->Send (p, header.GetDestination (), header.GetLengthType ());
+        }
+    }
+  else
+    {
+      m_device->Send (p, m_device->GetBroadcast (), m_protocol);
+    }
+  m_sent++;
+  m_txTrace (p);
+
+  ScheduleNext ();
+}
+
+} // Namespace ns3
@@ -0,0 +1,119 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PCAP_PACKET_SOURCE_H
+#define PCAP_PACKET_SOURCE_H
+
+#include "ns3/application.h"
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
+#include "ns3/traced-callback.h"
+#include "pcap-mapped-file.h"
+
+namespace ns3 {
+
+class NetDevice;
+class Packet;
+
+/**
+ * \brief Replay the packets of a pcap file through a NetDevice.
+ *
+ * The records of the file are sent through the device at the simulated
+ * times given by their timestamps, relative to the first record: the
+ * first packet is sent when the application starts.  The file is read
+ * in place with a PcapMappedFile, one record ahead, so that large
+ * captures are replayed without being loaded in memory.
+ *
+ * Ethernet captures (data link type 1) are sent with the destination,
+ * source and EtherType of their Ethernet header, which is removed from
+ * the packet.  The source address is used only if the device supports
+ * NetDevice::SendFrom.  The packets of other captures are sent whole,
+ * to the broadcast address of the device, with the "Protocol" number.
+ *
+ * Packets larger than the MTU of the device are dropped by the device.
+ * Provides a "Tx" Traced Callback with the packets sent.
+ */
+class PcapPacketSource : public Application
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  PcapPacketSource ();
+
+  virtual ~PcapPacketSource ();
+
+  /**
+   * \brief Set the device to send the packets through.
+   *
+   * By default, the packets are sent through the first device of the
+   * node.
+   *
+   * \param device the device, which must belong to the node of the
+   * application
+   */
+  void SetNetDevice (Ptr<NetDevice> device);
+
+  /**
+   * \return the number of packets sent so far
+   */
+  uint32_t GetSent (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  virtual void StartApplication (void);
+  virtual void StopApplication (void);
+
+  /**
+   * \brief Read the next record and schedule its transmission
+   */
+  void ScheduleNext (void);
+
+  /**
+   * \brief Send the packet of the record read last
+   */
+  void Send (void);
+
+  /**
+   * \brief Get the timestamp of a record
+   * \param record the record
+   * \return the timestamp
+   */
+  Time GetTimestamp (struct PcapMappedFile::Record const &record) const;
+
+  std::string m_filename;           //!< Name of the pcap file
+  uint16_t m_protocol;              //!< Protocol number of non-Ethernet captures
+  Ptr<NetDevice> m_device;          //!< Device to send the packets through
+  PcapMappedFile m_file;            //!< The pcap file
+  PcapMappedFile::Record m_record;  //!< The next record to send
+  Time m_firstTimestamp;            //!< Timestamp of the first record
+  Time m_startTime;                 //!< Time of the first transmission
+  uint32_t m_sent;                  //!< Counter for sent packets
+  EventId m_sendEvent;              //!< Event to send the next packet
+
+  /// Traced Callback: sent packets.
+  TracedCallback<Ptr<const Packet> > m_txTrace;
+};
+
+} // namespace ns3
+
+#endif /* PCAP_PACKET_SOURCE_H */
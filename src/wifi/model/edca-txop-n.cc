@@ -38,7 +38,7 @@
 #include "ns3/simulator.h"
 
 #undef NS_LOG_APPEND_CONTEXT
-#define NS_LOG_APPEND_CONTEXT if (m_low != 0) { std::clog << "[mac=" << m_low->GetAddress () << "] "; }
+#define NS_LOG_APPEND_CONTEXT if (m_low != 0) { ns3::LogContextStream () << "[mac=" << m_low->GetAddress () << "] "; }
 
 namespace ns3 {
 
@@ -39,7 +39,7 @@
 #include "wifi-mac-queue.h"
 
 #undef NS_LOG_APPEND_CONTEXT
-#define NS_LOG_APPEND_CONTEXT std::clog << "[mac=" << m_self << "] "
+#define NS_LOG_APPEND_CONTEXT ns3::LogContextStream () << "[mac=" << m_self << "] "
 
 namespace ns3 {
 
@@ -0,0 +1,214 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Benchmark the computation of the global routes of a grid of routers
+// connected by point-to-point links, by one thread and by several threads,
+// and their update after links go down and up again, fully or
+// incrementally.  The memory taken by the routing tables is measured with
+// and without the aggregation of the routes.
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include <iostream>
+#include <limits>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace ns3;
+
+// The heap bytes in use, counted by the replaced global operators new and
+// delete.  Each block starts with its size.
+static std::atomic<uint64_t> g_heapBytes (0);
+static const std::size_t g_heapHeader = 16;
+
+void *
+operator new (std::size_t size)
+{
+  char *block = static_cast<char *> (std::malloc (size + g_heapHeader));
+  if (block == 0)
+    {
+      throw std::bad_alloc ();
+    }
+  *reinterpret_cast<std::size_t *> (block) = size;
+  g_heapBytes += size;
+  return block + g_heapHeader;
+}
+
+void *
+operator new[] (std::size_t size)
+{
+  return operator new (size);
+}
+
+void
+operator delete (void *p) noexcept
+{
+  if (p == 0)
+    {
+      return;
+    }
+  char *block = static_cast<char *> (p) - g_heapHeader;
+  g_heapBytes -= *reinterpret_cast<std::size_t *> (block);
+  std::free (block);
+}
+
+void
+operator delete[] (void *p) noexcept
+{
+  operator delete (p);
+}
+
+static uint64_t
+runBenchOneIteration (void)
+{
+  SystemWallClockMs time;
+  time.Start ();
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  uint64_t deltaMs = time.End ();
+  return deltaMs;
+}
+
+static void
+runBench (uint32_t threads, uint32_t minIterations, uint32_t nodes)
+{
+  Config::SetGlobal ("GlobalRoutingIncremental", BooleanValue (false));
+  Config::SetGlobal ("GlobalRoutingThreads", UintegerValue (threads));
+  uint64_t minDelay = std::numeric_limits<uint64_t>::max ();
+  for (uint32_t i = 0; i < minIterations; i++)
+    {
+      uint64_t delay = runBenchOneIteration ();
+      minDelay = std::min (minDelay, delay);
+    }
+  double ps = nodes;
+  ps *= 1000;
+  ps /= std::max (minDelay, (uint64_t)1);
+  std::cout << ps << " nodes/s"
+            << " (" << minDelay << " ms elapsed)\t"
+            << "GlobalRoutingThreads=" << threads
+            << std::endl;
+}
+
+static void
+runFlapBench (bool incremental, uint32_t flaps, NodeContainer nodes)
+{
+  Config::SetGlobal ("GlobalRoutingIncremental", BooleanValue (incremental));
+  Config::SetGlobal ("GlobalRoutingThreads", UintegerValue (1));
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  // The same links flap in both runs.
+  Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable> ();
+  random->SetStream (1);
+  uint64_t totalMs = 0;
+  uint64_t recomputed = 0;
+  for (uint32_t i = 0; i < flaps; i++)
+    {
+      Ptr<Ipv4> ipv4 = nodes.Get (random->GetInteger (0, nodes.GetN () - 1))->GetObject<Ipv4> ();
+      uint32_t interface = random->GetInteger (1, ipv4->GetNInterfaces () - 1);
+      ipv4->SetDown (interface);
+      totalMs += runBenchOneIteration ();
+      recomputed += GlobalRouteManager::GetNRecomputedRoots ();
+      ipv4->SetUp (interface);
+      totalMs += runBenchOneIteration ();
+      recomputed += GlobalRouteManager::GetNRecomputedRoots ();
+    }
+  std::cout << (double)totalMs / (2 * flaps) << " ms/event"
+            << " (" << (double)recomputed / (2 * flaps) << " trees/event)\t"
+            << "GlobalRoutingIncremental=" << incremental
+            << std::endl;
+}
+
+static void
+runMemoryBench (bool aggregated, NodeContainer nodes)
+{
+  Config::SetGlobal ("GlobalRoutingIncremental", BooleanValue (false));
+  Config::SetGlobal ("GlobalRoutingAggregateRoutes", BooleanValue (aggregated));
+  Config::SetGlobal ("GlobalRoutingThreads", UintegerValue (1));
+  GlobalRouteManager::DeleteGlobalRoutes ();
+  GlobalRouteManager::BuildGlobalRoutingDatabase ();
+  uint64_t before = g_heapBytes;
+  GlobalRouteManager::InitializeRoutes ();
+  uint64_t bytes = g_heapBytes - before;
+  uint64_t routes = 0;
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      routes += nodes.Get (i)->GetObject<GlobalRouter> ()->GetRoutingProtocol ()->GetNRoutes ();
+    }
+  std::cout << (double)routes / nodes.GetN () << " routes/node, "
+            << (double)bytes / nodes.GetN () << " bytes/node\t"
+            << "GlobalRoutingAggregateRoutes=" << aggregated
+            << std::endl;
+  Config::SetGlobal ("GlobalRoutingAggregateRoutes", BooleanValue (false));
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t side = 30;
+  uint32_t threads = 0;
+  uint32_t minIterations = 1;
+  uint32_t flaps = 10;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the computation of the global routes of a grid of routers");
+  cmd.AddValue ("side", "number of routers on each side of the grid", side);
+  cmd.AddValue ("threads", "number of threads to compare with a single thread, 0 for one per processor", threads);
+  cmd.AddValue ("min-iterations", "number of subiterations to minimize iteration time over", minIterations);
+  cmd.AddValue ("flaps", "number of links going down and up again", flaps);
+  cmd.Parse (argc, argv);
+
+  NodeContainer nodes;
+  nodes.Create (side * side);
+  InternetStackHelper stack;
+  Ipv4GlobalRoutingHelper globalRouting;
+  stack.SetRoutingHelper (globalRouting);
+  stack.Install (nodes);
+
+  SimpleNetDeviceHelper devHelper;
+  devHelper.SetNetDevicePointToPointMode (true);
+  Ipv4AddressHelper address ("10.0.0.0", "255.255.255.252");
+  for (uint32_t row = 0; row < side; row++)
+    {
+      for (uint32_t column = 0; column < side; column++)
+        {
+          Ptr<Node> node = nodes.Get (row * side + column);
+          if (column + 1 < side)
+            {
+              address.Assign (devHelper.Install (NodeContainer (node, nodes.Get (row * side + column + 1))));
+              address.NewNetwork ();
+            }
+          if (row + 1 < side)
+            {
+              address.Assign (devHelper.Install (NodeContainer (node, nodes.Get ((row + 1) * side + column))));
+              address.NewNetwork ();
+            }
+        }
+    }
+
+  std::cout << "Running bench-global-routing with a grid of "
+            << side << "x" << side << " routers" << std::endl;
+
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+  runBench (1, minIterations, nodes.GetN ());
+  runBench (threads, minIterations, nodes.GetN ());
+  runFlapBench (false, flaps, nodes);
+  runFlapBench (true, flaps, nodes);
+  runMemoryBench (false, nodes);
+  runMemoryBench (true, nodes);
+
+  Simulator::Destroy ();
+  return 0;
+}
@@ -0,0 +1,201 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+// Benchmark the startup of a scenario of CSMA LANs, in which each host
+// sends a first UDP packet to its next neighbor over IPv4 and IPv6,
+// with the neighbors resolved by ARP and NDP, or preloaded in the
+// caches.  Report the wall clock time, the frames sent and the time
+// the last packet is received.
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/csma-module.h"
+#include <iostream>
+#include <stdlib.h> // for exit ()
+#include <limits>
+#include <algorithm>
+
+using namespace ns3;
+
+static uint32_t g_lans = 0;
+static uint32_t g_hosts = 10;
+static uint64_t g_frames = 0;
+static uint64_t g_received = 0;
+static Time g_lastReceived;
+
+static void
+TxEnd (Ptr<const Packet> packet)
+{
+  ++g_frames;
+}
+
+static void
+Receive (Ptr<Socket> socket)
+{
+  while (socket->Recv ())
+    {
+      ++g_received;
+      g_lastReceived = Simulator::Now ();
+    }
+}
+
+static void
+Send (Ptr<Socket> socket, Address to)
+{
+  socket->SendTo (Create<Packet> (100), 0, to);
+}
+
+// Build g_lans LANs of g_hosts hosts, and send a packet from each host
+// to the next one of its LAN over IPv4 and IPv6.
+static void
+benchStartup (bool populate)
+{
+  NodeContainer all;
+  std::vector<NetDeviceContainer> lans;
+  InternetStackHelper internet;
+  CsmaHelper csma;
+  csma.SetChannelAttribute ("DataRate", StringValue ("1Gbps"));
+  csma.SetChannelAttribute ("Delay", StringValue ("1us"));
+  for (uint32_t i = 0; i < g_lans; ++i)
+    {
+      NodeContainer hosts;
+      hosts.Create (g_hosts);
+      internet.Install (hosts);
+      lans.push_back (csma.Install (hosts));
+      all.Add (hosts);
+    }
+
+  NeighborCacheHelper neighborCache;
+  if (populate)
+    {
+      neighborCache.SuppressNeighborDiscovery (all);
+    }
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.0.0.0", "255.255.255.0");
+  Ipv6AddressHelper ipv6;
+  ipv6.SetBase (Ipv6Address ("2001:1::"), Ipv6Prefix (64));
+  std::vector<Ipv4InterfaceContainer> ipv4Interfaces;
+  std::vector<Ipv6InterfaceContainer> ipv6Interfaces;
+  for (uint32_t i = 0; i < g_lans; ++i)
+    {
+      ipv4Interfaces.push_back (ipv4.Assign (lans[i]));
+      ipv4.NewNetwork ();
+      ipv6Interfaces.push_back (ipv6.Assign (lans[i]));
+      ipv6.NewNetwork ();
+    }
+  if (populate)
+    {
+      neighborCache.PopulateNeighborCache ();
+    }
+
+  for (uint32_t i = 0; i < g_lans; ++i)
+    {
+      for (uint32_t j = 0; j < g_hosts; ++j)
+        {
+          Ptr<Node> node = lans[i].Get (j)->GetNode ();
+          uint32_t next = (j + 1) % g_hosts;
+
+          Ptr<Socket> server = Socket::CreateSocket (node, UdpSocketFactory::GetTypeId ());
+          server->Bind (InetSocketAddress (Ipv4Address::GetAny (), 5000));
+          server->SetRecvCallback (MakeCallback (&Receive));
+          Ptr<Socket> server6 = Socket::CreateSocket (node, UdpSocketFactory::GetTypeId ());
+          server6->Bind (Inet6SocketAddress (Ipv6Address::GetAny (), 5000));
+          server6->SetRecvCallback (MakeCallback (&Receive));
+
+          Ptr<Socket> client = Socket::CreateSocket (node, UdpSocketFactory::GetTypeId ());
+          Simulator::ScheduleWithContext (node->GetId (), Seconds (0), &Send, client,
+                                          InetSocketAddress (ipv4Interfaces[i].GetAddress (next), 5000));
+          Ptr<Socket> client6 = Socket::CreateSocket (node, UdpSocketFactory::GetTypeId ());
+          Simulator::ScheduleWithContext (node->GetId (), Seconds (0), &Send, client6,
+                                          Inet6SocketAddress (ipv6Interfaces[i].GetAddress (next, 1), 5000));
+        }
+    }
+  Config::ConnectWithoutContext ("/NodeList/*/DeviceList/*/$ns3::CsmaNetDevice/PhyTxEnd",
+                                 MakeCallback (&TxEnd));
+
+  g_frames = 0;
+  g_received = 0;
+  g_lastReceived = Seconds (0);
+  Simulator::Stop (Seconds (2));
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+static void
+benchDiscovery (void)
+{
+  benchStartup (false);
+}
+
+static void
+benchPopulated (void)
+{
+  benchStartup (true);
+}
+
+static uint64_t
+runBenchOneIteration (void (*bench) (void))
+{
+  SystemWallClockMs time;
+  time.Start ();
+  (*bench) ();
+  uint64_t deltaMs = time.End ();
+  return deltaMs;
+}
+
+static void
+runBench (void (*bench) (void), uint32_t minIterations, char const *name)
+{
+  uint64_t minDelay = std::numeric_limits<uint64_t>::max ();
+  for (uint32_t i = 0; i < minIterations; i++)
+    {
+      uint64_t delay = runBenchOneIteration (bench);
+      minDelay = std::min (minDelay, delay);
+    }
+  std::cout << minDelay << " ms elapsed, "
+            << g_frames << " frames sent, "
+            << g_received << " packets received, last at "
+            << g_lastReceived.GetMicroSeconds () << " us\t"
+            << name
+            << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t minIterations = 1;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the startup of a scenario with and without preloaded neighbor caches");
+  cmd.AddValue ("lans", "number of LANs", g_lans);
+  cmd.AddValue ("hosts", "number of hosts of each LAN", g_hosts);
+  cmd.AddValue ("min-iterations", "number of subiterations to minimize iteration time over", minIterations);
+  cmd.Parse (argc, argv);
+
+  if (g_lans == 0 || g_hosts < 2)
+    {
+      std::cerr << "Error-- number of LANs must be specified " <<
+        "by command-line argument --lans=(number of LANs)" << std::endl;
+      exit (1);
+    }
+
+  std::cout << "Running bench-neighbor-cache with lans=" << g_lans
+            << " hosts=" << g_hosts << std::endl;
+
+  runBench (&benchDiscovery, minIterations, "ARP and NDP");
+  runBench (&benchPopulated, minIterations, "Preloaded neighbor caches");
+
+  return 0;
+}
@@ -0,0 +1,102 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Measure the memory and the setup time of nodes with the full internet
+// stack and with the lightweight endpoint stack of InternetStackHelper.
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include <iostream>
+#include <fstream>
+#include <stdlib.h> // for exit ()
+#include <unistd.h> // for sysconf ()
+#if defined (__GLIBC__)
+#include <malloc.h>
+#endif
+
+using namespace ns3;
+
+// The number of bytes allocated on the heap, or the resident set size
+// when the C library does not report it.
+static uint64_t
+GetAllocatedBytes (void)
+{
+#if defined (__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+  struct mallinfo2 info = mallinfo2 ();
+  return info.uordblks + info.hblkhd;
+#else
+  std::ifstream statm ("/proc/self/statm");
+  uint64_t size = 0;
+  uint64_t resident = 0;
+  statm >> size >> resident;
+  return resident * sysconf (_SC_PAGESIZE);
+#endif
+}
+
+static void
+runBench (uint32_t nodes, bool lightweight, char const *name)
+{
+  uint64_t before = GetAllocatedBytes ();
+  SystemWallClockMs time;
+  time.Start ();
+
+  NodeContainer c;
+  c.Create (nodes);
+  InternetStackHelper stack;
+  stack.SetLightweightEndpoint (lightweight);
+  stack.Install (c);
+  SimpleNetDeviceHelper devHelper;
+  Ipv4AddressHelper address ("10.0.0.0", "255.0.0.0");
+  // One device per node, all on the same channel.
+  NetDeviceContainer devices = devHelper.Install (c);
+  Ipv4InterfaceContainer interfaces = address.Assign (devices);
+
+  uint64_t deltaMs = time.End ();
+  uint64_t after = GetAllocatedBytes ();
+  double perNode = after > before ? after - before : 0;
+  perNode /= nodes;
+  std::cout << perNode << " bytes/node"
+            << " (" << deltaMs << " ms setup)\t"
+            << name
+            << std::endl;
+  Simulator::Destroy ();
+  Ipv4AddressGenerator::Reset ();
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t nodes = 0;
+
+  CommandLine cmd;
+  cmd.Usage ("Measure the memory and setup time of nodes with an internet stack");
+  cmd.AddValue ("nodes", "number of nodes", nodes);
+  cmd.Parse (argc, argv);
+
+  if (nodes == 0)
+    {
+      std::cerr << "Error-- number of nodes must be specified " <<
+        "by command-line argument --nodes=(number of nodes)" << std::endl;
+      exit (1);
+    }
+
+  std::cout << "Running bench-node-memory with nodes=" << nodes << std::endl;
+
+  runBench (nodes, false, "Full internet stack");
+  runBench (nodes, true, "Lightweight endpoint stack");
+
+  return 0;
+}
@@ -0,0 +1,159 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Benchmark Object::GetObject on the aggregates of nodes
+// with a full internet stack installed.
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include <iostream>
+#include <stdlib.h> // for exit ()
+#include <limits>
+#include <algorithm>
+
+using namespace ns3;
+
+static NodeContainer g_nodes;
+// Count the successful checks so that the lookups cannot be optimized out.
+static uint32_t g_found = 0;
+
+static void
+benchIpv4 (uint32_t n)
+{
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Node> node = g_nodes.Get (i % g_nodes.GetN ());
+      g_found += (node->GetObject<Ipv4> () != 0);
+    }
+}
+
+static void
+benchMixed (uint32_t n)
+{
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Node> node = g_nodes.Get (i % g_nodes.GetN ());
+      switch (i % 6)
+        {
+        case 0:
+          g_found += (node->GetObject<Ipv4> () != 0);
+          break;
+        case 1:
+          g_found += (node->GetObject<Ipv4L3Protocol> () != 0);
+          break;
+        case 2:
+          g_found += (node->GetObject<ArpL3Protocol> () != 0);
+          break;
+        case 3:
+          g_found += (node->GetObject<UdpL4Protocol> () != 0);
+          break;
+        case 4:
+          g_found += (node->GetObject<Ipv6> () != 0);
+          break;
+        case 5:
+          g_found += (node->GetObject<Ipv4> ()->GetObject<Node> () == node);
+          break;
+        }
+    }
+}
+
+static void
+benchParent (uint32_t n)
+{
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Node> node = g_nodes.Get (i % g_nodes.GetN ());
+      g_found += (node->GetObject<IpL4Protocol> (UdpL4Protocol::GetTypeId ()) != 0);
+      g_found += (node->GetObject<Object> (IpL4Protocol::GetTypeId ()) != 0);
+    }
+}
+
+static void
+benchMiss (uint32_t n)
+{
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Node> node = g_nodes.Get (i % g_nodes.GetN ());
+      g_found += (node->GetObject<Ipv4RoutingProtocol> () == 0);
+    }
+}
+
+static uint64_t
+runBenchOneIteration (void (*bench) (uint32_t), uint32_t n)
+{
+  SystemWallClockMs time;
+  time.Start ();
+  (*bench) (n);
+  uint64_t deltaMs = time.End ();
+  return deltaMs;
+}
+
+static void
+runBench (void (*bench) (uint32_t), uint32_t n, uint32_t minIterations, char const *name)
+{
+  uint64_t minDelay = std::numeric_limits<uint64_t>::max ();
+  for (uint32_t i = 0; i < minIterations; i++)
+    {
+      uint64_t delay = runBenchOneIteration (bench, n);
+      minDelay = std::min (minDelay, delay);
+    }
+  double ps = n;
+  ps *= 1000;
+  ps /= std::max (minDelay, (uint64_t)1);
+  std::cout << ps << " lookups/s"
+            << " (" << minDelay << " ms elapsed)\t"
+            << name
+            << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t n = 0;
+  uint32_t nodes = 100;
+  uint32_t minIterations = 1;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark Object::GetObject on node aggregates");
+  cmd.AddValue ("n", "number of lookups", n);
+  cmd.AddValue ("nodes", "number of nodes to spread the lookups over", nodes);
+  cmd.AddValue ("min-iterations", "number of subiterations to minimize iteration time over", minIterations);
+  cmd.Parse (argc, argv);
+
+  if (n == 0)
+    {
+      std::cerr << "Error-- number of lookups must be specified " <<
+        "by command-line argument --n=(number of lookups)" << std::endl;
+      exit (1);
+    }
+
+  g_nodes.Create (nodes);
+  InternetStackHelper stack;
+  stack.Install (g_nodes);
+
+  std::cout << "Running bench-object with n=" << n
+            << " over " << nodes << " nodes" << std::endl;
+
+  runBench (&benchIpv4, n, minIterations, "GetObject<Ipv4>");
+  runBench (&benchMixed, n, minIterations, "Mixed protocol lookups");
+  runBench (&benchParent, n, minIterations, "Lookups by parent TypeId");
+  runBench (&benchMiss, n, minIterations, "Unsuccessful lookups");
+
+  std::cout << g_found << " checks succeeded" << std::endl;
+
+  Simulator::Destroy ();
+  return 0;
+}
@@ -0,0 +1,199 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+// Benchmark the enqueue and dequeue cost of DropTailQueue, alone and on
+// the device queues of a saturated chain of point-to-point links.
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/point-to-point-module.h"
+#include <iostream>
+#include <stdlib.h> // for exit ()
+#include <limits>
+#include <algorithm>
+
+using namespace ns3;
+
+static Ptr<Packet> g_packet = Create<Packet> (1000);
+// Count the dequeued items so that the loops cannot be optimized out.
+static uint32_t g_dequeued = 0;
+
+// Keep the queue half full, as a busy device queue.
+static void
+benchPacketMode (uint32_t n)
+{
+  Ptr<DropTailQueue> queue = CreateObject<DropTailQueue> ();
+  queue->SetAttribute ("MaxPackets", UintegerValue (100));
+  for (uint32_t i = 0; i < 50; i++)
+    {
+      queue->Enqueue (Create<QueueItem> (g_packet));
+    }
+  for (uint32_t i = 0; i < n; i++)
+    {
+      queue->Enqueue (Create<QueueItem> (g_packet));
+      g_dequeued += (queue->Dequeue () != 0);
+    }
+}
+
+// Fill the queue up to its limit, then drain it.
+static void
+benchFillDrain (uint32_t n)
+{
+  Ptr<DropTailQueue> queue = CreateObject<DropTailQueue> ();
+  queue->SetAttribute ("MaxPackets", UintegerValue (1000));
+  for (uint32_t i = 0; i < n; i += 1000)
+    {
+      while (queue->Enqueue (Create<QueueItem> (g_packet)))
+        {
+        }
+      while (!queue->IsEmpty ())
+        {
+          g_dequeued += (queue->Dequeue () != 0);
+        }
+    }
+}
+
+static void
+benchByteMode (uint32_t n)
+{
+  Ptr<DropTailQueue> queue = CreateObject<DropTailQueue> ();
+  queue->SetAttribute ("Mode", EnumValue (Queue::QUEUE_MODE_BYTES));
+  queue->SetAttribute ("MaxBytes", UintegerValue (100 * 1000));
+  for (uint32_t i = 0; i < 50; i++)
+    {
+      queue->Enqueue (Create<QueueItem> (g_packet));
+    }
+  for (uint32_t i = 0; i < n; i++)
+    {
+      queue->Enqueue (Create<QueueItem> (g_packet));
+      g_dequeued += (queue->Dequeue () != 0);
+    }
+}
+
+static uint32_t g_hops = 8;
+static uint32_t g_received = 0;
+
+// Forward the packets received by a node of the chain to the next link.
+static void
+Forward (Ptr<NetDevice> next, Ptr<NetDevice> device, Ptr<const Packet> packet,
+         uint16_t protocol, const Address &from, const Address &to, NetDevice::PacketType type)
+{
+  next->Send (packet->Copy (), next->GetBroadcast (), protocol);
+}
+
+static void
+Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
+         uint16_t protocol, const Address &from, const Address &to, NetDevice::PacketType type)
+{
+  g_received++;
+}
+
+static void
+Saturate (Ptr<NetDevice> device, uint32_t remaining)
+{
+  // Send twice as fast as the 10Mb/s link rate: the device queue stays
+  // full and drops half of the packets.
+  device->Send (g_packet->Copy (), device->GetBroadcast (), 0x0800);
+  if (remaining > 1)
+    {
+      Simulator::Schedule (MicroSeconds (400), &Saturate, device, remaining - 1);
+    }
+}
+
+// Send n packets through a saturated chain of links.
+static void
+benchChain (uint32_t n)
+{
+  NodeContainer nodes;
+  nodes.Create (g_hops + 1);
+  PointToPointHelper p2p;
+  p2p.SetDeviceAttribute ("DataRate", StringValue ("10Mbps"));
+  p2p.SetChannelAttribute ("Delay", StringValue ("1ms"));
+  std::vector<NetDeviceContainer> links;
+  for (uint32_t i = 0; i < g_hops; i++)
+    {
+      links.push_back (p2p.Install (nodes.Get (i), nodes.Get (i + 1)));
+    }
+  for (uint32_t i = 1; i < g_hops; i++)
+    {
+      nodes.Get (i)->RegisterProtocolHandler (MakeBoundCallback (&Forward, links[i].Get (0)),
+                                              0x0800, links[i - 1].Get (1));
+    }
+  nodes.Get (g_hops)->RegisterProtocolHandler (MakeCallback (&Receive), 0x0800, links[g_hops - 1].Get (1));
+
+  Simulator::ScheduleWithContext (0, Seconds (0), &Saturate, links[0].Get (0), n);
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+static uint64_t
+runBenchOneIteration (void (*bench) (uint32_t), uint32_t n)
+{
+  SystemWallClockMs time;
+  time.Start ();
+  (*bench) (n);
+  uint64_t deltaMs = time.End ();
+  return deltaMs;
+}
+
+static void
+runBench (void (*bench) (uint32_t), uint32_t n, uint32_t minIterations, char const *name)
+{
+  uint64_t minDelay = std::numeric_limits<uint64_t>::max ();
+  for (uint32_t i = 0; i < minIterations; i++)
+    {
+      uint64_t delay = runBenchOneIteration (bench, n);
+      minDelay = std::min (minDelay, delay);
+    }
+  double ps = n;
+  ps *= 1000;
+  ps /= std::max (minDelay, (uint64_t)1);
+  std::cout << ps << " packets/s"
+            << " (" << minDelay << " ms elapsed)\t"
+            << name
+            << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t n = 0;
+  uint32_t minIterations = 1;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark DropTailQueue enqueue and dequeue");
+  cmd.AddValue ("n", "number of packets", n);
+  cmd.AddValue ("hops", "number of point-to-point links of the chain", g_hops);
+  cmd.AddValue ("min-iterations", "number of subiterations to minimize iteration time over", minIterations);
+  cmd.Parse (argc, argv);
+
+  if (n == 0 || g_hops == 0)
+    {
+      std::cerr << "Error-- number of packets must be specified " <<
+        "by command-line argument --n=(number of packets)" << std::endl;
+      exit (1);
+    }
+
+  std::cout << "Running bench-queue with n=" << n << std::endl;
+
+  runBench (&benchPacketMode, n, minIterations, "Enqueue/dequeue, packet mode");
+  runBench (&benchFillDrain, n, minIterations, "Fill and drain, packet mode");
+  runBench (&benchByteMode, n, minIterations, "Enqueue/dequeue, byte mode");
+  runBench (&benchChain, n, minIterations, "Saturated point-to-point chain");
+
+  std::cout << g_dequeued << " items dequeued, "
+            << g_received << " packets through the chain" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,172 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Benchmark the route lookups of Ipv4GlobalRouting and Ipv4StaticRouting
+// with routing tables of the size PopulateRoutingTables builds on large
+// topologies: one host route per node, plus some network routes.
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include <iostream>
+#include <stdlib.h> // for exit ()
+#include <limits>
+#include <algorithm>
+#include <vector>
+
+using namespace ns3;
+
+static Ptr<Ipv4GlobalRouting> g_global;
+static Ptr<Ipv4StaticRouting> g_static;
+static std::vector<Ipv4Header> g_headers;
+static Ptr<Packet> g_packet;
+// Count the routes found so that the lookups cannot be optimized out.
+static uint32_t g_found = 0;
+
+static void
+benchGlobal (uint32_t n)
+{
+  Socket::SocketErrno err;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      g_found += (g_global->RouteOutput (g_packet, g_headers[i % g_headers.size ()], 0, err) != 0);
+    }
+}
+
+static void
+benchStatic (uint32_t n)
+{
+  Socket::SocketErrno err;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      g_found += (g_static->RouteOutput (g_packet, g_headers[i % g_headers.size ()], 0, err) != 0);
+    }
+}
+
+static uint64_t
+runBenchOneIteration (void (*bench) (uint32_t), uint32_t n)
+{
+  SystemWallClockMs time;
+  time.Start ();
+  (*bench) (n);
+  uint64_t deltaMs = time.End ();
+  return deltaMs;
+}
+
+static void
+runBench (void (*bench) (uint32_t), uint32_t n, uint32_t minIterations, char const *name)
+{
+  uint64_t minDelay = std::numeric_limits<uint64_t>::max ();
+  for (uint32_t i = 0; i < minIterations; i++)
+    {
+      uint64_t delay = runBenchOneIteration (bench, n);
+      minDelay = std::min (minDelay, delay);
+    }
+  double ps = n;
+  ps *= 1000;
+  ps /= std::max (minDelay, (uint64_t)1);
+  std::cout << ps << " lookups/s"
+            << " (" << minDelay << " ms elapsed)\t"
+            << name
+            << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t n = 0;
+  uint32_t routes = 10000;
+  uint32_t minIterations = 1;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the route lookups of the IPv4 global and static routing");
+  cmd.AddValue ("n", "number of lookups", n);
+  cmd.AddValue ("routes", "number of host routes", routes);
+  cmd.AddValue ("min-iterations", "number of subiterations to minimize iteration time over", minIterations);
+  cmd.Parse (argc, argv);
+
+  if (n == 0)
+    {
+      std::cerr << "Error-- number of lookups must be specified " <<
+        "by command-line argument --n=(number of lookups)" << std::endl;
+      exit (1);
+    }
+
+  // A router with two interfaces, whose routing tables are filled by hand.
+  Ptr<Node> node = CreateObject<Node> ();
+  InternetStackHelper stack;
+  stack.Install (node);
+  SimpleNetDeviceHelper devHelper;
+  NetDeviceContainer devices = devHelper.Install (node);
+  devices.Add (devHelper.Install (node));
+  Ipv4AddressHelper address ("192.168.0.0", "255.255.255.0");
+  address.Assign (devices.Get (0));
+  address.NewNetwork ();
+  address.Assign (devices.Get (1));
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+
+  g_global = CreateObject<Ipv4GlobalRouting> ();
+  g_global->SetIpv4 (ipv4);
+  g_static = CreateObject<Ipv4StaticRouting> ();
+  g_static->SetIpv4 (ipv4);
+  Ipv4Address gateways[] = { Ipv4Address ("192.168.0.2"), Ipv4Address ("192.168.1.2") };
+  for (uint32_t i = 0; i < routes; i++)
+    {
+      // The host routes to the nodes, within 10.0.0.0/8.
+      Ipv4Address host (0x0a000001 + i * 4);
+      g_global->AddHostRouteTo (host, gateways[i % 2], 1 + i % 2);
+      g_static->AddHostRouteTo (host, gateways[i % 2], 1 + i % 2);
+      if (i % 4 == 0)
+        {
+          // The routes to the links, within 172.16.0.0/12.
+          Ipv4Address network (0xac100000 + i * 4);
+          g_global->AddNetworkRouteTo (network, Ipv4Mask ("255.255.255.252"), gateways[i % 2], 1 + i % 2);
+          g_static->AddNetworkRouteTo (network, Ipv4Mask ("255.255.255.252"), gateways[i % 2], 1 + i % 2);
+        }
+    }
+  g_static->SetDefaultRoute (gateways[0], 1);
+
+  // Destinations spread over the hosts and the links.
+  Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable> ();
+  for (uint32_t i = 0; i < 4096; i++)
+    {
+      Ipv4Header header;
+      uint32_t index = rand->GetInteger (0, routes - 1);
+      if (i % 4 == 0)
+        {
+          header.SetDestination (Ipv4Address (0xac100001 + (index & ~3) * 4));
+        }
+      else
+        {
+          header.SetDestination (Ipv4Address (0x0a000001 + index * 4));
+        }
+      g_headers.push_back (header);
+    }
+  g_packet = Create<Packet> (100);
+
+  std::cout << "Running bench-routing-lookup with n=" << n
+            << " and " << routes << " host routes" << std::endl;
+
+  runBench (&benchGlobal, n, minIterations, "Ipv4GlobalRouting");
+  runBench (&benchStatic, n, minIterations, "Ipv4StaticRouting");
+
+  std::cout << g_found << " routes found" << std::endl;
+
+  g_global = 0;
+  g_static = 0;
+  g_packet = 0;
+  Simulator::Destroy ();
+  return 0;
+}
@@ -0,0 +1,204 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+// Benchmark a bulk TCP transfer over a point-to-point link with a large
+// bandwidth-delay product, and report the simulated bytes transferred
+// per second of wall clock time.
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include <iostream>
+#include <stdlib.h> // for exit ()
+#include <limits>
+#include <algorithm>
+
+using namespace ns3;
+
+static uint64_t g_bytes = 0;
+static uint32_t g_sendSize = 512;
+static uint64_t g_sent = 0;
+static uint64_t g_received = 0;
+static bool g_sack = false;
+
+// Fill the send buffer, as BulkSendApplication does.
+static void
+Write (Ptr<Socket> socket, uint32_t available)
+{
+  while (g_sent < g_bytes)
+    {
+      uint32_t size = std::min<uint64_t> (g_sendSize, g_bytes - g_sent);
+      if (socket->GetTxAvailable () < size)
+        {
+          return;
+        }
+      int sent = socket->Send (Create<Packet> (size));
+      if (sent < 0)
+        {
+          return;
+        }
+      g_sent += sent;
+    }
+  socket->Close ();
+}
+
+static void
+Connected (Ptr<Socket> socket)
+{
+  Write (socket, socket->GetTxAvailable ());
+}
+
+static void
+Read (Ptr<Socket> socket)
+{
+  Ptr<Packet> packet;
+  while ((packet = socket->Recv ()))
+    {
+      g_received += packet->GetSize ();
+    }
+}
+
+static void
+Accept (Ptr<Socket> socket, const Address &from)
+{
+  socket->SetRecvCallback (MakeCallback (&Read));
+}
+
+// Connect once the nodes are initialized, and their device queues exist.
+static void
+Connect (Ptr<Socket> client, Address remote)
+{
+  client->Connect (remote);
+}
+
+// Transfer g_bytes over a 1Gb/s link with a 20ms round trip time, with
+// the given packet error rate on the receiver.
+static void
+benchBulk (double errorRate)
+{
+  Config::SetDefault ("ns3::TcpSocket::SndBufSize", UintegerValue (8 << 20));
+  Config::SetDefault ("ns3::TcpSocket::RcvBufSize", UintegerValue (8 << 20));
+  Config::SetDefault ("ns3::TcpSocket::SegmentSize", UintegerValue (1448));
+  Config::SetDefault ("ns3::TcpSocketBase::Sack", BooleanValue (g_sack));
+
+  NodeContainer nodes;
+  nodes.Create (2);
+  PointToPointHelper p2p;
+  p2p.SetDeviceAttribute ("DataRate", StringValue ("1Gbps"));
+  p2p.SetChannelAttribute ("Delay", StringValue ("10ms"));
+  p2p.SetQueue ("ns3::DropTailQueue", "MaxPackets", UintegerValue (10000));
+  NetDeviceContainer devices = p2p.Install (nodes);
+  if (errorRate > 0)
+    {
+      Ptr<RateErrorModel> error = CreateObject<RateErrorModel> ();
+      error->SetAttribute ("ErrorUnit", StringValue ("ERROR_UNIT_PACKET"));
+      error->SetAttribute ("ErrorRate", DoubleValue (errorRate));
+      devices.Get (1)->SetAttribute ("ReceiveErrorModel", PointerValue (error));
+    }
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  Ipv4AddressHelper address;
+  address.SetBase ("10.1.1.0", "255.255.255.0");
+  Ipv4InterfaceContainer interfaces = address.Assign (devices);
+
+  Ptr<Socket> server = Socket::CreateSocket (nodes.Get (1), TcpSocketFactory::GetTypeId ());
+  server->Bind (InetSocketAddress (Ipv4Address::GetAny (), 5000));
+  server->Listen ();
+  server->SetAcceptCallback (MakeNullCallback<bool, Ptr<Socket>, const Address &> (),
+                             MakeCallback (&Accept));
+
+  Ptr<Socket> client = Socket::CreateSocket (nodes.Get (0), TcpSocketFactory::GetTypeId ());
+  client->Bind ();
+  client->SetConnectCallback (MakeCallback (&Connected), MakeNullCallback<void, Ptr<Socket> > ());
+  client->SetSendCallback (MakeCallback (&Write));
+  Simulator::Schedule (Seconds (0), &Connect, client,
+                       InetSocketAddress (interfaces.GetAddress (1), 5000));
+
+  g_sent = 0;
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+static void
+benchLossless (void)
+{
+  benchBulk (0);
+}
+
+static void
+benchLossy (void)
+{
+  benchBulk (0.001);
+}
+
+static uint64_t
+runBenchOneIteration (void (*bench) (void))
+{
+  SystemWallClockMs time;
+  time.Start ();
+  (*bench) ();
+  uint64_t deltaMs = time.End ();
+  return deltaMs;
+}
+
+static void
+runBench (void (*bench) (void), uint32_t minIterations, char const *name)
+{
+  uint64_t minDelay = std::numeric_limits<uint64_t>::max ();
+  for (uint32_t i = 0; i < minIterations; i++)
+    {
+      uint64_t delay = runBenchOneIteration (bench);
+      minDelay = std::min (minDelay, delay);
+    }
+  double bps = g_bytes;
+  bps *= 1000;
+  bps /= std::max (minDelay, (uint64_t)1);
+  std::cout << bps << " simulated bytes/s"
+            << " (" << minDelay << " ms elapsed)\t"
+            << name
+            << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t megabytes = 0;
+  uint32_t minIterations = 1;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark a bulk TCP transfer");
+  cmd.AddValue ("megabytes", "number of megabytes to transfer", megabytes);
+  cmd.AddValue ("send-size", "number of bytes of each write of the sender", g_sendSize);
+  cmd.AddValue ("sack", "enable the SACK option", g_sack);
+  cmd.AddValue ("min-iterations", "number of subiterations to minimize iteration time over", minIterations);
+  cmd.Parse (argc, argv);
+
+  if (megabytes == 0 || g_sendSize == 0)
+    {
+      std::cerr << "Error-- number of megabytes must be specified " <<
+        "by command-line argument --megabytes=(number of megabytes)" << std::endl;
+      exit (1);
+    }
+  g_bytes = megabytes * 1000000ull;
+
+  std::cout << "Running bench-tcp-bulk with megabytes=" << megabytes << std::endl;
+
+  runBench (&benchLossless, minIterations, "Bulk transfer, no loss");
+  runBench (&benchLossy, minIterations, "Bulk transfer, 0.1% packet loss");
+
+  std::cout << g_received << " bytes received" << std::endl;
+
+  return 0;
+}
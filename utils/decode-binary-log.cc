@@ -0,0 +1,55 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Render a log file written by the binary logging backend
+// (NS_LOG_BINARY) as text on the standard output.
+
+#include "ns3/core-module.h"
+#include <iostream>
+#include <fstream>
+#include <stdlib.h> // for exit ()
+
+using namespace ns3;
+
+int main (int argc, char *argv[])
+{
+  std::string filename;
+
+  CommandLine cmd;
+  cmd.Usage ("Render a binary log file as text");
+  cmd.AddValue ("file", "name of the binary log file", filename);
+  cmd.Parse (argc, argv);
+
+  if (filename.empty ())
+    {
+      std::cerr << "Error-- the log file must be specified " <<
+        "by command-line argument --file=(file name)" << std::endl;
+      exit (1);
+    }
+
+  std::ifstream is (filename.c_str (), std::ios::binary);
+  if (!is)
+    {
+      std::cerr << "Error-- could not open " << filename << std::endl;
+      exit (1);
+    }
+  if (!LogBinaryDecode (is, std::cout))
+    {
+      std::cerr << "Error-- " << filename << " is not a valid binary log" << std::endl;
+      exit (1);
+    }
+  return 0;
+}